@@ -0,0 +1,1354 @@
+// Synthetic micro-benchmarks for the HandleEnum pipeline.
+//
+// Usage: handle_bench [section|all] [rows]
+// Runs on any host: rows are generated, no NT calls are made.
+
+#include "alloc_tracker.hpp"
+#include "async_writer.hpp"
+#include "filter_expr.hpp"
+#include "fleet_merge.hpp"
+#include "handle_sort.hpp"
+#include "history_store.hpp"
+#include "latency.hpp"
+#include "metrics.hpp"
+#include "name_policy.hpp"
+#include "parallel_filter.hpp"
+#include "pid_table.hpp"
+#include "pipeline.hpp"
+#include "printer.hpp"
+#include "shared_objects.hpp"
+#include "sketch.hpp"
+#include "string_interner.hpp"
+#include "string_utils.hpp"
+#include "types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <streambuf>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Synthetic snapshot
+// ---------------------------------------------------------------------------
+
+class Rng {
+public:
+    explicit Rng(const std::uint64_t seed) : m_state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    std::uint64_t next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+
+    std::size_t below(const std::size_t bound) {
+        return static_cast<std::size_t>(next() % bound);
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+// One synthetic row as the resolvers would return it.
+struct SyntheticRow {
+    std::uint32_t pid{};
+    std::uintptr_t handleValue{};
+    std::uintptr_t objectAddress{};
+    std::uint32_t grantedAccess{};
+    std::uint16_t objectTypeIndex{};
+    std::string_view processName;
+    std::string_view handleType;
+    std::string_view objectName;
+};
+
+struct SyntheticSnapshot {
+    std::vector<std::string> processNames;
+    std::vector<std::string> typeNames;
+    std::vector<std::string> objectNames;
+    std::vector<SyntheticRow> rows;
+};
+
+// Skewed like a real host: a few types and processes dominate, most handles
+// are unnamed, named objects repeat (DLLs, registry keys, sections).
+SyntheticSnapshot make_snapshot(const std::size_t row_count) {
+    SyntheticSnapshot snapshot;
+    static constexpr std::string_view kTypes[] = {
+        "File", "Event", "Key", "Section", "Mutant", "Semaphore", "Thread", "Process",
+        "Token", "ALPC Port", "IoCompletion", "WaitCompletionPacket", "TpWorkerFactory",
+        "Directory", "Desktop", "WindowStation", "Timer", "IRTimer", "EtwRegistration", "Job"
+    };
+    for (const std::string_view type : kTypes) {
+        snapshot.typeNames.emplace_back(type);
+    }
+
+    static constexpr std::string_view kProcesses[] = {
+        "svchost.exe", "chrome.exe", "explorer.exe", "MsMpEng.exe", "System", "lsass.exe",
+        "services.exe", "csrss.exe", "RuntimeBroker.exe", "sqlservr.exe"
+    };
+    constexpr std::size_t kProcessCount = 400;
+    for (std::size_t i = 0; i < kProcessCount; ++i) {
+        snapshot.processNames.emplace_back(i < std::size(kProcesses)
+            ? std::string(kProcesses[i])
+            : std::string(kProcesses[i % 4]));
+    }
+
+    snapshot.objectNames.emplace_back("N/A");
+    snapshot.objectNames.emplace_back("");
+    const std::size_t distinct_names = std::max<std::size_t>(row_count / 8, 16);
+    for (std::size_t i = 0; i < distinct_names; ++i) {
+        switch (i % 4) {
+        case 0:
+            snapshot.objectNames.push_back("\\Device\\HarddiskVolume3\\Windows\\System32\\module" + std::to_string(i) + ".dll");
+            break;
+        case 1:
+            snapshot.objectNames.push_back("\\REGISTRY\\MACHINE\\SOFTWARE\\Vendor\\Key" + std::to_string(i));
+            break;
+        case 2:
+            snapshot.objectNames.push_back("\\Sessions\\1\\BaseNamedObjects\\Local_" + std::to_string(i));
+            break;
+        default:
+            snapshot.objectNames.push_back("\\Device\\NamedPipe\\pipe_" + std::to_string(i));
+            break;
+        }
+    }
+
+    Rng rng(row_count);
+    snapshot.rows.reserve(row_count);
+    for (std::size_t i = 0; i < row_count; ++i) {
+        // Square the draw to bias towards low indices (hot types/processes).
+        const std::size_t type_draw = rng.below(snapshot.typeNames.size());
+        const std::size_t type_index = (type_draw * type_draw) / snapshot.typeNames.size();
+        const std::size_t process_index = rng.below(kProcessCount);
+        const bool named = rng.below(100) < 45;
+        const std::size_t name_index = named ? 2 + rng.below(distinct_names) : rng.below(2);
+
+        snapshot.rows.push_back(SyntheticRow{
+            .pid = static_cast<std::uint32_t>(4 + process_index * 4),
+            .handleValue = static_cast<std::uintptr_t>(4 + (i % 65'536) * 4),
+            .objectAddress = static_cast<std::uintptr_t>(0xFFFF800000000000ull + rng.below(row_count / 2 + 1) * 0x40),
+            .grantedAccess = static_cast<std::uint32_t>(rng.next() & 0x1F01FF),
+            .objectTypeIndex = static_cast<std::uint16_t>(type_index + 2),
+            .processName = snapshot.processNames[process_index],
+            .handleType = snapshot.typeNames[type_index],
+            .objectName = snapshot.objectNames[name_index]
+        });
+    }
+
+    return snapshot;
+}
+
+// ---------------------------------------------------------------------------
+// Reporting helpers
+// ---------------------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+[[nodiscard]] double elapsed_ms(const Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+[[nodiscard]] std::size_t string_heap_bytes(const std::string& text) {
+    // Strings beyond the small-buffer capacity own a heap block of capacity + 1.
+    return text.capacity() > std::string{}.capacity() ? text.capacity() + 1 : 0;
+}
+
+void print_line(const std::string_view label, const double value, const std::string_view unit) {
+    std::cout << "  " << label;
+    for (std::size_t i = label.size(); i < 40; ++i) {
+        std::cout << ' ';
+    }
+    std::cout << value << ' ' << unit << "\n";
+}
+
+// ---------------------------------------------------------------------------
+// Section: interning (owned std::string rows vs interned ids)
+// ---------------------------------------------------------------------------
+
+// Row layout before interning: four owned strings per handle.
+struct LegacyHandleInfo {
+    uint32_t pid{};
+    std::string processName;
+    std::string handleType;
+    std::string objectName;
+    uint32_t grantedAccess{};
+    std::uintptr_t objectAddress{};
+    std::uintptr_t handleValue{};
+    uint16_t objectTypeIndex{};
+    uint32_t handleAttributes{};
+};
+
+[[nodiscard]] std::string lower_copy(const std::string_view text) {
+    std::string lower(text);
+    for (char& ch : lower) {
+        if (ch >= 'A' && ch <= 'Z') {
+            ch = static_cast<char>(ch - 'A' + 'a');
+        }
+    }
+    return lower;
+}
+
+// The pre-interning comparator: two lowercase copies per comparison.
+void legacy_sort_by_name(std::vector<LegacyHandleInfo>& handles) {
+    std::ranges::sort(handles, [](const LegacyHandleInfo& left, const LegacyHandleInfo& right) {
+        const std::string left_name = lower_copy(left.objectName);
+        const std::string right_name = lower_copy(right.objectName);
+        if (left_name != right_name) {
+            return left_name < right_name;
+        }
+        if (left.pid != right.pid) {
+            return left.pid < right.pid;
+        }
+        return left.handleValue < right.handleValue;
+    });
+}
+
+void bench_interning(const SyntheticSnapshot& snapshot) {
+    std::cout << "[interning] rows=" << snapshot.rows.size() << "\n";
+
+    auto start = Clock::now();
+    std::vector<LegacyHandleInfo> legacy;
+    legacy.reserve(snapshot.rows.size());
+    for (const SyntheticRow& row : snapshot.rows) {
+        legacy.push_back(LegacyHandleInfo{
+            .pid = row.pid,
+            .processName = std::string(row.processName),
+            .handleType = std::string(row.handleType),
+            .objectName = std::string(row.objectName),
+            .grantedAccess = row.grantedAccess,
+            .objectAddress = row.objectAddress,
+            .handleValue = row.handleValue,
+            .objectTypeIndex = row.objectTypeIndex
+        });
+    }
+    const double legacy_build_ms = elapsed_ms(start);
+
+    std::size_t legacy_bytes = legacy.capacity() * sizeof(LegacyHandleInfo);
+    for (const LegacyHandleInfo& row : legacy) {
+        legacy_bytes += string_heap_bytes(row.processName) +
+                        string_heap_bytes(row.handleType) +
+                        string_heap_bytes(row.objectName);
+    }
+
+    start = Clock::now();
+    legacy_sort_by_name(legacy);
+    const double legacy_sort_ms = elapsed_ms(start);
+
+    start = Clock::now();
+    StringInterner strings;
+    // Mirrors HandleEnumApp: process names are interned once per pid.
+    std::unordered_map<std::uint32_t, StringId> process_ids;
+    std::vector<HandleInfo> interned;
+    interned.reserve(snapshot.rows.size());
+    for (const SyntheticRow& row : snapshot.rows) {
+        auto [process_it, inserted] = process_ids.try_emplace(row.pid, StringInterner::kEmpty);
+        if (inserted) {
+            process_it->second = strings.intern(row.processName);
+        }
+        interned.push_back(HandleInfo{
+            .pid = row.pid,
+            .processName = process_it->second,
+            .handleType = strings.intern(row.handleType),
+            .objectName = strings.intern(row.objectName),
+            .grantedAccess = row.grantedAccess,
+            .objectAddress = row.objectAddress,
+            .handleValue = row.handleValue,
+            .objectTypeIndex = row.objectTypeIndex
+        });
+    }
+    const double interned_build_ms = elapsed_ms(start);
+
+    start = Clock::now();
+    sorting::sort_handles(interned, SortField::Name, strings);
+    const double interned_sort_ms = elapsed_ms(start);
+    const std::size_t interned_bytes = interned.capacity() * sizeof(HandleInfo) + strings.bytes_reserved();
+
+    print_line("owned strings: row size (bytes)", static_cast<double>(sizeof(LegacyHandleInfo)), "B");
+    print_line("owned strings: total memory", static_cast<double>(legacy_bytes) / (1024.0 * 1024.0), "MiB");
+    print_line("owned strings: build", legacy_build_ms, "ms");
+    print_line("owned strings: sort by name", legacy_sort_ms, "ms");
+    print_line("interned: row size (bytes)", static_cast<double>(sizeof(HandleInfo)), "B");
+    print_line("interned: total memory", static_cast<double>(interned_bytes) / (1024.0 * 1024.0), "MiB");
+    print_line("interned: distinct strings", static_cast<double>(strings.size()), "");
+    print_line("interned: build", interned_build_ms, "ms");
+    print_line("interned: sort by name (incl. ranks)", interned_sort_ms, "ms");
+}
+
+// ---------------------------------------------------------------------------
+// Section: filters (virtual IHandleFilter chain vs compiled FilterProgram)
+// ---------------------------------------------------------------------------
+
+// Raw handles whose handleValue indexes the synthetic row, so the fake NT
+// queries below can answer in O(1) and return fresh strings like the real ones.
+[[nodiscard]] std::vector<nt::RawHandle> make_raw_handles(const SyntheticSnapshot& snapshot) {
+    std::vector<nt::RawHandle> handles;
+    handles.reserve(snapshot.rows.size());
+    for (std::size_t i = 0; i < snapshot.rows.size(); ++i) {
+        const SyntheticRow& row = snapshot.rows[i];
+        handles.push_back(nt::RawHandle{
+            .objectAddress = row.objectAddress,
+            .processId = row.pid,
+            .handleValue = i,
+            .grantedAccess = row.grantedAccess,
+            .objectTypeIndex = row.objectTypeIndex
+        });
+    }
+    return handles;
+}
+
+struct LookupCounters {
+    std::size_t types = 0;
+    std::size_t names = 0;
+};
+
+// Shape of the former IHandleFilter hierarchy, plus the And/Or/Not
+// composites a virtual design would need for boolean expressions.
+class VirtualFilter {
+public:
+    virtual ~VirtualFilter() = default;
+    [[nodiscard]] virtual bool match(const nt::RawHandle& handle) const = 0;
+};
+
+using VirtualFilterPtr = std::unique_ptr<VirtualFilter>;
+
+class VirtualPidFilter final : public VirtualFilter {
+public:
+    explicit VirtualPidFilter(const std::uintptr_t pid) : m_pid(pid) {}
+    [[nodiscard]] bool match(const nt::RawHandle& handle) const override { return handle.processId == m_pid; }
+
+private:
+    std::uintptr_t m_pid;
+};
+
+class VirtualTypeFilter final : public VirtualFilter {
+public:
+    VirtualTypeFilter(const SyntheticSnapshot& snapshot, LookupCounters& counters, std::string target)
+        : m_snapshot(snapshot), m_counters(counters), m_target(lower_copy(target)) {}
+
+    [[nodiscard]] bool match(const nt::RawHandle& handle) const override {
+        ++m_counters.types;
+        const std::string type(m_snapshot.rows[handle.handleValue].handleType);
+        return lower_copy(type) == m_target;
+    }
+
+private:
+    const SyntheticSnapshot& m_snapshot;
+    LookupCounters& m_counters;
+    std::string m_target;
+};
+
+class VirtualNameFilter final : public VirtualFilter {
+public:
+    VirtualNameFilter(const SyntheticSnapshot& snapshot, LookupCounters& counters, std::string target)
+        : m_snapshot(snapshot), m_counters(counters), m_target(lower_copy(target)) {}
+
+    [[nodiscard]] bool match(const nt::RawHandle& handle) const override {
+        ++m_counters.names;
+        const std::string name(m_snapshot.rows[handle.handleValue].objectName);
+        return lower_copy(name).find(m_target) != std::string::npos;
+    }
+
+private:
+    const SyntheticSnapshot& m_snapshot;
+    LookupCounters& m_counters;
+    std::string m_target;
+};
+
+class VirtualAnyOf final : public VirtualFilter {
+public:
+    explicit VirtualAnyOf(std::vector<VirtualFilterPtr> children) : m_children(std::move(children)) {}
+
+    [[nodiscard]] bool match(const nt::RawHandle& handle) const override {
+        return std::ranges::any_of(m_children, [&](const VirtualFilterPtr& child) { return child->match(handle); });
+    }
+
+private:
+    std::vector<VirtualFilterPtr> m_children;
+};
+
+class VirtualAllOf final : public VirtualFilter {
+public:
+    explicit VirtualAllOf(std::vector<VirtualFilterPtr> children) : m_children(std::move(children)) {}
+
+    [[nodiscard]] bool match(const nt::RawHandle& handle) const override {
+        return std::ranges::all_of(m_children, [&](const VirtualFilterPtr& child) { return child->match(handle); });
+    }
+
+private:
+    std::vector<VirtualFilterPtr> m_children;
+};
+
+template <typename... Filters>
+[[nodiscard]] std::vector<VirtualFilterPtr> make_filters(Filters... filters) {
+    std::vector<VirtualFilterPtr> list;
+    (list.push_back(VirtualFilterPtr(filters)), ...);
+    return list;
+}
+
+void bench_filters(const SyntheticSnapshot& snapshot) {
+    std::cout << "[filters] rows=" << snapshot.rows.size() << "\n";
+    const std::vector<nt::RawHandle> handles = make_raw_handles(snapshot);
+
+    LookupCounters virtual_counters;
+    LookupCounters program_counters;
+    const filter_expr::FieldResolvers resolvers{
+        .typeQuery = [&](const nt::RawHandle& handle) -> std::expected<std::string, nt::Error> {
+            ++program_counters.types;
+            return std::string(snapshot.rows[handle.handleValue].handleType);
+        },
+        .nameQuery = [&](const nt::RawHandle& handle) -> std::expected<std::string, nt::Error> {
+            ++program_counters.names;
+            return std::string(snapshot.rows[handle.handleValue].objectName);
+        },
+        .processName = {}
+    };
+
+    struct Case {
+        std::string_view label;
+        std::string_view expression;
+        // The equivalent filter as the virtual design would express it, in the
+        // order the user wrote it.
+        std::function<VirtualFilterPtr()> build_virtual;
+    };
+
+    const auto type_filter = [&](std::string target) { return new VirtualTypeFilter(snapshot, virtual_counters, std::move(target)); };
+    const auto name_filter = [&](std::string target) { return new VirtualNameFilter(snapshot, virtual_counters, std::move(target)); };
+
+    const std::vector<Case> cases{
+        {"-t File -o pipe", "type=File and name~pipe", [&] {
+            return VirtualFilterPtr(new VirtualAllOf(make_filters(type_filter("File"), name_filter("pipe"))));
+        }},
+        {"name first, pid decides", "name~pipe and type=File and pid=8", [&] {
+            return VirtualFilterPtr(new VirtualAllOf(make_filters(name_filter("pipe"), type_filter("File"), new VirtualPidFilter(8))));
+        }},
+        {"(type and name) or pid in {4,8}", "(type=File and name~pipe) or pid in {4,8}", [&] {
+            return VirtualFilterPtr(new VirtualAnyOf(make_filters(
+                new VirtualAllOf(make_filters(type_filter("File"), name_filter("pipe"))),
+                new VirtualAnyOf(make_filters(new VirtualPidFilter(4), new VirtualPidFilter(8))))));
+        }},
+    };
+
+    for (const Case& bench_case : cases) {
+        virtual_counters = {};
+        program_counters = {};
+
+        const VirtualFilterPtr chain = bench_case.build_virtual();
+        auto start = Clock::now();
+        std::size_t virtual_matches = 0;
+        for (const nt::RawHandle& handle : handles) {
+            virtual_matches += chain->match(handle) ? 1 : 0;
+        }
+        const double virtual_ms = elapsed_ms(start);
+
+        const auto program = filter_expr::FilterProgram::compile(*filter_expr::parse(bench_case.expression));
+        start = Clock::now();
+        std::size_t program_matches = 0;
+        for (const nt::RawHandle& handle : handles) {
+            program_matches += program.matches(handle, resolvers) ? 1 : 0;
+        }
+        const double program_ms = elapsed_ms(start);
+
+        std::cout << "  case: " << bench_case.label << (virtual_matches == program_matches ? "" : "  (MISMATCH)") << "\n";
+        print_line("  virtual chain", virtual_ms, "ms");
+        print_line("  virtual chain lookups (type+name)", static_cast<double>(virtual_counters.types + virtual_counters.names), "");
+        print_line("  compiled program", program_ms, "ms");
+        print_line("  compiled program lookups (type+name)", static_cast<double>(program_counters.types + program_counters.names), "");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section: parallel (--count -o foo over the raw array, 1..N filter threads)
+// ---------------------------------------------------------------------------
+
+// CPU-bound stand-in for the NtQueryObject round trip (a few microseconds of
+// kernel work per handle); the result depends on the work so it is not elided.
+[[nodiscard]] std::string simulated_name_query(const SyntheticRow& row) {
+    std::uint64_t state = row.objectAddress;
+    for (int i = 0; i < 2'000; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    std::string name(row.objectName);
+    if (state == 0) {
+        name.push_back('?');
+    }
+    return name;
+}
+
+void bench_parallel(const SyntheticSnapshot& snapshot) {
+    std::cout << "[parallel] rows=" << snapshot.rows.size()
+              << " hardware_threads=" << std::thread::hardware_concurrency() << "\n";
+    const std::vector<nt::RawHandle> handles = make_raw_handles(snapshot);
+
+    const filter_expr::FieldResolvers resolvers{
+        .typeQuery = {},
+        .nameQuery = [&](const nt::RawHandle& handle) -> std::expected<std::string, nt::Error> {
+            return simulated_name_query(snapshot.rows[handle.handleValue]);
+        },
+        .processName = {}
+    };
+    const auto program = filter_expr::FilterProgram::compile(*filter_expr::parse("name~pipe"));
+    const parallel::HandlePredicate matches = [&](const nt::RawHandle& handle) {
+        return program.matches(handle, resolvers);
+    };
+
+    double serial_ms = 0.0;
+    const std::size_t max_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        const auto start = Clock::now();
+        const std::size_t matched = parallel::count(handles, matches, {.threads = threads});
+        const double ms = elapsed_ms(start);
+        if (threads == 1) {
+            serial_ms = ms;
+        }
+        print_line(std::format("count, {} thread(s)", threads), ms, std::format("ms ({} matches)", matched));
+        print_line(std::format("speedup, {} thread(s)", threads), serial_ms / ms, "x");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section: shared (--shared-objects grouping vs sort-and-scan)
+// ---------------------------------------------------------------------------
+
+// The same report built by sorting a copy of the table on (address, pid),
+// scanning runs and ordering the qualifying groups.
+[[nodiscard]] std::size_t shared_by_sorting(std::vector<nt::RawHandle> handles, const std::size_t min_processes) {
+    std::ranges::sort(handles, [](const nt::RawHandle& left, const nt::RawHandle& right) {
+        return std::tie(left.objectAddress, left.processId) < std::tie(right.objectAddress, right.processId);
+    });
+
+    std::vector<shared_objects::Group> groups;
+    for (std::size_t begin = 0; begin < handles.size();) {
+        std::size_t end = begin;
+        std::size_t processes = 0;
+        while (end < handles.size() && handles[end].objectAddress == handles[begin].objectAddress) {
+            processes += (end == begin || handles[end].processId != handles[end - 1].processId) ? 1 : 0;
+            ++end;
+        }
+        if (processes >= min_processes) {
+            groups.push_back(shared_objects::Group{
+                .objectAddress = handles[begin].objectAddress,
+                .objectTypeIndex = handles[begin].objectTypeIndex,
+                .processCount = processes,
+                .firstHandle = begin,
+                .handleCount = end - begin
+            });
+        }
+        begin = end;
+    }
+
+    std::ranges::sort(groups, [](const shared_objects::Group& left, const shared_objects::Group& right) {
+        return std::tie(right.processCount, right.handleCount, left.objectAddress) <
+               std::tie(left.processCount, left.handleCount, right.objectAddress);
+    });
+    return groups.size();
+}
+
+void bench_shared(const SyntheticSnapshot& snapshot) {
+    std::cout << "[shared] rows=" << snapshot.rows.size() << "\n";
+    const std::vector<nt::RawHandle> handles = make_raw_handles(snapshot);
+
+    for (const std::size_t min_processes : {2, 4}) {
+        auto start = Clock::now();
+        const std::size_t sorted_groups = shared_by_sorting(handles, min_processes);
+        const double sort_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        const std::size_t hashed_groups = shared_objects::find(handles, min_processes).groups.size();
+        const double hash_ms = elapsed_ms(start);
+
+        std::cout << "  min processes: " << min_processes << ", groups: " << hashed_groups
+                  << (sorted_groups == hashed_groups ? "" : "  (MISMATCH)") << "\n";
+        print_line("  sort + scan (copy)", sort_ms, "ms");
+        print_line("  hash grouping", hash_ms, "ms");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section: history (delta-compressed frames vs full snapshots)
+// ---------------------------------------------------------------------------
+
+// Appends `frames` snapshots with ~1% churn per frame (half closed, half
+// opened) and returns the file size.
+std::uint64_t write_history(const std::filesystem::path& path,
+                            const SyntheticSnapshot& snapshot,
+                            const std::size_t rows,
+                            const std::size_t frames,
+                            const history::WriterOptions options,
+                            double& append_ms,
+                            std::uint64_t& flat_bytes) {
+    std::filesystem::remove(path);
+    auto writer = history::HistoryWriter::open(path, options);
+    if (!writer) {
+        std::cerr << writer.error() << "\n";
+        return 0;
+    }
+
+    const auto to_record = [&](const SyntheticRow& row, const std::uint64_t handle_value) {
+        return history::Record{
+            .pid = row.pid,
+            .handleValue = handle_value,
+            .objectAddress = row.objectAddress,
+            .grantedAccess = row.grantedAccess,
+            .objectTypeIndex = row.objectTypeIndex,
+            .processName = writer->intern(row.processName),
+            .handleType = writer->intern(row.handleType),
+            .objectName = writer->intern(row.objectName)
+        };
+    };
+
+    // Flat size of each row: fixed fields plus its three strings, as a plain
+    // per-snapshot dump would store them.
+    const auto flat_size = [](const SyntheticRow& row) {
+        return 26 + row.processName.size() + row.handleType.size() + row.objectName.size();
+    };
+
+    std::vector<history::Record> state;
+    std::vector<std::size_t> state_bytes;
+    state.reserve(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        state.push_back(to_record(snapshot.rows[i], snapshot.rows[i].handleValue + (i / 65'536) * 0x40000));
+        state_bytes.push_back(flat_size(snapshot.rows[i]));
+    }
+
+    Rng rng(frames);
+    std::uint64_t next_handle = 0x100000;
+    append_ms = 0;
+    flat_bytes = 0;
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        if (frame > 0) {
+            const std::size_t churn = std::max<std::size_t>(rows / 200, 1);
+            for (std::size_t i = 0; i < churn; ++i) {
+                const std::size_t closed = rng.below(state.size());
+                state[closed] = state.back();
+                state_bytes[closed] = state_bytes.back();
+                const SyntheticRow& opened = snapshot.rows[rng.below(snapshot.rows.size())];
+                state.back() = to_record(opened, next_handle += 4);
+                state_bytes.back() = flat_size(opened);
+            }
+        }
+        for (const std::size_t bytes : state_bytes) {
+            flat_bytes += bytes;
+        }
+
+        const auto start = Clock::now();
+        const auto stats = writer->append(static_cast<std::int64_t>(1'000'000 + frame * 1000), state);
+        append_ms += elapsed_ms(start);
+        if (!stats) {
+            std::cerr << stats.error() << "\n";
+            return 0;
+        }
+    }
+    return std::filesystem::file_size(path);
+}
+
+void bench_history(const SyntheticSnapshot& snapshot) {
+    const std::size_t rows = std::min<std::size_t>(snapshot.rows.size(), 100'000);
+    constexpr std::size_t kFrames = 120;
+    std::cout << "[history] rows=" << rows << " frames=" << kFrames << " churn=1%/frame\n";
+
+    const auto path = std::filesystem::temp_directory_path() / "handle_bench_history.bin";
+    double delta_append_ms = 0;
+    double keyframe_append_ms = 0;
+    std::uint64_t flat_bytes = 0;
+    const std::uint64_t keyframe_bytes =
+        write_history(path, snapshot, rows, kFrames, history::WriterOptions{.keyframeInterval = 1}, keyframe_append_ms, flat_bytes);
+    const std::uint64_t delta_bytes =
+        write_history(path, snapshot, rows, kFrames, history::WriterOptions{}, delta_append_ms, flat_bytes);
+
+    print_line("flat snapshots", static_cast<double>(flat_bytes) / 1e6, "MB");
+    print_line("keyframes only", static_cast<double>(keyframe_bytes) / 1e6, "MB");
+    print_line("keyframe every 60 + deltas", static_cast<double>(delta_bytes) / 1e6, "MB");
+    print_line("compression vs flat", static_cast<double>(flat_bytes) / static_cast<double>(delta_bytes), "x");
+    print_line("append, keyframes only", keyframe_append_ms / kFrames, "ms/frame");
+    print_line("append, deltas", delta_append_ms / kFrames, "ms/frame");
+
+    auto reader = history::HistoryReader::open(path);
+    if (!reader) {
+        std::cerr << reader.error() << "\n";
+        return;
+    }
+    const std::uint64_t address = snapshot.rows[rows / 2].objectAddress;
+    const std::int64_t last = reader->frames().back().timestampMs;
+
+    auto start = Clock::now();
+    const auto all = reader->holders_of(address, 0, last);
+    print_line("holders_of, whole history", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    const auto window = reader->holders_of(address, last - 5000, last - 2000);
+    print_line("holders_of, 3 s window", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    const auto state = reader->snapshot_at(last);
+    print_line("snapshot_at, last frame", elapsed_ms(start), "ms");
+    std::cout << "  holders: " << (all ? all->size() : 0) << " / " << (window ? window->size() : 0)
+              << ", last snapshot rows: " << (state ? state->size() : 0) << "\n";
+
+    std::filesystem::remove(path);
+}
+
+// ---------------------------------------------------------------------------
+// Section: top (full sort vs bounded heap for --top N)
+// ---------------------------------------------------------------------------
+
+void bench_top(const SyntheticSnapshot& snapshot) {
+    std::cout << "[top] rows=" << snapshot.rows.size() << "\n";
+
+    StringInterner strings;
+    std::vector<HandleInfo> rows;
+    rows.reserve(snapshot.rows.size());
+    for (const SyntheticRow& row : snapshot.rows) {
+        rows.push_back(HandleInfo{
+            .pid = row.pid,
+            .handleType = strings.intern(row.handleType),
+            .objectName = strings.intern(row.objectName),
+            .handleValue = row.handleValue
+        });
+    }
+
+    // Ranks are built once up front so the sort is timed alone.
+    strings.build_sort_ranks();
+    for (const std::size_t limit : {20, 1000}) {
+        std::vector<HandleInfo> sorted = rows;
+        auto start = Clock::now();
+        sorting::sort_handles(sorted, SortField::Name, strings);
+        const double sort_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        sorting::TopRows top(limit, rows.size(), SortField::Name, strings);
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            top.offer(rows[i], i);
+        }
+        const std::vector<sorting::TopRows::Entry> kept = top.take_sorted();
+        const double heap_ms = elapsed_ms(start);
+
+        const bool same = std::ranges::equal(kept, std::span(sorted).first(kept.size()),
+            [](const sorting::TopRows::Entry& entry, const HandleInfo& row) { return entry.row.handleValue == row.handleValue && entry.row.pid == row.pid; });
+        std::cout << "  top " << limit << " by name" << (same ? "" : "  (MISMATCH)") << "\n";
+        print_line("  full sort", sort_ms, "ms");
+        print_line("  bounded heap", heap_ms, "ms");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section: output (inline writes vs background writer on a slow disk)
+// ---------------------------------------------------------------------------
+
+// Simulated slow disk: sleeps as if writing at `bytes_per_second`.
+class ThrottledBackend final : public output::WriteBackend {
+public:
+    explicit ThrottledBackend(const double bytes_per_second) : m_bytes_per_second(bytes_per_second) {}
+
+    std::expected<void, std::string> write_batch(const std::span<const std::span<const char>> buffers) override {
+        std::size_t bytes = 0;
+        for (const std::span<const char> buffer : buffers) {
+            bytes += buffer.size();
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(static_cast<double>(bytes) / m_bytes_per_second));
+        return {};
+    }
+
+    std::string_view name() const noexcept override { return "throttled"; }
+
+private:
+    double m_bytes_per_second;
+};
+
+// Formats rows the way HandlePrinter does, one line per row.
+void format_rows(const SyntheticSnapshot& snapshot, std::ostream& out) {
+    std::string line;
+    for (const SyntheticRow& row : snapshot.rows) {
+        line.clear();
+        std::format_to(std::back_inserter(line), "{:<8} {:<15} 0x{:<8X} {:<24} {}\n",
+                       row.pid, row.processName, row.handleValue, row.handleType, row.objectName);
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+}
+
+// Same stream interface, but each full buffer is written on the calling thread.
+class InlineBuffer final : public std::streambuf {
+public:
+    explicit InlineBuffer(output::WriteBackend& backend) : m_backend(backend), m_buffer(256 * 1024) {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+    void flush_buffer() {
+        const std::span<const char> pending(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+        if (!pending.empty()) {
+            (void)m_backend.write_batch(std::span(&pending, 1));
+        }
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+protected:
+    int_type overflow(const int_type ch) override {
+        flush_buffer();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    output::WriteBackend& m_backend;
+    std::vector<char> m_buffer;
+};
+
+void bench_output(const SyntheticSnapshot& snapshot) {
+    constexpr double kDiskBytesPerSecond = 100.0 * 1024 * 1024;
+    std::cout << "[output] rows=" << snapshot.rows.size() << ", simulated disk: 100 MB/s\n";
+
+    ThrottledBackend inline_disk(kDiskBytesPerSecond);
+    InlineBuffer inline_buffer(inline_disk);
+    std::ostream inline_stream(&inline_buffer);
+    auto start = Clock::now();
+    format_rows(snapshot, inline_stream);
+    inline_buffer.flush_buffer();
+    print_line("inline writes (total)", elapsed_ms(start), "ms");
+
+    for (const std::size_t buffers : {2, 8}) {
+        output::AsyncWriter writer(std::make_unique<ThrottledBackend>(kDiskBytesPerSecond),
+                                   {.bufferBytes = 256 * 1024, .bufferCount = buffers});
+        std::ostream stream(&writer);
+        start = Clock::now();
+        format_rows(snapshot, stream);
+        const double formatted_ms = elapsed_ms(start);
+        (void)writer.close();
+        const double total_ms = elapsed_ms(start);
+        const output::WriterStats stats = writer.stats();
+
+        std::cout << "  background writer, " << buffers << " buffers (" << stats.bytes / (1024 * 1024) << " MB, "
+                  << stats.batches << " batches, " << stats.producerWaits << " producer waits)\n";
+        print_line("  formatting done", formatted_ms, "ms");
+        print_line("  total incl. drain", total_ms, "ms");
+    }
+
+    // Formatting alone bounds what any writer can achieve.
+    output::AsyncWriter unthrottled(std::make_unique<ThrottledBackend>(1e15));
+    std::ostream stream(&unthrottled);
+    start = Clock::now();
+    format_rows(snapshot, stream);
+    (void)unthrottled.close();
+    print_line("formatting only (no disk)", elapsed_ms(start), "ms");
+}
+
+// ---------------------------------------------------------------------------
+// Section: metrics (--openmetrics counting and rendering over the raw array)
+// ---------------------------------------------------------------------------
+
+void bench_metrics(const SyntheticSnapshot& snapshot) {
+    std::cout << "[metrics] rows=" << snapshot.rows.size() << "\n";
+    const std::vector<nt::RawHandle> handles = make_raw_handles(snapshot);
+
+    auto start = Clock::now();
+    const metrics::Summary summary = metrics::summarize(handles, metrics::kDefaultTopK);
+    print_line("count per process and type", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    const std::string text = metrics::render(summary, handles.size(), metrics::Labels{
+        .processName = [](std::uint32_t) { return std::string_view("process.exe"); },
+        .typeName = [](const metrics::TypeCount&) { return std::string_view("File"); }
+    });
+    print_line("render exposition", elapsed_ms(start), "ms");
+    std::cout << "  " << summary.processes << " processes, " << summary.types << " types -> "
+              << text.size() << " bytes\n";
+}
+
+// ---------------------------------------------------------------------------
+// Section: sketch (--sketch updates against exact counting)
+// ---------------------------------------------------------------------------
+
+void bench_sketch(const SyntheticSnapshot& snapshot) {
+    std::cout << "[sketch] rows=" << snapshot.rows.size() << "\n";
+
+    auto start = Clock::now();
+    sketch::SketchSet sketches;
+    std::unordered_map<std::uint16_t, sketch::HyperLogLog*> by_type;
+    std::unordered_map<std::uint32_t, sketch::HyperLogLog*> by_process;
+    for (const SyntheticRow& row : snapshot.rows) {
+        const std::uint64_t object = sketch::hash_u64(row.objectAddress);
+        sketches.objects.add_hash(object);
+        auto type_it = by_type.find(row.objectTypeIndex);
+        if (type_it == by_type.end()) {
+            type_it = by_type.emplace(row.objectTypeIndex, &sketches.objectsByType.counter(row.handleType)).first;
+        }
+        type_it->second->add_hash(object);
+        auto process_it = by_process.find(row.pid);
+        if (process_it == by_process.end()) {
+            process_it = by_process.emplace(row.pid, &sketches.objectsByProcess.counter(row.processName)).first;
+        }
+        process_it->second->add_hash(object);
+        if (!row.objectName.empty()) {
+            sketches.names.add(row.objectName);
+        }
+    }
+    print_line("sketch update", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    std::unordered_set<std::uintptr_t> objects;
+    std::unordered_map<std::string_view, std::size_t> names;
+    for (const SyntheticRow& row : snapshot.rows) {
+        objects.insert(row.objectAddress);
+        if (!row.objectName.empty()) {
+            ++names[row.objectName];
+        }
+    }
+    print_line("exact objects and name counts", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    const codec::Bytes bytes = sketch::serialize(sketches);
+    print_line("serialize", elapsed_ms(start), "ms");
+    const auto heaviest = std::ranges::max_element(names, {}, [](const auto& entry) { return entry.second; });
+    std::cout << "  distinct objects " << objects.size() << " exact, " << static_cast<std::size_t>(sketches.objects.estimate())
+              << " estimated; heaviest name " << heaviest->second << " exact, " << sketches.names.top().front().count
+              << " estimated; " << bytes.size() << " bytes serialized\n";
+}
+
+// ---------------------------------------------------------------------------
+// Section: latency (--latency / --slow-log recording overhead per NT call)
+// ---------------------------------------------------------------------------
+
+void bench_latency(const SyntheticSnapshot& snapshot) {
+    std::cout << "[latency] rows=" << snapshot.rows.size() << "\n";
+    latency::Recorder& recorder = latency::recorder();
+    const auto time_calls = [&](const std::string_view label, const std::size_t threads) {
+        const auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&snapshot, t, threads] {
+                for (std::size_t i = t; i < snapshot.rows.size(); i += threads) {
+                    const SyntheticRow& row = snapshot.rows[i];
+                    const latency::ScopedTimer timer(latency::Call::NameQuery, row.pid, row.objectTypeIndex, row.grantedAccess,
+                                                     row.handleValue);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        const double ms = elapsed_ms(start);
+        print_line(label, ms * 1e6 / static_cast<double>(snapshot.rows.size()), "ns/call");
+    };
+
+    recorder.disable();
+    time_calls("timer, recording disabled", 1);
+    recorder.enable(std::chrono::milliseconds(100));
+    time_calls("timer + record, 1 thread", 1);
+    recorder.enable(std::chrono::milliseconds(100));
+    time_calls("timer + record, 8 threads", 8);
+    const auto calls = recorder.summarize(latency::kDefaultKeys);
+    recorder.disable();
+    if (!calls.empty()) {
+        std::cout << "  " << calls[0].count << " calls, " << calls[0].byType.size() << "+" << calls[0].byProcess.size()
+                  << " keyed histograms shown, p99 " << calls[0].p99 << " ns\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section: pids (per-handle process name lookup: hash map vs PidTable)
+// ---------------------------------------------------------------------------
+
+void bench_pids(const SyntheticSnapshot& snapshot) {
+    std::cout << "[pids] rows=" << snapshot.rows.size() << "\n";
+    StringInterner strings;
+    std::vector<StringId> process_ids(snapshot.processNames.size());
+    for (std::size_t i = 0; i < snapshot.processNames.size(); ++i) {
+        process_ids[i] = strings.intern(snapshot.processNames[i]);
+    }
+    const auto resolve = [&](const std::uint32_t pid) { return process_ids[pid / 4 - 1]; };
+
+    // The old path: collect unique pids in a set, fill the map, then one
+    // hash lookup per row.
+    std::uint64_t checksum = 0;
+    auto start = Clock::now();
+    std::unordered_map<std::uint32_t, StringId> map;
+    map.reserve(snapshot.rows.size());
+    std::unordered_set<std::uint32_t> unique_pids;
+    unique_pids.reserve(snapshot.rows.size());
+    for (const SyntheticRow& row : snapshot.rows) {
+        unique_pids.insert(row.pid);
+    }
+    for (const std::uint32_t pid : unique_pids) {
+        map.emplace(pid, resolve(pid));
+    }
+    for (const SyntheticRow& row : snapshot.rows) {
+        checksum += map.find(row.pid)->second;
+    }
+    print_line("unordered_set + unordered_map", elapsed_ms(start), "ms");
+
+    std::uint64_t table_checksum = 0;
+    start = Clock::now();
+    PidTable table;
+    for (const SyntheticRow& row : snapshot.rows) {
+        auto entry = table.find(row.pid);
+        if (!entry) {
+            const StringId id = resolve(row.pid);
+            entry = table.publish(row.pid, PidTable::Entry{.id = id, .name = strings.view(id)});
+        }
+        table_checksum += entry->id;
+    }
+    print_line("PidTable", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    std::vector<std::thread> readers;
+    std::atomic<std::uint64_t> parallel_checksum{0};
+    for (std::size_t t = 0; t < 8; ++t) {
+        readers.emplace_back([&, t] {
+            std::uint64_t local = 0;
+            const std::size_t begin = snapshot.rows.size() * t / 8;
+            const std::size_t end = snapshot.rows.size() * (t + 1) / 8;
+            for (std::size_t i = begin; i < end; ++i) {
+                local += table.find(snapshot.rows[i].pid)->id;
+            }
+            parallel_checksum.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    print_line("PidTable, 8 lock-free readers", elapsed_ms(start), "ms");
+    std::cout << "  " << table.size() << " pids in " << table.chunk_count() << " chunk(s), checksums "
+              << (checksum == table_checksum && checksum == parallel_checksum.load() ? "match" : "DIFFER") << "\n";
+}
+
+// ---------------------------------------------------------------------------
+// Section: pipeline (eager select + map vs the lazy generator stages, --limit)
+// ---------------------------------------------------------------------------
+
+void bench_pipeline(const SyntheticSnapshot& snapshot) {
+    std::cout << "[pipeline] rows=" << snapshot.rows.size() << "\n";
+    const std::vector<nt::RawHandle> handles = make_raw_handles(snapshot);
+    // -o module: a simulated name query per tested handle.
+    const parallel::HandlePredicate named_module = [&snapshot](const nt::RawHandle& handle) {
+        return simulated_name_query(snapshot.rows[handle.handleValue]).find("module") != std::string::npos;
+    };
+    const parallel::HandlePredicate cheap = [](const nt::RawHandle& handle) { return handle.processId % 3 == 0; };
+    const auto resolve = [](const nt::RawHandle& handle) {
+        return HandleInfo{.pid = static_cast<std::uint32_t>(handle.processId), .handleValue = handle.handleValue};
+    };
+
+    auto start = Clock::now();
+    std::size_t eager_rows = 0;
+    for (const nt::RawHandle& handle : parallel::select(handles, cheap, {.threads = 1})) {
+        eager_rows += resolve(handle).pid != 0 ? 1 : 0;
+    }
+    print_line("eager select + map, all rows", elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    std::size_t lazy_rows = 0;
+    for (const HandleInfo& row : pipeline::resolve(pipeline::filter(pipeline::acquire(handles), cheap, {.threads = 1}), resolve)) {
+        lazy_rows += row.pid != 0 ? 1 : 0;
+    }
+    print_line("lazy stages, all rows", elapsed_ms(start), "ms");
+
+    // The first ten matches of an expensive filter (--limit 10 -o module).
+    const std::size_t sample_rows = std::min<std::size_t>(handles.size(), 50'000);
+    const std::vector<nt::RawHandle> sample(handles.begin(), handles.begin() + static_cast<std::ptrdiff_t>(sample_rows));
+    start = Clock::now();
+    const std::vector<nt::RawHandle> all_matches = parallel::select(sample, named_module);
+    print_line(std::format("eager filter, first {} rows", sample_rows), elapsed_ms(start), "ms");
+
+    start = Clock::now();
+    std::size_t kept = 0;
+    for ([[maybe_unused]] const nt::RawHandle& handle : pipeline::filter(pipeline::acquire(sample), named_module)) {
+        if (++kept == 10) {
+            break;
+        }
+    }
+    print_line("lazy filter, --limit 10", elapsed_ms(start), "ms");
+    std::cout << "  " << all_matches.size() << " matches in the first " << sample_rows << " rows"
+              << (eager_rows == lazy_rows ? "" : "  (MISMATCH)") << "\n";
+}
+
+// ---------------------------------------------------------------------------
+// Section: names (adaptive per-type name query skipping vs querying every row)
+// ---------------------------------------------------------------------------
+
+void bench_names(const SyntheticSnapshot& snapshot) {
+    std::cout << "[names] rows=" << snapshot.rows.size() << "\n";
+    // Only these types carry their row's name; the rest always come back empty.
+    const auto has_names = [](const std::string_view type) {
+        return type == "File" || type == "Key" || type == "Section" || type == "ALPC Port" || type == "Directory";
+    };
+    const std::size_t rows = std::min<std::size_t>(snapshot.rows.size(), 200'000);
+
+    const auto dump = [&](const bool adaptive) {
+        NameSkipPolicy policy;
+        std::size_t queries = 0;
+        std::size_t named = 0;
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < rows; ++i) {
+            const SyntheticRow& row = snapshot.rows[i];
+            if (adaptive && !policy.should_query(row.objectTypeIndex)) {
+                continue;
+            }
+            const auto query_start = Clock::now();
+            // Unnamed objects cost the same round trip to find out.
+            std::string name = simulated_name_query(row);
+            if (!has_names(row.handleType)) {
+                name.clear();
+            }
+            ++queries;
+            named += name.empty() ? 0 : 1;
+            policy.record(row.objectTypeIndex, !name.empty(), Clock::now() - query_start);
+        }
+        const double ms = elapsed_ms(start);
+        print_line(adaptive ? "adaptive skip" : "every row", ms, "ms");
+        std::cout << "    " << queries << " name queries, " << named << " names, " << policy.skipped_count() << " skipped\n";
+    };
+    dump(false);
+    dump(true);
+}
+
+// ---------------------------------------------------------------------------
+// Section: utf16 (vectorized vs scalar UTF-16 to UTF-8)
+// ---------------------------------------------------------------------------
+
+void bench_utf16(const SyntheticSnapshot& snapshot) {
+    std::cout << "[utf16] rows=" << snapshot.rows.size() << "\n";
+    // Object names as NtQueryObject returns them. The mixed set gives every
+    // eighth name accented, CJK and supplementary characters.
+    std::vector<std::u16string> ascii;
+    std::vector<std::u16string> mixed;
+    ascii.reserve(snapshot.objectNames.size());
+    mixed.reserve(snapshot.objectNames.size());
+    for (std::size_t i = 0; i < snapshot.objectNames.size(); ++i) {
+        const std::string& name = snapshot.objectNames[i];
+        ascii.emplace_back(name.begin(), name.end());
+        mixed.push_back(ascii.back());
+        if (i % 8 == 0) {
+            mixed.back().insert(mixed.back().size() / 2, u"_r\u00E9sum\u00E9_\u65E5\u672C_\U0001F600");
+        }
+    }
+
+    std::unordered_map<const char*, std::size_t> name_index;
+    for (std::size_t i = 0; i < snapshot.objectNames.size(); ++i) {
+        name_index.emplace(snapshot.objectNames[i].data(), i);
+    }
+    std::vector<std::size_t> row_names;
+    row_names.reserve(snapshot.rows.size());
+    for (const SyntheticRow& row : snapshot.rows) {
+        row_names.push_back(name_index.at(row.objectName.data()));
+    }
+
+    const auto run = [&](const std::string_view label, const std::vector<std::u16string>& names, auto convert) {
+        std::size_t bytes = 0;
+        const auto start = Clock::now();
+        for (const std::size_t index : row_names) {
+            bytes += convert(names[index]).size();
+        }
+        const double ms = elapsed_ms(start);
+        print_line(label, ms, "ms");
+        return bytes;
+    };
+    const auto measure = [&](const std::string_view set, const std::vector<std::u16string>& names) {
+        const std::size_t scalar = run(std::string(set) + " scalar", names, [](const std::u16string& name) {
+            return utils::utf16_to_utf8_scalar(name);
+        });
+        const std::size_t vector = run(std::string(set) + " vectorized", names, [](const std::u16string& name) {
+            return utils::utf16_to_utf8(name);
+        });
+        std::cout << "    " << vector << " UTF-8 bytes" << (scalar == vector ? "" : " (MISMATCH)") << "\n";
+    };
+    measure("ascii", ascii);
+    measure("mixed", mixed);
+}
+
+// ---------------------------------------------------------------------------
+// Section: allocs (heap allocations per handle in each pipeline stage)
+// ---------------------------------------------------------------------------
+
+void bench_allocs(const SyntheticSnapshot& snapshot) {
+    std::cout << "[allocs] rows=" << snapshot.rows.size() << "\n";
+    const std::vector<nt::RawHandle> handles = make_raw_handles(snapshot);
+    const auto report = [&](const std::string_view label, const alloc::Stage stage, const double ms) {
+        const alloc::Counts counts = alloc::counts(stage);
+        const double rows = static_cast<double>(std::max<std::size_t>(handles.size(), 1));
+        print_line(label, ms, "ms");
+        std::cout << std::format("    {:.3f} allocations, {:.1f} bytes per handle\n",
+                                 static_cast<double>(counts.allocations) / rows, static_cast<double>(counts.bytes) / rows);
+    };
+    alloc::enable();
+
+    // Map: intern the resolved strings into rows, as map_to_info does.
+    StringInterner strings;
+    std::vector<HandleInfo> rows;
+    auto start = Clock::now();
+    {
+        const alloc::StageScope stage(alloc::Stage::Map);
+        rows.reserve(snapshot.rows.size());
+        for (const SyntheticRow& row : snapshot.rows) {
+            rows.push_back(HandleInfo{
+                .pid = row.pid,
+                .processName = strings.intern(row.processName),
+                .handleType = strings.intern(row.handleType),
+                .objectName = strings.intern(row.objectName),
+                .grantedAccess = row.grantedAccess,
+                .objectAddress = row.objectAddress,
+                .handleValue = row.handleValue,
+                .objectTypeIndex = row.objectTypeIndex});
+        }
+    }
+    report("map (intern 3 strings)", alloc::Stage::Map, elapsed_ms(start));
+
+    // Filter: a raw-field program over the parallel selection.
+    using filter_expr::CompareOp;
+    using filter_expr::Field;
+    const filter_expr::FilterProgram program = filter_expr::FilterProgram::compile(filter_expr::all_of({
+        filter_expr::make_test(Field::Pid, CompareOp::NotEqual, 4),
+        filter_expr::make_test(Field::Access, CompareOp::HasBits, 0x1)}));
+    const filter_expr::FieldResolvers resolvers;
+    start = Clock::now();
+    const std::vector<nt::RawHandle> selected = [&] {
+        const alloc::StageScope stage(alloc::Stage::Filter);
+        return parallel::select(handles, [&](const nt::RawHandle& handle) { return program.matches(handle, resolvers); },
+                                {.threads = 1});
+    }();
+    report(std::format("filter (pid, access; {} kept)", selected.size()), alloc::Stage::Filter, elapsed_ms(start));
+
+    start = Clock::now();
+    {
+        const alloc::StageScope stage(alloc::Stage::Sort);
+        sorting::sort_handles(rows, SortField::Name, strings);
+    }
+    report("sort by name", alloc::Stage::Sort, elapsed_ms(start));
+
+    const HandlePrinter printer;
+    std::size_t bytes = 0;
+    start = Clock::now();
+    for (const HandleInfo& row : rows) {
+        const alloc::StageScope stage(alloc::Stage::Print);
+        bytes += printer.format_row(row, strings).size();
+    }
+    report("print (format_row)", alloc::Stage::Print, elapsed_ms(start));
+    alloc::disable();
+    std::cout << "    " << bytes << " bytes formatted\n";
+}
+
+// ---------------------------------------------------------------------------
+// Section: merge (k-way merge of per-host snapshot files, parallel decode)
+// ---------------------------------------------------------------------------
+
+void bench_merge(const SyntheticSnapshot& snapshot) {
+    constexpr std::size_t kHosts = 64;
+    std::cout << "[merge] rows=" << snapshot.rows.size() << " hosts=" << kHosts << " sorted by name\n";
+    const auto directory = std::filesystem::temp_directory_path() / "handle_bench_merge";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // Rows dealt round-robin to hosts; each host exports its share sorted.
+    std::uint64_t file_bytes = 0;
+    auto start = Clock::now();
+    for (std::size_t host = 0; host < kHosts; ++host) {
+        StringInterner strings;
+        std::vector<HandleInfo> rows;
+        for (std::size_t i = host; i < snapshot.rows.size(); i += kHosts) {
+            const SyntheticRow& row = snapshot.rows[i];
+            rows.push_back(HandleInfo{
+                .pid = row.pid,
+                .processName = strings.intern(row.processName),
+                .handleType = strings.intern(row.handleType),
+                .objectName = strings.intern(row.objectName),
+                .grantedAccess = row.grantedAccess,
+                .objectAddress = row.objectAddress,
+                .handleValue = row.handleValue,
+                .objectTypeIndex = row.objectTypeIndex});
+        }
+        sorting::sort_handles(rows, SortField::Name, strings);
+        const auto written = fleet::write_snapshot(directory / std::format("host{:02}.snap", host),
+                                                   fleet::SnapshotInfo{.host = std::format("host{:02}", host),
+                                                                       .sortBy = SortField::Name},
+                                                   rows, strings);
+        file_bytes += written.value_or(0);
+    }
+    print_line("export (sort + write, all hosts)", elapsed_ms(start), "ms");
+    print_line("snapshot files", static_cast<double>(file_bytes) / 1e6, "MB");
+
+    const auto paths = fleet::expand_inputs(std::vector<std::string>{directory.string()});
+    const std::size_t hardware = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    for (const std::size_t threads : {std::size_t{1}, hardware}) {
+        auto merger = paths ? fleet::Merger::open(*paths, fleet::MergeOptions{.threads = threads})
+                            : std::unexpected(paths.error());
+        if (!merger) {
+            std::cerr << merger.error() << "\n";
+            break;
+        }
+        std::size_t name_bytes = 0;
+        start = Clock::now();
+        const auto stats = merger->run([&](const fleet::Row& row, std::size_t) { name_bytes += row.objectName.size(); });
+        const double ms = elapsed_ms(start);
+        print_line(std::format("merge, {} decode threads", threads), ms, "ms");
+        if (stats && ms > 0) {
+            std::cout << std::format("    {:.1f} M rows/s, {:.0f} MB/s of snapshot files ({} rows, {} name bytes)\n",
+                                     static_cast<double>(stats->rows) / ms / 1e3,
+                                     static_cast<double>(stats->bytes) / ms / 1e3, stats->rows, name_bytes);
+        }
+    }
+    std::filesystem::remove_all(directory);
+}
+
+struct Section {
+    std::string_view name;
+    std::function<void(const SyntheticSnapshot&)> run;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::string_view selected = argc > 1 ? std::string_view(argv[1]) : std::string_view("all");
+    const std::size_t rows = argc > 2 ? static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10)) : 1'000'000;
+
+    const std::vector<Section> sections{
+        {"interning", bench_interning},
+        {"filters", bench_filters},
+        {"parallel", bench_parallel},
+        {"shared", bench_shared},
+        {"history", bench_history},
+        {"top", bench_top},
+        {"output", bench_output},
+        {"metrics", bench_metrics},
+        {"sketch", bench_sketch},
+        {"latency", bench_latency},
+        {"pids", bench_pids},
+        {"pipeline", bench_pipeline},
+        {"names", bench_names},
+        {"utf16", bench_utf16},
+        {"allocs", bench_allocs},
+        {"merge", bench_merge},
+    };
+
+    const SyntheticSnapshot snapshot = make_snapshot(rows);
+    bool ran = false;
+    for (const Section& section : sections) {
+        if (selected == "all" || selected == section.name) {
+            section.run(snapshot);
+            ran = true;
+        }
+    }
+
+    if (!ran) {
+        std::cerr << "Unknown section: " << selected << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Opt-in heap allocation accounting by pipeline stage (--stats). Linking
+// alloc_tracker.cpp replaces the global operator new and delete with counted
+// versions; until enable() they cost one relaxed load each.
+namespace alloc {
+
+// Pipeline stages allocations are attributed to.
+enum class Stage : std::uint8_t {
+    // Outside any StageScope, including helper threads (name resolver
+    // workers, the output writer) that never enter one.
+    Other,
+    Acquire,
+    Filter,
+    Map,
+    Sort,
+    Print
+};
+
+inline constexpr std::size_t kStageCount = 6;
+
+[[nodiscard]] std::string_view stage_name(Stage stage) noexcept;
+
+struct Counts {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t frees = 0;
+};
+
+// Clears every counter and starts counting.
+void enable() noexcept;
+void disable() noexcept;
+[[nodiscard]] bool enabled() noexcept;
+
+// Since the last enable(). Aligned (over-aligned type) allocations are not counted.
+[[nodiscard]] Counts counts(Stage stage) noexcept;
+[[nodiscard]] std::array<Counts, kStageCount> all_counts() noexcept;
+
+/**
+ * @brief Attributes this thread's allocations to `stage` until destroyed.
+ *
+ * The stage is thread-local, so parallel filter workers each enter their own
+ * scope and never race on a shared one. Scopes nest; the previous stage is
+ * restored on exit. While counting is disabled a scope does nothing.
+ */
+class StageScope {
+public:
+    explicit StageScope(Stage stage) noexcept;
+    ~StageScope();
+
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+private:
+    Stage m_previous = Stage::Other;
+    bool m_active = false;
+};
+
+} // namespace alloc
@@ -1,9 +1,20 @@
 #pragma once
 
-#include "filters.hpp"
+#include "filter_expr.hpp"
+#include "generation_cache.hpp"
+#include "name_policy.hpp"
+#include "name_resolver.hpp"
+#include "pid_table.hpp"
+#include "progressive.hpp"
+#include "sampling.hpp"
+#include "string_interner.hpp"
 #include "types.hpp"
 
+#include <chrono>
+#include <expected>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -15,11 +26,135 @@ public:
     int run(int argc, char* argv[]);
 
 private:
+    // Everything after argument parsing; run() wraps it for --output.
+    int execute(const Parser& options);
+    // Which resolved HandleInfo fields the current run has to materialize.
+    struct FieldPlan {
+        bool processName = true;
+        bool handleType = true;
+        bool objectName = true;
+    };
+
+    [[nodiscard]] static FieldPlan plan_fields(const Parser& options);
     [[nodiscard]] HandleInfo map_to_info(const nt::RawHandle& raw_handle);
-    const std::string& get_cached_process_name(uint32_t pid);
-    static void sort_handles(std::vector<HandleInfo>& handles, SortField sort_by);
-    void build_filters(const Parser& parsed_args);
+    [[nodiscard]] HandleInfo map_to_info(const nt::RawHandle& raw_handle, const FieldPlan& fields);
+    [[nodiscard]] StringId resolve_type(const nt::RawHandle& raw_handle);
+    [[nodiscard]] StringId resolve_name(const nt::RawHandle& raw_handle);
+    // resolve_name through m_name_policy: types that almost never have a name
+    // are only probed once they have been learned.
+    [[nodiscard]] StringId resolve_name_adaptive(const nt::RawHandle& raw_handle);
+    // Queries the name and teaches m_name_policy the outcome and its cost.
+    [[nodiscard]] StringId resolve_name_recorded(const nt::RawHandle& raw_handle);
+    [[nodiscard]] StringId intern_name(const std::expected<std::string, nt::Error>& name_result);
+    // Type and name queries through the long-lived object cache; safe to call
+    // from filter threads.
+    [[nodiscard]] std::expected<std::string, nt::Error> query_type_cached(const nt::RawHandle& raw_handle);
+    [[nodiscard]] std::expected<std::string, nt::Error> query_name_cached(const nt::RawHandle& raw_handle);
+    StringId get_cached_process_name(uint32_t pid);
+    // Lock-free once the pid is published; safe from parallel filter threads.
+    PidTable::Entry process_name_entry(uint32_t pid);
+    // Queries the system handle table and refreshes the long-lived caches for it.
+    [[nodiscard]] std::expected<std::vector<nt::RawHandle>, std::string> acquire_snapshot();
+    void refresh_caches(std::span<const nt::RawHandle> handles);
+    [[nodiscard]] std::expected<void, std::string> build_filters(const Parser& parsed_args);
+    int report_shared_objects(const Parser& options,
+                              std::span<const nt::RawHandle> handles,
+                              std::size_t total_raw_count);
+    int report_top_rows(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    int report_top_processes(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    // --sample: estimates from the filtered sample with confidence intervals.
+    int report_sample(const Parser& options,
+                      const sampling::Sample& sample,
+                      std::span<const nt::RawHandle> selected,
+                      std::size_t total_raw_count,
+                      uint64_t seed);
+    // OpenMetrics exposition of per-process and per-type counts (--openmetrics).
+    [[nodiscard]] std::string render_metrics(const Parser& options,
+                                             std::span<const nt::RawHandle> handles,
+                                             std::size_t total_raw_count);
+    int export_metrics(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    // Serves --openmetrics-port until the listener fails; every scrape takes a fresh snapshot.
+    int serve_metrics(const Parser& options);
+    // --export: every matching row, fully resolved and sorted, to a snapshot file.
+    int export_snapshot(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    // --merge: streams the merged snapshot files; no NT calls.
+    int merge_snapshots(const Parser& options);
+    // --publish: snapshot, filter and resolve every interval into shared memory
+    // until --publish-count snapshots are out (or forever).
+    int publish_snapshots(const Parser& options);
+    // --sketch: folds the filtered snapshot into the sketch file.
+    int update_sketches(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    // --sketch-merge: offline merge of sketch files, no snapshot.
+    int merge_sketches(const Parser& options);
+    // --deadline phase one: a row from raw fields and cached names only. Fields
+    // that would need an NT call are `unresolved`; names of types the policy
+    // skips are empty, as in a normal listing.
+    [[nodiscard]] HandleInfo map_from_caches(const nt::RawHandle& raw_handle, StringId unresolved);
+    // --deadline: phase one for every match, phase two until the budget runs
+    // out, then the rows and how complete they are.
+    int report_progressive(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    int record_history(const Parser& options, std::span<const nt::RawHandle> handles, std::size_t total_raw_count);
+    int query_history(const Parser& options);
+    // Filters, maps and prints one query against an acquired snapshot;
+    // m_fields and m_filter must already describe `options`.
+    int evaluate(const Parser& options, std::vector<nt::RawHandle> handles, std::size_t total_raw_count);
+    int run_batch(const Parser& options,
+                  std::span<const BatchQuery> queries,
+                  std::span<const nt::RawHandle> handles,
+                  std::size_t total_raw_count);
+    void report_diagnostics(const Parser& options) const;
+    // --latency / --slow-log: stops recording and prints what was recorded.
+    void report_latency(const Parser& options);
+    // --stats: stops counting and prints allocations per stage and per handle.
+    void report_allocations();
+
+    filter_expr::FilterProgram m_filter;
+    filter_expr::FieldResolvers m_filter_resolvers;
+    std::unique_ptr<NameResolver> m_name_resolver;
+    FieldPlan m_fields;
+    // When execute() started; --deadline counts from here.
+    std::chrono::steady_clock::time_point m_run_start;
+    // --stats denominators: handles in the last snapshot, and map_to_info
+    // calls (--top maps its winners twice).
+    std::size_t m_snapshot_handles = 0;
+    std::size_t m_mapped_rows = 0;
+    // Serializes process name misses (interning into m_strings and publishing
+    // into m_process_names) while filters run in parallel; hits take no lock.
+    std::mutex m_process_name_mutex;
+    PidTable m_process_names;
+    StringInterner m_strings;
+
+    // Survive across run() calls (watch, batch); keyed by process instance and
+    // object identity so pid and address reuse never serve stale names.
+    // m_process_cache is guarded by m_process_name_mutex.
+    ProcessCache m_process_cache;
+    std::mutex m_object_cache_mutex;
+    ObjectCache m_object_cache;
+    ProcessCache::RefreshStats m_process_refresh;
+    std::size_t m_objects_evicted = 0;
+
+    // Per-snapshot memo so --batch queries each handle's type and name at
+    // most once however many queries need them. Successful types are already
+    // served per type index by m_object_cache, so only per-handle type
+    // failures are kept. Guarded by m_object_cache_mutex; batch mode only.
+    struct HandleKey {
+        std::uintptr_t pid = 0;
+        std::uintptr_t handleValue = 0;
+        bool operator==(const HandleKey&) const = default;
+    };
+
+    struct HandleKeyHash {
+        [[nodiscard]] std::size_t operator()(const HandleKey& key) const noexcept {
+            return static_cast<std::size_t>((key.pid * 0x9E3779B97F4A7C15ull) ^ key.handleValue);
+        }
+    };
+
+    // Learned per type index, so it survives across run() calls like the
+    // caches above; skip counts are per run. Used from the mapping thread only.
+    NameSkipPolicy m_name_policy;
+    bool m_skip_unnamed_types = false;
 
-    std::vector<std::unique_ptr<IHandleFilter>> m_filters;
-    std::unordered_map<uint32_t, std::string> m_process_name_cache;
+    bool m_memoize_lookups = false;
+    std::unordered_map<HandleKey, nt::Error, HandleKeyHash> m_type_failures;
+    std::unordered_map<HandleKey, std::expected<std::string, nt::Error>, HandleKeyHash> m_name_memo;
 };
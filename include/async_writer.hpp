@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace output {
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring.
+ *
+ * One thread calls try_push, one other thread calls try_pop and
+ * wait_nonempty. Capacity is rounded up to a power of two. Waiting uses
+ * std::atomic::wait on the published index, so neither side takes a lock.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(const std::size_t capacity)
+        : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 1))), m_mask(m_slots.size() - 1) {}
+
+    // Producer only. Returns false (leaving `value` untouched) when full.
+    [[nodiscard]] bool try_push(T& value) {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_tail.notify_one();
+        return true;
+    }
+
+    // Consumer only.
+    [[nodiscard]] std::optional<T> try_pop() {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(m_slots[head & m_mask]));
+        m_head.store(head + 1, std::memory_order_release);
+        m_head.notify_one();
+        return value;
+    }
+
+    // Consumer only: blocks until try_pop would succeed.
+    void wait_nonempty() const {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        for (std::size_t tail = m_tail.load(std::memory_order_acquire); tail == head;
+             tail = m_tail.load(std::memory_order_acquire)) {
+            m_tail.wait(tail, std::memory_order_acquire);
+        }
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_slots.size(); }
+
+private:
+    std::vector<T> m_slots;
+    std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+// Destination of the writer thread. write_batch() gets every buffer that was
+// ready when the thread woke up, in order, and returns once all are written.
+class WriteBackend {
+public:
+    virtual ~WriteBackend() = default;
+    [[nodiscard]] virtual std::expected<void, std::string> write_batch(std::span<const std::span<const char>> buffers) = 0;
+    [[nodiscard]] virtual std::string_view name() const noexcept = 0;
+};
+
+struct WriterOptions {
+    std::size_t bufferBytes = 256 * 1024;
+    // Two is classic double buffering; more lets bursts ride out a slow disk.
+    std::size_t bufferCount = 4;
+    // Linux only: try io_uring before plain write(2).
+    bool allowIoUring = true;
+};
+
+struct WriterStats {
+    std::size_t bytes = 0;
+    std::size_t buffers = 0;
+    // write_batch() calls; fewer than `buffers` when writes were coalesced.
+    std::size_t batches = 0;
+    // Times the producer found every buffer in flight and had to wait.
+    std::size_t producerWaits = 0;
+    std::chrono::nanoseconds producerWaitTime{0};
+};
+
+// Opens `path` for writing (truncating it): io_uring on Linux when the kernel
+// allows it, plain write(2) otherwise, and stdio on other platforms.
+[[nodiscard]] std::expected<std::unique_ptr<WriteBackend>, std::string> open_file_backend(const std::filesystem::path& path,
+                                                                                         bool allowIoUring);
+
+/**
+ * @brief Output stream buffer whose disk writes happen on a dedicated thread.
+ *
+ * The producer (whatever writes to the std::ostream using this buffer)
+ * fills one buffer while the writer thread writes earlier ones. Filled
+ * buffers travel to the writer and empty ones back through two SpscRings, so
+ * the producer waits only when every buffer is queued for disk. sync() hands
+ * the partial buffer over without waiting for the write; close() drains
+ * everything and reports the first write error.
+ */
+class AsyncWriter final : public std::streambuf {
+public:
+    AsyncWriter(std::unique_ptr<WriteBackend> backend, WriterOptions options = {});
+    ~AsyncWriter() override;
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    [[nodiscard]] static std::expected<std::unique_ptr<AsyncWriter>, std::string> open(const std::filesystem::path& path,
+                                                                                       WriterOptions options = {});
+
+    // Flushes, joins the writer thread and returns the first write error.
+    // Later calls return the same result; nothing may be written afterwards.
+    [[nodiscard]] std::expected<void, std::string> close();
+
+    // Final once close() has returned.
+    [[nodiscard]] WriterStats stats() const;
+    [[nodiscard]] std::string_view backend_name() const noexcept { return m_backend->name(); }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        std::size_t size = 0;
+    };
+
+    // Hands the current buffer to the writer and takes a free one.
+    void hand_off();
+    void writer_loop();
+    void fail(std::string message);
+
+    std::unique_ptr<WriteBackend> m_backend;
+    WriterOptions m_options;
+    SpscRing<Buffer> m_filled;
+    SpscRing<Buffer> m_free;
+    Buffer m_current;
+    bool m_closed = false;
+
+    mutable std::mutex m_result_mutex;
+    std::optional<std::string> m_error;
+    std::expected<void, std::string> m_close_result;
+    WriterStats m_stats;
+    std::atomic<std::size_t> m_written_bytes{0};
+    std::atomic<std::size_t> m_written_buffers{0};
+    std::atomic<std::size_t> m_batches{0};
+    std::thread m_thread;
+};
+
+} // namespace output
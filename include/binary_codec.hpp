@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace codec {
+
+using Bytes = std::vector<std::uint8_t>;
+
+// Maps signed deltas to unsigned so small magnitudes stay small varints.
+[[nodiscard]] constexpr std::uint64_t zigzag_encode(const std::int64_t value) noexcept {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+[[nodiscard]] constexpr std::int64_t zigzag_decode(const std::uint64_t value) noexcept {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// Appends little-endian fixed-width and LEB128 varint values to a byte buffer.
+class ByteWriter {
+public:
+    void varint(std::uint64_t value);
+    void zigzag(std::int64_t value) { varint(zigzag_encode(value)); }
+    void fixed32(std::uint32_t value);
+    void fixed64(std::uint64_t value);
+    void bytes(std::span<const std::uint8_t> data);
+    // Length-prefixed string.
+    void string(std::string_view text);
+
+    [[nodiscard]] const Bytes& data() const noexcept { return m_bytes; }
+    [[nodiscard]] Bytes take() noexcept { return std::move(m_bytes); }
+    [[nodiscard]] std::size_t size() const noexcept { return m_bytes.size(); }
+    void clear() noexcept { m_bytes.clear(); }
+
+private:
+    Bytes m_bytes;
+};
+
+/**
+ * @brief Reads values written by ByteWriter from a borrowed buffer.
+ *
+ * Errors are sticky: reading past the end or a malformed varint sets failed()
+ * and every later read returns zero, so decoders check once at the end.
+ */
+class ByteReader {
+public:
+    explicit ByteReader(std::span<const std::uint8_t> data) noexcept : m_data(data) {}
+
+    [[nodiscard]] std::uint64_t varint() noexcept;
+    [[nodiscard]] std::int64_t zigzag() noexcept { return zigzag_decode(varint()); }
+    [[nodiscard]] std::uint32_t fixed32() noexcept;
+    [[nodiscard]] std::uint64_t fixed64() noexcept;
+    // Next `size` bytes, or an empty span (and failed()) if fewer remain.
+    [[nodiscard]] std::span<const std::uint8_t> bytes(std::size_t size) noexcept;
+    [[nodiscard]] std::string_view string() noexcept;
+
+    [[nodiscard]] bool failed() const noexcept { return m_failed; }
+    [[nodiscard]] bool at_end() const noexcept { return m_offset == m_data.size(); }
+    [[nodiscard]] std::size_t offset() const noexcept { return m_offset; }
+
+private:
+    std::span<const std::uint8_t> m_data;
+    std::size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+} // namespace codec
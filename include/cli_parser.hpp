@@ -2,6 +2,8 @@
 #include "types.hpp"
 #include <expected>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace cli {
 
@@ -9,6 +11,16 @@ namespace cli {
 // Returns an error string (or "help") via std::unexpected on invalid input.
 std::expected<CliOptions, std::string> parse(int argc, char* argv[]);
 
+// Splits one query line into arguments on whitespace. Single or double quotes
+// group text containing spaces; there are no escapes, so object names keep
+// their backslashes.
+std::expected<std::vector<std::string>, std::string> split_arguments(std::string_view line);
+
+// Reads a --batch query file: one set of options per line, blank lines and
+// lines starting with '#' skipped. Snapshot-wide options (--batch, --history,
+// --record) are rejected per line; errors name the offending line.
+std::expected<std::vector<BatchQuery>, std::string> load_batch(const std::string& path);
+
 // Prints usage and available options to standard output.
 void print_help();
 
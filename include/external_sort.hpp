@@ -0,0 +1,65 @@
+#pragma once
+
+#include "string_interner.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sorting {
+
+/**
+ * @brief Sorts rows under a memory budget by spilling sorted runs to disk.
+ *
+ * Rows are buffered until the buffer reaches the budget, then sorted and
+ * written to a temp file as a run of varint-encoded rows. finish() k-way
+ * merges the runs and the in-memory tail while streaming rows to the caller;
+ * each run is read back one small block at a time.
+ * Rows keep their StringIds, so the interner must outlive the sorter; the
+ * order is exactly sort_handles' (handle_less is a total order), so output is
+ * identical to the in-memory path.
+ */
+class ExternalSorter {
+public:
+    using Consumer = std::function<void(const HandleInfo&)>;
+
+    ExternalSorter(SortField sort_by,
+                   StringInterner& strings,
+                   std::size_t max_memory_bytes,
+                   std::filesystem::path temp_dir = std::filesystem::temp_directory_path());
+    ~ExternalSorter();
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    [[nodiscard]] std::expected<void, std::string> push(const HandleInfo& row);
+
+    // Streams every pushed row in sorted order; the sorter is empty afterwards.
+    [[nodiscard]] std::expected<void, std::string> finish(const Consumer& consume);
+
+    // Runs and rows written to disk so far (still counted after finish()).
+    [[nodiscard]] std::size_t run_count() const noexcept { return m_run_count; }
+    [[nodiscard]] std::size_t spilled_rows() const noexcept { return m_spilled_rows; }
+    [[nodiscard]] std::size_t buffer_capacity() const noexcept { return m_capacity; }
+
+private:
+    [[nodiscard]] std::expected<void, std::string> spill();
+    void remove_runs() noexcept;
+
+    SortField m_sort_by;
+    StringInterner& m_strings;
+    std::filesystem::path m_temp_dir;
+    std::size_t m_capacity;
+    std::vector<HandleInfo> m_buffer;
+    std::vector<std::filesystem::path> m_runs;
+    std::size_t m_run_count = 0;
+    std::size_t m_spilled_rows = 0;
+    std::uint64_t m_tag;
+};
+
+} // namespace sorting
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace filter_expr {
+
+// Handle attributes a predicate can test. Raw fields come straight from the
+// system handle table; Process, Type and Name need a lookup.
+enum class Field { Pid, Handle, Access, Address, TypeIndex, Process, Type, Name };
+
+enum class CompareOp { Equal, NotEqual, Contains, Less, LessEqual, Greater, GreaterEqual, HasBits, In };
+
+// One `field op value` test. Numeric fields use `numbers`, string fields use
+// `texts` (stored lowercase; string comparisons are ASCII case-insensitive).
+struct Predicate {
+    Field field = Field::Pid;
+    CompareOp op = CompareOp::Equal;
+    std::vector<std::uint64_t> numbers;
+    std::vector<std::string> texts;
+};
+
+// Parsed boolean expression. And/Or hold two or more children, Not holds one.
+struct Node {
+    enum class Kind { Test, And, Or, Not };
+
+    Kind kind = Kind::Test;
+    Predicate predicate;
+    std::vector<Node> children;
+};
+
+/**
+ * @brief Parses a --where expression, e.g.
+ *        `(type=File and name~pipe) or pid in {4,8}`.
+ * @return The expression tree, or a message naming the offending position.
+ */
+[[nodiscard]] std::expected<Node, std::string> parse(std::string_view text);
+
+[[nodiscard]] Node make_test(Field field, CompareOp op, std::uint64_t number);
+[[nodiscard]] Node make_test(Field field, CompareOp op, std::string_view text);
+// Conjunction of the given nodes (a single node is returned unchanged).
+[[nodiscard]] Node all_of(std::vector<Node> nodes);
+
+// Lookups for the fields that are not in RawHandle.
+struct FieldResolvers {
+    nt::ObjectQuery typeQuery;
+    nt::ObjectQuery nameQuery;
+    std::function<std::string_view(uint32_t pid)> processName;
+};
+
+/**
+ * @brief Flat, short-circuiting bytecode for one filter expression.
+ *
+ * compile() pushes negation down to the tests, flattens nested and/or and
+ * orders operands by estimated cost so raw-field tests run before process,
+ * type and name lookups. Each lookup runs at most once per handle, and only if
+ * the cheaper operands could not decide the result.
+ *
+ * A test on a process, type or name that could not be read is unknown, and
+ * unknown never matches: neither `name~x` nor `not name~x` nor `name!=x`
+ * selects a handle whose name lookup failed.
+ */
+class FilterProgram {
+public:
+    // An empty program matches every handle.
+    FilterProgram() = default;
+
+    [[nodiscard]] static FilterProgram compile(Node root);
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool uses(Field field) const noexcept;
+    [[nodiscard]] bool matches(const nt::RawHandle& handle, const FieldResolvers& resolvers) const;
+
+    // Human-readable listing, one instruction per line (for --verbose/tests).
+    [[nodiscard]] std::string disassemble() const;
+
+private:
+    enum class OpCode : std::uint8_t { Test, JumpIfFalse, JumpIfTrue };
+
+    struct Instruction {
+        OpCode code = OpCode::Test;
+        Field field = Field::Pid;
+        CompareOp op = CompareOp::Equal;
+        // Test: inverts the result, but a failed lookup stays false.
+        bool negate = false;
+        // Test: index into m_predicates. Jumps: absolute target.
+        std::uint32_t operand = 0;
+    };
+
+    void emit(const Node& node);
+
+    std::vector<Instruction> m_code;
+    std::vector<Predicate> m_predicates;
+};
+
+} // namespace filter_expr
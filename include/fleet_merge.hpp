@@ -0,0 +1,126 @@
+#pragma once
+
+#include "string_interner.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Snapshot files (--export) and the streaming merge of many of them (--merge).
+//
+// A snapshot file holds one host's filtered snapshot, sorted by one key, with
+// a string table and rows in independently decodable blocks. Merging maps
+// every file, decodes the next block of each on worker threads while the
+// current one is merged, and keeps at most two decoded blocks per file.
+namespace fleet {
+
+// Rows per encoded block; a merge holds two decoded blocks per input file.
+inline constexpr std::size_t kBlockRows = 256;
+
+// File-level metadata written by --export.
+struct SnapshotInfo {
+    std::string host;
+    SortField sortBy = SortField::Pid;
+    // Milliseconds since the Unix epoch (UTC) when the snapshot was taken.
+    std::int64_t takenMs = 0;
+    // Handles in the system table before filtering.
+    std::uint64_t totalRawCount = 0;
+    std::uint64_t rowCount = 0;
+};
+
+// One handle read back from a snapshot file; strings point into the mapped file.
+struct Row {
+    std::uint32_t pid = 0;
+    std::uint64_t handleValue = 0;
+    std::uint64_t objectAddress = 0;
+    std::uint32_t grantedAccess = 0;
+    std::uint32_t handleAttributes = 0;
+    std::uint16_t objectTypeIndex = 0;
+    std::string_view processName;
+    std::string_view handleType;
+    std::string_view objectName;
+};
+
+/**
+ * @brief Writes `rows` as a snapshot file.
+ *
+ * Rows must already be in sort_handles order for info.sortBy; info.rowCount
+ * is ignored. Only the strings the rows use are stored. The file is written
+ * to a temporary name and renamed, so a collector never sees half a file.
+ * @return Bytes written.
+ */
+[[nodiscard]] std::expected<std::uint64_t, std::string> write_snapshot(const std::filesystem::path& path,
+                                                                       const SnapshotInfo& info,
+                                                                       std::span<const HandleInfo> rows,
+                                                                       const StringInterner& strings);
+
+// This computer's name, the default --host; "unknown" if the system has none.
+[[nodiscard]] std::string local_host_name();
+
+// sorting::handle_less on decoded rows: the key, case-insensitively for type
+// and name, then pid and handle value.
+[[nodiscard]] bool row_less(const Row& left, const Row& right, SortField sort_by) noexcept;
+// True if both rows have the same sort key (what --merge --count groups by).
+[[nodiscard]] bool same_key(const Row& left, const Row& right, SortField sort_by) noexcept;
+
+// Expands a --merge list: files as given, directories to their *.snap files
+// in name order.
+[[nodiscard]] std::expected<std::vector<std::filesystem::path>, std::string>
+expand_inputs(std::span<const std::string> entries);
+
+struct MergeOptions {
+    // Decode worker threads; 0 means one per hardware thread.
+    std::size_t threads = 0;
+};
+
+struct MergeStats {
+    std::size_t rows = 0;
+    std::size_t blocks = 0;
+    // Bytes of all mapped input files.
+    std::uint64_t bytes = 0;
+};
+
+/**
+ * @brief K-way merge of snapshot files sorted by the same key.
+ *
+ * open() maps every file and checks its header; the descriptors are closed
+ * right away, so thousands of inputs do not need as many open files. run()
+ * streams every row once, in row_less order with ties between files broken
+ * by input order, and reads each file front to back.
+ */
+class Merger {
+public:
+    // Called once per row; `input` indexes the opened files (see info()).
+    using Consumer = std::function<void(const Row& row, std::size_t input)>;
+
+    ~Merger();
+    Merger(Merger&&) noexcept;
+    Merger& operator=(Merger&&) noexcept;
+
+    [[nodiscard]] static std::expected<Merger, std::string> open(std::span<const std::filesystem::path> paths,
+                                                                 MergeOptions options = {});
+
+    [[nodiscard]] SortField sort_by() const noexcept;
+    [[nodiscard]] std::size_t input_count() const noexcept;
+    [[nodiscard]] const SnapshotInfo& info(std::size_t input) const noexcept;
+
+    // Streams every row; a corrupt block stops the merge with an error naming the file.
+    [[nodiscard]] std::expected<MergeStats, std::string> run(const Consumer& consume);
+
+private:
+    struct State;
+
+    explicit Merger(std::unique_ptr<State> state) noexcept;
+
+    std::unique_ptr<State> m_state;
+};
+
+} // namespace fleet
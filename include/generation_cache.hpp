@@ -0,0 +1,135 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Long-lived per-process cache keyed by process instance.
+ *
+ * Pids are reused, (pid, creation time) is not. refresh() installs the current
+ * process list; entries whose pid is gone or now belongs to a newer process
+ * are dropped, so a name cached for one process is never served for the next
+ * process that gets the same pid. An unchanged list is detected with one
+ * lookup per process and costs no rebuild or allocation.
+ */
+class ProcessCache {
+public:
+    struct RefreshStats {
+        bool changed = false;
+        // Cached names dropped because their process instance is gone.
+        std::size_t evicted = 0;
+    };
+
+    RefreshStats refresh(std::span<const nt::ProcessIdentity> processes);
+
+    // Creation time of the live process with this pid, per the last refresh().
+    [[nodiscard]] std::optional<std::uint64_t> create_time(std::uint32_t pid) const;
+    // Name cached for the live process with this pid, or nullptr.
+    [[nodiscard]] const std::string* name(std::uint32_t pid) const;
+    // Ignored for pids absent from the last refresh(): their identity is unknown.
+    void store(std::uint32_t pid, std::string_view name);
+
+    // Bumped by every refresh() that changes the process list.
+    [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_processes.size(); }
+    [[nodiscard]] std::size_t named_count() const noexcept { return m_named; }
+    void clear();
+
+private:
+    struct Entry {
+        std::uint64_t createTime = 0;
+        std::optional<std::string> name;
+    };
+
+    std::unordered_map<std::uint32_t, Entry> m_processes;
+    std::uint64_t m_generation = 0;
+    std::size_t m_named = 0;
+};
+
+/**
+ * @brief Long-lived object type and name cache.
+ *
+ * Type names are keyed by type index, which is fixed for the life of the boot.
+ * Object names are keyed by object address plus type index and anchored to the
+ * handles seen referencing them: process instance, handle value, access mask
+ * and attributes. refresh() must see every snapshot; it keeps an entry only
+ * while one of its anchors is present in each of them with the same address
+ * and type. Within one snapshot every handle with the same address and type
+ * refers to the same object and shares the entry.
+ *
+ * Across snapshots that is evidence, not proof: between two snapshots a
+ * process can close a handle and open another object that gets the same
+ * handle value, access and (from a lookaside list) pool address. So a name is
+ * carried through at most kMaxCarriedRefreshes refreshes and then queried
+ * again, which bounds how long such a mix-up can last.
+ */
+class ObjectCache {
+public:
+    // Refreshes a cached object name survives before it is queried again.
+    static constexpr std::uint64_t kMaxCarriedRefreshes = 8;
+
+    // Evicts object names whose anchor handle is gone; returns how many.
+    std::size_t refresh(std::span<const nt::RawHandle> handles, const ProcessCache& processes);
+
+    [[nodiscard]] const std::string* type_name(std::uint16_t typeIndex) const;
+    void store_type(std::uint16_t typeIndex, std::string_view name);
+
+    // `processCreateTime` identifies the instance of the handle's process; when
+    // known, a hit also records the handle as an anchor of the entry. Handles
+    // without an object address (no elevation) are never cached.
+    [[nodiscard]] const std::string* object_name(const nt::RawHandle& handle,
+                                                 std::optional<std::uint64_t> processCreateTime);
+    void store_object(const nt::RawHandle& handle, std::uint64_t processCreateTime, std::string_view name);
+
+    [[nodiscard]] std::size_t object_count() const noexcept { return m_objects.size(); }
+    void clear();
+
+private:
+    struct ObjectKey {
+        std::uintptr_t objectAddress = 0;
+        std::uint16_t typeIndex = 0;
+        bool operator==(const ObjectKey&) const = default;
+    };
+
+    struct ObjectKeyHash {
+        [[nodiscard]] std::size_t operator()(const ObjectKey& key) const noexcept {
+            return static_cast<std::size_t>((key.objectAddress ^ (std::uint64_t{key.typeIndex} << 48)) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    struct Anchor {
+        std::uintptr_t pid = 0;
+        std::uintptr_t handleValue = 0;
+        std::uint32_t grantedAccess = 0;
+        std::uint32_t handleAttributes = 0;
+        std::uint64_t processCreateTime = 0;
+        std::uint64_t seenInRefresh = 0;
+
+        [[nodiscard]] bool same_handle(const nt::RawHandle& handle) const noexcept {
+            return pid == handle.processId && handleValue == handle.handleValue &&
+                   grantedAccess == handle.grantedAccess && handleAttributes == handle.handleAttributes;
+        }
+    };
+
+    struct ObjectEntry {
+        std::string name;
+        std::vector<Anchor> anchors;
+        // Refresh count when the name was queried.
+        std::uint64_t storedInRefresh = 0;
+    };
+
+    // A few anchors are enough to outlive any single holder closing its handle.
+    static constexpr std::size_t kMaxAnchors = 4;
+
+    std::unordered_map<std::uint16_t, std::string> m_types;
+    std::unordered_map<ObjectKey, ObjectEntry, ObjectKeyHash> m_objects;
+    std::uint64_t m_refreshes = 0;
+};
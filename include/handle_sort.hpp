@@ -0,0 +1,64 @@
+#pragma once
+
+#include "string_interner.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace sorting {
+
+// Orders rows by the requested key, then pid, then handle value. Type and name
+// keys compare interned case-insensitive ranks, so strings.build_sort_ranks()
+// must have run after the last intern() (sort_handles does this).
+[[nodiscard]] bool handle_less(const HandleInfo& left,
+                               const HandleInfo& right,
+                               SortField sort_by,
+                               const StringInterner& strings) noexcept;
+
+// Same order as handle_less, but compares type and name text directly, so it
+// needs no sort ranks and stays valid while strings are still being interned.
+[[nodiscard]] bool handle_less_unranked(const HandleInfo& left,
+                                        const HandleInfo& right,
+                                        SortField sort_by,
+                                        const StringInterner& strings) noexcept;
+
+// Sorts rows in place using handle_less.
+void sort_handles(std::vector<HandleInfo>& handles, SortField sort_by, StringInterner& strings);
+
+/**
+ * @brief Keeps the first `limit` rows in handle_less order out of a stream.
+ *
+ * A bounded max-heap: offer() costs O(log limit) and memory stays O(limit)
+ * however many rows are offered, so rows only need their sort key resolved
+ * to be offered; the rest of each winner can be resolved afterwards. Each
+ * row carries the caller's `source` index for that purpose. Storage is
+ * reserved for min(limit, row_count), so a limit far above the number of
+ * rows that will be offered costs nothing.
+ */
+class TopRows {
+public:
+    struct Entry {
+        HandleInfo row;
+        std::size_t source = 0;
+    };
+
+    TopRows(std::size_t limit, std::size_t row_count, SortField sort_by, const StringInterner& strings);
+
+    void offer(const HandleInfo& row, std::size_t source);
+
+    // The kept rows in handle_less order; the heap is empty afterwards.
+    [[nodiscard]] std::vector<Entry> take_sorted();
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_heap.size(); }
+
+private:
+    [[nodiscard]] bool less(const Entry& left, const Entry& right) const noexcept;
+
+    std::size_t m_limit;
+    SortField m_sort_by;
+    const StringInterner& m_strings;
+    std::vector<Entry> m_heap;
+};
+
+} // namespace sorting
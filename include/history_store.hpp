@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace history {
+
+// Index into a history file's string dictionary; 0 is the empty string.
+using DictionaryId = std::uint32_t;
+
+// One handle as stored in a history frame. Strings are dictionary ids shared by
+// every frame of the file.
+struct Record {
+    std::uint32_t pid = 0;
+    std::uint64_t handleValue = 0;
+    std::uint64_t objectAddress = 0;
+    std::uint32_t grantedAccess = 0;
+    std::uint16_t objectTypeIndex = 0;
+    DictionaryId processName = 0;
+    DictionaryId handleType = 0;
+    DictionaryId objectName = 0;
+
+    // Identity across frames; attribute changes are stored as close + open.
+    [[nodiscard]] auto key() const noexcept { return std::tuple(pid, handleValue, objectAddress); }
+    bool operator==(const Record&) const = default;
+};
+
+enum class FrameKind : std::uint8_t { Keyframe = 2, Delta = 3 };
+
+// Frame metadata, read from block headers without decoding the payload.
+struct FrameInfo {
+    std::int64_t timestampMs = 0;
+    FrameKind kind = FrameKind::Keyframe;
+    // Handles in the snapshot after this frame, and the changes it carries.
+    std::size_t handleCount = 0;
+    std::size_t opened = 0;
+    std::size_t closed = 0;
+    std::uint64_t payloadOffset = 0;
+    std::uint64_t payloadSize = 0;
+};
+
+// A record seen during a queried time range.
+struct Holding {
+    Record record;
+    // Timestamps of the first and last frame (in effect during the range) that contained it.
+    std::int64_t firstSeenMs = 0;
+    std::int64_t lastSeenMs = 0;
+};
+
+struct WriterOptions {
+    // A full keyframe is written every this many frames; deltas in between.
+    std::size_t keyframeInterval = 60;
+};
+
+struct AppendStats {
+    FrameKind kind = FrameKind::Keyframe;
+    std::size_t opened = 0;
+    std::size_t closed = 0;
+    // Bytes appended to the file, dictionary block included.
+    std::size_t bytes = 0;
+};
+
+/**
+ * @brief Read access to a history file.
+ *
+ * open() reads block headers and dictionary blocks only. Queries replay from
+ * the nearest keyframe and, for object queries, decode the address column of
+ * each frame first and skip the rest of the frame when the object is absent.
+ */
+class HistoryReader {
+public:
+    [[nodiscard]] static std::expected<HistoryReader, std::string> open(const std::filesystem::path& path);
+
+    [[nodiscard]] const std::vector<FrameInfo>& frames() const noexcept { return m_frames; }
+    [[nodiscard]] std::string_view text(DictionaryId id) const noexcept;
+    [[nodiscard]] const std::vector<std::string>& dictionary() const noexcept { return m_strings; }
+    // Bytes up to the end of the last complete frame (a torn append is ignored).
+    [[nodiscard]] std::uint64_t valid_size() const noexcept { return m_valid_size; }
+
+    // Handles present at `timestampMs` (the last frame at or before it), sorted by key.
+    [[nodiscard]] std::expected<std::vector<Record>, std::string> snapshot_at(std::int64_t timestampMs);
+
+    // Every handle to `objectAddress` in effect at any point of [fromMs, toMs].
+    [[nodiscard]] std::expected<std::vector<Holding>, std::string> holders_of(std::uint64_t objectAddress,
+                                                                             std::int64_t fromMs,
+                                                                             std::int64_t toMs);
+
+private:
+    [[nodiscard]] std::expected<std::vector<std::uint8_t>, std::string> load(const FrameInfo& frame);
+    // Index of the last frame at or before `timestampMs`, or frames().size() if none.
+    [[nodiscard]] std::size_t frame_at(std::int64_t timestampMs) const noexcept;
+    [[nodiscard]] std::size_t keyframe_before(std::size_t frame) const noexcept;
+
+    std::ifstream m_file;
+    std::vector<FrameInfo> m_frames;
+    std::vector<std::string> m_strings;
+    std::uint64_t m_valid_size = 0;
+};
+
+/**
+ * @brief Appends snapshots to a history file as keyframes and deltas.
+ *
+ * Records are diffed against the previous frame by key; only opened and closed
+ * handles are written between keyframes. Columns are varint/delta encoded and
+ * strings are interned into a dictionary shared by all frames. Reopening an
+ * existing file continues its dictionary and delta chain.
+ */
+class HistoryWriter {
+public:
+    [[nodiscard]] static std::expected<HistoryWriter, std::string> open(const std::filesystem::path& path,
+                                                                       WriterOptions options = {});
+
+    [[nodiscard]] DictionaryId intern(std::string_view text);
+
+    // Timestamps must increase from frame to frame.
+    [[nodiscard]] std::expected<AppendStats, std::string> append(std::int64_t timestampMs, std::vector<Record> records);
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view text) const noexcept {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    std::ofstream m_file;
+    WriterOptions m_options;
+    std::unordered_map<std::string, DictionaryId, StringHash, std::equal_to<>> m_ids;
+    std::vector<std::string> m_pending;
+    DictionaryId m_first_pending = 1;
+    std::vector<Record> m_previous;
+    std::size_t m_frames_since_keyframe = 0;
+    std::int64_t m_last_timestamp = 0;
+    bool m_has_frames = false;
+};
+
+} // namespace history
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace latency {
+
+// Instrumented NT calls.
+enum class Call : std::uint8_t {
+    // duplicate_to_current_process: OpenProcess + DuplicateHandle.
+    Duplicate,
+    // query_unicode_information for ObjectTypeInformation.
+    TypeQuery,
+    // query_unicode_information for ObjectNameInformation.
+    NameQuery,
+    // get_process_name_by_pid.
+    ProcessName
+};
+
+inline constexpr std::size_t kCallCount = 4;
+// Types and processes shown per call when --top is not given.
+inline constexpr std::size_t kDefaultKeys = 5;
+
+[[nodiscard]] std::string_view call_name(Call call) noexcept;
+
+// Type index for calls that have none (process name lookups).
+inline constexpr std::uint32_t kNoType = 0xFFFF'FFFFu;
+
+/**
+ * @brief Log-linear latency histogram in nanoseconds, HDR style.
+ *
+ * Each power of two is split into 16 linear sub-buckets, so any recorded
+ * value is reported within 1/16 (6.25%) of itself from 16 ns up to
+ * kMaxValue; larger values are clamped. The 528 buckets are 32-bit relaxed
+ * atomics: record() is a few instructions and safe from any thread.
+ */
+class Histogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::uint64_t kMaxValue = (std::uint64_t{1} << 36) - 1;
+    static constexpr std::size_t kBucketCount = (36 - kSubBucketBits + 1) << kSubBucketBits;
+
+    void record(std::uint64_t nanoseconds) noexcept;
+    void reset() noexcept;
+
+    [[nodiscard]] std::uint64_t count() const noexcept;
+    [[nodiscard]] std::uint64_t max() const noexcept { return m_max.load(std::memory_order_relaxed); }
+    // Upper bound of the bucket holding the given percentile (0..100).
+    [[nodiscard]] std::uint64_t percentile(double percent) const noexcept;
+
+    [[nodiscard]] static std::size_t bucket_of(std::uint64_t value) noexcept;
+    [[nodiscard]] static std::uint64_t bucket_upper_bound(std::size_t bucket) noexcept;
+
+private:
+    std::array<std::atomic<std::uint32_t>, kBucketCount> m_counts{};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+// One call over the --slow-log threshold.
+struct SlowCall {
+    Call call = Call::Duplicate;
+    std::uint32_t pid = 0;
+    std::uint32_t typeIndex = kNoType;
+    std::uint32_t grantedAccess = 0;
+    std::uintptr_t handleValue = 0;
+    std::uint64_t nanoseconds = 0;
+    // The name resolver gave up waiting; `nanoseconds` is the deadline.
+    bool timedOut = false;
+};
+
+// Percentiles of one call for one type index or pid.
+struct KeyedSummary {
+    std::uint32_t key = 0;
+    std::uint64_t count = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t max = 0;
+};
+
+struct CallSummary {
+    Call call = Call::Duplicate;
+    std::uint64_t count = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p90 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t max = 0;
+    // Slowest first by p99, at most `limit` of each.
+    std::vector<KeyedSummary> byType;
+    std::vector<KeyedSummary> byProcess;
+};
+
+/**
+ * @brief Per-call latency histograms overall, per type index and per process,
+ *        plus the calls that crossed the slow threshold.
+ *
+ * Keyed histograms are created on first use up to kMaxKeyed; beyond that
+ * calls only count overall. Slow calls beyond kMaxSlowCalls are counted but
+ * not kept. Memory is therefore bounded however long a run is.
+ */
+class Recorder {
+public:
+    static constexpr std::size_t kMaxKeyed = 2048;
+    static constexpr std::size_t kMaxSlowCalls = 1024;
+
+    // Clears all data and starts recording. Zero threshold: no slow log.
+    void enable(std::chrono::nanoseconds slow_threshold);
+    void disable() noexcept { m_enabled.store(false, std::memory_order_relaxed); }
+    [[nodiscard]] bool enabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+
+    void record(Call call, std::uint32_t pid, std::uint32_t type_index, std::uint32_t granted_access,
+                std::uintptr_t handle_value, std::uint64_t nanoseconds);
+    // A call the name resolver abandoned at its deadline; slow log only.
+    void record_timeout(Call call, std::uint32_t pid, std::uint32_t type_index, std::uint32_t granted_access,
+                        std::uintptr_t handle_value, std::chrono::nanoseconds deadline);
+
+    // Calls with at least one sample, keyed lists cut to `limit`.
+    [[nodiscard]] std::vector<CallSummary> summarize(std::size_t limit) const;
+    // Slowest first.
+    [[nodiscard]] std::vector<SlowCall> slow_calls() const;
+    [[nodiscard]] std::size_t dropped_slow_calls() const;
+
+private:
+    enum class Dimension : std::uint8_t { Type, Process };
+
+    void record_keyed(Call call, Dimension dimension, std::uint32_t key, std::uint64_t nanoseconds);
+    void add_slow(const SlowCall& slow);
+
+    std::atomic<bool> m_enabled{false};
+    std::atomic<std::uint64_t> m_slow_threshold{0};
+    std::array<Histogram, kCallCount> m_overall;
+
+    mutable std::shared_mutex m_keyed_mutex;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Histogram>> m_keyed;
+
+    mutable std::mutex m_slow_mutex;
+    std::vector<SlowCall> m_slow;
+    std::size_t m_slow_dropped = 0;
+};
+
+// Process-wide recorder the NT layer reports to. Never destroyed, so a name
+// query finishing on an abandoned worker after the run still has a target.
+[[nodiscard]] Recorder& recorder() noexcept;
+
+/**
+ * @brief Times one call into recorder() if it is enabled.
+ *
+ * Disabled recording costs one relaxed load: the clock is not read.
+ */
+class ScopedTimer {
+public:
+    ScopedTimer(Call call, std::uint32_t pid, std::uint32_t type_index, std::uint32_t granted_access,
+                std::uintptr_t handle_value) noexcept;
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Call m_call;
+    std::uint32_t m_pid;
+    std::uint32_t m_type_index;
+    std::uint32_t m_granted_access;
+    std::uintptr_t m_handle_value;
+    bool m_active;
+    Clock::time_point m_start{};
+};
+
+} // namespace latency
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metrics {
+
+// Series kept per label dimension when --top is not given.
+inline constexpr std::size_t kDefaultTopK = 20;
+
+struct ProcessCount {
+    std::uint32_t pid = 0;
+    std::size_t handles = 0;
+};
+
+struct TypeCount {
+    std::uint16_t typeIndex = 0;
+    std::size_t handles = 0;
+    // Index into the counted span of one handle of this type, so the type
+    // name can be queried without another pass.
+    std::size_t sample = 0;
+};
+
+// Per-process and per-type handle counts with bounded cardinality: the
+// largest `top_k` groups of each dimension, the rest folded into "other".
+struct Summary {
+    std::size_t handles = 0;
+    std::size_t processes = 0;
+    std::size_t types = 0;
+    // Largest first, ties by ascending pid / type index.
+    std::vector<ProcessCount> topProcesses;
+    std::vector<TypeCount> topTypes;
+    std::size_t otherProcessHandles = 0;
+    std::size_t otherProcesses = 0;
+    std::size_t otherTypeHandles = 0;
+    std::size_t otherTypes = 0;
+};
+
+/**
+ * @brief Counts handles per process and per object type in one pass.
+ *
+ * Only RawHandle::processId and RawHandle::objectTypeIndex are read: no
+ * handle is duplicated and no name is queried. Type counts use a flat table
+ * indexed by type index; the top groups are then chosen with a partial sort.
+ */
+[[nodiscard]] Summary summarize(std::span<const nt::RawHandle> handles, std::size_t top_k);
+
+// Names for the label values of the kept groups.
+struct Labels {
+    std::function<std::string_view(std::uint32_t pid)> processName;
+    std::function<std::string_view(const TypeCount& type)> typeName;
+};
+
+// OpenMetrics text exposition of `summary`, ending with "# EOF".
+// `system_handles` is the size of the whole table before filtering.
+[[nodiscard]] std::string render(const Summary& summary, std::size_t system_handles, const Labels& labels);
+
+// Escapes a label value (backslash, double quote and newline).
+[[nodiscard]] std::string escape_label(std::string_view value);
+
+// Writes `text` next to `path` and renames it over `path`, so a textfile
+// collector never reads a half-written file.
+[[nodiscard]] std::expected<void, std::string> write_textfile(const std::string& path, std::string_view text);
+
+/**
+ * @brief Minimal HTTP/1.0 endpoint bound to 127.0.0.1.
+ *
+ * Serves one request at a time: GET /metrics calls the body callback and
+ * returns its text as application/openmetrics-text, any other path gets
+ * 404. Only loopback is ever bound, so the endpoint is not reachable from
+ * the network without an explicit forwarder.
+ */
+class LoopbackServer {
+public:
+    // Produces the exposition for one scrape, or an error message (served as 500).
+    using Body = std::function<std::expected<std::string, std::string>()>;
+
+    LoopbackServer() = default;
+    ~LoopbackServer();
+
+    LoopbackServer(LoopbackServer&& other) noexcept;
+    LoopbackServer& operator=(LoopbackServer&& other) noexcept;
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    // Port 0 binds an ephemeral port; port() tells which.
+    [[nodiscard]] static std::expected<LoopbackServer, std::string> listen(std::uint16_t port);
+
+    [[nodiscard]] std::uint16_t port() const noexcept { return m_port; }
+
+    // Accepts and answers one connection. Transient accept() failures (an
+    // interrupted call, a connection aborted before it was accepted, running
+    // out of descriptors) are retried; only a broken listener is an error. A
+    // client that disconnects early only loses its own response.
+    [[nodiscard]] std::expected<void, std::string> serve_one(const Body& body);
+
+private:
+    void close() noexcept;
+
+    std::intptr_t m_socket = -1;
+    std::uint16_t m_port = 0;
+};
+
+} // namespace metrics
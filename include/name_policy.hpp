@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tuning knobs for NameSkipPolicy.
+struct NameSkipOptions {
+    // Name queries observed per type before the type may be skipped.
+    std::uint32_t warmup = 64;
+    // Types whose observed share of non-empty names is below this stop being queried.
+    double minNamedRate = 0.01;
+    // A skipped type is still queried once per this many handles, so a type
+    // that starts having names is noticed and queried again.
+    std::uint32_t probeInterval = 256;
+};
+
+/**
+ * @brief Learns per object type index how often a name query returns a name,
+ *        and stops querying types that almost never have one.
+ *
+ * Event, Semaphore, Thread, IoCompletion and similar objects are nearly always
+ * unnamed, yet each name query costs a duplicate and a kernel round trip.
+ * Every type is queried for its first `warmup` handles; after that, a type
+ * whose named rate is below `minNamedRate` is only probed once per
+ * `probeInterval` handles. Probes keep the rate current, so a type climbs back
+ * over the threshold as soon as names show up. Learned rates and costs survive
+ * reset_skip_counts(); type indexes are fixed for the life of the boot.
+ *
+ * Not thread-safe: callers decide and record from one thread.
+ */
+class NameSkipPolicy {
+public:
+    struct TypeReport {
+        std::uint16_t typeIndex = 0;
+        std::uint64_t observed = 0;
+        std::uint64_t named = 0;
+        std::uint64_t skipped = 0;
+        std::chrono::nanoseconds averageCost{0};
+    };
+
+    explicit NameSkipPolicy(NameSkipOptions options = {});
+
+    // False when this handle's name query should be skipped; counts the skip.
+    [[nodiscard]] bool should_query(std::uint16_t type_index);
+    // Outcome of a query should_query() allowed.
+    void record(std::uint16_t type_index, bool named, std::chrono::nanoseconds cost);
+
+    // Types skipped at least once since reset_skip_counts(), most skipped first.
+    [[nodiscard]] std::vector<TypeReport> skipped_types() const;
+    [[nodiscard]] std::uint64_t skipped_count() const noexcept { return m_skipped; }
+    // Skipped queries times the average cost of their type.
+    [[nodiscard]] std::chrono::nanoseconds estimated_savings() const;
+
+    void reset_skip_counts() noexcept;
+
+private:
+    struct TypeStats {
+        std::uint64_t observed = 0;
+        std::uint64_t named = 0;
+        std::uint64_t totalCost = 0;
+        std::uint64_t skipped = 0;
+        std::uint32_t sinceProbe = 0;
+    };
+
+    [[nodiscard]] bool below_threshold(const TypeStats& stats) const noexcept;
+
+    NameSkipOptions m_options;
+    // Indexed by type index; type indexes are small and dense.
+    std::vector<TypeStats> m_types;
+    std::uint64_t m_skipped = 0;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Tuning knobs for NameResolver.
+struct NameResolverOptions {
+    // Upper bound on concurrently live helper workers.
+    std::size_t maxWorkers = 4;
+    // Per-call deadline; a worker still busy after this is abandoned.
+    std::chrono::milliseconds deadline{250};
+    // Once this many workers are stuck, no replacements are spawned.
+    std::size_t maxAbandoned = 16;
+};
+
+/**
+ * @brief Runs object name queries on helper threads with a per-call deadline.
+ *
+ * NtQueryObject(ObjectNameInformation) can block forever on synchronous pipes.
+ * Instead of guessing which handles are dangerous, each query runs on a pooled
+ * worker; if it misses its deadline the worker is detached (it exits on its
+ * own if the call ever returns), a fresh worker takes its place and the caller
+ * gets std::errc::timed_out.
+ */
+class NameResolver {
+public:
+    explicit NameResolver(nt::ObjectQuery query, NameResolverOptions options);
+    ~NameResolver();
+
+    NameResolver(const NameResolver&) = delete;
+    NameResolver& operator=(const NameResolver&) = delete;
+
+    /**
+     * @brief Resolves one handle name, bounded by the configured deadline.
+     * @return Object name, the backend's error, or std::errc::timed_out.
+     */
+    [[nodiscard]] std::expected<std::string, nt::Error> resolve(const nt::RawHandle& handle);
+
+    [[nodiscard]] std::chrono::milliseconds deadline() const noexcept { return m_options.deadline; }
+    [[nodiscard]] std::size_t timed_out_count() const noexcept;
+    [[nodiscard]] std::size_t abandoned_worker_count() const noexcept;
+
+private:
+    struct Worker;
+
+    static void worker_loop(const std::shared_ptr<Worker>& worker, const nt::ObjectQuery& query);
+    [[nodiscard]] std::shared_ptr<Worker> acquire_worker();
+    void release_worker(std::shared_ptr<Worker> worker);
+    void abandon_worker(const std::shared_ptr<Worker>& worker);
+
+    nt::ObjectQuery m_query;
+    NameResolverOptions m_options;
+
+    std::mutex m_mutex;
+    std::condition_variable m_idle_cv;
+    std::vector<std::shared_ptr<Worker>> m_live_workers;
+    std::vector<std::shared_ptr<Worker>> m_idle_workers;
+
+    std::atomic<std::size_t> m_timed_out{0};
+    std::atomic<std::size_t> m_abandoned{0};
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "nt_types.hpp"
+
 #include <windows.h>
 #include <winternl.h>
 #include <cstdint>
@@ -12,28 +14,45 @@ namespace nt {
 
     // Status codes for NT API.
     using NTSTATUS = LONG;
-    using Error = std::error_code;
     inline constexpr NTSTATUS STATUS_SUCCESS = 0x00000000;
     inline constexpr NTSTATUS STATUS_INFO_LENGTH_MISMATCH = static_cast<NTSTATUS>(0xC0000004u);
+    inline constexpr NTSTATUS STATUS_BUFFER_OVERFLOW = static_cast<NTSTATUS>(0x80000005u);
+    inline constexpr NTSTATUS STATUS_BUFFER_TOO_SMALL = static_cast<NTSTATUS>(0xC0000023u);
 
     // Use extended handle information for modern 64-bit safe layouts.
     inline constexpr SYSTEM_INFORMATION_CLASS SystemExtendedHandleInformation =
         static_cast<SYSTEM_INFORMATION_CLASS>(64);
-
-    // Public, tool-level representation of one system handle.
-    struct RawHandle {
-        std::uintptr_t objectAddress{};
-        std::uintptr_t processId{};
-        std::uintptr_t handleValue{};
-        std::uint32_t grantedAccess{};
-        std::uint16_t objectTypeIndex{};
-        std::uint32_t handleAttributes{};
-    };
+    inline constexpr SYSTEM_INFORMATION_CLASS SystemProcessListInformation =
+        static_cast<SYSTEM_INFORMATION_CLASS>(5);
 
     namespace detail {
+        using NtQueryObjectPtr = NTSTATUS(NTAPI*)(
+            HANDLE Handle,
+            OBJECT_INFORMATION_CLASS ObjectInformationClass,
+            PVOID ObjectInformation,
+            ULONG ObjectInformationLength,
+            PULONG ReturnLength
+        );
+
+        // Per-thread NtQueryObject accounting, readable by tests and diagnostics.
+        struct ObjectQueryCounters {
+            std::size_t ntCalls = 0;
+            std::size_t allocations = 0;
+        };
+
         // Internal helper exposed for deterministic unit testing.
         std::size_t grow_buffer_size(std::size_t current, ULONG needed);
         bool buffer_has_complete_payload(std::size_t buffer_size, std::size_t handle_count);
+
+        // Queries a UNICODE_STRING-headed information class into the calling
+        // thread's scratch buffer (real query first, resize only on mismatch).
+        std::expected<std::string, Error> query_unicode_information(
+            NtQueryObjectPtr nt_query_object,
+            HANDLE handle,
+            OBJECT_INFORMATION_CLASS info_class);
+
+        ObjectQueryCounters& object_query_counters() noexcept;
+        std::size_t object_query_scratch_capacity() noexcept;
     }
 
     /**
@@ -48,6 +67,13 @@ namespace nt {
      */
     std::expected<std::vector<RawHandle>, std::error_code> query_system_handles();
 
+    /**
+     * @brief Lists running processes with their creation times
+     *        (NtQuerySystemInformation, SystemProcessInformation).
+     * @return std::expected<std::vector<ProcessIdentity>, std::error_code> One entry per process.
+     */
+    std::expected<std::vector<ProcessIdentity>, std::error_code> query_process_snapshot();
+
     /**
      * @brief Best-effort object type query for a raw handle.
      * @return std::expected<std::string, Error> Type name or error.
@@ -56,6 +82,8 @@ namespace nt {
 
     /**
      * @brief Best-effort object name query for a raw handle.
+     * @note May block indefinitely on synchronous pipes; run it through a
+     *       NameResolver when the caller must not hang.
      * @return std::expected<std::string, Error> Object name or error.
      */
     [[nodiscard]] std::expected<std::string, Error> query_object_name(const RawHandle& handle) noexcept;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <string>
+#include <system_error>
+
+// Platform-neutral NT handle types. Kept free of <windows.h> so that
+// components which only consume handles (resolvers, caches, stores) can be
+// built and unit-tested on any host.
+namespace nt {
+
+    using Error = std::error_code;
+
+    // Public, tool-level representation of one system handle.
+    struct RawHandle {
+        std::uintptr_t objectAddress{};
+        std::uintptr_t processId{};
+        std::uintptr_t handleValue{};
+        std::uint32_t grantedAccess{};
+        std::uint16_t objectTypeIndex{};
+        std::uint32_t handleAttributes{};
+    };
+
+    // One process instance. Pids are reused; (pid, creation time) is unique.
+    struct ProcessIdentity {
+        std::uint32_t pid{};
+        // Creation time as a FILETIME count (100 ns ticks since 1601).
+        std::uint64_t createTime{};
+        bool operator==(const ProcessIdentity&) const = default;
+    };
+
+    // Signature shared by the per-handle string queries (type, name).
+    using ObjectQuery = std::function<std::expected<std::string, Error>(const RawHandle&)>;
+
+} // namespace nt
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace parallel {
+
+using HandlePredicate = std::function<bool(const nt::RawHandle&)>;
+
+struct ParallelOptions {
+    // Worker threads; 0 means std::thread::hardware_concurrency().
+    std::size_t threads = 0;
+    // Handles claimed per step. Small enough to balance uneven per-handle
+    // cost (name queries), large enough to keep the shared counter cold.
+    std::size_t chunkSize = 1024;
+};
+
+// Threads actually used for `items` handles: never more than there are chunks.
+[[nodiscard]] std::size_t effective_threads(std::size_t items, const ParallelOptions& options) noexcept;
+
+/**
+ * @brief Returns the handles for which `predicate` is true, in input order.
+ *
+ * The array is split into fixed-size chunks that worker threads claim from a
+ * shared counter. Each chunk gets its own selection vector, written only by the
+ * thread that claimed it, and the vectors are concatenated in chunk order, so
+ * the result is identical to a serial pass. `predicate` must be safe to call
+ * concurrently. An exception thrown by it is rethrown after all workers stop.
+ */
+[[nodiscard]] std::vector<nt::RawHandle> select(std::span<const nt::RawHandle> handles,
+                                                const HandlePredicate& predicate,
+                                                const ParallelOptions& options = {});
+
+// Number of handles for which `predicate` is true. Each worker keeps a private
+// counter; nothing is materialized or merged besides the final sum.
+[[nodiscard]] std::size_t count(std::span<const nt::RawHandle> handles,
+                                const HandlePredicate& predicate,
+                                const ParallelOptions& options = {});
+
+} // namespace parallel
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "string_interner.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief Process names indexed directly by pid, readable without locks.
+ *
+ * Windows pids are small multiples of four, so pid / 4 indexes a flat slot
+ * array split into fixed chunks that are allocated on first use and never
+ * move. A lookup is one directory load and one slot load. Each slot holds the
+ * interned id and a view of the interned text; the id is published last with
+ * release order, so a reader that sees it also sees the view.
+ *
+ * Any number of threads may call find() while one thread at a time calls
+ * publish(); callers serialize publishers (the app already holds its process
+ * name mutex to intern the name). clear() needs exclusive access. Pids that
+ * are not multiples of four or lie beyond kMaxDensePid go to a small locked
+ * map instead.
+ */
+class PidTable {
+public:
+    struct Entry {
+        StringId id = StringInterner::kEmpty;
+        // Points into the interner's arena, which never moves its text.
+        std::string_view name;
+    };
+
+    static constexpr std::size_t kChunkSlots = 1024;
+    static constexpr std::size_t kChunkCount = 1024;
+    static constexpr std::uint32_t kMaxDensePid = kChunkSlots * kChunkCount * 4 - 4;
+
+    PidTable() = default;
+    ~PidTable();
+
+    PidTable(const PidTable&) = delete;
+    PidTable& operator=(const PidTable&) = delete;
+
+    [[nodiscard]] std::optional<Entry> find(std::uint32_t pid) const noexcept;
+    // Stores `entry` for `pid` unless it already has one; returns what is stored.
+    Entry publish(std::uint32_t pid, Entry entry);
+
+    // Forgets every pid but keeps allocated chunks for the next snapshot.
+    void clear() noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+    // Slot chunks currently allocated.
+    [[nodiscard]] std::size_t chunk_count() const noexcept;
+
+private:
+    struct Slot {
+        // Interned id + 1; 0 while the slot is empty.
+        std::atomic<StringId> published{0};
+        std::uint32_t length = 0;
+        const char* data = nullptr;
+    };
+
+    using Chunk = std::array<Slot, kChunkSlots>;
+
+    [[nodiscard]] static bool is_dense(std::uint32_t pid) noexcept { return (pid & 3) == 0 && pid <= kMaxDensePid; }
+
+    std::array<std::atomic<Chunk*>, kChunkCount> m_chunks{};
+    std::atomic<std::size_t> m_size{0};
+
+    mutable std::mutex m_sparse_mutex;
+    std::unordered_map<std::uint32_t, Entry> m_sparse;
+};
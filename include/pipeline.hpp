@@ -0,0 +1,50 @@
+#pragma once
+
+#include "nt_types.hpp"
+#include "parallel_filter.hpp"
+#include "types.hpp"
+
+#include <functional>
+#include <generator>
+#include <string>
+#include <vector>
+
+/**
+ * Lazy listing pipeline: acquire -> filter -> resolve -> format.
+ *
+ * Each stage is a std::generator that pulls from the one before it only when
+ * its consumer asks for the next element. A consumer that stops early (--limit,
+ * --exists) destroys the chain, so no handle past that point is filtered,
+ * name-queried or formatted. Order is always the snapshot order.
+ */
+namespace pipeline {
+
+using Handles = std::generator<const nt::RawHandle&>;
+using Rows = std::generator<HandleInfo>;
+using Lines = std::generator<std::string>;
+
+using Resolver = std::function<HandleInfo(const nt::RawHandle&)>;
+using Formatter = std::function<std::string(const HandleInfo&)>;
+
+// Yields the handles of one snapshot; the generator owns it.
+[[nodiscard]] Handles acquire(std::vector<nt::RawHandle> snapshot);
+
+/**
+ * @brief Yields the upstream handles for which `predicate` is true; an empty
+ *        predicate passes everything through.
+ *
+ * With one thread, handles are tested one at a time. With more, they are
+ * pulled in blocks and tested with parallel::select; the first block holds
+ * one handle per thread and each later block doubles, up to threads x
+ * chunkSize. An early stop therefore wastes at most the rest of one block:
+ * about as much work as was already done, and never more than one full block.
+ */
+[[nodiscard]] Handles filter(Handles upstream, parallel::HandlePredicate predicate, parallel::ParallelOptions options = {});
+
+// Resolves each handle into a row as it is pulled.
+[[nodiscard]] Rows resolve(Handles upstream, Resolver resolver);
+
+// Formats each row into an output line as it is pulled.
+[[nodiscard]] Lines format(Rows upstream, Formatter formatter);
+
+} // namespace pipeline
@@ -1,18 +1,126 @@
 #pragma once
 
+#include "alloc_tracker.hpp"
+#include "fleet_merge.hpp"
+#include "history_store.hpp"
+#include "latency.hpp"
+#include "progressive.hpp"
+#include "sampling.hpp"
+#include "sketch.hpp"
+#include "string_interner.hpp"
 #include "types.hpp"
 
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 class HandlePrinter {
 public:
+    HandlePrinter() = default;
+    explicit HandlePrinter(std::vector<Column> columns);
+
     void print_count_only(const CliOptions& options,
                           std::size_t total_raw_count,
                           std::size_t matching_count) const;
     void print_results(const std::vector<HandleInfo>& handles,
+                       const StringInterner& strings,
                        const CliOptions& options,
                        std::size_t total_raw_count) const;
+    // print_results in pieces, for callers that stream sorted rows.
+    void print_preamble(const CliOptions& options, std::size_t total_raw_count) const;
+    // `shown_count` differs from `matching_count` when --top cut the rows.
+    void print_footer(std::size_t matching_count, std::optional<std::size_t> shown_count = std::nullopt) const;
+    // --count --top: processes ordered by matching handle count.
+    void print_process_counts(const std::vector<ProcessHandleCount>& processes,
+                              const StringInterner& strings,
+                              const CliOptions& options,
+                              std::size_t total_raw_count,
+                              std::size_t matching_count) const;
+    // --sample: estimated total, then (without --count) per-process and per-type estimates.
+    void print_sample_estimates(const CliOptions& options,
+                                std::size_t total_raw_count,
+                                std::size_t sampled_count,
+                                const sampling::Estimate& matching,
+                                const std::vector<EstimatedGroup>& processes,
+                                const std::vector<EstimatedGroup>& types,
+                                const StringInterner& strings) const;
+    // --sketch: what the accumulated sketches say. `total_raw_count` is set
+    // when this run added a snapshot of `added_count` handles, unset for
+    // --sketch-merge.
+    void print_sketch_summary(const CliOptions& options,
+                              const sketch::SketchSet& sketches,
+                              std::optional<std::size_t> total_raw_count,
+                              std::size_t added_count) const;
+    // --latency and --slow-log: per-call percentiles, then the slow calls.
+    // The label callbacks name a type index or a pid (empty if unknown).
+    void print_latency(const CliOptions& options,
+                       const std::vector<latency::CallSummary>& calls,
+                       const std::vector<latency::SlowCall>& slow_calls,
+                       std::size_t dropped_slow_calls,
+                       const std::function<std::string_view(uint32_t type_index)>& type_name,
+                       const std::function<std::string_view(uint32_t pid)>& process_name) const;
+    // --stats: allocations per pipeline stage. Acquire, filter and other are
+    // divided by the snapshot's handles, map, sort and print by mapped rows.
+    void print_allocations(const std::array<alloc::Counts, alloc::kStageCount>& counts,
+                           std::size_t snapshot_handles,
+                           std::size_t mapped_rows) const;
+    // --deadline: how the run ended against its budget and how complete the rows are.
+    void print_completeness(const progressive::Completeness& completeness,
+                            const progressive::FieldSet& needed,
+                            std::chrono::nanoseconds budget,
+                            std::chrono::nanoseconds elapsed,
+                            std::size_t lookups_left) const;
+    // --shared-objects report: one block per object, holders as indented rows.
+    void print_shared_objects(const std::vector<SharedObjectInfo>& objects,
+                              const StringInterner& strings,
+                              const CliOptions& options,
+                              std::size_t total_raw_count) const;
+    // --record summary for the frame just appended.
+    void print_record_summary(const CliOptions& options,
+                              const history::AppendStats& stats,
+                              std::size_t recorded_count,
+                              std::size_t total_raw_count) const;
+    // --export summary for the file just written.
+    void print_export_summary(const CliOptions& options,
+                              std::string_view host,
+                              std::size_t exported_count,
+                              std::size_t total_raw_count,
+                              std::uint64_t bytes) const;
+    // --merge: rows go under a leading Host column; with --count, one line per
+    // sort key with its handles and the hosts holding them.
+    void print_merge_preamble(std::size_t file_count, SortField sort_by) const;
+    void print_merge_header() const;
+    [[nodiscard]] std::string format_merged_row(std::string_view host, const fleet::Row& row) const;
+    void print_merge_count_header(SortField sort_by) const;
+    [[nodiscard]] std::string format_merge_count(SortField sort_by,
+                                                 const fleet::Row& key,
+                                                 std::size_t handle_count,
+                                                 std::size_t host_count) const;
+    // --history without --held: one line per frame in the requested range.
+    void print_history_frames(const std::vector<history::FrameInfo>& frames, const CliOptions& options) const;
+    // --history --held: every recorded handle to the object and when it was seen.
+    void print_held_intervals(const std::vector<HeldInterval>& intervals,
+                              const StringInterner& strings,
+                              const CliOptions& options) const;
     void print_header() const;
-    void print_row(const HandleInfo& handle) const;
+    void print_row(const HandleInfo& handle, const StringInterner& strings) const;
+    // The line print_row writes, for the lazy pipeline's format stage.
+    [[nodiscard]] std::string format_row(const HandleInfo& handle, const StringInterner& strings) const;
+
+private:
+    [[nodiscard]] std::string format_header() const;
+    // One row's line; a non-empty `host` becomes a leading Host cell.
+    [[nodiscard]] std::string format_cells(std::string_view host,
+                                           const HandleInfo& handle,
+                                           std::string_view process,
+                                           std::string_view type,
+                                           std::string_view name) const;
+
+    std::vector<Column> m_columns{CliOptions{}.columns};
 };
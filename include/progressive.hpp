@@ -0,0 +1,85 @@
+#pragma once
+
+#include "string_interner.hpp"
+#include "types.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Two-phase listing under a wall-clock budget (--deadline). Phase one builds
+// every row from raw handle fields and cached names; phase two fills in the
+// rest, most useful lookups first, until the budget runs out. Fields still
+// missing then keep an `unresolved` marker.
+namespace progressive {
+
+// A resolved HandleInfo field phase two may fill in.
+enum class Field : std::uint8_t { ProcessName, HandleType, ObjectName };
+
+inline constexpr std::size_t kFieldCount = 3;
+
+// Plural label for reports: "process names", "types", "object names".
+[[nodiscard]] std::string_view field_name(Field field) noexcept;
+
+// Indexed by Field: whether the report shows or sorts on it.
+using FieldSet = std::array<bool, kFieldCount>;
+
+/**
+ * @brief The wall-clock budget of one --deadline run.
+ *
+ * Callers check expired() before every lookup and start no new one after it.
+ * A lookup that started in time is bounded by its own timeout, so a run ends
+ * at most one query timeout past the deadline.
+ */
+class Budget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Budget(Clock::time_point start, Clock::duration budget) noexcept : m_start(start), m_end(start + budget) {}
+
+    [[nodiscard]] bool expired(const Clock::time_point now = Clock::now()) const noexcept { return now >= m_end; }
+    [[nodiscard]] Clock::duration elapsed(const Clock::time_point now = Clock::now()) const noexcept { return now - m_start; }
+    [[nodiscard]] Clock::duration budget() const noexcept { return m_end - m_start; }
+
+private:
+    Clock::time_point m_start;
+    Clock::time_point m_end;
+};
+
+// One phase two lookup. A process name or type lookup fills every row with
+// the same pid or type index; `row` is the first of them.
+struct Lookup {
+    Field field = Field::ObjectName;
+    std::size_t row = 0;
+};
+
+/**
+ * @brief Orders phase two so each lookup completes as many fields as possible.
+ *
+ * One process name query fills every row of that process and one type query
+ * every row of that type index, so those go first, largest groups first. Object
+ * names cost one query per row and follow in row order, so a run cut short
+ * still has complete leading rows.
+ */
+[[nodiscard]] std::vector<Lookup> plan(std::span<const HandleInfo> rows, StringId unresolved);
+
+// How much of the report phase two completed.
+struct Completeness {
+    std::size_t rows = 0;
+    // Rows with every needed field resolved.
+    std::size_t completeRows = 0;
+    // Indexed by Field: rows that need the field, and rows that have it.
+    std::array<std::size_t, kFieldCount> needed{};
+    std::array<std::size_t, kFieldCount> resolved{};
+
+    // Resolved over needed fields across all rows; 1 when nothing is needed.
+    [[nodiscard]] double fraction() const noexcept;
+};
+
+[[nodiscard]] Completeness measure(std::span<const HandleInfo> rows, FieldSet needed, StringId unresolved);
+
+} // namespace progressive
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace sampling {
+
+// Groups reported per dimension when --top is not given.
+inline constexpr std::size_t kDefaultGroups = 20;
+// Two-sided 95% normal quantile.
+inline constexpr double kZ95 = 1.959963984540054;
+
+enum class Strategy {
+    // One stratum: a simple random sample of the whole table.
+    Uniform,
+    // One stratum per process, each sampled at the same fraction (at least one
+    // handle), so small processes are never missed entirely.
+    ByPid
+};
+
+struct Stratum {
+    std::size_t population = 0;
+    std::size_t sampled = 0;
+};
+
+struct Sample {
+    // Sampled handles, in table order.
+    std::vector<nt::RawHandle> handles;
+    std::vector<Stratum> strata;
+    std::size_t population = 0;
+    Strategy strategy = Strategy::Uniform;
+    // ByPid only: stratum index by process id.
+    std::unordered_map<std::uint32_t, std::uint32_t> pidStrata;
+
+    // Stratum a handle of the table was drawn from.
+    [[nodiscard]] std::uint32_t stratum_of(const nt::RawHandle& handle) const;
+};
+
+/**
+ * @brief Draws a random sample of `fraction` of the handle table.
+ *
+ * Each stratum gets round(fraction * population) handles (at least one),
+ * chosen without replacement by selection sampling in one pass, so the
+ * sample keeps table order. Only raw fields are read. The same seed and
+ * table always give the same sample.
+ */
+[[nodiscard]] Sample draw(std::span<const nt::RawHandle> handles, double fraction, Strategy strategy, std::uint64_t seed);
+
+// Population estimate with a confidence interval. `low` and `high` never
+// leave the hard bounds: at least the handles seen in the sample, at most
+// those plus every handle that was not sampled.
+struct Estimate {
+    double value = 0;
+    double low = 0;
+    double high = 0;
+    // Sampled handles that were counted.
+    std::size_t observed = 0;
+};
+
+/**
+ * @brief Turns sampled hits per group into population counts.
+ *
+ * Uses the stratified expansion estimator sum(N_h / n_h * m_h). Its
+ * variance is sum(N_h^2 (1 - n_h/N_h) s_h^2 / n_h). s_h^2 comes from an
+ * Agresti-Coull adjusted proportion, so rare groups get honest, wider
+ * intervals instead of zero-width ones.
+ */
+class Estimator {
+public:
+    explicit Estimator(const Sample& sample) : m_sample(sample) {}
+
+    // Counts one sampled handle (that passed the filters) towards `group`.
+    void add(const nt::RawHandle& handle, std::uint64_t group);
+
+    [[nodiscard]] Estimate estimate(std::uint64_t group, double z = kZ95) const;
+
+    // Groups with at least one hit, in no particular order.
+    [[nodiscard]] std::vector<std::uint64_t> groups() const;
+
+private:
+    const Sample& m_sample;
+    // Hits per group, per stratum.
+    std::unordered_map<std::uint64_t, std::unordered_map<std::uint32_t, std::size_t>> m_hits;
+};
+
+} // namespace sampling
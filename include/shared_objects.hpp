@@ -0,0 +1,49 @@
+#pragma once
+
+#include "nt_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace shared_objects {
+
+// One kernel object held by several processes.
+struct Group {
+    std::uintptr_t objectAddress = 0;
+    std::uint16_t objectTypeIndex = 0;
+    // Distinct processes among the group's handles.
+    std::size_t processCount = 0;
+    // Range of the group's handles in Report::handles.
+    std::size_t firstHandle = 0;
+    std::size_t handleCount = 0;
+};
+
+struct Report {
+    std::vector<Group> groups;
+    // Handles of every reported group, contiguous per group and in input order.
+    std::vector<nt::RawHandle> handles;
+
+    [[nodiscard]] std::span<const nt::RawHandle> holders(const Group& group) const noexcept;
+};
+
+/**
+ * @brief Groups handles by RawHandle::objectAddress and returns the objects
+ *        held by at least `min_processes` distinct processes.
+ *
+ * Handles are first routed into hash partitions, then each partition is
+ * grouped in a cache-sized open-addressing table and its candidate groups are
+ * placed contiguously. Distinct process counts are computed exactly only for
+ * groups that can still qualify, so the handle table is never sorted.
+ * Handles with a zero address (hidden from unprivileged callers) are ignored.
+ * Groups are ordered by process count, then handle count (both descending),
+ * then address. Only the first `max_groups` are kept, selected with a
+ * partial sort.
+ */
+[[nodiscard]] Report find(std::span<const nt::RawHandle> handles,
+                          std::size_t min_processes,
+                          std::size_t max_groups = std::numeric_limits<std::size_t>::max());
+
+} // namespace shared_objects
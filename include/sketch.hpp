@@ -0,0 +1,183 @@
+#pragma once
+
+#include "binary_codec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sketch {
+
+// Rows shown per summary table when --top is not given.
+inline constexpr std::size_t kDefaultRows = 20;
+
+// Stable 64-bit hashes: sketches from different hosts and builds must agree,
+// so std::hash (implementation defined) is never used.
+[[nodiscard]] std::uint64_t hash_bytes(std::string_view bytes) noexcept;
+[[nodiscard]] std::uint64_t hash_u64(std::uint64_t value) noexcept;
+
+/**
+ * @brief HyperLogLog distinct counter with 2^precision one-byte registers.
+ *
+ * Relative standard error is about 1.04 / sqrt(2^precision). Small
+ * cardinalities fall back to linear counting. Merging takes the register-wise
+ * maximum, so merge order does not matter and merging a sketch into itself
+ * changes nothing.
+ */
+class HyperLogLog {
+public:
+    explicit HyperLogLog(std::uint8_t precision = 12);
+
+    void add_hash(std::uint64_t hash) noexcept;
+    [[nodiscard]] double estimate() const noexcept;
+    [[nodiscard]] double relative_error() const noexcept;
+    [[nodiscard]] std::uint8_t precision() const noexcept { return m_precision; }
+
+    [[nodiscard]] std::expected<void, std::string> merge(const HyperLogLog& other);
+
+    // Sparse (index delta, rank) pairs while few registers are set, raw otherwise.
+    void serialize(codec::ByteWriter& out) const;
+    [[nodiscard]] static std::expected<HyperLogLog, std::string> deserialize(codec::ByteReader& in);
+
+private:
+    std::uint8_t m_precision;
+    std::vector<std::uint8_t> m_registers;
+};
+
+/**
+ * @brief Count-min sketch: `depth` rows of `width` counters.
+ *
+ * estimate() never undercounts; it overcounts by at most e/width of the total
+ * with probability 1 - e^-depth. Merging adds counters cell by cell.
+ */
+class CountMin {
+public:
+    CountMin(std::size_t width = 2048, std::size_t depth = 4);
+
+    void add(std::uint64_t hash, std::uint64_t count = 1) noexcept;
+    [[nodiscard]] std::uint64_t estimate(std::uint64_t hash) const noexcept;
+    [[nodiscard]] std::uint64_t total() const noexcept { return m_total; }
+
+    [[nodiscard]] std::expected<void, std::string> merge(const CountMin& other);
+
+    void serialize(codec::ByteWriter& out) const;
+    [[nodiscard]] static std::expected<CountMin, std::string> deserialize(codec::ByteReader& in);
+
+private:
+    [[nodiscard]] std::size_t cell(std::size_t row, std::uint64_t hash) const noexcept;
+
+    std::size_t m_width;
+    std::size_t m_depth;
+    std::uint64_t m_total = 0;
+    std::vector<std::uint64_t> m_counters;
+};
+
+/**
+ * @brief Most frequent keys: a count-min sketch plus at most `capacity`
+ *        candidate keys.
+ *
+ * Every key goes into the count-min sketch. When its estimate beats the
+ * smallest candidate, it replaces that candidate. Keys are truncated to
+ * kMaxKeyBytes so memory is bounded however long object names get. Merging
+ * merges the sketches and re-ranks the union of both candidate sets.
+ */
+class HeavyHitters {
+public:
+    static constexpr std::size_t kMaxKeyBytes = 256;
+
+    struct Entry {
+        std::string key;
+        std::uint64_t count = 0;
+    };
+
+    explicit HeavyHitters(std::size_t capacity = 64, std::size_t width = 2048, std::size_t depth = 4);
+
+    void add(std::string_view key, std::uint64_t count = 1);
+    // Candidates by estimated count (descending, then key).
+    [[nodiscard]] std::vector<Entry> top() const;
+    [[nodiscard]] std::uint64_t total() const noexcept { return m_counts.total(); }
+
+    [[nodiscard]] std::expected<void, std::string> merge(const HeavyHitters& other);
+
+    void serialize(codec::ByteWriter& out) const;
+    [[nodiscard]] static std::expected<HeavyHitters, std::string> deserialize(codec::ByteReader& in);
+
+private:
+    struct Candidate {
+        std::string key;
+        std::uint64_t estimate = 0;
+    };
+
+    void offer(std::uint64_t hash, std::string_view key, std::uint64_t estimate);
+
+    std::size_t m_capacity;
+    CountMin m_counts;
+    // At most m_capacity candidates, keyed by key hash so the per-handle
+    // lookup never allocates.
+    std::unordered_map<std::uint64_t, Candidate> m_candidates;
+};
+
+/**
+ * @brief Distinct counters keyed by label (type or process name), with a
+ *        fixed number of labels.
+ *
+ * The first `max_labels` labels get their own HyperLogLog; later labels share
+ * the kOtherLabel counter, so memory stays fixed however many labels appear.
+ */
+class LabeledDistinct {
+public:
+    static constexpr std::string_view kOtherLabel = "(other)";
+
+    struct Count {
+        std::string label;
+        double estimate = 0;
+    };
+
+    explicit LabeledDistinct(std::size_t max_labels = 256, std::uint8_t precision = 10);
+
+    void add_hash(std::string_view label, std::uint64_t hash);
+    // Counter for `label` (or kOtherLabel once the limit is reached). The
+    // reference stays valid, so callers may keep it for a run of handles.
+    [[nodiscard]] HyperLogLog& counter(std::string_view label);
+    [[nodiscard]] const std::unordered_map<std::string, HyperLogLog>& counters() const noexcept { return m_counters; }
+    // The `limit` largest counters by estimate (descending, then label).
+    [[nodiscard]] std::vector<Count> largest(std::size_t limit) const;
+
+    [[nodiscard]] std::expected<void, std::string> merge(const LabeledDistinct& other);
+
+    void serialize(codec::ByteWriter& out) const;
+    [[nodiscard]] static std::expected<LabeledDistinct, std::string> deserialize(codec::ByteReader& in);
+
+private:
+    std::size_t m_max_labels;
+    std::uint8_t m_precision;
+    std::unordered_map<std::string, HyperLogLog> m_counters;
+};
+
+// Everything --sketch tracks about a stream of snapshots.
+struct SketchSet {
+    std::uint64_t snapshots = 0;
+    std::uint64_t handles = 0;
+    // Distinct kernel objects (by address) overall, per type name and per process name.
+    HyperLogLog objects{14};
+    LabeledDistinct objectsByType{256, 10};
+    LabeledDistinct objectsByProcess{512, 10};
+    // Handle counts per object name.
+    HeavyHitters names{64, 2048, 4};
+
+    [[nodiscard]] std::expected<void, std::string> merge(const SketchSet& other);
+};
+
+[[nodiscard]] codec::Bytes serialize(const SketchSet& sketches);
+[[nodiscard]] std::expected<SketchSet, std::string> deserialize(std::span<const std::uint8_t> bytes);
+
+// File round trip; save() writes a temp file and renames it over `path`.
+[[nodiscard]] std::expected<SketchSet, std::string> load(const std::filesystem::path& path);
+[[nodiscard]] std::expected<void, std::string> save(const std::filesystem::path& path, const SketchSet& sketches);
+
+} // namespace sketch
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "string_interner.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Publication of the latest resolved snapshot in a named shared-memory region
+// (--publish), and the reader side other local agents link against.
+//
+// Region layout (fixed-width integers in host byte order):
+//   RegionHeader                          64 bytes
+//   slot 0, slot 1                        RegionHeader::slotBytes each
+// Slot layout:
+//   SlotHeader                            64 bytes
+//   Row[rowCount]                         48 bytes each
+//   uint32 stringOffsets[stringCount + 1] into the string data
+//   char stringData[stringBytes]          not NUL-terminated
+//
+// The publisher writes generation g into slot g % 2 and then advances
+// RegionHeader::latest, so the newest snapshot is never overwritten while it is
+// the newest. Each slot carries a seqlock sequence that is odd while the slot
+// is written; a reader that finds it changed after reading retries.
+//
+// A snapshot that outgrows the slots makes the publisher retire the region
+// (RegionHeader::retired) and create a larger one under the same name whose
+// generations continue where the old ones stopped. Readers that see
+// Reader::retired() open the name again.
+namespace shm {
+
+inline constexpr std::uint32_t kMagic = 0x4E534548; // "HESN"
+inline constexpr std::uint16_t kLayoutVersion = 1;
+inline constexpr std::uint16_t kSlotCount = 2;
+
+struct RegionHeader {
+    // Written last on creation; readers refuse a region without it.
+    std::uint32_t magic;
+    std::uint16_t layoutVersion;
+    std::uint16_t slotCount;
+    std::uint32_t headerBytes;
+    std::uint32_t rowBytes;
+    std::uint64_t slotBytes;
+    // Generation of the newest complete snapshot; 0 before the first.
+    std::uint64_t latest;
+    std::uint64_t publisherPid;
+    // Nonzero once the publisher moved on to a larger region under the same name.
+    std::uint64_t retired;
+    std::uint8_t reserved[16];
+};
+
+struct SlotHeader {
+    // Seqlock: odd while the publisher rewrites this slot.
+    std::uint64_t sequence;
+    std::uint64_t generation;
+    // Milliseconds since the Unix epoch (UTC) when the snapshot was taken.
+    std::int64_t publishedMs;
+    // Handles in the system table before filtering.
+    std::uint64_t totalRawCount;
+    std::uint32_t rowCount;
+    std::uint32_t stringCount;
+    std::uint64_t stringBytes;
+    std::uint8_t reserved[16];
+};
+
+// One handle. Names are indexes into the slot's string table.
+struct Row {
+    std::uint64_t objectAddress;
+    std::uint64_t handleValue;
+    std::uint32_t pid;
+    std::uint32_t grantedAccess;
+    std::uint32_t handleAttributes;
+    std::uint32_t processName;
+    std::uint32_t handleType;
+    std::uint32_t objectName;
+    std::uint16_t objectTypeIndex;
+    std::uint16_t reserved[3];
+};
+
+static_assert(sizeof(RegionHeader) == 64 && sizeof(SlotHeader) == 64 && sizeof(Row) == 48,
+              "the shared layout is part of the reader ABI");
+
+// Payload bytes one slot needs for `rows` (rows, string table and strings).
+[[nodiscard]] std::size_t payload_bytes(std::span<const HandleInfo> rows, const StringInterner& strings);
+
+/**
+ * @brief A zero-copy view of one published snapshot.
+ *
+ * Rows and strings point into the shared region. The publisher may start
+ * overwriting the slot once it has published two newer generations, so
+ * anything read through a view is only trustworthy if Reader::valid() still
+ * holds afterwards.
+ */
+struct SnapshotView {
+    std::uint64_t generation = 0;
+    std::int64_t publishedMs = 0;
+    std::uint64_t totalRawCount = 0;
+    std::span<const Row> rows;
+
+    // Bounds-checked: a bad index (from a torn read) gives an empty string.
+    [[nodiscard]] std::string_view string(std::uint32_t index) const noexcept;
+
+    std::span<const std::uint32_t> stringOffsets;
+    std::string_view stringData;
+    // Seqlock state when the view was taken.
+    std::uint32_t slot = 0;
+    std::uint64_t sequence = 0;
+};
+
+// Owns one mapped view of a region; closes it on destruction.
+class Mapping {
+public:
+    Mapping() = default;
+    ~Mapping();
+
+    Mapping(Mapping&& other) noexcept;
+    Mapping& operator=(Mapping&& other) noexcept;
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    // Creates a new region of `bytes`; fails if `name` already exists.
+    [[nodiscard]] static std::expected<Mapping, std::string> create(std::string_view name, std::size_t bytes);
+    // Maps an existing region read-only.
+    [[nodiscard]] static std::expected<Mapping, std::string> open(std::string_view name);
+
+    [[nodiscard]] std::byte* data() const noexcept { return m_data; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+private:
+    void close() noexcept;
+
+    std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+    // File mapping handle (Windows) or descriptor (POSIX).
+    std::intptr_t m_handle = -1;
+    // Set for the creator, which removes the name on close (POSIX).
+    std::string m_owned_name;
+};
+
+/**
+ * @brief Single writer of a region.
+ *
+ * Each publish() fills the slot the newest snapshot is not in, then makes it
+ * the newest. A snapshot that does not fit fails before anything is written,
+ * so readers keep the previous one.
+ */
+class Publisher {
+public:
+    // `slot_bytes` is the payload capacity of each of the two slots. A region
+    // that replaces a retired one passes the last generation published there.
+    [[nodiscard]] static std::expected<Publisher, std::string> create(std::string_view name,
+                                                                      std::size_t slot_bytes,
+                                                                      std::uint64_t last_generation = 0);
+
+    [[nodiscard]] std::size_t slot_capacity() const noexcept;
+    [[nodiscard]] std::uint64_t generation() const noexcept { return m_generation; }
+
+    // Tells readers to reopen the name; the last snapshot stays readable.
+    void retire() noexcept;
+
+    // Only the strings the rows use are copied. Returns the new generation.
+    [[nodiscard]] std::expected<std::uint64_t, std::string> publish(std::span<const HandleInfo> rows,
+                                                                    const StringInterner& strings,
+                                                                    std::uint64_t total_raw_count,
+                                                                    std::int64_t published_ms);
+
+private:
+    Mapping m_mapping;
+    std::uint64_t m_generation = 0;
+};
+
+class Reader {
+public:
+    // Fails if the region does not exist or its header is not a layout this reader knows.
+    [[nodiscard]] static std::expected<Reader, std::string> open(std::string_view name);
+
+    // The newest snapshot, or nullopt before the first publication.
+    [[nodiscard]] std::optional<SnapshotView> latest() const;
+    // True if the publisher has not touched the view's slot since it was taken.
+    [[nodiscard]] bool valid(const SnapshotView& view) const noexcept;
+    // True once the publisher replaced this region with a larger one; open() the name again.
+    [[nodiscard]] bool retired() const noexcept;
+
+    // Runs `consume` on the newest snapshot until one pass ends with the view
+    // still valid, so `consume` must tolerate being repeated. Returns the
+    // generation consumed, or nullopt if nothing is published yet.
+    template <typename Consume>
+    std::optional<std::uint64_t> read(Consume&& consume) const {
+        while (true) {
+            const std::optional<SnapshotView> view = latest();
+            if (!view) {
+                return std::nullopt;
+            }
+            consume(*view);
+            if (valid(*view)) {
+                return view->generation;
+            }
+        }
+    }
+
+private:
+    Mapping m_mapping;
+    std::uint64_t m_slot_bytes = 0;
+};
+
+} // namespace shm
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compact handle to a string owned by a StringInterner.
+using StringId = std::uint32_t;
+
+// ASCII case-insensitive three-way comparison; the order sort ranks follow.
+[[nodiscard]] int compare_ignore_case(std::string_view left, std::string_view right) noexcept;
+
+/**
+ * @brief Snapshot-scoped string pool for process, type and object names.
+ *
+ * Each distinct string is stored once in append-only arena chunks; rows keep a
+ * 32-bit StringId instead of an owned std::string. After build_sort_ranks()
+ * every id also has a case-insensitive rank, so sorting by type or name
+ * becomes an integer comparison.
+ */
+class StringInterner {
+public:
+    StringInterner();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+    StringInterner(StringInterner&&) noexcept = default;
+    StringInterner& operator=(StringInterner&&) noexcept = default;
+
+    [[nodiscard]] StringId intern(std::string_view text);
+    [[nodiscard]] std::string_view view(StringId id) const noexcept;
+
+    /**
+     * @brief Assigns every interned string its position in ASCII
+     *        case-insensitive order. Strings equal ignoring case share a rank.
+     */
+    void build_sort_ranks();
+    [[nodiscard]] bool has_sort_ranks() const noexcept;
+    [[nodiscard]] std::uint32_t sort_rank(StringId id) const noexcept;
+
+    // Drops every string; previously returned ids become invalid.
+    void clear();
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    // Heap bytes held by the arena, id table and lookup index (approximate).
+    [[nodiscard]] std::size_t bytes_reserved() const noexcept;
+
+    // Id of the empty string, always present.
+    static constexpr StringId kEmpty = 0;
+
+private:
+    [[nodiscard]] std::string_view store(std::string_view text);
+    void grow_index();
+
+    static constexpr std::size_t kChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    std::size_t m_chunk_used = kChunkSize;
+    std::size_t m_arena_bytes = 0;
+
+    std::vector<std::string_view> m_views;
+    std::vector<std::size_t> m_hashes;
+    // Open-addressing index: slot holds id + 1, or 0 when empty.
+    std::vector<StringId> m_slots;
+    std::vector<std::uint32_t> m_ranks;
+};
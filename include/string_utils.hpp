@@ -8,6 +8,19 @@ namespace utils {
 [[nodiscard]] std::string to_lower_ascii(std::string_view text);
 [[nodiscard]] bool equals_ignore_case(std::string_view left, std::string_view right);
 [[nodiscard]] bool contains_ignore_case(std::string_view text, std::string_view needle);
+
+/**
+ * @brief Converts UTF-16 to UTF-8 without the Windows API.
+ *
+ * Unpaired surrogates become U+FFFD, as WideCharToMultiByte does. Runs of
+ * ASCII are narrowed 16 code units at a time with SSE2 or NEON where the
+ * target has them, and the result is allocated once.
+ */
+[[nodiscard]] std::string utf16_to_utf8(std::u16string_view utf16);
+// wchar_t is UTF-16 on Windows; where it is wider, each unit is a code point.
 [[nodiscard]] std::string utf16_to_utf8(std::wstring_view wide);
+// One code unit at a time, sized in a first pass: the reference the tests
+// and handle_bench compare utf16_to_utf8 against.
+[[nodiscard]] std::string utf16_to_utf8_scalar(std::u16string_view utf16);
 
 } // namespace utils
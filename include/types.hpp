@@ -1,12 +1,18 @@
 #pragma once
+#include "string_interner.hpp"
+
 #include <string>
 #include <optional>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 // Defines the supported sort keys for output ordering.
 enum class SortField { Pid, Type, Name };
 
+// Output columns selectable with --columns, printed in the given order.
+enum class Column { Pid, Process, Handle, Type, Name, Access, Address };
+
 // Holds all parsed command-line filters and mode switches.
 struct CliOptions {
     // Optional process ID filter.
@@ -17,23 +23,157 @@ struct CliOptions {
     std::optional<std::string> handleType;
     // Optional object-name filter.
     std::optional<std::string> objectName;
+    // Optional boolean filter expression (--where), AND-ed with the filters above.
+    std::optional<std::string> whereExpression;
     // Output sorting strategy.
     SortField sortBy = SortField::Pid;
     // If true, print aggregate counts only.
     bool showCountOnly = false;
     // If true, print additional diagnostics/details.
     bool verbose = false;
+    // Per-handle deadline for object name queries, in milliseconds.
+    uint32_t nameTimeoutMs = 250;
+    // If true, query every handle's name; otherwise types that have shown
+    // almost no names are skipped once learned (never when filtering on name).
+    bool allNames = false;
+    // If set, finish within this many milliseconds (plus at most one name
+    // query timeout): rows come from raw fields and cached names first, then
+    // lookups fill in the rest until the budget runs out; whatever is left
+    // is printed as unresolved.
+    std::optional<uint32_t> deadlineMs;
+    // Filter worker threads; 0 means one per hardware thread.
+    uint32_t threads = 0;
+    // If set, report objects shared by at least this many processes instead of handles.
+    std::optional<uint32_t> sharedObjectsMin;
+    // Columns to print; fields no column, sort or filter needs are never resolved.
+    std::vector<Column> columns{Column::Pid, Column::Process, Column::Handle, Column::Type, Column::Name};
+    // If set, keep only the first N rows in sort order (or, with --count, the
+    // N processes holding the most matching handles; with --shared-objects,
+    // the N most widely shared objects).
+    std::optional<std::size_t> topN;
+    // If set, stop after the first N matching handles in snapshot order;
+    // nothing past the Nth match is filtered or resolved.
+    std::optional<std::size_t> limit;
+    // If true, print nothing and exit 0 at the first matching handle, or 1
+    // when none matches.
+    bool exists = false;
+    // Budget in bytes for buffered rows of a type/name sort; beyond it sorted
+    // runs are spilled to temp files and merged while printing.
+    std::optional<std::size_t> maxMemoryBytes;
+    // If set, filter and count only a random sample of this fraction (0, 1] of
+    // the handle table and report estimates with 95% confidence intervals.
+    std::optional<double> sampleFraction;
+    // --sample: draw the same fraction from every process instead of the whole table.
+    bool sampleByPid = false;
+    // --sample: fixed seed for a reproducible sample; random if unset.
+    std::optional<uint64_t> sampleSeed;
+    // If set, append the filtered snapshot (fields per --columns) to this history file.
+    std::optional<std::string> recordPath;
+    // If set, query this history file instead of the live handle table.
+    std::optional<std::string> historyPath;
+    // --history: report the holders of this object; without it, frames are listed.
+    std::optional<uint64_t> heldAddress;
+    // --history time range in milliseconds since the Unix epoch (UTC); open-ended if unset.
+    std::optional<int64_t> fromMs;
+    std::optional<int64_t> toMs;
+    // If true, print NT call latency percentiles overall, per type index and
+    // per process after the report.
+    bool latencyReport = false;
+    // If set, also list the NT calls that took at least this many milliseconds.
+    std::optional<uint32_t> slowLogMs;
+    // If true, count heap allocations per pipeline stage and print them, per
+    // handle, after the report.
+    bool stats = false;
+    // If set, all report output goes to this file through a background writer.
+    std::optional<std::string> outputPath;
+    // If set, write per-process and per-type handle counts as OpenMetrics
+    // text to this file ("-" for standard output) instead of the report.
+    std::optional<std::string> openMetricsPath;
+    // If set, serve the same exposition at http://127.0.0.1:<port>/metrics,
+    // taking one snapshot per scrape.
+    std::optional<uint16_t> openMetricsPort;
+    // If set, fold the filtered snapshot into the distinct-count and
+    // heavy-hitter sketches in this file (created if missing) and print them.
+    std::optional<std::string> sketchPath;
+    // --sketch: instead of taking a snapshot, replace the file with the merge
+    // of these sketch files (e.g. one per host).
+    std::vector<std::string> sketchMergePaths;
+    // If set, run every query in this file against one handle snapshot.
+    std::optional<std::string> batchPath;
+    // --batch: write each query's output to its own file in this directory
+    // instead of separate sections on standard output.
+    std::optional<std::string> batchOutputDir;
+    // If set, publish the filtered snapshot, every field resolved, to this
+    // named shared-memory region instead of printing it, once per interval.
+    std::optional<std::string> publishName;
+    // --publish: milliseconds between snapshots (default 5 s), and how many
+    // to publish before exiting (default: until interrupted).
+    std::optional<uint32_t> publishIntervalMs;
+    std::optional<uint64_t> publishCount;
+    // If set, write the filtered snapshot, every field resolved and sorted by
+    // --sort, to this snapshot file for a later --merge.
+    std::optional<std::string> exportPath;
+    // --export: host name stored in the file (default: this computer's name).
+    std::optional<std::string> exportHost;
+    // If set, merge these snapshot files (a directory stands for every *.snap
+    // file in it) into one host-tagged listing instead of taking a snapshot.
+    std::vector<std::string> mergePaths;
+};
+
+// One line of a --batch query file: a full set of filter, sort and output options.
+struct BatchQuery {
+    // 1-based line number in the query file, for diagnostics.
+    std::size_t line{};
+    std::string text;
+    CliOptions options;
 };
 
 // High-level enriched handle model used by app-level pipeline.
+// String fields are ids into the snapshot's StringInterner.
 struct HandleInfo {
     uint32_t pid{};
-    std::string processName;
-    std::string handleType;
-    std::string objectName;
+    StringId processName{};
+    StringId handleType{};
+    StringId objectName{};
     uint32_t grantedAccess{};
     std::uintptr_t objectAddress{};
     std::uintptr_t handleValue{};
     uint16_t objectTypeIndex{};
     uint32_t handleAttributes{};
-};
\ No newline at end of file
+};
+
+// One kernel object held by several processes (--shared-objects).
+struct SharedObjectInfo {
+    std::uintptr_t objectAddress{};
+    StringId handleType{};
+    StringId objectName{};
+    std::size_t processCount{};
+    // One row per handle to the object; type and name are left empty.
+    std::vector<HandleInfo> holders;
+};
+
+// Matching handles held by one process (--count --top).
+struct ProcessHandleCount {
+    uint32_t pid{};
+    StringId processName{};
+    std::size_t handleCount{};
+};
+
+// Estimated matching handles of one process or type (--sample).
+struct EstimatedGroup {
+    uint32_t pid{};
+    // Process name, or the type name for a type group.
+    StringId label{};
+    double estimate{};
+    // 95% confidence interval.
+    double low{};
+    double high{};
+};
+
+// A handle found in a history file (--history --held), with the timestamps of
+// the first and last recorded frames that contained it.
+struct HeldInterval {
+    HandleInfo handle;
+    int64_t firstSeenMs{};
+    int64_t lastSeenMs{};
+};
@@ -0,0 +1,142 @@
+#include "alloc_tracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace alloc {
+
+namespace {
+
+// One cache line per stage: filter workers count into the same stage at once.
+struct alignas(64) StageCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> frees{0};
+};
+
+// Constant-initialized: operator new may run before any dynamic initializer.
+constinit std::atomic<bool> g_enabled{false};
+constinit std::array<StageCounters, kStageCount> g_counters{};
+constinit thread_local Stage t_stage = Stage::Other;
+
+void record_allocation(const std::size_t size) noexcept {
+    if (!g_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    StageCounters& counters = g_counters[static_cast<std::size_t>(t_stage)];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void record_free(const void* pointer) noexcept {
+    if (pointer == nullptr || !g_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    g_counters[static_cast<std::size_t>(t_stage)].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size) {
+    record_allocation(size);
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* pointer = std::malloc(size)) {
+            return pointer;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* allocate_nothrow(const std::size_t size) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocate(void* pointer) noexcept {
+    record_free(pointer);
+    std::free(pointer);
+}
+
+} // namespace
+
+std::string_view stage_name(const Stage stage) noexcept {
+    switch (stage) {
+    case Stage::Other: return "other";
+    case Stage::Acquire: return "acquire";
+    case Stage::Filter: return "filter";
+    case Stage::Map: return "map";
+    case Stage::Sort: return "sort";
+    case Stage::Print: return "print";
+    }
+    return "unknown";
+}
+
+void enable() noexcept {
+    for (StageCounters& counters : g_counters) {
+        counters.allocations.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.frees.store(0, std::memory_order_relaxed);
+    }
+    g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void disable() noexcept {
+    g_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool enabled() noexcept {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+Counts counts(const Stage stage) noexcept {
+    const StageCounters& counters = g_counters[static_cast<std::size_t>(stage)];
+    return Counts{
+        .allocations = counters.allocations.load(std::memory_order_relaxed),
+        .bytes = counters.bytes.load(std::memory_order_relaxed),
+        .frees = counters.frees.load(std::memory_order_relaxed)};
+}
+
+std::array<Counts, kStageCount> all_counts() noexcept {
+    std::array<Counts, kStageCount> all{};
+    for (std::size_t stage = 0; stage < kStageCount; ++stage) {
+        all[stage] = counts(static_cast<Stage>(stage));
+    }
+    return all;
+}
+
+StageScope::StageScope(const Stage stage) noexcept : m_active(enabled()) {
+    if (m_active) {
+        m_previous = std::exchange(t_stage, stage);
+    }
+}
+
+StageScope::~StageScope() {
+    if (m_active) {
+        t_stage = m_previous;
+    }
+}
+
+} // namespace alloc
+
+// Replacements for the global allocation functions; the array, nothrow and
+// sized forms all route through the same counted pair.
+void* operator new(const std::size_t size) { return alloc::allocate(size); }
+void* operator new[](const std::size_t size) { return alloc::allocate(size); }
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept { return alloc::allocate_nothrow(size); }
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept { return alloc::allocate_nothrow(size); }
+void operator delete(void* pointer) noexcept { alloc::deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { alloc::deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { alloc::deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { alloc::deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { alloc::deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { alloc::deallocate(pointer); }
@@ -1,66 +1,232 @@
 #include "app.hpp"
 
+#include "alloc_tracker.hpp"
+#include "async_writer.hpp"
 #include "cli_parser.hpp"
+#include "external_sort.hpp"
+#include "fleet_merge.hpp"
+#include "handle_sort.hpp"
+#include "history_store.hpp"
+#include "latency.hpp"
+#include "metrics.hpp"
 #include "nt.hpp"
+#include "parallel_filter.hpp"
+#include "pipeline.hpp"
 #include "printer.hpp"
-#include "string_utils.hpp"
+#include "progressive.hpp"
+#include "sampling.hpp"
+#include "shared_objects.hpp"
+#include "sketch.hpp"
+#include "snapshot_shm.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <filesystem>
 #include <format>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <random>
 #include <ranges>
 #include <string>
-#include <unordered_set>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
-const std::string& HandleEnumApp::get_cached_process_name(const uint32_t pid) {
-    if (const auto cache_it = m_process_name_cache.find(pid); cache_it != m_process_name_cache.end()) {
-        return cache_it->second;
+StringId HandleEnumApp::get_cached_process_name(const uint32_t pid) {
+    return process_name_entry(pid).id;
+}
+
+PidTable::Entry HandleEnumApp::process_name_entry(const uint32_t pid) {
+    if (const auto cached = m_process_names.find(pid)) {
+        return *cached;
+    }
+
+    // Misses intern into m_strings and publish, both of which take the lock;
+    // another filter thread may have published this pid in the meantime.
+    const std::lock_guard lock(m_process_name_mutex);
+    if (const auto cached = m_process_names.find(pid)) {
+        return *cached;
+    }
+
+    StringId name = StringInterner::kEmpty;
+    if (const std::string* cached = m_process_cache.name(pid)) {
+        name = m_strings.intern(*cached);
+    } else {
+        const std::string resolved = nt::get_process_name_by_pid(pid);
+        if (resolved != "Unknown") {
+            m_process_cache.store(pid, resolved);
+        }
+        name = m_strings.intern(resolved);
+    }
+    return m_process_names.publish(pid, PidTable::Entry{.id = name, .name = m_strings.view(name)});
+}
+
+void HandleEnumApp::refresh_caches(const std::span<const nt::RawHandle> handles) {
+    auto processes = nt::query_process_snapshot();
+    const std::lock_guard process_lock(m_process_name_mutex);
+    const std::lock_guard object_lock(m_object_cache_mutex);
+    if (!processes) {
+        // Without creation times a reused pid cannot be told apart: start over
+        // and cache nothing per process this run.
+        m_process_refresh = ProcessCache::RefreshStats{.changed = true, .evicted = m_process_cache.named_count()};
+        m_process_cache.clear();
+        m_objects_evicted = m_object_cache.refresh({}, m_process_cache);
+        return;
+    }
+
+    m_process_refresh = m_process_cache.refresh(*processes);
+    m_objects_evicted = m_object_cache.refresh(handles, m_process_cache);
+}
+
+std::expected<std::vector<nt::RawHandle>, std::string> HandleEnumApp::acquire_snapshot() {
+    const alloc::StageScope stage(alloc::Stage::Acquire);
+    auto handles_result = nt::query_system_handles();
+    if (!handles_result) {
+        return std::unexpected(std::format("failed to query system handles ({})", handles_result.error().message()));
+    }
+    refresh_caches(*handles_result);
+    m_snapshot_handles = handles_result->size();
+    return std::move(*handles_result);
+}
+
+std::expected<std::string, nt::Error> HandleEnumApp::query_type_cached(const nt::RawHandle& raw_handle) {
+    const HandleKey key{.pid = raw_handle.processId, .handleValue = raw_handle.handleValue};
+    {
+        const std::lock_guard lock(m_object_cache_mutex);
+        if (const std::string* cached = m_object_cache.type_name(raw_handle.objectTypeIndex)) {
+            return *cached;
+        }
+        if (const auto failed = m_type_failures.find(key); failed != m_type_failures.end()) {
+            return std::unexpected(failed->second);
+        }
+    }
+
+    auto type_result = nt::query_object_type(raw_handle);
+    const std::lock_guard lock(m_object_cache_mutex);
+    if (type_result) {
+        m_object_cache.store_type(raw_handle.objectTypeIndex, *type_result);
+    } else if (m_memoize_lookups) {
+        m_type_failures.emplace(key, type_result.error());
+    }
+    return type_result;
+}
+
+std::expected<std::string, nt::Error> HandleEnumApp::query_name_cached(const nt::RawHandle& raw_handle) {
+    const HandleKey key{.pid = raw_handle.processId, .handleValue = raw_handle.handleValue};
+    std::optional<uint64_t> create_time;
+    {
+        const std::lock_guard lock(m_process_name_mutex);
+        create_time = m_process_cache.create_time(static_cast<uint32_t>(raw_handle.processId));
+    }
+    {
+        const std::lock_guard lock(m_object_cache_mutex);
+        if (const auto memo = m_name_memo.find(key); memo != m_name_memo.end()) {
+            return memo->second;
+        }
+        if (const std::string* cached = m_object_cache.object_name(raw_handle, create_time)) {
+            return *cached;
+        }
+    }
+
+    auto name_result = m_name_resolver->resolve(raw_handle);
+    if (!name_result && name_result.error() == std::errc::timed_out) {
+        // The call itself is only timed if it ever returns.
+        latency::recorder().record_timeout(latency::Call::NameQuery, static_cast<uint32_t>(raw_handle.processId),
+                                           raw_handle.objectTypeIndex, raw_handle.grantedAccess, raw_handle.handleValue,
+                                           m_name_resolver->deadline());
+    }
+    const std::lock_guard lock(m_object_cache_mutex);
+    if (name_result && create_time) {
+        m_object_cache.store_object(raw_handle, *create_time, *name_result);
+    }
+    if (m_memoize_lookups) {
+        m_name_memo.emplace(key, name_result);
+    }
+    return name_result;
+}
+
+HandleEnumApp::FieldPlan HandleEnumApp::plan_fields(const Parser& options) {
+    const auto shows = [&](const Column column) {
+        return std::ranges::find(options.columns, column) != options.columns.end();
+    };
+
+    // Merged files can be listed with any columns, so exports carry them all.
+    if (options.exportPath) {
+        return FieldPlan{.processName = true, .handleType = true, .objectName = true};
+    }
+
+    // Shared-object holders only list owners; type and name are resolved
+    // once per reported object instead.
+    if (options.sharedObjectsMin) {
+        return FieldPlan{.processName = true, .handleType = false, .objectName = false};
+    }
+
+    // Filters run on raw handles before mapping, so only columns and the
+    // sort key decide what map_to_info has to resolve.
+    return FieldPlan{
+        .processName = shows(Column::Process),
+        .handleType = shows(Column::Type) || options.sortBy == SortField::Type,
+        .objectName = shows(Column::Name) || options.sortBy == SortField::Name
+    };
+}
+
+StringId HandleEnumApp::resolve_type(const nt::RawHandle& raw_handle) {
+    const auto type_result = query_type_cached(raw_handle);
+    return m_strings.intern(type_result ? std::string_view(*type_result) : "N/A");
+}
+
+StringId HandleEnumApp::resolve_name(const nt::RawHandle& raw_handle) {
+    return intern_name(query_name_cached(raw_handle));
+}
+
+StringId HandleEnumApp::resolve_name_adaptive(const nt::RawHandle& raw_handle) {
+    if (!m_skip_unnamed_types) {
+        return resolve_name(raw_handle);
+    }
+    // Skipped handles print an empty name, like queried unnamed objects.
+    if (!m_name_policy.should_query(raw_handle.objectTypeIndex)) {
+        return StringInterner::kEmpty;
     }
+    return resolve_name_recorded(raw_handle);
+}
 
-    const auto [inserted_it, inserted] = m_process_name_cache.emplace(pid, nt::get_process_name_by_pid(pid));
-    (void)inserted;
-    return inserted_it->second;
+StringId HandleEnumApp::resolve_name_recorded(const nt::RawHandle& raw_handle) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto name_result = query_name_cached(raw_handle);
+    m_name_policy.record(raw_handle.objectTypeIndex, name_result && !name_result->empty(),
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+    return intern_name(name_result);
+}
+
+StringId HandleEnumApp::intern_name(const std::expected<std::string, nt::Error>& name_result) {
+    if (name_result) {
+        return m_strings.intern(*name_result);
+    }
+    return m_strings.intern(name_result.error() == std::errc::timed_out ? "Timed Out" : "N/A");
 }
 
 HandleInfo HandleEnumApp::map_to_info(const nt::RawHandle& raw_handle) {
+    return map_to_info(raw_handle, m_fields);
+}
+
+HandleInfo HandleEnumApp::map_to_info(const nt::RawHandle& raw_handle, const FieldPlan& fields) {
+    const alloc::StageScope stage(alloc::Stage::Map);
+    ++m_mapped_rows;
     const uint32_t pid = raw_handle.processId > static_cast<std::uintptr_t>(std::numeric_limits<uint32_t>::max())
         ? std::numeric_limits<uint32_t>::max()
         : static_cast<uint32_t>(raw_handle.processId);
 
-    const std::string& process_name = get_cached_process_name(pid);
-
-    const auto type_result = nt::query_object_type(raw_handle);
-    const std::string handle_type = type_result ? *type_result : "N/A";
-    
-    std::string object_name;
-    
-    // Refined Anti-deadlock bypass: skip name queries ONLY for risky pipes/sockets
-    bool is_risky_pipe = false;
-    
-    if (handle_type == "File") {
-        if (raw_handle.grantedAccess == 0x0012019F || 
-            raw_handle.grantedAccess == 0x001A019F ||
-            raw_handle.grantedAccess == 0x00120189 ||
-            raw_handle.grantedAccess == 0x00100000 ||
-            raw_handle.grantedAccess == 0x001F0003) {
-            is_risky_pipe = true;
-        }
-    }
-    
-    if (is_risky_pipe) {
-        object_name = "Locked (Anti-Deadlock)";
-    } else {
-        const auto name_result = nt::query_object_name(raw_handle);
-        if (!name_result) {
-            object_name = "N/A";
-        } else {
-            object_name = *name_result;
-        }
-    }
+    const StringId process_name = fields.processName ? get_cached_process_name(pid) : StringInterner::kEmpty;
+
+    const StringId handle_type = fields.handleType ? resolve_type(raw_handle) : StringInterner::kEmpty;
+    // Not printed or sorted on: skip the most expensive query entirely.
+    const StringId object_name = fields.objectName ? resolve_name_adaptive(raw_handle) : StringInterner::kEmpty;
 
     return HandleInfo{
         .pid = pid,
@@ -75,59 +241,829 @@ HandleInfo HandleEnumApp::map_to_info(const nt::RawHandle& raw_handle) {
     };
 }
 
-void HandleEnumApp::sort_handles(std::vector<HandleInfo>& handles, const SortField sort_by) {
-    switch (sort_by) {
-    case SortField::Pid:
-        std::ranges::sort(handles, [](const HandleInfo& left, const HandleInfo& right) {
-            if (left.pid != right.pid) {
-                return left.pid < right.pid;
+HandleInfo HandleEnumApp::map_from_caches(const nt::RawHandle& raw_handle, const StringId unresolved) {
+    HandleInfo row = map_to_info(raw_handle, FieldPlan{.processName = false, .handleType = false, .objectName = false});
+    std::optional<uint64_t> create_time;
+    if (m_fields.processName || m_fields.objectName) {
+        const std::lock_guard lock(m_process_name_mutex);
+        create_time = m_process_cache.create_time(row.pid);
+        if (m_fields.processName) {
+            row.processName = unresolved;
+            if (const auto published = m_process_names.find(row.pid)) {
+                row.processName = published->id;
+            } else if (const std::string* cached = m_process_cache.name(row.pid)) {
+                const StringId name = m_strings.intern(*cached);
+                row.processName = m_process_names.publish(row.pid, PidTable::Entry{.id = name, .name = m_strings.view(name)}).id;
+            }
+        }
+    }
+
+    const std::lock_guard lock(m_object_cache_mutex);
+    if (m_fields.handleType) {
+        const std::string* cached = m_object_cache.type_name(raw_handle.objectTypeIndex);
+        row.handleType = cached ? m_strings.intern(*cached) : unresolved;
+    }
+    if (m_fields.objectName) {
+        if (const std::string* cached = m_object_cache.object_name(raw_handle, create_time)) {
+            row.objectName = m_strings.intern(*cached);
+        } else if (m_skip_unnamed_types && !m_name_policy.should_query(raw_handle.objectTypeIndex)) {
+            // The skip is counted here; phase two queries only what is left.
+            row.objectName = StringInterner::kEmpty;
+        } else {
+            row.objectName = unresolved;
+        }
+    }
+    return row;
+}
+
+int HandleEnumApp::report_progressive(const Parser& options,
+                                      std::span<const nt::RawHandle> handles,
+                                      const std::size_t total_raw_count) {
+    const progressive::Budget budget(m_run_start, std::chrono::milliseconds(*options.deadlineMs));
+    const std::size_t matching_count = handles.size();
+    if (options.limit && handles.size() > *options.limit) {
+        handles = handles.first(*options.limit);
+    }
+
+    // Phase one: no NT calls, so every row exists however little time is left.
+    // "<unresolved>" cannot be a process image or type name.
+    const StringId unresolved = m_strings.intern("<unresolved>");
+    std::vector<HandleInfo> rows;
+    rows.reserve(handles.size());
+    for (const nt::RawHandle& raw_handle : handles) {
+        rows.push_back(map_from_caches(raw_handle, unresolved));
+    }
+    const auto phase_one = budget.elapsed();
+
+    // Phase two: no lookup starts after the deadline, and a name query that
+    // started before it is bounded by --name-timeout.
+    const std::vector<progressive::Lookup> lookups = progressive::plan(rows, unresolved);
+    std::unordered_map<uint16_t, StringId> types;
+    std::size_t started = 0;
+    for (; started < lookups.size() && !budget.expired(); ++started) {
+        const alloc::StageScope stage(alloc::Stage::Map);
+        const progressive::Lookup& lookup = lookups[started];
+        const nt::RawHandle& raw_handle = handles[lookup.row];
+        switch (lookup.field) {
+        case progressive::Field::ProcessName:
+            // Published into m_process_names; every row of the pid is filled below.
+            get_cached_process_name(rows[lookup.row].pid);
+            break;
+        case progressive::Field::HandleType:
+            types.emplace(raw_handle.objectTypeIndex, resolve_type(raw_handle));
+            break;
+        case progressive::Field::ObjectName:
+            rows[lookup.row].objectName = m_skip_unnamed_types ? resolve_name_recorded(raw_handle) : resolve_name(raw_handle);
+            break;
+        }
+    }
+    for (HandleInfo& row : rows) {
+        if (row.processName == unresolved) {
+            if (const auto published = m_process_names.find(row.pid)) {
+                row.processName = published->id;
             }
-            return left.handleValue < right.handleValue;
+        }
+        if (row.handleType == unresolved) {
+            if (const auto type = types.find(row.objectTypeIndex); type != types.end()) {
+                row.handleType = type->second;
+            }
+        }
+    }
+
+    const progressive::Completeness completeness =
+        progressive::measure(rows, {m_fields.processName, m_fields.handleType, m_fields.objectName}, unresolved);
+    // Pid order is snapshot order, as in the streaming listing.
+    if (options.sortBy != SortField::Pid) {
+        const alloc::StageScope stage(alloc::Stage::Sort);
+        sorting::sort_handles(rows, options.sortBy, m_strings);
+    }
+
+    const HandlePrinter printer(options.columns);
+    printer.print_preamble(options, total_raw_count);
+    printer.print_header();
+    for (const HandleInfo& row : rows) {
+        const alloc::StageScope stage(alloc::Stage::Print);
+        printer.print_row(row, m_strings);
+    }
+    printer.print_footer(matching_count, rows.size());
+    printer.print_completeness(completeness, {m_fields.processName, m_fields.handleType, m_fields.objectName},
+                               budget.budget(), budget.elapsed(), lookups.size() - started);
+    if (options.verbose) {
+        std::cout << std::format("Phase one: {} rows from raw fields and caches after {:.1f} ms, {} lookups planned\n",
+                                 rows.size(), std::chrono::duration<double, std::milli>(phase_one).count(), lookups.size());
+    }
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::report_shared_objects(const Parser& options,
+                                         const std::span<const nt::RawHandle> handles,
+                                         const std::size_t total_raw_count) {
+    const shared_objects::Report report = shared_objects::find(
+        handles, *options.sharedObjectsMin, options.topN.value_or(std::numeric_limits<std::size_t>::max()));
+
+    // Type and name are per object, so they are resolved once per reported
+    // group (types once per type index), never for the rest of the table.
+    std::unordered_map<uint16_t, StringId> type_by_index;
+    const StringId not_available = m_strings.intern("N/A");
+    std::vector<SharedObjectInfo> objects;
+    objects.reserve(report.groups.size());
+    for (const shared_objects::Group& group : report.groups) {
+        const std::span<const nt::RawHandle> holders = report.holders(group);
+        const nt::RawHandle& first = holders.front();
+        auto type_it = type_by_index.find(group.objectTypeIndex);
+        if (type_it == type_by_index.end()) {
+            type_it = type_by_index.emplace(group.objectTypeIndex, resolve_type(first)).first;
+        }
+
+        // Protected holders (e.g. System) refuse duplication; try a few others.
+        StringId object_name = resolve_name(first);
+        for (std::size_t i = 1; i < std::min<std::size_t>(holders.size(), 3) && object_name == not_available; ++i) {
+            object_name = resolve_name(holders[i]);
+        }
+
+        SharedObjectInfo object{
+            .objectAddress = group.objectAddress,
+            .handleType = type_it->second,
+            .objectName = object_name,
+            .processCount = group.processCount,
+            .holders = {}
+        };
+        object.holders.reserve(holders.size());
+        for (const nt::RawHandle& handle : holders) {
+            object.holders.push_back(map_to_info(handle));
+        }
+        objects.push_back(std::move(object));
+    }
+
+    const HandlePrinter printer;
+    printer.print_shared_objects(objects, m_strings, options, total_raw_count);
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::report_top_rows(const Parser& options,
+                                   const std::span<const nt::RawHandle> handles,
+                                   const std::size_t total_raw_count) {
+    // Offer every row with only its sort key resolved; the other fields are
+    // resolved for the N winners alone.
+    const FieldPlan key_fields{
+        .processName = false,
+        .handleType = options.sortBy == SortField::Type,
+        .objectName = options.sortBy == SortField::Name
+    };
+    sorting::TopRows top(*options.topN, handles.size(), options.sortBy, m_strings);
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        HandleInfo row = map_to_info(handles[i], key_fields);
+        const alloc::StageScope stage(alloc::Stage::Sort);
+        top.offer(row, i);
+    }
+
+    const FieldPlan rest_fields{
+        .processName = m_fields.processName,
+        .handleType = m_fields.handleType && !key_fields.handleType,
+        .objectName = m_fields.objectName && !key_fields.objectName
+    };
+    const HandlePrinter printer(options.columns);
+    printer.print_preamble(options, total_raw_count);
+    printer.print_header();
+    const std::vector<sorting::TopRows::Entry> winners = [&] {
+        const alloc::StageScope stage(alloc::Stage::Sort);
+        return top.take_sorted();
+    }();
+    for (const sorting::TopRows::Entry& entry : winners) {
+        HandleInfo row = map_to_info(handles[entry.source], rest_fields);
+        if (key_fields.handleType) {
+            row.handleType = entry.row.handleType;
+        }
+        if (key_fields.objectName) {
+            row.objectName = entry.row.objectName;
+        }
+        const alloc::StageScope stage(alloc::Stage::Print);
+        printer.print_row(row, m_strings);
+    }
+    printer.print_footer(handles.size(), winners.size());
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::report_top_processes(const Parser& options,
+                                        const std::span<const nt::RawHandle> handles,
+                                        const std::size_t total_raw_count) {
+    std::unordered_map<uint32_t, std::size_t> counts;
+    for (const nt::RawHandle& raw_handle : handles) {
+        ++counts[static_cast<uint32_t>(std::min<std::uintptr_t>(raw_handle.processId, std::numeric_limits<uint32_t>::max()))];
+    }
+
+    std::vector<ProcessHandleCount> processes;
+    processes.reserve(counts.size());
+    for (const auto& [pid, count] : counts) {
+        processes.push_back(ProcessHandleCount{.pid = pid, .handleCount = count});
+    }
+    // Names are resolved for the reported processes only.
+    const std::size_t kept = std::min(*options.topN, processes.size());
+    std::ranges::partial_sort(processes, processes.begin() + static_cast<std::ptrdiff_t>(kept),
+                              [](const ProcessHandleCount& left, const ProcessHandleCount& right) {
+        return std::tie(right.handleCount, left.pid) < std::tie(left.handleCount, right.pid);
+    });
+    processes.resize(kept);
+    for (ProcessHandleCount& process : processes) {
+        process.processName = get_cached_process_name(process.pid);
+    }
+
+    const HandlePrinter printer;
+    printer.print_process_counts(processes, m_strings, options, total_raw_count, handles.size());
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::report_sample(const Parser& options,
+                                 const sampling::Sample& sample,
+                                 const std::span<const nt::RawHandle> selected,
+                                 const std::size_t total_raw_count,
+                                 const uint64_t seed) {
+    sampling::Estimator matching(sample);
+    sampling::Estimator by_process(sample);
+    sampling::Estimator by_type(sample);
+    std::unordered_map<uint16_t, const nt::RawHandle*> type_example;
+    for (const nt::RawHandle& raw_handle : selected) {
+        matching.add(raw_handle, 0);
+        by_process.add(raw_handle, std::min<std::uintptr_t>(raw_handle.processId, std::numeric_limits<uint32_t>::max()));
+        by_type.add(raw_handle, raw_handle.objectTypeIndex);
+        type_example.try_emplace(raw_handle.objectTypeIndex, &raw_handle);
+    }
+
+    // Largest estimates first; names are resolved for the shown groups only.
+    const std::size_t shown = options.topN.value_or(sampling::kDefaultGroups);
+    const auto largest = [shown](const sampling::Estimator& estimator) {
+        std::vector<std::pair<uint64_t, sampling::Estimate>> groups;
+        for (const uint64_t group : estimator.groups()) {
+            groups.emplace_back(group, estimator.estimate(group));
+        }
+        const std::size_t kept = std::min(shown, groups.size());
+        std::ranges::partial_sort(groups, groups.begin() + static_cast<std::ptrdiff_t>(kept), [](const auto& left, const auto& right) {
+            return left.second.value != right.second.value ? left.second.value > right.second.value : left.first < right.first;
         });
-        break;
-    case SortField::Type:
-        std::ranges::sort(handles, [](const HandleInfo& left, const HandleInfo& right) {
-            const std::string left_type = utils::to_lower_ascii(left.handleType);
-            const std::string right_type = utils::to_lower_ascii(right.handleType);
-            if (left_type != right_type) {
-                return left_type < right_type;
+        groups.resize(kept);
+        return groups;
+    };
+
+    std::vector<EstimatedGroup> processes;
+    std::vector<EstimatedGroup> types;
+    if (!options.showCountOnly) {
+        for (const auto& [pid, estimate] : largest(by_process)) {
+            processes.push_back(EstimatedGroup{
+                .pid = static_cast<uint32_t>(pid),
+                .label = get_cached_process_name(static_cast<uint32_t>(pid)),
+                .estimate = estimate.value, .low = estimate.low, .high = estimate.high});
+        }
+        for (const auto& [type_index, estimate] : largest(by_type)) {
+            types.push_back(EstimatedGroup{
+                .label = resolve_type(*type_example.at(static_cast<uint16_t>(type_index))),
+                .estimate = estimate.value, .low = estimate.low, .high = estimate.high});
+        }
+    }
+
+    const HandlePrinter printer;
+    printer.print_sample_estimates(options, total_raw_count, sample.handles.size(), matching.estimate(0), processes, types, m_strings);
+    if (options.verbose) {
+        std::cout << std::format("Sample seed: {} ({} of {} sampled handles matched)\n", seed, selected.size(), sample.handles.size());
+    }
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+std::string HandleEnumApp::render_metrics(const Parser& options,
+                                         const std::span<const nt::RawHandle> handles,
+                                         const std::size_t total_raw_count) {
+    // Counting reads raw fields only; names are looked up for the kept series
+    // alone: K process names and one type query per kept type index.
+    const metrics::Summary summary = metrics::summarize(handles, options.topN.value_or(metrics::kDefaultTopK));
+    return metrics::render(summary, total_raw_count, metrics::Labels{
+        .processName = [this](const uint32_t pid) { return m_strings.view(get_cached_process_name(pid)); },
+        .typeName = [&](const metrics::TypeCount& type) { return m_strings.view(resolve_type(handles[type.sample])); }
+    });
+}
+
+int HandleEnumApp::export_metrics(const Parser& options,
+                                  const std::span<const nt::RawHandle> handles,
+                                  const std::size_t total_raw_count) {
+    const std::string text = render_metrics(options, handles, total_raw_count);
+    if (*options.openMetricsPath == "-") {
+        // Standard output carries the exposition alone, so no diagnostics.
+        std::cout << text;
+        return EXIT_SUCCESS;
+    }
+
+    if (auto written = metrics::write_textfile(*options.openMetricsPath, text); !written) {
+        std::cerr << std::format("Error: {}\n", written.error());
+        return EXIT_FAILURE;
+    }
+    if (options.verbose) {
+        std::cout << std::format("OpenMetrics: {} matching handles written to {}\n", handles.size(), *options.openMetricsPath);
+    }
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::serve_metrics(const Parser& options) {
+    auto server = metrics::LoopbackServer::listen(*options.openMetricsPort);
+    if (!server) {
+        std::cerr << std::format("Error: {}\n", server.error());
+        return EXIT_FAILURE;
+    }
+    std::cout << std::format("Serving OpenMetrics at http://127.0.0.1:{}/metrics\n", server->port()) << std::flush;
+
+    const parallel::ParallelOptions filter_parallelism{.threads = options.threads};
+    const parallel::HandlePredicate matches = [this](const nt::RawHandle& handle) {
+        const alloc::StageScope stage(alloc::Stage::Filter);
+        return m_filter.matches(handle, m_filter_resolvers);
+    };
+    // One kernel query per scrape; names stay cached across scrapes.
+    const metrics::LoopbackServer::Body scrape = [&]() -> std::expected<std::string, std::string> {
+        m_process_names.clear();
+        m_strings.clear();
+        auto handles = acquire_snapshot();
+        if (!handles) {
+            return std::unexpected(handles.error());
+        }
+        const std::size_t total_raw_count = handles->size();
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(*handles)
+            : parallel::select(*handles, matches, filter_parallelism);
+        return render_metrics(options, selected, total_raw_count);
+    };
+
+    while (true) {
+        if (auto served = server->serve_one(scrape); !served) {
+            std::cerr << std::format("Error: {}\n", served.error());
+            return EXIT_FAILURE;
+        }
+    }
+}
+
+int HandleEnumApp::publish_snapshots(const Parser& options) {
+    // Readers get every field, whatever --columns would print.
+    m_fields = FieldPlan{.processName = true, .handleType = true, .objectName = true};
+    m_skip_unnamed_types = !options.allNames && !m_filter.uses(filter_expr::Field::Name);
+    const parallel::ParallelOptions filter_parallelism{.threads = options.threads};
+    const parallel::HandlePredicate matches = [this](const nt::RawHandle& handle) {
+        const alloc::StageScope stage(alloc::Stage::Filter);
+        return m_filter.matches(handle, m_filter_resolvers);
+    };
+    const auto interval = std::chrono::milliseconds(options.publishIntervalMs.value_or(5000));
+
+    // Created on the first snapshot, sized from it, and replaced when a
+    // snapshot no longer fits.
+    std::optional<shm::Publisher> publisher;
+    uint64_t last_generation = 0;
+    for (uint64_t published = 0; !options.publishCount || published < *options.publishCount; ++published) {
+        if (published != 0) {
+            std::this_thread::sleep_for(interval);
+        }
+        // Names stay cached across snapshots; the interner is per snapshot.
+        m_process_names.clear();
+        m_strings.clear();
+        auto handles = acquire_snapshot();
+        if (!handles) {
+            std::cerr << std::format("Error: {}\n", handles.error());
+            return EXIT_FAILURE;
+        }
+        const std::size_t total_raw_count = handles->size();
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(*handles)
+            : parallel::select(*handles, matches, filter_parallelism);
+        std::vector<HandleInfo> rows;
+        rows.reserve(selected.size());
+        for (const nt::RawHandle& raw_handle : selected) {
+            rows.push_back(map_to_info(raw_handle));
+        }
+
+        const std::size_t needed = shm::payload_bytes(rows, m_strings);
+        if (publisher && needed > publisher->slot_capacity()) {
+            // The table outgrew the slots. Readers see the region retired and
+            // reopen the name; the replacement continues the generations.
+            last_generation = publisher->generation();
+            publisher->retire();
+            publisher.reset();
+        }
+        if (!publisher) {
+            // Twice the snapshot, so the handle table can grow.
+            auto created = shm::Publisher::create(*options.publishName, std::max<std::size_t>(2 * needed, 1 << 20),
+                                                  last_generation);
+            if (!created && last_generation == 0) {
+                std::cerr << std::format("Error: {}\n", created.error());
+                return EXIT_FAILURE;
+            }
+            if (!created) {
+                // Readers may still hold the retired name (Windows keeps it until they close it).
+                std::cerr << std::format("Warning: skipped a snapshot of {} handles: {}; retrying next interval\n",
+                                         rows.size(), created.error());
+                continue;
+            }
+            publisher.emplace(std::move(*created));
+            std::cout << std::format("{} shared memory '{}' (2 slots of {} bytes)\n",
+                                     last_generation == 0 ? "Publishing to" : "Grew", *options.publishName,
+                                     publisher->slot_capacity()) << std::flush;
+        }
+        const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+        const auto generation = publisher->publish(rows, m_strings, total_raw_count, now.time_since_epoch().count());
+        if (!generation) {
+            std::cerr << std::format("Error: {}\n", generation.error());
+            return EXIT_FAILURE;
+        }
+        if (options.verbose) {
+            std::cout << std::format("Published generation {}: {} of {} handles\n", *generation, rows.size(), total_raw_count)
+                      << std::flush;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::update_sketches(const Parser& options,
+                                   const std::span<const nt::RawHandle> handles,
+                                   const std::size_t total_raw_count) {
+    sketch::SketchSet sketches;
+    if (std::filesystem::exists(*options.sketchPath)) {
+        auto loaded = sketch::load(*options.sketchPath);
+        if (!loaded) {
+            std::cerr << std::format("Error: {}\n", loaded.error());
+            return EXIT_FAILURE;
+        }
+        sketches = std::move(*loaded);
+    }
+
+    // Objects are counted by kernel address; type and process counters are
+    // keyed by name so sketches from other hosts line up. Each counter is
+    // looked up once per type index and process, not once per handle.
+    std::unordered_map<uint16_t, sketch::HyperLogLog*> by_type;
+    std::unordered_map<uint32_t, sketch::HyperLogLog*> by_process;
+    for (const nt::RawHandle& raw_handle : handles) {
+        if (raw_handle.objectAddress != 0) {
+            const uint64_t object = sketch::hash_u64(raw_handle.objectAddress);
+            sketches.objects.add_hash(object);
+
+            auto type_it = by_type.find(raw_handle.objectTypeIndex);
+            if (type_it == by_type.end()) {
+                sketch::HyperLogLog& counter = sketches.objectsByType.counter(m_strings.view(resolve_type(raw_handle)));
+                type_it = by_type.emplace(raw_handle.objectTypeIndex, &counter).first;
             }
-            if (left.pid != right.pid) {
-                return left.pid < right.pid;
+            type_it->second->add_hash(object);
+
+            const uint32_t pid = static_cast<uint32_t>(std::min<std::uintptr_t>(raw_handle.processId, std::numeric_limits<uint32_t>::max()));
+            auto process_it = by_process.find(pid);
+            if (process_it == by_process.end()) {
+                sketch::HyperLogLog& counter = sketches.objectsByProcess.counter(m_strings.view(get_cached_process_name(pid)));
+                process_it = by_process.emplace(pid, &counter).first;
             }
-            return left.handleValue < right.handleValue;
+            process_it->second->add_hash(object);
+        }
+
+        // Names go straight into the sketch; they are not interned, so memory
+        // stays fixed however many distinct names stream past.
+        if (const auto name = query_name_cached(raw_handle); name && !name->empty()) {
+            sketches.names.add(*name);
+        }
+    }
+    ++sketches.snapshots;
+    sketches.handles += handles.size();
+
+    if (auto saved = sketch::save(*options.sketchPath, sketches); !saved) {
+        std::cerr << std::format("Error: {}\n", saved.error());
+        return EXIT_FAILURE;
+    }
+
+    const HandlePrinter printer;
+    printer.print_sketch_summary(options, sketches, total_raw_count, handles.size());
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::merge_sketches(const Parser& options) {
+    sketch::SketchSet merged;
+    for (const std::string& path : options.sketchMergePaths) {
+        auto loaded = sketch::load(path);
+        if (!loaded) {
+            std::cerr << std::format("Error: {}\n", loaded.error());
+            return EXIT_FAILURE;
+        }
+        if (auto result = merged.merge(*loaded); !result) {
+            std::cerr << std::format("Error: cannot merge {} ({})\n", path, result.error());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (auto saved = sketch::save(*options.sketchPath, merged); !saved) {
+        std::cerr << std::format("Error: {}\n", saved.error());
+        return EXIT_FAILURE;
+    }
+
+    const HandlePrinter printer;
+    printer.print_sketch_summary(options, merged, std::nullopt, 0);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::record_history(const Parser& options,
+                                  const std::span<const nt::RawHandle> handles,
+                                  const std::size_t total_raw_count) {
+    auto writer = history::HistoryWriter::open(*options.recordPath);
+    if (!writer) {
+        std::cerr << std::format("Error: {}\n", writer.error());
+        return EXIT_FAILURE;
+    }
+
+    // Only the fields --columns asks for are resolved; the rest are stored empty.
+    std::vector<history::Record> records;
+    records.reserve(handles.size());
+    for (const nt::RawHandle& raw_handle : handles) {
+        const HandleInfo info = map_to_info(raw_handle);
+        records.push_back(history::Record{
+            .pid = info.pid,
+            .handleValue = info.handleValue,
+            .objectAddress = info.objectAddress,
+            .grantedAccess = info.grantedAccess,
+            .objectTypeIndex = info.objectTypeIndex,
+            .processName = writer->intern(m_strings.view(info.processName)),
+            .handleType = writer->intern(m_strings.view(info.handleType)),
+            .objectName = writer->intern(m_strings.view(info.objectName))
         });
-        break;
-    case SortField::Name:
-        std::ranges::sort(handles, [](const HandleInfo& left, const HandleInfo& right) {
-            const std::string left_name = utils::to_lower_ascii(left.objectName);
-            const std::string right_name = utils::to_lower_ascii(right.objectName);
-            if (left_name != right_name) {
-                return left_name < right_name;
+    }
+
+    const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+    const std::size_t recorded_count = records.size();
+    const auto stats = writer->append(now.time_since_epoch().count(), std::move(records));
+    if (!stats) {
+        std::cerr << std::format("Error: {}\n", stats.error());
+        return EXIT_FAILURE;
+    }
+
+    const HandlePrinter printer;
+    printer.print_record_summary(options, *stats, recorded_count, total_raw_count);
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::export_snapshot(const Parser& options,
+                                   const std::span<const nt::RawHandle> handles,
+                                   const std::size_t total_raw_count) {
+    std::vector<HandleInfo> rows;
+    rows.reserve(handles.size());
+    for (const nt::RawHandle& raw_handle : handles) {
+        rows.push_back(map_to_info(raw_handle));
+    }
+    {
+        const alloc::StageScope stage(alloc::Stage::Sort);
+        sorting::sort_handles(rows, options.sortBy, m_strings);
+    }
+
+    const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+    const fleet::SnapshotInfo info{
+        .host = options.exportHost.value_or(fleet::local_host_name()),
+        .sortBy = options.sortBy,
+        .takenMs = now.time_since_epoch().count(),
+        .totalRawCount = total_raw_count};
+    const auto bytes = fleet::write_snapshot(*options.exportPath, info, rows, m_strings);
+    if (!bytes) {
+        std::cerr << std::format("Error: {}\n", bytes.error());
+        return EXIT_FAILURE;
+    }
+
+    const HandlePrinter printer;
+    printer.print_export_summary(options, info.host, rows.size(), total_raw_count, *bytes);
+    report_diagnostics(options);
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::merge_snapshots(const Parser& options) {
+    const auto paths = fleet::expand_inputs(options.mergePaths);
+    if (!paths) {
+        std::cerr << std::format("Error: {}\n", paths.error());
+        return EXIT_FAILURE;
+    }
+    auto merger = fleet::Merger::open(*paths, fleet::MergeOptions{.threads = options.threads});
+    if (!merger) {
+        std::cerr << std::format("Error: {}\n", merger.error());
+        return EXIT_FAILURE;
+    }
+    // -s pid is the default, so only another key can contradict the files.
+    const SortField sort_by = merger->sort_by();
+    if (options.sortBy != SortField::Pid && options.sortBy != sort_by) {
+        std::cerr << "Error: --sort cannot reorder a merge; the files fix the order (export them with the key you need)\n";
+        return EXIT_FAILURE;
+    }
+
+    const HandlePrinter printer(options.columns);
+    printer.print_merge_preamble(merger->input_count(), sort_by);
+    std::expected<fleet::MergeStats, std::string> stats;
+    std::size_t group_count = 0;
+    if (options.showCountOnly) {
+        // Rows arrive grouped by key, so one group is open at a time. Hosts
+        // are counted by input file; only the files seen are reset.
+        printer.print_merge_count_header(sort_by);
+        fleet::Row key;
+        std::size_t handles = 0;
+        std::vector<bool> seen(merger->input_count());
+        std::vector<std::size_t> seen_inputs;
+        const auto close_group = [&] {
+            if (handles != 0) {
+                std::cout << printer.format_merge_count(sort_by, key, handles, seen_inputs.size());
+                ++group_count;
+            }
+            for (const std::size_t input : seen_inputs) {
+                seen[input] = false;
+            }
+            seen_inputs.clear();
+            handles = 0;
+        };
+        stats = merger->run([&](const fleet::Row& row, const std::size_t input) {
+            if (handles != 0 && !fleet::same_key(key, row, sort_by)) {
+                close_group();
+            }
+            if (handles == 0) {
+                key = row;
             }
-            if (left.pid != right.pid) {
-                return left.pid < right.pid;
+            ++handles;
+            if (!seen[input]) {
+                seen[input] = true;
+                seen_inputs.push_back(input);
             }
-            return left.handleValue < right.handleValue;
         });
-        break;
+        close_group();
+    } else {
+        printer.print_merge_header();
+        stats = merger->run([&](const fleet::Row& row, const std::size_t input) {
+            std::cout << printer.format_merged_row(merger->info(input).host, row);
+        });
+    }
+    if (!stats) {
+        std::cerr << std::format("Error: {}\n", stats.error());
+        return EXIT_FAILURE;
+    }
+
+    if (options.showCountOnly) {
+        std::cout << std::format("Merged handles: {} in {} groups\n", stats->rows, group_count);
+    } else {
+        std::cout << std::format("Merged handles: {}\n", stats->rows);
+    }
+    if (options.verbose) {
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_run_start).count();
+        std::cout << std::format("Merge: {} files, {} bytes mapped, {} blocks decoded, {:.0f} rows/s\n",
+                                 merger->input_count(), stats->bytes, stats->blocks,
+                                 elapsed > 0 ? static_cast<double>(stats->rows) / elapsed : 0.0);
+    }
+    return EXIT_SUCCESS;
+}
+
+int HandleEnumApp::query_history(const Parser& options) {
+    auto reader = history::HistoryReader::open(*options.historyPath);
+    if (!reader) {
+        std::cerr << std::format("Error: {}\n", reader.error());
+        return EXIT_FAILURE;
+    }
+
+    const HandlePrinter printer;
+    if (!options.heldAddress) {
+        printer.print_history_frames(reader->frames(), options);
+        return EXIT_SUCCESS;
+    }
+
+    const auto holdings = reader->holders_of(*options.heldAddress,
+                                             options.fromMs.value_or(std::numeric_limits<int64_t>::min()),
+                                             options.toMs.value_or(std::numeric_limits<int64_t>::max()));
+    if (!holdings) {
+        std::cerr << std::format("Error: {}\n", holdings.error());
+        return EXIT_FAILURE;
+    }
+
+    std::vector<HeldInterval> intervals;
+    intervals.reserve(holdings->size());
+    for (const history::Holding& holding : *holdings) {
+        const history::Record& record = holding.record;
+        intervals.push_back(HeldInterval{
+            .handle = HandleInfo{
+                .pid = record.pid,
+                .processName = m_strings.intern(reader->text(record.processName)),
+                .handleType = m_strings.intern(reader->text(record.handleType)),
+                .objectName = m_strings.intern(reader->text(record.objectName)),
+                .grantedAccess = record.grantedAccess,
+                .objectAddress = static_cast<std::uintptr_t>(record.objectAddress),
+                .handleValue = static_cast<std::uintptr_t>(record.handleValue),
+                .objectTypeIndex = record.objectTypeIndex
+            },
+            .firstSeenMs = holding.firstSeenMs,
+            .lastSeenMs = holding.lastSeenMs
+        });
+    }
+    std::ranges::sort(intervals, [](const HeldInterval& left, const HeldInterval& right) {
+        return std::tie(left.firstSeenMs, left.handle.pid, left.handle.handleValue) <
+               std::tie(right.firstSeenMs, right.handle.pid, right.handle.handleValue);
+    });
+
+    printer.print_held_intervals(intervals, m_strings, options);
+    return EXIT_SUCCESS;
+}
+
+void HandleEnumApp::report_diagnostics(const Parser& options) const {
+    if (!options.verbose) {
+        return;
+    }
+
+    std::cout << std::format("Caches: {} process names ({} evicted{}), {} object names ({} evicted)\n",
+                             m_process_cache.named_count(),
+                             m_process_refresh.evicted,
+                             m_process_refresh.changed ? "" : ", process list unchanged",
+                             m_object_cache.object_count(),
+                             m_objects_evicted);
+
+    if (m_name_policy.skipped_count() > 0) {
+        const auto saved = std::chrono::duration<double, std::milli>(m_name_policy.estimated_savings());
+        std::cout << std::format("Name queries skipped: {} (about {:.1f} ms saved; --all-names queries every handle)\n",
+                                 m_name_policy.skipped_count(), saved.count());
+        for (const NameSkipPolicy::TypeReport& type : m_name_policy.skipped_types()) {
+            const std::string* type_name = m_object_cache.type_name(type.typeIndex);
+            std::cout << std::format("  {:<24} {:>8} skipped, {} of {} queried named, {:.1f} us per query\n",
+                                     type_name ? *type_name : std::format("type {}", type.typeIndex), type.skipped,
+                                     type.named, type.observed,
+                                     std::chrono::duration<double, std::micro>(type.averageCost).count());
+        }
+    }
+
+    if (m_name_resolver->timed_out_count() == 0) {
+        return;
+    }
+
+    std::cout << std::format("Name queries timed out: {} ({} helper workers abandoned)\n",
+                             m_name_resolver->timed_out_count(),
+                             m_name_resolver->abandoned_worker_count());
+}
+
+void HandleEnumApp::report_latency(const Parser& options) {
+    latency::Recorder& recorder = latency::recorder();
+    if (!recorder.enabled()) {
+        return;
     }
+    // Stop first: naming the slow processes below must not add samples.
+    recorder.disable();
+    const std::vector<latency::CallSummary> calls = recorder.summarize(options.topN.value_or(latency::kDefaultKeys));
+    const std::vector<latency::SlowCall> slow_calls = recorder.slow_calls();
+
+    const HandlePrinter printer;
+    printer.print_latency(
+        options, calls, slow_calls, recorder.dropped_slow_calls(),
+        [this](const uint32_t type_index) {
+            const std::string* name = type_index <= std::numeric_limits<uint16_t>::max()
+                ? m_object_cache.type_name(static_cast<uint16_t>(type_index))
+                : nullptr;
+            return name ? std::string_view(*name) : std::string_view();
+        },
+        [this](const uint32_t pid) { return m_strings.view(get_cached_process_name(pid)); });
+}
+
+void HandleEnumApp::report_allocations() {
+    if (!alloc::enabled()) {
+        return;
+    }
+    // Stop first so the report's own allocations are not counted.
+    alloc::disable();
+    const HandlePrinter printer;
+    printer.print_allocations(alloc::all_counts(), m_snapshot_handles, m_mapped_rows);
 }
 
-void HandleEnumApp::build_filters(const Parser& parsed_args) {
-    m_filters.clear();
+std::expected<void, std::string> HandleEnumApp::build_filters(const Parser& parsed_args) {
+    using filter_expr::CompareOp;
+    using filter_expr::Field;
+
+    // Every filter compiles into one flat program: the classic flags become
+    // predicates AND-ed with the --where expression.
+    std::vector<filter_expr::Node> terms;
 
     if (parsed_args.pid.has_value()) {
-        m_filters.push_back(std::make_unique<PidFilter>(*parsed_args.pid));
+        terms.push_back(filter_expr::make_test(Field::Pid, CompareOp::Equal, *parsed_args.pid));
     }
 
     if (parsed_args.handleType.has_value()) {
-        m_filters.push_back(std::make_unique<TypeFilter>(*parsed_args.handleType));
+        terms.push_back(filter_expr::make_test(Field::Type, CompareOp::Equal, *parsed_args.handleType));
     }
 
     if (parsed_args.objectName.has_value()) {
-        m_filters.push_back(std::make_unique<NameFilter>(*parsed_args.objectName));
+        terms.push_back(filter_expr::make_test(Field::Name, CompareOp::Contains, *parsed_args.objectName));
+    }
+
+    if (parsed_args.whereExpression.has_value()) {
+        auto where = filter_expr::parse(*parsed_args.whereExpression);
+        if (!where) {
+            return std::unexpected(std::format("invalid --where expression: {}", where.error()));
+        }
+        terms.push_back(std::move(*where));
     }
+
+    m_filter = terms.empty() ? filter_expr::FilterProgram{} : filter_expr::FilterProgram::compile(filter_expr::all_of(std::move(terms)));
+    m_filter_resolvers = filter_expr::FieldResolvers{
+        .typeQuery = [this](const nt::RawHandle& handle) { return query_type_cached(handle); },
+        .nameQuery = [this](const nt::RawHandle& handle) { return query_name_cached(handle); },
+        .processName = [this](const uint32_t pid) { return process_name_entry(pid).name; }
+    };
+    return {};
 }
 
 int HandleEnumApp::run(int argc, char* argv[]) {
@@ -143,83 +1079,347 @@ int HandleEnumApp::run(int argc, char* argv[]) {
     }
 
     const Parser& options = parse_result.value();
-    build_filters(options);
+    if (!options.outputPath) {
+        const int exit_code = execute(options);
+        report_latency(options);
+        report_allocations();
+        return exit_code;
+    }
+
+    auto writer = output::AsyncWriter::open(*options.outputPath);
+    if (!writer) {
+        std::cerr << std::format("Error: {}\n", writer.error());
+        return EXIT_FAILURE;
+    }
+
+    // Rows are formatted on this thread while the writer thread does the disk
+    // I/O; output only waits for the disk when every buffer is in flight.
+    std::streambuf* const console = std::cout.rdbuf(writer->get());
+    int exit_code = execute(options);
+    report_latency(options);
+    report_allocations();
+    std::cout.rdbuf(console);
+    if (auto closed = (*writer)->close(); !closed) {
+        std::cerr << std::format("Error: writing {} failed ({})\n", *options.outputPath, closed.error());
+        return EXIT_FAILURE;
+    }
+
+    if (options.verbose) {
+        const output::WriterStats stats = (*writer)->stats();
+        std::cout << std::format("Output: {} bytes to {} via {} ({} buffers in {} batches, output waited {} times, {} ms)\n",
+                                 stats.bytes, *options.outputPath, (*writer)->backend_name(), stats.buffers, stats.batches,
+                                 stats.producerWaits,
+                                 std::chrono::duration_cast<std::chrono::milliseconds>(stats.producerWaitTime).count());
+    }
+    return exit_code;
+}
+
+int HandleEnumApp::execute(const Parser& options) {
+    m_run_start = std::chrono::steady_clock::now();
+    if (options.historyPath) {
+        // Offline query: no live handle table, privileges or name resolution.
+        m_strings.clear();
+        return query_history(options);
+    }
+    if (!options.sketchMergePaths.empty()) {
+        return merge_sketches(options);
+    }
+    if (!options.mergePaths.empty()) {
+        return merge_snapshots(options);
+    }
+
+    std::vector<BatchQuery> queries;
+    if (options.batchPath) {
+        auto loaded = cli::load_batch(*options.batchPath);
+        if (!loaded) {
+            std::cerr << std::format("Error: {}\n", loaded.error());
+            return EXIT_FAILURE;
+        }
+        queries = std::move(*loaded);
+    }
+
+    if (options.latencyReport || options.slowLogMs) {
+        latency::recorder().enable(std::chrono::milliseconds(options.slowLogMs.value_or(0)));
+    }
+    m_snapshot_handles = 0;
+    m_mapped_rows = 0;
+    if (options.stats) {
+        alloc::enable();
+    }
+
+    const parallel::ParallelOptions filter_parallelism{.threads = options.threads};
+    // Every filter thread may be waiting on a name query at once.
+    m_name_resolver = std::make_unique<NameResolver>(
+        nt::query_object_name,
+        NameResolverOptions{
+            .maxWorkers = std::max<std::size_t>(NameResolverOptions{}.maxWorkers,
+                                                parallel::effective_threads(std::numeric_limits<std::size_t>::max(), filter_parallelism)),
+            .deadline = std::chrono::milliseconds(options.nameTimeoutMs)});
+    m_process_names.clear();
+    m_strings.clear();
+    m_memoize_lookups = options.batchPath.has_value();
+    m_type_failures.clear();
+    m_name_memo.clear();
+    m_name_policy.reset_skip_counts();
+    if (!options.batchPath) {
+        m_fields = plan_fields(options);
+        if (auto filters_result = build_filters(options); !filters_result) {
+            std::cerr << std::format("Error: {}\n", filters_result.error());
+            return EXIT_FAILURE;
+        }
+        if (options.deadlineMs && m_filter.uses(filter_expr::Field::Name)) {
+            std::cerr << "Error: --deadline cannot be combined with a name filter (-o, or name in --where); "
+                         "it would have to query every name\n";
+            return EXIT_FAILURE;
+        }
+    }
 
     if (auto privilege_result = nt::enable_debug_privilege(); !privilege_result) {
         std::cerr << std::format("Warning: failed to enable SeDebugPrivilege ({})\n",
                                  privilege_result.error().message());
     }
 
-    auto handles_result = nt::query_system_handles();
+    if (options.openMetricsPort) {
+        return serve_metrics(options);
+    }
+    if (options.publishName) {
+        return publish_snapshots(options);
+    }
+
+    auto handles_result = acquire_snapshot();
     if (!handles_result) {
-        std::cerr << std::format("Error: failed to query system handles ({})\n",
-                                 handles_result.error().message());
+        std::cerr << std::format("Error: {}\n", handles_result.error());
         return EXIT_FAILURE;
     }
 
     const std::size_t total_raw_count = handles_result->size();
 
-    std::vector<nt::RawHandle> filtered_handles;
-    filtered_handles.reserve(handles_result->size());
+    if (options.batchPath) {
+        return run_batch(options, queries, *handles_result, total_raw_count);
+    }
+    return evaluate(options, std::move(*handles_result), total_raw_count);
+}
 
-    for (const nt::RawHandle& handle : *handles_result) {
-        bool keep = true;
-        for (const auto& filter : m_filters) {
-            if (!filter->match(handle)) {
-                keep = false;
-                break;
+int HandleEnumApp::run_batch(const Parser& options,
+                             const std::span<const BatchQuery> queries,
+                             const std::span<const nt::RawHandle> handles,
+                             const std::size_t total_raw_count) {
+    if (options.batchOutputDir) {
+        std::error_code error;
+        std::filesystem::create_directories(*options.batchOutputDir, error);
+        if (error) {
+            std::cerr << std::format("Error: cannot create {} ({})\n", *options.batchOutputDir, error.message());
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Every query sees the same snapshot, interner and process names; the
+    // lookup memo makes each type and name query happen at most once.
+    int exit_code = EXIT_SUCCESS;
+    for (std::size_t index = 0; index < queries.size(); ++index) {
+        const BatchQuery& query = queries[index];
+        std::ofstream file;
+        std::streambuf* const stdout_buffer = std::cout.rdbuf();
+        if (options.batchOutputDir) {
+            const auto path = std::filesystem::path(*options.batchOutputDir) / std::format("query-{:03}.txt", index + 1);
+            file.open(path);
+            if (!file) {
+                std::cerr << std::format("Error: cannot write {}\n", path.string());
+                exit_code = EXIT_FAILURE;
+                continue;
             }
+            std::cout.rdbuf(file.rdbuf());
+        } else {
+            std::cout << std::format("{}=== Query {} (line {}): {} ===\n", index == 0 ? "" : "\n", index + 1, query.line, query.text);
         }
 
-        if (keep) {
-            filtered_handles.push_back(handle);
+        m_fields = plan_fields(query.options);
+        int query_exit = EXIT_FAILURE;
+        if (auto filters_result = build_filters(query.options); !filters_result) {
+            std::cerr << std::format("Error: query {} (line {}): {}\n", index + 1, query.line, filters_result.error());
+        } else {
+            query_exit = evaluate(query.options, std::vector<nt::RawHandle>(handles.begin(), handles.end()), total_raw_count);
+        }
+        std::cout.rdbuf(stdout_buffer);
+        if (query_exit != EXIT_SUCCESS) {
+            exit_code = EXIT_FAILURE;
         }
     }
 
+    if (options.verbose) {
+        std::cout << std::format("Batch: {} queries against one snapshot of {} handles ({} object names resolved)\n",
+                                 queries.size(), total_raw_count, m_name_memo.size());
+        report_diagnostics(options);
+    }
+    return exit_code;
+}
+
+int HandleEnumApp::evaluate(const Parser& options, std::vector<nt::RawHandle> handles, const std::size_t total_raw_count) {
+    // A name the filter matched on is always shown, never skipped.
+    m_skip_unnamed_types = !options.allNames && !m_filter.uses(filter_expr::Field::Name);
+    const parallel::ParallelOptions filter_parallelism{.threads = options.threads};
+    const parallel::HandlePredicate matches = [this](const nt::RawHandle& handle) {
+        const alloc::StageScope stage(alloc::Stage::Filter);
+        return m_filter.matches(handle, m_filter_resolvers);
+    };
+
+    if (options.sharedObjectsMin) {
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(handles)
+            : parallel::select(handles, matches, filter_parallelism);
+        return report_shared_objects(options, selected, total_raw_count);
+    }
+
+    if (options.openMetricsPath) {
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(handles)
+            : parallel::select(handles, matches, filter_parallelism);
+        return export_metrics(options, selected, total_raw_count);
+    }
+
+    if (options.sampleFraction) {
+        // Filters, including name-based ones, only ever see the sampled handles.
+        const uint64_t seed = options.sampleSeed.value_or(std::random_device{}());
+        const sampling::Sample sample = sampling::draw(
+            handles, *options.sampleFraction, options.sampleByPid ? sampling::Strategy::ByPid : sampling::Strategy::Uniform, seed);
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? sample.handles
+            : parallel::select(sample.handles, matches, filter_parallelism);
+        return report_sample(options, sample, selected, total_raw_count, seed);
+    }
+
+    if (options.sketchPath) {
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(handles)
+            : parallel::select(handles, matches, filter_parallelism);
+        return update_sketches(options, selected, total_raw_count);
+    }
+
+    if (options.showCountOnly && options.topN) {
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(handles)
+            : parallel::select(handles, matches, filter_parallelism);
+        return report_top_processes(options, selected, total_raw_count);
+    }
+
     if (options.showCountOnly) {
+        const std::size_t matching_count = m_filter.empty()
+            ? total_raw_count
+            : parallel::count(handles, matches, filter_parallelism);
         const HandlePrinter printer;
-        printer.print_count_only(options, total_raw_count, filtered_handles.size());
+        printer.print_count_only(options, total_raw_count, matching_count);
+        report_diagnostics(options);
         return EXIT_SUCCESS;
     }
 
-    m_process_name_cache.clear();
-    m_process_name_cache.reserve(filtered_handles.size());
+    const parallel::HandlePredicate filter_predicate = m_filter.empty() ? parallel::HandlePredicate{} : matches;
 
-    std::unordered_set<uint32_t> unique_pids;
-    unique_pids.reserve(filtered_handles.size());
-
-    for (const nt::RawHandle& raw_handle : filtered_handles) {
-        const uint32_t pid = raw_handle.processId > static_cast<std::uintptr_t>(std::numeric_limits<uint32_t>::max())
-            ? std::numeric_limits<uint32_t>::max()
-            : static_cast<uint32_t>(raw_handle.processId);
-        unique_pids.insert(pid);
+    if (options.deadlineMs) {
+        // Filters here never query a name; execute() rejects name filters.
+        const std::vector<nt::RawHandle> selected = m_filter.empty()
+            ? std::move(handles)
+            : parallel::select(handles, matches, filter_parallelism);
+        return report_progressive(options, selected, total_raw_count);
     }
 
-    for (const uint32_t pid : unique_pids) {
-        m_process_name_cache.emplace(pid, nt::get_process_name_by_pid(pid));
+    if (options.exists) {
+        // Only the first match is ever pulled: nothing after it is filtered.
+        pipeline::Handles found = pipeline::filter(pipeline::acquire(std::move(handles)), filter_predicate, filter_parallelism);
+        return found.begin() != found.end() ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    const HandlePrinter printer;
-
-    if (options.sortBy == SortField::Pid) {
-        // Streaming mode: print handles as they're processed
+    if (options.sortBy == SortField::Pid && !options.recordPath && !options.exportPath && !options.topN) {
+        // Streaming mode: rows are pulled through the lazy pipeline one at a
+        // time, so stopping at --limit stops filtering and resolution too.
+        const HandlePrinter printer(options.columns);
         if (options.verbose) {
             std::cout << "Verbose mode is ON\n";
         }
         if (options.pid) {
             std::cout << std::format("Filtering by PID: {}\n", *options.pid);
         }
+        if (options.verbose && options.whereExpression) {
+            std::cout << "Filter program:\n" << m_filter.disassemble();
+        }
         std::cout << std::format("Retrieved {} system handles.\n", total_raw_count);
         printer.print_header();
 
+        const std::size_t limit = options.limit.value_or(std::numeric_limits<std::size_t>::max());
         std::size_t matching_count = 0;
+        for (const std::string& line : pipeline::format(
+                 pipeline::resolve(pipeline::filter(pipeline::acquire(std::move(handles)), filter_predicate, filter_parallelism),
+                                   [this](const nt::RawHandle& raw_handle) { return map_to_info(raw_handle); }),
+                 [&printer, this](const HandleInfo& row) {
+                     const alloc::StageScope stage(alloc::Stage::Print);
+                     return printer.format_row(row, m_strings);
+                 })) {
+            std::cout << line;
+            if (++matching_count == limit) {
+                break;
+            }
+        }
+
+        // Nothing past the Nth match is filtered, so whether more would have
+        // matched is unknown; the footer only says the limit was reached.
+        if (matching_count == limit) {
+            std::cout << std::format("Matching handles: {} (--limit reached)\n", matching_count);
+        } else {
+            std::cout << std::format("Matching handles: {}\n", matching_count);
+        }
+        report_diagnostics(options);
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<nt::RawHandle> filtered_handles = m_filter.empty()
+        ? std::move(handles)
+        : parallel::select(handles, matches, filter_parallelism);
+
+    if (options.recordPath) {
+        return record_history(options, filtered_handles, total_raw_count);
+    }
+    if (options.exportPath) {
+        return export_snapshot(options, filtered_handles, total_raw_count);
+    }
+
+    if (options.topN) {
+        return report_top_rows(options, filtered_handles, total_raw_count);
+    }
+
+    const HandlePrinter printer(options.columns);
+
+    if (options.maxMemoryBytes) {
+        // Budgeted batch mode: spill sorted runs past the budget, merge while printing
+        sorting::ExternalSorter sorter(options.sortBy, m_strings, *options.maxMemoryBytes);
         for (const nt::RawHandle& raw_handle : filtered_handles) {
-            HandleInfo handle_info = map_to_info(raw_handle);
-            printer.print_row(handle_info);
-            ++matching_count;
+            HandleInfo row = map_to_info(raw_handle);
+            const alloc::StageScope stage(alloc::Stage::Sort);
+            if (auto pushed = sorter.push(row); !pushed) {
+                std::cerr << std::format("Error: {}\n", pushed.error());
+                return EXIT_FAILURE;
+            }
         }
 
-        std::cout << std::format("Matching handles: {}\n", matching_count);
+        printer.print_preamble(options, total_raw_count);
+        printer.print_header();
+        std::size_t matching_count = 0;
+        const auto merged = [&] {
+            const alloc::StageScope stage(alloc::Stage::Sort);
+            return sorter.finish([&](const HandleInfo& handle_info) {
+                const alloc::StageScope print_stage(alloc::Stage::Print);
+                printer.print_row(handle_info, m_strings);
+                ++matching_count;
+            });
+        }();
+        if (!merged) {
+            std::cerr << std::format("Error: {}\n", merged.error());
+            return EXIT_FAILURE;
+        }
+        printer.print_footer(matching_count);
+
+        if (options.verbose && sorter.run_count() > 0) {
+            std::cout << std::format("Sort spilled {} rows in {} runs (buffer: {} rows)\n",
+                                     sorter.spilled_rows(), sorter.run_count(), sorter.buffer_capacity());
+        }
     } else {
         // Batch mode: collect all, sort, then print
         std::vector<HandleInfo> mapped_handles;
@@ -229,9 +1429,14 @@ int HandleEnumApp::run(int argc, char* argv[]) {
             mapped_handles.push_back(map_to_info(raw_handle));
         }
 
-        sort_handles(mapped_handles, options.sortBy);
-        printer.print_results(mapped_handles, options, total_raw_count);
+        {
+            const alloc::StageScope stage(alloc::Stage::Sort);
+            sorting::sort_handles(mapped_handles, options.sortBy, m_strings);
+        }
+        const alloc::StageScope stage(alloc::Stage::Print);
+        printer.print_results(mapped_handles, m_strings, options, total_raw_count);
     }
 
+    report_diagnostics(options);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,501 @@
+#include "async_writer.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#define HANDLE_ENUM_HAS_IO_URING 1
+#endif
+#endif
+
+namespace output {
+
+namespace {
+
+#if defined(__linux__)
+
+[[nodiscard]] std::string errno_message(const std::string_view what, const int error) {
+    return std::format("{} failed: {}", what, std::strerror(error));
+}
+
+// write(2) until everything is written, retrying on EINTR and short writes.
+[[nodiscard]] std::expected<void, std::string> write_all(const int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(errno_message("write", errno));
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return {};
+}
+
+class PosixWriteBackend final : public WriteBackend {
+public:
+    explicit PosixWriteBackend(const int fd) : m_fd(fd) {}
+    ~PosixWriteBackend() override { ::close(m_fd); }
+
+    std::expected<void, std::string> write_batch(const std::span<const std::span<const char>> buffers) override {
+        for (const std::span<const char> buffer : buffers) {
+            if (auto written = write_all(m_fd, buffer.data(), buffer.size()); !written) {
+                return written;
+            }
+        }
+        return {};
+    }
+
+    std::string_view name() const noexcept override { return "write"; }
+
+private:
+    int m_fd;
+};
+
+#if defined(HANDLE_ENUM_HAS_IO_URING)
+
+/**
+ * A batch becomes one IORING_OP_WRITE per buffer at explicit file offsets,
+ * submitted and awaited with a single io_uring_enter. Short writes are
+ * resubmitted for their remainder. If the kernel rejects the opcode (pre-5.6)
+ * before anything was written, the backend degrades to write(2).
+ */
+class IoUringBackend final : public WriteBackend {
+public:
+    [[nodiscard]] static std::unique_ptr<IoUringBackend> create(const int fd, const unsigned entries) {
+        io_uring_params params{};
+        const int ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0) {
+            return nullptr;
+        }
+
+        auto backend = std::unique_ptr<IoUringBackend>(new IoUringBackend(fd, ring_fd));
+        if (!backend->map(params)) {
+            // The caller keeps the file for its write(2) fallback.
+            backend->m_fd = -1;
+            return nullptr;
+        }
+        return backend;
+    }
+
+    ~IoUringBackend() override {
+        if (m_sqes != MAP_FAILED) {
+            ::munmap(m_sqes, m_sqes_bytes);
+        }
+        if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring) {
+            ::munmap(m_cq_ring, m_cq_bytes);
+        }
+        if (m_sq_ring != MAP_FAILED) {
+            ::munmap(m_sq_ring, m_sq_bytes);
+        }
+        ::close(m_ring_fd);
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    std::expected<void, std::string> write_batch(const std::span<const std::span<const char>> buffers) override {
+        std::vector<Pending> pending;
+        pending.reserve(buffers.size());
+        for (const std::span<const char> buffer : buffers) {
+            pending.push_back(Pending{.data = buffer.data(), .size = buffer.size(), .offset = m_offset});
+            m_offset += buffer.size();
+        }
+
+        while (!pending.empty()) {
+            if (m_fallback) {
+                for (const Pending& write : pending) {
+                    if (auto written = write_all(m_fd, write.data, write.size); !written) {
+                        return written;
+                    }
+                }
+                return {};
+            }
+
+            const std::size_t count = std::min<std::size_t>(pending.size(), m_sq_entries);
+            auto completed = submit_and_wait(std::span(pending).first(count));
+            if (!completed) {
+                return std::unexpected(completed.error());
+            }
+
+            std::vector<Pending> next;
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::size_t done = (*completed)[i];
+                if (done < pending[i].size) {
+                    next.push_back(Pending{.data = pending[i].data + done,
+                                           .size = pending[i].size - done,
+                                           .offset = pending[i].offset + done});
+                }
+            }
+            next.insert(next.end(), pending.begin() + static_cast<std::ptrdiff_t>(count), pending.end());
+            pending = std::move(next);
+        }
+        return {};
+    }
+
+    std::string_view name() const noexcept override { return m_fallback ? "write (io_uring write unsupported)" : "io_uring"; }
+
+private:
+    struct Pending {
+        const char* data = nullptr;
+        std::size_t size = 0;
+        std::uint64_t offset = 0;
+    };
+
+    IoUringBackend(const int fd, const int ring_fd) : m_fd(fd), m_ring_fd(ring_fd) {}
+
+    [[nodiscard]] bool map(const io_uring_params& params) {
+        m_sq_entries = params.sq_entries;
+        m_sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            m_sq_bytes = m_cq_bytes = std::max(m_sq_bytes, m_cq_bytes);
+        }
+
+        m_sq_ring = ::mmap(nullptr, m_sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+        if (m_sq_ring == MAP_FAILED) {
+            return false;
+        }
+        m_cq_ring = single_mmap
+            ? m_sq_ring
+            : ::mmap(nullptr, m_cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+        if (m_cq_ring == MAP_FAILED) {
+            return false;
+        }
+        m_sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = ::mmap(nullptr, m_sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+        if (m_sqes == MAP_FAILED) {
+            return false;
+        }
+
+        auto* const sq = static_cast<char*>(m_sq_ring);
+        auto* const cq = static_cast<char*>(m_cq_ring);
+        m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Submits one write per entry and returns the bytes each one wrote.
+    [[nodiscard]] std::expected<std::vector<std::size_t>, std::string> submit_and_wait(const std::span<const Pending> writes) {
+        const unsigned count = static_cast<unsigned>(writes.size());
+        unsigned tail = std::atomic_ref(*m_sq_tail).load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < count; ++i, ++tail) {
+            const unsigned index = tail & m_sq_mask;
+            io_uring_sqe& sqe = static_cast<io_uring_sqe*>(m_sqes)[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_WRITE;
+            sqe.fd = m_fd;
+            sqe.addr = reinterpret_cast<std::uintptr_t>(writes[i].data);
+            sqe.len = static_cast<std::uint32_t>(std::min<std::size_t>(writes[i].size, 1u << 30));
+            sqe.off = writes[i].offset;
+            sqe.user_data = i;
+            m_sq_array[index] = index;
+        }
+        std::atomic_ref(*m_sq_tail).store(tail, std::memory_order_release);
+
+        std::vector<std::size_t> written(count, 0);
+        unsigned to_submit = count;
+        unsigned reaped = 0;
+        bool unsupported = false;
+        while (reaped < count) {
+            const long entered = ::syscall(__NR_io_uring_enter, m_ring_fd, to_submit, count - reaped, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (entered < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return std::unexpected(errno_message("io_uring_enter", errno));
+            }
+            to_submit -= std::min(to_submit, static_cast<unsigned>(entered));
+
+            unsigned head = std::atomic_ref(*m_cq_head).load(std::memory_order_relaxed);
+            const unsigned cq_tail = std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+            for (; head != cq_tail; ++head, ++reaped) {
+                const io_uring_cqe& cqe = m_cqes[head & m_cq_mask];
+                if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+                    unsupported = true;
+                } else if (cqe.res < 0) {
+                    std::atomic_ref(*m_cq_head).store(head + 1, std::memory_order_release);
+                    return std::unexpected(errno_message("io_uring write", -cqe.res));
+                } else if (cqe.res == 0 && writes[cqe.user_data].size > 0) {
+                    std::atomic_ref(*m_cq_head).store(head + 1, std::memory_order_release);
+                    return std::unexpected("io_uring write made no progress");
+                } else {
+                    written[cqe.user_data] = static_cast<std::size_t>(cqe.res);
+                    m_wrote_any = true;
+                }
+            }
+            std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+        }
+
+        if (unsupported) {
+            if (m_wrote_any) {
+                return std::unexpected("io_uring write rejected by the kernel");
+            }
+            // Nothing was written yet: the write loop redoes these with write(2).
+            m_fallback = true;
+            ::lseek(m_fd, static_cast<off_t>(writes.front().offset), SEEK_SET);
+            std::ranges::fill(written, 0);
+        }
+        return written;
+    }
+
+    int m_fd;
+    int m_ring_fd;
+    std::uint64_t m_offset = 0;
+    bool m_fallback = false;
+    bool m_wrote_any = false;
+
+    void* m_sq_ring = MAP_FAILED;
+    void* m_cq_ring = MAP_FAILED;
+    void* m_sqes = MAP_FAILED;
+    std::size_t m_sq_bytes = 0;
+    std::size_t m_cq_bytes = 0;
+    std::size_t m_sqes_bytes = 0;
+    unsigned m_sq_entries = 0;
+    unsigned* m_sq_tail = nullptr;
+    unsigned m_sq_mask = 0;
+    unsigned* m_sq_array = nullptr;
+    unsigned* m_cq_head = nullptr;
+    unsigned* m_cq_tail = nullptr;
+    unsigned m_cq_mask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+};
+
+#endif // HANDLE_ENUM_HAS_IO_URING
+
+#else
+
+class StdioBackend final : public WriteBackend {
+public:
+    explicit StdioBackend(std::FILE* file) : m_file(file) { std::setvbuf(m_file, nullptr, _IONBF, 0); }
+    ~StdioBackend() override { std::fclose(m_file); }
+
+    std::expected<void, std::string> write_batch(const std::span<const std::span<const char>> buffers) override {
+        for (const std::span<const char> buffer : buffers) {
+            if (std::fwrite(buffer.data(), 1, buffer.size(), m_file) != buffer.size()) {
+                return std::unexpected("write to output file failed");
+            }
+        }
+        return {};
+    }
+
+    std::string_view name() const noexcept override { return "stdio"; }
+
+private:
+    std::FILE* m_file;
+};
+
+#endif
+
+} // namespace
+
+std::expected<std::unique_ptr<WriteBackend>, std::string> open_file_backend(const std::filesystem::path& path,
+                                                                           [[maybe_unused]] const bool allowIoUring) {
+#if defined(__linux__)
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return std::unexpected(std::format("cannot open {}: {}", path.string(), std::strerror(errno)));
+    }
+#if defined(HANDLE_ENUM_HAS_IO_URING)
+    if (allowIoUring) {
+        if (auto ring = IoUringBackend::create(fd, 8)) {
+            return ring;
+        }
+    }
+#endif
+    return std::make_unique<PosixWriteBackend>(fd);
+#else
+    std::FILE* file = std::fopen(path.string().c_str(), "wb");
+    if (!file) {
+        return std::unexpected(std::format("cannot open {}", path.string()));
+    }
+    return std::make_unique<StdioBackend>(file);
+#endif
+}
+
+AsyncWriter::AsyncWriter(std::unique_ptr<WriteBackend> backend, const WriterOptions options)
+    : m_backend(std::move(backend)),
+      m_options{.bufferBytes = std::max<std::size_t>(options.bufferBytes, 1),
+                .bufferCount = std::max<std::size_t>(options.bufferCount, 2),
+                .allowIoUring = options.allowIoUring},
+      // Both rings can hold every buffer at once (plus the end marker), so
+      // pushes never fail.
+      m_filled(m_options.bufferCount + 1),
+      m_free(m_options.bufferCount) {
+    m_current.data = std::make_unique<char[]>(m_options.bufferBytes);
+    for (std::size_t i = 1; i < m_options.bufferCount; ++i) {
+        Buffer spare{.data = std::make_unique<char[]>(m_options.bufferBytes)};
+        (void)m_free.try_push(spare);
+    }
+    setp(m_current.data.get(), m_current.data.get() + m_options.bufferBytes);
+    m_thread = std::thread([this] { writer_loop(); });
+}
+
+AsyncWriter::~AsyncWriter() {
+    (void)close();
+}
+
+std::expected<std::unique_ptr<AsyncWriter>, std::string> AsyncWriter::open(const std::filesystem::path& path,
+                                                                           const WriterOptions options) {
+    auto backend = open_file_backend(path, options.allowIoUring);
+    if (!backend) {
+        return std::unexpected(backend.error());
+    }
+    return std::make_unique<AsyncWriter>(std::move(*backend), options);
+}
+
+void AsyncWriter::hand_off() {
+    m_current.size = static_cast<std::size_t>(pptr() - pbase());
+    if (m_current.size == 0) {
+        return;
+    }
+
+    (void)m_filled.try_push(m_current);
+    std::optional<Buffer> next = m_free.try_pop();
+    if (!next) {
+        // Every buffer is queued for disk: the only place the producer waits.
+        const auto start = std::chrono::steady_clock::now();
+        m_free.wait_nonempty();
+        next = m_free.try_pop();
+        ++m_stats.producerWaits;
+        m_stats.producerWaitTime += std::chrono::steady_clock::now() - start;
+    }
+    m_current = std::move(*next);
+    setp(m_current.data.get(), m_current.data.get() + m_options.bufferBytes);
+}
+
+AsyncWriter::int_type AsyncWriter::overflow(const int_type ch) {
+    if (m_closed) {
+        return traits_type::eof();
+    }
+    hand_off();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize AsyncWriter::xsputn(const char* data, const std::streamsize count) {
+    if (m_closed) {
+        return 0;
+    }
+    std::streamsize remaining = count;
+    while (remaining > 0) {
+        if (pptr() == epptr()) {
+            hand_off();
+        }
+        const std::streamsize chunk = std::min<std::streamsize>(remaining, epptr() - pptr());
+        std::memcpy(pptr(), data, static_cast<std::size_t>(chunk));
+        pbump(static_cast<int>(chunk));
+        data += chunk;
+        remaining -= chunk;
+    }
+    return count;
+}
+
+int AsyncWriter::sync() {
+    if (!m_closed) {
+        hand_off();
+    }
+    return 0;
+}
+
+void AsyncWriter::fail(std::string message) {
+    const std::lock_guard lock(m_result_mutex);
+    if (!m_error) {
+        m_error = std::move(message);
+    }
+}
+
+void AsyncWriter::writer_loop() {
+    std::vector<Buffer> batch;
+    std::vector<std::span<const char>> spans;
+    bool failed = false;
+    bool done = false;
+    while (!done) {
+        m_filled.wait_nonempty();
+        while (std::optional<Buffer> buffer = m_filled.try_pop()) {
+            if (!buffer->data) {
+                done = true;
+                break;
+            }
+            batch.push_back(std::move(*buffer));
+        }
+        if (batch.empty()) {
+            continue;
+        }
+
+        // After a failure buffers are still recycled so the producer never
+        // blocks; their contents are dropped and close() reports the error.
+        if (!failed) {
+            spans.clear();
+            std::size_t bytes = 0;
+            for (const Buffer& buffer : batch) {
+                spans.emplace_back(buffer.data.get(), buffer.size);
+                bytes += buffer.size;
+            }
+            if (auto written = m_backend->write_batch(spans); written) {
+                m_written_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                m_written_buffers.fetch_add(batch.size(), std::memory_order_relaxed);
+                m_batches.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                failed = true;
+                fail(std::move(written.error()));
+            }
+        }
+
+        for (Buffer& buffer : batch) {
+            buffer.size = 0;
+            (void)m_free.try_push(buffer);
+        }
+        batch.clear();
+    }
+}
+
+std::expected<void, std::string> AsyncWriter::close() {
+    if (m_closed) {
+        return m_close_result;
+    }
+
+    hand_off();
+    m_closed = true;
+    Buffer end_marker;
+    (void)m_filled.try_push(end_marker);
+    m_thread.join();
+    setp(nullptr, nullptr);
+
+    const std::lock_guard lock(m_result_mutex);
+    if (m_error) {
+        m_close_result = std::unexpected(*m_error);
+    }
+    return m_close_result;
+}
+
+WriterStats AsyncWriter::stats() const {
+    WriterStats stats = m_stats;
+    stats.bytes = m_written_bytes.load(std::memory_order_relaxed);
+    stats.buffers = m_written_buffers.load(std::memory_order_relaxed);
+    stats.batches = m_batches.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace output
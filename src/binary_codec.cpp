@@ -0,0 +1,84 @@
+#include "binary_codec.hpp"
+
+namespace codec {
+
+void ByteWriter::varint(std::uint64_t value) {
+    while (value >= 0x80) {
+        m_bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    m_bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+void ByteWriter::fixed32(const std::uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        m_bytes.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void ByteWriter::fixed64(const std::uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        m_bytes.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void ByteWriter::bytes(const std::span<const std::uint8_t> data) {
+    m_bytes.insert(m_bytes.end(), data.begin(), data.end());
+}
+
+void ByteWriter::string(const std::string_view text) {
+    varint(text.size());
+    m_bytes.insert(m_bytes.end(), text.begin(), text.end());
+}
+
+std::uint64_t ByteReader::varint() noexcept {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (m_failed || m_offset >= m_data.size()) {
+            m_failed = true;
+            return 0;
+        }
+        const std::uint8_t byte = m_data[m_offset++];
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    m_failed = true;
+    return 0;
+}
+
+std::uint32_t ByteReader::fixed32() noexcept {
+    const auto data = bytes(4);
+    std::uint32_t value = 0;
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        value |= static_cast<std::uint32_t>(data[i]) << (i * 8);
+    }
+    return value;
+}
+
+std::uint64_t ByteReader::fixed64() noexcept {
+    const auto data = bytes(8);
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        value |= static_cast<std::uint64_t>(data[i]) << (i * 8);
+    }
+    return value;
+}
+
+std::span<const std::uint8_t> ByteReader::bytes(const std::size_t size) noexcept {
+    if (m_failed || size > m_data.size() - m_offset) {
+        m_failed = true;
+        return {};
+    }
+    const auto data = m_data.subspan(m_offset, size);
+    m_offset += size;
+    return data;
+}
+
+std::string_view ByteReader::string() noexcept {
+    const auto data = bytes(static_cast<std::size_t>(varint()));
+    return {reinterpret_cast<const char*>(data.data()), data.size()};
+}
+
+} // namespace codec
@@ -1,14 +1,112 @@
 #include "cli_parser.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
 #include <expected>
+#include <fstream>
 #include <string_view>
 #include <iostream>
 #include <format>
 #include <vector>
 #include <map>
 #include <functional>
+#include <limits>
 
 namespace cli {
 
+namespace {
+
+// Upper bound for --threads; it sizes the name resolver's worker pool.
+constexpr uint32_t kMaxThreads = 1024;
+
+std::expected<std::vector<Column>, std::string> parse_columns(std::string_view list) {
+    static const std::map<std::string_view, Column> names = {
+        {"pid", Column::Pid},
+        {"process", Column::Process},
+        {"handle", Column::Handle},
+        {"type", Column::Type},
+        {"name", Column::Name},
+        {"access", Column::Access},
+        {"address", Column::Address}
+    };
+
+    std::vector<Column> columns;
+    while (true) {
+        const std::size_t comma = list.find(',');
+        const std::string_view item = list.substr(0, comma);
+        const auto it = names.find(item);
+        if (it == names.end()) return std::unexpected(std::format("Invalid column: {}", item));
+        if (std::ranges::find(columns, it->second) != columns.end()) {
+            return std::unexpected(std::format("Duplicate column: {}", item));
+        }
+        columns.push_back(it->second);
+
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return columns;
+}
+
+// Accepts a byte count with an optional K, M or G suffix (binary units).
+std::expected<std::size_t, std::string> parse_byte_size(const std::string_view text) {
+    std::string_view digits = text;
+    std::size_t multiplier = 1;
+    if (!digits.empty()) {
+        switch (digits.back()) {
+        case 'K': case 'k': multiplier = std::size_t{1} << 10; break;
+        case 'M': case 'm': multiplier = std::size_t{1} << 20; break;
+        case 'G': case 'g': multiplier = std::size_t{1} << 30; break;
+        default: break;
+        }
+        if (multiplier != 1) digits.remove_suffix(1);
+    }
+
+    std::size_t value = 0;
+    const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (digits.empty() || error != std::errc{} || end != digits.data() + digits.size() || value == 0 ||
+        value > std::numeric_limits<std::size_t>::max() / multiplier) {
+        return std::unexpected(std::format("Invalid memory size: {} (e.g. 512M, 2G)", text));
+    }
+    return value * multiplier;
+}
+
+// Accepts Unix epoch seconds or a UTC time of the form YYYY-MM-DDTHH:MM[:SS].
+std::expected<int64_t, std::string> parse_time(const std::string_view text) {
+    const auto invalid = [&] { return std::unexpected(std::format("Invalid time: {} (use epoch seconds or YYYY-MM-DDTHH:MM[:SS])", text)); };
+    const auto number = [&](const std::size_t offset, const std::size_t length, int& value) {
+        if (offset + length > text.size()) return false;
+        const char* first = text.data() + offset;
+        const auto [end, error] = std::from_chars(first, first + length, value);
+        return error == std::errc{} && end == first + length;
+    };
+
+    if (!text.empty() && std::ranges::all_of(text, [](const char c) { return c >= '0' && c <= '9'; })) {
+        int64_t seconds = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+        if (error != std::errc{} || seconds > std::numeric_limits<int64_t>::max() / 1000) return invalid();
+        return seconds * 1000;
+    }
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    const bool shape = (text.size() == 16 || text.size() == 19) && text[4] == '-' && text[7] == '-' &&
+                       (text[10] == 'T' || text[10] == ' ') && text[13] == ':' && (text.size() == 16 || text[16] == ':');
+    if (!shape || !number(0, 4, year) || !number(5, 2, month) || !number(8, 2, day) || !number(11, 2, hour) ||
+        !number(14, 2, minute) || (text.size() == 19 && !number(17, 2, second))) {
+        return invalid();
+    }
+
+    const std::chrono::year_month_day date{std::chrono::year(year), std::chrono::month(static_cast<unsigned>(month)),
+                                           std::chrono::day(static_cast<unsigned>(day))};
+    if (!date.ok() || hour > 23 || minute > 59 || second > 59) return invalid();
+
+    const auto time = std::chrono::sys_days(date) + std::chrono::hours(hour) + std::chrono::minutes(minute) +
+                      std::chrono::seconds(second);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
 /**
  * @brief Parses command-line arguments using a command-mapping approach.
  * This eliminates long if-else chains and makes the code highly extensible.
@@ -52,6 +150,276 @@ std::expected<CliOptions, std::string> parse(int argc, char* argv[]) {
             return {};
         }},
 
+        {"--name-timeout", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --name-timeout");
+            try { options.nameTimeoutMs = static_cast<uint32_t>(std::stoul(std::string(args[i]))); }
+            catch (...) { return std::unexpected(std::format("Invalid timeout: {}", args[i])); }
+            if (options.nameTimeoutMs == 0) return std::unexpected("Timeout must be positive");
+            return {};
+        }},
+
+        {"--all-names", [&](size_t&) -> std::expected<void, std::string> { options.allNames = true; return {}; }},
+
+        {"--threads", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --threads");
+            uint32_t count = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), count);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || count == 0 || count > kMaxThreads) {
+                return std::unexpected(std::format("Invalid thread count: {} (expected 1 to {})", args[i], kMaxThreads));
+            }
+            options.threads = count;
+            return {};
+        }},
+
+        {"--shared-objects", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --shared-objects");
+            uint32_t minimum = 0;
+            try { minimum = static_cast<uint32_t>(std::stoul(std::string(args[i]))); }
+            catch (...) { return std::unexpected(std::format("Invalid process count: {}", args[i])); }
+            if (minimum < 2) return std::unexpected("--shared-objects needs a process count of at least 2");
+            options.sharedObjectsMin = minimum;
+            return {};
+        }},
+
+        {"--where", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --where");
+            options.whereExpression = std::string(args[i]); return {};
+        }},
+
+        {"--columns", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --columns");
+            auto columns = parse_columns(args[i]);
+            if (!columns) return std::unexpected(columns.error());
+            options.columns = std::move(*columns);
+            return {};
+        }},
+
+        {"--top", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --top");
+            std::size_t count = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), count);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || count == 0) {
+                return std::unexpected(std::format("Invalid row count: {}", args[i]));
+            }
+            options.topN = count;
+            return {};
+        }},
+
+        {"--limit", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --limit");
+            std::size_t count = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), count);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || count == 0) {
+                return std::unexpected(std::format("Invalid row count: {}", args[i]));
+            }
+            options.limit = count;
+            return {};
+        }},
+
+        {"--exists", [&](size_t&) -> std::expected<void, std::string> { options.exists = true; return {}; }},
+
+        {"--deadline", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --deadline");
+            double seconds = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), seconds);
+            // At least a millisecond, at most a day.
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || !(seconds >= 0.001 && seconds <= 86'400)) {
+                return std::unexpected(std::format("Invalid deadline: {} (use seconds, e.g. 5 or 0.5)", args[i]));
+            }
+            options.deadlineMs = static_cast<uint32_t>(std::llround(seconds * 1000));
+            return {};
+        }},
+
+        {"--sample", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --sample");
+            double fraction = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), fraction);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || !(fraction > 0 && fraction <= 1)) {
+                return std::unexpected(std::format("Invalid sample fraction: {} (use a value in (0, 1])", args[i]));
+            }
+            options.sampleFraction = fraction;
+            return {};
+        }},
+
+        {"--sample-by", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --sample-by");
+            if (args[i] == "pid") options.sampleByPid = true;
+            else if (args[i] == "uniform") options.sampleByPid = false;
+            else return std::unexpected(std::format("Invalid sampling: {} (use uniform or pid)", args[i]));
+            return {};
+        }},
+
+        {"--sample-seed", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --sample-seed");
+            uint64_t seed = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), seed);
+            if (error != std::errc{} || end != args[i].data() + args[i].size()) {
+                return std::unexpected(std::format("Invalid seed: {}", args[i]));
+            }
+            options.sampleSeed = seed;
+            return {};
+        }},
+
+        {"--max-memory", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --max-memory");
+            auto bytes = parse_byte_size(args[i]);
+            if (!bytes) return std::unexpected(bytes.error());
+            options.maxMemoryBytes = *bytes;
+            return {};
+        }},
+
+        {"--record", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --record");
+            options.recordPath = std::string(args[i]); return {};
+        }},
+
+        {"--history", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --history");
+            options.historyPath = std::string(args[i]); return {};
+        }},
+
+        {"--held", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --held");
+            std::size_t used = 0;
+            try { options.heldAddress = std::stoull(std::string(args[i]), &used, 0); }
+            catch (...) { used = 0; }
+            if (used == 0 || used != args[i].size()) return std::unexpected(std::format("Invalid object address: {}", args[i]));
+            return {};
+        }},
+
+        {"--from", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --from");
+            auto time = parse_time(args[i]);
+            if (!time) return std::unexpected(time.error());
+            options.fromMs = *time;
+            return {};
+        }},
+
+        {"--to", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --to");
+            auto time = parse_time(args[i]);
+            if (!time) return std::unexpected(time.error());
+            options.toMs = *time;
+            return {};
+        }},
+
+        {"--output", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --output");
+            options.outputPath = std::string(args[i]); return {};
+        }},
+
+        {"--openmetrics", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --openmetrics");
+            options.openMetricsPath = std::string(args[i]); return {};
+        }},
+
+        {"--openmetrics-port", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --openmetrics-port");
+            uint16_t port = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), port);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || port == 0) {
+                return std::unexpected(std::format("Invalid port: {}", args[i]));
+            }
+            options.openMetricsPort = port;
+            return {};
+        }},
+
+        {"--publish", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --publish");
+            options.publishName = std::string(args[i]); return {};
+        }},
+
+        {"--publish-interval", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --publish-interval");
+            double seconds = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), seconds);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || !(seconds >= 0.01 && seconds <= 86'400)) {
+                return std::unexpected(std::format("Invalid publish interval: {} (use seconds, e.g. 5 or 0.5)", args[i]));
+            }
+            options.publishIntervalMs = static_cast<uint32_t>(std::llround(seconds * 1000));
+            return {};
+        }},
+
+        {"--publish-count", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --publish-count");
+            uint64_t count = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), count);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || count == 0) {
+                return std::unexpected(std::format("Invalid publish count: {}", args[i]));
+            }
+            options.publishCount = count;
+            return {};
+        }},
+
+        {"--export", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --export");
+            options.exportPath = std::string(args[i]); return {};
+        }},
+
+        {"--host", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --host");
+            if (args[i].empty()) return std::unexpected("Invalid host name: (empty)");
+            options.exportHost = std::string(args[i]); return {};
+        }},
+
+        {"--merge", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --merge");
+            std::string_view list = args[i];
+            while (true) {
+                const std::size_t comma = list.find(',');
+                const std::string_view item = list.substr(0, comma);
+                if (item.empty()) return std::unexpected(std::format("Invalid snapshot file list: {}", args[i]));
+                options.mergePaths.emplace_back(item);
+                if (comma == std::string_view::npos) break;
+                list.remove_prefix(comma + 1);
+            }
+            return {};
+        }},
+
+        {"--sketch", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --sketch");
+            options.sketchPath = std::string(args[i]); return {};
+        }},
+
+        {"--sketch-merge", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --sketch-merge");
+            std::string_view list = args[i];
+            while (true) {
+                const std::size_t comma = list.find(',');
+                const std::string_view item = list.substr(0, comma);
+                if (item.empty()) return std::unexpected(std::format("Invalid sketch file list: {}", args[i]));
+                options.sketchMergePaths.emplace_back(item);
+                if (comma == std::string_view::npos) break;
+                list.remove_prefix(comma + 1);
+            }
+            return {};
+        }},
+
+        {"--latency", [&](size_t&) -> std::expected<void, std::string> { options.latencyReport = true; return {}; }},
+
+        {"--stats", [&](size_t&) -> std::expected<void, std::string> { options.stats = true; return {}; }},
+
+        {"--slow-log", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --slow-log");
+            uint32_t threshold = 0;
+            const auto [end, error] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), threshold);
+            if (error != std::errc{} || end != args[i].data() + args[i].size() || threshold == 0) {
+                return std::unexpected(std::format("Invalid slow call threshold: {}", args[i]));
+            }
+            options.slowLogMs = threshold;
+            return {};
+        }},
+
+        {"--batch", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --batch");
+            options.batchPath = std::string(args[i]); return {};
+        }},
+
+        {"--batch-output", [&](size_t& i) -> std::expected<void, std::string> {
+            if (++i >= args.size()) return std::unexpected("Missing value for --batch-output");
+            options.batchOutputDir = std::string(args[i]); return {};
+        }},
+
         {"-c", [&](size_t&) -> std::expected<void, std::string> { options.showCountOnly = true; return {}; }},
 
         {"-v", [&](size_t&) -> std::expected<void, std::string> { options.verbose = true; return {}; }},
@@ -78,9 +446,202 @@ std::expected<CliOptions, std::string> parse(int argc, char* argv[]) {
         }
     }
 
+    if (options.historyPath && options.recordPath) {
+        return std::unexpected("--record and --history cannot be combined");
+    }
+    if (!options.historyPath && (options.heldAddress || options.fromMs || options.toMs)) {
+        return std::unexpected("--held, --from and --to require --history");
+    }
+    if (options.showCountOnly && options.sharedObjectsMin) {
+        return std::unexpected("--count and --shared-objects cannot be combined");
+    }
+    if (options.recordPath && (options.showCountOnly || options.sharedObjectsMin)) {
+        return std::unexpected("--record cannot be combined with --count or --shared-objects");
+    }
+    if (options.fromMs && options.toMs && *options.fromMs > *options.toMs) {
+        return std::unexpected("--from must not be later than --to");
+    }
+    if (options.topN && (options.recordPath || options.maxMemoryBytes)) {
+        return std::unexpected("--top cannot be combined with --record or --max-memory");
+    }
+    if (options.openMetricsPath && options.openMetricsPort) {
+        return std::unexpected("--openmetrics and --openmetrics-port cannot be combined");
+    }
+    if ((options.openMetricsPath || options.openMetricsPort) &&
+        (options.showCountOnly || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath ||
+         options.historyPath || options.batchPath)) {
+        return std::unexpected("OpenMetrics output cannot be combined with --count, --shared-objects, --max-memory, "
+                               "--record, --history or --batch");
+    }
+    if (!options.sampleFraction && (options.sampleByPid || options.sampleSeed)) {
+        return std::unexpected("--sample-by and --sample-seed require --sample");
+    }
+    if (options.sampleFraction &&
+        (options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath || options.historyPath ||
+         options.openMetricsPath || options.openMetricsPort)) {
+        return std::unexpected("--sample cannot be combined with --shared-objects, --max-memory, --record, "
+                               "--history or OpenMetrics output");
+    }
+    if (!options.sketchMergePaths.empty() && !options.sketchPath) {
+        return std::unexpected("--sketch-merge requires --sketch");
+    }
+    if (options.sketchPath &&
+        (options.showCountOnly || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath ||
+         options.historyPath || options.openMetricsPath || options.openMetricsPort || options.sampleFraction)) {
+        return std::unexpected("--sketch cannot be combined with --count, --shared-objects, --max-memory, --record, "
+                               "--history, --sample or OpenMetrics output");
+    }
+    // These modes make no NT calls, or own standard output or never return.
+    if ((options.latencyReport || options.slowLogMs) &&
+        (options.historyPath || !options.sketchMergePaths.empty() || options.openMetricsPath || options.openMetricsPort)) {
+        return std::unexpected("--latency and --slow-log cannot be combined with --history, --sketch-merge or OpenMetrics output");
+    }
+    if (options.stats &&
+        (options.historyPath || !options.sketchMergePaths.empty() || options.openMetricsPath || options.openMetricsPort)) {
+        return std::unexpected("--stats cannot be combined with --history, --sketch-merge or OpenMetrics output");
+    }
+    // Both stop the snapshot-order listing early; every other mode needs all matches.
+    if ((options.limit || options.exists) &&
+        (options.showCountOnly || options.topN || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath ||
+         options.historyPath || options.sampleFraction || options.sketchPath || options.openMetricsPath ||
+         options.openMetricsPort)) {
+        return std::unexpected("--limit and --exists cannot be combined with --count, --top, --shared-objects, "
+                               "--max-memory, --record, --history, --sample, --sketch or OpenMetrics output");
+    }
+    if (options.limit && options.exists) {
+        return std::unexpected("--limit and --exists cannot be combined");
+    }
+    if (options.limit && options.sortBy != SortField::Pid) {
+        return std::unexpected("--limit keeps snapshot order; use --top for the first rows in --sort order");
+    }
+    // Only the plain listing has rows to hold back and fields to leave unresolved.
+    if (options.deadlineMs &&
+        (options.showCountOnly || options.topN || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath ||
+         options.historyPath || options.sampleFraction || options.sketchPath || options.openMetricsPath ||
+         options.openMetricsPort || options.exists)) {
+        return std::unexpected("--deadline cannot be combined with --count, --top, --shared-objects, --max-memory, "
+                               "--record, --history, --sample, --sketch, --exists or OpenMetrics output");
+    }
+    if ((options.publishIntervalMs || options.publishCount) && !options.publishName) {
+        return std::unexpected("--publish-interval and --publish-count require --publish");
+    }
+    // The publisher replaces the report with shared memory and keeps running.
+    if (options.publishName &&
+        (options.showCountOnly || options.topN || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath ||
+         options.historyPath || options.sampleFraction || options.sketchPath || options.openMetricsPath ||
+         options.openMetricsPort || options.limit || options.exists || options.deadlineMs || options.batchPath)) {
+        return std::unexpected("--publish cannot be combined with --count, --top, --shared-objects, --max-memory, --record, "
+                               "--history, --sample, --sketch, --limit, --exists, --deadline, --batch or OpenMetrics output");
+    }
+    if (options.exportHost && !options.exportPath) {
+        return std::unexpected("--host requires --export");
+    }
+    // An export holds every matching row, in full, for the merge to combine.
+    if (options.exportPath &&
+        (options.showCountOnly || options.topN || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath ||
+         options.historyPath || options.sampleFraction || options.sketchPath || options.openMetricsPath ||
+         options.openMetricsPort || options.limit || options.exists || options.deadlineMs || options.publishName ||
+         options.batchPath)) {
+        return std::unexpected("--export cannot be combined with --count, --top, --shared-objects, --max-memory, --record, "
+                               "--history, --sample, --sketch, --limit, --exists, --deadline, --publish, --batch or "
+                               "OpenMetrics output");
+    }
+    // The merge reads files only; filtering and sorting happened on each host.
+    if (!options.mergePaths.empty() &&
+        (options.pid || options.processName || options.handleType || options.objectName || options.whereExpression ||
+         options.topN || options.sharedObjectsMin || options.maxMemoryBytes || options.recordPath || options.historyPath ||
+         options.sampleFraction || options.sketchPath || options.openMetricsPath || options.openMetricsPort ||
+         options.limit || options.exists || options.deadlineMs || options.publishName || options.batchPath ||
+         options.exportPath || options.latencyReport || options.slowLogMs || options.stats)) {
+        return std::unexpected("--merge reads snapshot files only; it cannot be combined with filters, --top, "
+                               "--shared-objects, --max-memory, --record, --history, --sample, --sketch, --limit, "
+                               "--exists, --deadline, --publish, --batch, --export, --latency, --slow-log, --stats "
+                               "or OpenMetrics output");
+    }
+    if (options.batchOutputDir && !options.batchPath) {
+        return std::unexpected("--batch-output requires --batch");
+    }
+    // Only snapshot-wide settings may accompany --batch; everything else is per query.
+    if (options.batchPath &&
+        (options.pid || options.processName || options.handleType || options.objectName || options.whereExpression ||
+         options.sortBy != SortField::Pid || options.showCountOnly || options.sharedObjectsMin || options.topN ||
+         options.maxMemoryBytes || options.recordPath || options.historyPath || options.sampleFraction ||
+         options.sketchPath || options.limit || options.exists || options.allNames || options.deadlineMs ||
+         options.columns != CliOptions{}.columns)) {
+        return std::unexpected("--batch takes filter, sort and output options from the query file");
+    }
+
     return options;
 }
 
+std::expected<std::vector<std::string>, std::string> split_arguments(const std::string_view line) {
+    std::vector<std::string> arguments;
+    std::string current;
+    bool in_argument = false;
+    char quote = '\0';
+    for (const char c : line) {
+        if (quote != '\0') {
+            if (c == quote) quote = '\0';
+            else current.push_back(c);
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            in_argument = true;
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            if (in_argument) arguments.push_back(std::move(current));
+            current.clear();
+            in_argument = false;
+        } else {
+            current.push_back(c);
+            in_argument = true;
+        }
+    }
+
+    if (quote != '\0') return std::unexpected(std::format("Unterminated {} quote", quote));
+    if (in_argument) arguments.push_back(std::move(current));
+    return arguments;
+}
+
+std::expected<std::vector<BatchQuery>, std::string> load_batch(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return std::unexpected(std::format("cannot open query file {}", path));
+
+    std::vector<BatchQuery> queries;
+    std::string text;
+    for (std::size_t line = 1; std::getline(file, text); ++line) {
+        const std::size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos || text[first] == '#') continue;
+
+        const auto fail = [&](const std::string_view message) {
+            return std::unexpected(std::format("{}:{}: {}", path, line, message));
+        };
+        auto arguments = split_arguments(text);
+        if (!arguments) return fail(arguments.error());
+
+        // parse() skips argv[0], the program name.
+        std::string program = "HandleEnum.exe";
+        std::vector<char*> argv{program.data()};
+        for (std::string& argument : *arguments) {
+            argv.push_back(argument.data());
+        }
+        auto options = parse(static_cast<int>(argv.size()), argv.data());
+        if (!options) return fail(options.error() == "help" ? "--help cannot be used in a batch query" : options.error());
+        if (options->batchPath || options->batchOutputDir || options->historyPath || options->recordPath || options->outputPath ||
+            options->openMetricsPath || options->openMetricsPort || options->sketchPath || options->latencyReport ||
+            options->slowLogMs || options->exists || options->deadlineMs || options->stats || options->publishName ||
+            options->exportPath || !options->mergePaths.empty()) {
+            return fail("--batch, --batch-output, --history, --record, --output, --openmetrics, --sketch, --latency, "
+                        "--slow-log, --exists, --deadline, --stats, --publish, --export and --merge cannot be used in "
+                        "a batch query");
+        }
+
+        const std::size_t last = text.find_last_not_of(" \t\r");
+        queries.push_back(BatchQuery{.line = line, .text = text.substr(first, last - first + 1), .options = std::move(*options)});
+    }
+
+    if (queries.empty()) return std::unexpected(std::format("query file {} contains no queries", path));
+    return queries;
+}
+
 void print_help() {
     std::cout << "HandleEnum.exe [OPTIONS]\n\n"
               << "Options:\n"
@@ -89,7 +650,71 @@ void print_help() {
               << "  -t, --type <HandleType>  Filter by handle type\n"
               << "  -o, --object <ObjectName> Filter by object name (substring)\n"
               << "  -s, --sort <Field>       Sort by: pid, type, name (default: pid)\n"
+              << "      --where <Expr>       Filter expression, e.g. (type=File and name~pipe) or pid in {4,8}\n"
+              << "                           fields: pid handle access address typeindex process type name\n"
+              << "                           ops: = != ~ < <= > >= & in {..}; combine with and/or/not\n"
+              << "      --columns <List>     Columns to print, comma-separated: pid, process,\n"
+              << "                           handle, type, name, access, address\n"
+              << "                           (default: pid,process,handle,type,name)\n"
+              << "      --max-memory <Size>  Row memory budget for type/name sorts, e.g. 512M;\n"
+              << "                           larger sorts spill to temp files\n"
+              << "      --top <N>            Print only the first N rows in sort order; with\n"
+              << "                           --count, the N processes with the most handles\n"
+              << "      --limit <N>          Stop after the first N matching handles in pid\n"
+              << "                           order; later handles are not filtered or resolved\n"
+              << "      --exists             Print nothing; exit 0 at the first matching handle,\n"
+              << "                           1 if none matches\n"
+              << "      --deadline <Seconds> Finish within Seconds, e.g. 5 or 0.5: rows from\n"
+              << "                           cached names first, then lookups until the time\n"
+              << "                           is up; the rest print as <unresolved>\n"
+              << "      --sample <Fraction>  Filter only a random sample, e.g. 0.05, and report\n"
+              << "                           estimated counts per process and type with 95%\n"
+              << "                           confidence intervals (--top sets the groups shown)\n"
+              << "      --sample-by <Mode>   uniform (default) or pid: sample every process\n"
+              << "      --sample-seed <N>    Seed for a reproducible sample\n"
               << "  -c, --count              Show only count statistics\n"
+              << "      --shared-objects <N> Report kernel objects held by N or more processes\n"
+              << "      --name-timeout <ms>  Per-handle name query deadline (default: 250)\n"
+              << "      --all-names          Query every name; by default, types that have\n"
+              << "                           shown almost no names stop being queried\n"
+              << "      --threads <N>        Filter worker threads, 1 to 1024 (default: all cores)\n"
+              << "      --record <File>      Append the filtered snapshot to a history file\n"
+              << "      --history <File>     List the frames of a history file\n"
+              << "      --held <Address>     With --history: handles to this object over time\n"
+              << "      --from, --to <Time>  With --history: time range, epoch seconds or\n"
+              << "                           YYYY-MM-DDTHH:MM[:SS] (UTC)\n"
+              << "      --output <File>      Write the report to File from a background thread\n"
+              << "      --openmetrics <File> Write per-process and per-type handle counts as\n"
+              << "                           OpenMetrics text (- for stdout); --top sets the\n"
+              << "                           series kept per dimension (default: 20)\n"
+              << "      --openmetrics-port <Port> Serve them at http://127.0.0.1:Port/metrics\n"
+              << "      --sketch <File>      Add the filtered snapshot to the distinct-object and\n"
+              << "                           frequent-name sketches in File (created if\n"
+              << "                           missing) and print them; --top sets the rows\n"
+              << "      --sketch-merge <List> With --sketch: replace File with the merge of\n"
+              << "                           these comma-separated sketch files\n"
+              << "      --publish <Name>     Publish the filtered snapshot, every field resolved,\n"
+              << "                           to a named shared-memory region for local readers\n"
+              << "      --publish-interval <s> With --publish: seconds between snapshots\n"
+              << "                           (default 5)\n"
+              << "      --publish-count <N>  With --publish: exit after N snapshots\n"
+              << "      --export <File>      Write the filtered snapshot, sorted by --sort and\n"
+              << "                           every field resolved, as a snapshot file for --merge\n"
+              << "      --host <Name>        With --export: host name to store (default: this\n"
+              << "                           computer's name)\n"
+              << "      --merge <List>       Merge snapshot files sorted by the same key (comma-\n"
+              << "                           separated; a directory means its *.snap files) into\n"
+              << "                           one host-tagged listing; with --count, handles and\n"
+              << "                           hosts per key\n"
+              << "      --latency            Print NT call latency percentiles per call, type\n"
+              << "                           and process after the report\n"
+              << "      --slow-log <ms>      List NT calls that took at least ms, with pid,\n"
+              << "                           type index and access mask\n"
+              << "      --stats              Print heap allocations per pipeline stage and\n"
+              << "                           per handle after the report\n"
+              << "      --batch <File>       Run one query per line of File against a single\n"
+              << "                           snapshot; names are resolved once for all queries\n"
+              << "      --batch-output <Dir> With --batch: one output file per query\n"
               << "  -v, --verbose            Show detailed info\n"
               << "  -h, --help               Display help message\n";
 }
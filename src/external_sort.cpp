@@ -0,0 +1,240 @@
+#include "external_sort.hpp"
+
+#include "binary_codec.hpp"
+#include "handle_sort.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <queue>
+#include <random>
+#include <span>
+#include <system_error>
+
+namespace sorting {
+
+namespace {
+
+// Runs are written and read back in blocks of about this many bytes:
+// varint(size) followed by whole encoded rows.
+constexpr std::size_t kBlockBytes = 32 * 1024;
+
+void encode_row(const HandleInfo& row, codec::ByteWriter& out) {
+    out.varint(row.pid);
+    out.varint(row.processName);
+    out.varint(row.handleType);
+    out.varint(row.objectName);
+    out.varint(row.grantedAccess);
+    out.varint(row.objectAddress);
+    out.varint(row.handleValue);
+    out.varint(row.objectTypeIndex);
+    out.varint(row.handleAttributes);
+}
+
+[[nodiscard]] HandleInfo decode_row(codec::ByteReader& in) {
+    HandleInfo row;
+    row.pid = static_cast<uint32_t>(in.varint());
+    row.processName = static_cast<StringId>(in.varint());
+    row.handleType = static_cast<StringId>(in.varint());
+    row.objectName = static_cast<StringId>(in.varint());
+    row.grantedAccess = static_cast<uint32_t>(in.varint());
+    row.objectAddress = static_cast<std::uintptr_t>(in.varint());
+    row.handleValue = static_cast<std::uintptr_t>(in.varint());
+    row.objectTypeIndex = static_cast<uint16_t>(in.varint());
+    row.handleAttributes = static_cast<uint32_t>(in.varint());
+    return row;
+}
+
+// Sequential reader over one spilled run.
+class RunReader {
+public:
+    explicit RunReader(const std::filesystem::path& path) : m_file(path, std::ios::binary) {}
+
+    [[nodiscard]] bool is_open() const { return m_file.is_open(); }
+
+    // Reads the next row into `row`; false at the end of the run or on error.
+    [[nodiscard]] bool next(HandleInfo& row) {
+        while (m_reader.at_end()) {
+            if (!load_block()) {
+                return false;
+            }
+        }
+        row = decode_row(m_reader);
+        m_failed = m_reader.failed();
+        return !m_failed;
+    }
+
+    [[nodiscard]] bool failed() const noexcept { return m_failed; }
+
+private:
+    [[nodiscard]] bool load_block() {
+        std::uint64_t size = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const int byte = m_file.get();
+            if (byte == std::char_traits<char>::eof()) {
+                // A clean end of file is only valid between blocks.
+                m_failed = shift != 0;
+                return false;
+            }
+            size |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        m_block.resize(static_cast<std::size_t>(size));
+        if (size > 2 * kBlockBytes ||
+            !m_file.read(reinterpret_cast<char*>(m_block.data()), static_cast<std::streamsize>(m_block.size()))) {
+            m_failed = true;
+            return false;
+        }
+        m_reader = codec::ByteReader(m_block);
+        return true;
+    }
+
+    std::ifstream m_file;
+    std::vector<std::uint8_t> m_block;
+    codec::ByteReader m_reader{std::span<const std::uint8_t>{}};
+    bool m_failed = false;
+};
+
+} // namespace
+
+ExternalSorter::ExternalSorter(const SortField sort_by,
+                               StringInterner& strings,
+                               const std::size_t max_memory_bytes,
+                               std::filesystem::path temp_dir)
+    : m_sort_by(sort_by),
+      m_strings(strings),
+      m_temp_dir(std::move(temp_dir)),
+      m_capacity(std::max<std::size_t>(max_memory_bytes / sizeof(HandleInfo), 1)),
+      m_tag(std::random_device{}()) {
+    m_buffer.reserve(std::min<std::size_t>(m_capacity, 1u << 16));
+}
+
+ExternalSorter::~ExternalSorter() {
+    remove_runs();
+}
+
+std::expected<void, std::string> ExternalSorter::push(const HandleInfo& row) {
+    if (m_buffer.size() >= m_capacity) {
+        if (auto spilled = spill(); !spilled) {
+            return spilled;
+        }
+    }
+    m_buffer.push_back(row);
+    return {};
+}
+
+std::expected<void, std::string> ExternalSorter::spill() {
+    // Ranks reflect every string interned so far; later strings only insert
+    // new ranks between existing ones, so this run stays sorted under the
+    // final ranks used by the merge.
+    sort_handles(m_buffer, m_sort_by, m_strings);
+
+    const auto path = m_temp_dir / std::format("handleenum-sort-{:x}-{}.run", m_tag, m_runs.size());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return std::unexpected(std::format("cannot create sort run {}", path.string()));
+    }
+    m_runs.push_back(path);
+    ++m_run_count;
+
+    codec::ByteWriter block;
+    codec::ByteWriter header;
+    const auto flush_block = [&] {
+        header.clear();
+        header.varint(block.size());
+        file.write(reinterpret_cast<const char*>(header.data().data()), static_cast<std::streamsize>(header.size()));
+        file.write(reinterpret_cast<const char*>(block.data().data()), static_cast<std::streamsize>(block.size()));
+        block.clear();
+    };
+    for (const HandleInfo& row : m_buffer) {
+        encode_row(row, block);
+        if (block.size() >= kBlockBytes) {
+            flush_block();
+        }
+    }
+    if (block.size() > 0) {
+        flush_block();
+    }
+
+    if (!file.flush()) {
+        return std::unexpected(std::format("cannot write sort run {}", path.string()));
+    }
+    m_spilled_rows += m_buffer.size();
+    m_buffer.clear();
+    return {};
+}
+
+std::expected<void, std::string> ExternalSorter::finish(const Consumer& consume) {
+    sort_handles(m_buffer, m_sort_by, m_strings);
+    if (m_runs.empty()) {
+        for (const HandleInfo& row : m_buffer) {
+            consume(row);
+        }
+        m_buffer.clear();
+        return {};
+    }
+
+    // Sources: one reader per run, plus the sorted in-memory tail.
+    std::vector<RunReader> readers;
+    readers.reserve(m_runs.size());
+    for (const auto& path : m_runs) {
+        readers.emplace_back(path);
+        if (!readers.back().is_open()) {
+            return std::unexpected(std::format("cannot reopen sort run {}", path.string()));
+        }
+    }
+
+    struct Head {
+        HandleInfo row;
+        std::size_t source;
+    };
+    const auto later = [this](const Head& left, const Head& right) {
+        return handle_less(right.row, left.row, m_sort_by, m_strings);
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+
+    std::size_t tail_next = 0;
+    const std::size_t tail_source = readers.size();
+    const auto advance = [&](const std::size_t source) {
+        HandleInfo row;
+        if (source == tail_source) {
+            if (tail_next < m_buffer.size()) {
+                heads.push(Head{m_buffer[tail_next++], source});
+            }
+        } else if (readers[source].next(row)) {
+            heads.push(Head{row, source});
+        }
+    };
+
+    for (std::size_t source = 0; source <= tail_source; ++source) {
+        advance(source);
+    }
+    while (!heads.empty()) {
+        const Head head = heads.top();
+        heads.pop();
+        consume(head.row);
+        advance(head.source);
+    }
+
+    const bool failed = std::ranges::any_of(readers, &RunReader::failed);
+    m_buffer.clear();
+    readers.clear();
+    remove_runs();
+    if (failed) {
+        return std::unexpected(std::string("sort run is truncated or corrupt"));
+    }
+    return {};
+}
+
+void ExternalSorter::remove_runs() noexcept {
+    for (const auto& path : m_runs) {
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+    m_runs.clear();
+}
+
+} // namespace sorting
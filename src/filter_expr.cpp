@@ -0,0 +1,586 @@
+#include "filter_expr.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <optional>
+#include <utility>
+
+namespace filter_expr {
+
+namespace {
+
+struct FieldInfo {
+    std::string_view name;
+    Field field;
+    bool numeric;
+    // Relative lookup cost used to order operands: raw fields are free,
+    // process names are cached per pid, type and name cost an NT round-trip.
+    std::size_t cost;
+};
+
+constexpr std::array<FieldInfo, 8> kFields{{
+    {"pid", Field::Pid, true, 1},
+    {"handle", Field::Handle, true, 1},
+    {"access", Field::Access, true, 1},
+    {"address", Field::Address, true, 1},
+    {"typeindex", Field::TypeIndex, true, 1},
+    {"process", Field::Process, false, 16},
+    {"type", Field::Type, false, 256},
+    {"name", Field::Name, false, 4096},
+}};
+
+[[nodiscard]] const FieldInfo& info_of(const Field field) {
+    return kFields[static_cast<std::size_t>(field)];
+}
+
+[[nodiscard]] std::string_view op_text(const CompareOp op) {
+    switch (op) {
+    case CompareOp::Equal: return "=";
+    case CompareOp::NotEqual: return "!=";
+    case CompareOp::Contains: return "~";
+    case CompareOp::Less: return "<";
+    case CompareOp::LessEqual: return "<=";
+    case CompareOp::Greater: return ">";
+    case CompareOp::GreaterEqual: return ">=";
+    case CompareOp::HasBits: return "&";
+    case CompareOp::In: return "in";
+    }
+    return "?";
+}
+
+void lower_in_place(std::string& text) {
+    for (char& ch : text) {
+        if (ch >= 'A' && ch <= 'Z') {
+            ch = static_cast<char>(ch - 'A' + 'a');
+        }
+    }
+}
+
+[[nodiscard]] std::string lower_ascii(std::string_view text) {
+    std::string lower(text);
+    lower_in_place(lower);
+    return lower;
+}
+
+[[nodiscard]] bool iequals(const std::string_view left, const std::string_view right) {
+    return left.size() == right.size() &&
+           std::ranges::equal(left, right, [](const char a, const char b) {
+               return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+           });
+}
+
+[[nodiscard]] std::optional<std::uint64_t> parse_number(std::string_view text) {
+    int base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text.remove_prefix(2);
+        base = 16;
+    }
+
+    std::uint64_t value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    if (error != std::errc{} || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
+
+struct Token {
+    enum class Kind { End, Word, Quoted, LParen, RParen, LBrace, RBrace, Comma, Op };
+
+    Kind kind = Kind::End;
+    std::string_view text;
+    std::size_t position = 0;
+};
+
+class Lexer {
+public:
+    explicit Lexer(const std::string_view text) : m_text(text) {}
+
+    std::expected<Token, std::string> next() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+            ++m_pos;
+        }
+
+        const std::size_t start = m_pos;
+        if (m_pos >= m_text.size()) {
+            return Token{Token::Kind::End, {}, start};
+        }
+
+        const char ch = m_text[m_pos];
+        switch (ch) {
+        case '(': ++m_pos; return Token{Token::Kind::LParen, m_text.substr(start, 1), start};
+        case ')': ++m_pos; return Token{Token::Kind::RParen, m_text.substr(start, 1), start};
+        case '{': ++m_pos; return Token{Token::Kind::LBrace, m_text.substr(start, 1), start};
+        case '}': ++m_pos; return Token{Token::Kind::RBrace, m_text.substr(start, 1), start};
+        case ',': ++m_pos; return Token{Token::Kind::Comma, m_text.substr(start, 1), start};
+        case '"': {
+            const std::size_t close = m_text.find('"', start + 1);
+            if (close == std::string_view::npos) {
+                return std::unexpected(std::format("Unterminated string at position {}", start));
+            }
+            m_pos = close + 1;
+            return Token{Token::Kind::Quoted, m_text.substr(start + 1, close - start - 1), start};
+        }
+        case '!': case '<': case '>':
+            m_pos += (m_pos + 1 < m_text.size() && m_text[m_pos + 1] == '=') ? 2 : 1;
+            return Token{Token::Kind::Op, m_text.substr(start, m_pos - start), start};
+        case '=': case '~': case '&':
+            ++m_pos;
+            return Token{Token::Kind::Op, m_text.substr(start, 1), start};
+        default:
+            break;
+        }
+
+        constexpr std::string_view kDelimiters = "(){},\"!<>=~&";
+        while (m_pos < m_text.size() &&
+               !std::isspace(static_cast<unsigned char>(m_text[m_pos])) &&
+               kDelimiters.find(m_text[m_pos]) == std::string_view::npos) {
+            ++m_pos;
+        }
+        return Token{Token::Kind::Word, m_text.substr(start, m_pos - start), start};
+    }
+
+private:
+    std::string_view m_text;
+    std::size_t m_pos = 0;
+};
+
+class Parser {
+public:
+    explicit Parser(const std::string_view text) : m_lexer(text) {}
+
+    std::expected<Node, std::string> parse_all() {
+        if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+        if (m_token.kind == Token::Kind::End) {
+            return std::unexpected("Empty expression");
+        }
+
+        auto root = parse_or();
+        if (!root) return root;
+        if (m_token.kind != Token::Kind::End) {
+            return error("Unexpected '{}'");
+        }
+        return root;
+    }
+
+private:
+    std::expected<void, std::string> advance() {
+        auto token = m_lexer.next();
+        if (!token) return std::unexpected(token.error());
+        m_token = *token;
+        return {};
+    }
+
+    [[nodiscard]] bool at_keyword(const std::string_view keyword) const {
+        return m_token.kind == Token::Kind::Word && iequals(m_token.text, keyword);
+    }
+
+    [[nodiscard]] std::unexpected<std::string> error(const std::string_view pattern) const {
+        const std::string_view shown = m_token.kind == Token::Kind::End ? "end of expression" : m_token.text;
+        std::string message(pattern);
+        if (const std::size_t slot = message.find("{}"); slot != std::string::npos) {
+            message.replace(slot, 2, shown);
+        }
+        return std::unexpected(std::format("{} at position {}", message, m_token.position));
+    }
+
+    std::expected<Node, std::string> parse_binary(const Node::Kind kind,
+                                                  const std::string_view keyword,
+                                                  std::expected<Node, std::string> (Parser::*operand)()) {
+        auto first = (this->*operand)();
+        if (!first || !at_keyword(keyword)) return first;
+
+        Node node{.kind = kind, .predicate = {}, .children = {}};
+        node.children.push_back(std::move(*first));
+        while (at_keyword(keyword)) {
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            auto next = (this->*operand)();
+            if (!next) return next;
+            node.children.push_back(std::move(*next));
+        }
+        return node;
+    }
+
+    std::expected<Node, std::string> parse_or() {
+        return parse_binary(Node::Kind::Or, "or", &Parser::parse_and);
+    }
+
+    std::expected<Node, std::string> parse_and() {
+        return parse_binary(Node::Kind::And, "and", &Parser::parse_unary);
+    }
+
+    std::expected<Node, std::string> parse_unary() {
+        if (at_keyword("not")) {
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            auto operand = parse_unary();
+            if (!operand) return operand;
+            Node node{.kind = Node::Kind::Not, .predicate = {}, .children = {}};
+            node.children.push_back(std::move(*operand));
+            return node;
+        }
+
+        if (m_token.kind == Token::Kind::LParen) {
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            auto inner = parse_or();
+            if (!inner) return inner;
+            if (m_token.kind != Token::Kind::RParen) return error("Expected ')' but found '{}'");
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            return inner;
+        }
+
+        return parse_predicate();
+    }
+
+    std::expected<void, std::string> append_value(const FieldInfo& field, Predicate& predicate) {
+        if (m_token.kind != Token::Kind::Word && m_token.kind != Token::Kind::Quoted) {
+            return error("Expected a value but found '{}'");
+        }
+
+        if (field.numeric) {
+            const auto number = parse_number(m_token.text);
+            if (!number) return error("Invalid number '{}'");
+            predicate.numbers.push_back(*number);
+        } else {
+            predicate.texts.push_back(lower_ascii(m_token.text));
+        }
+        return advance();
+    }
+
+    std::expected<Node, std::string> parse_predicate() {
+        if (m_token.kind != Token::Kind::Word) return error("Expected a field name but found '{}'");
+
+        const auto field_it = std::ranges::find_if(kFields, [&](const FieldInfo& info) {
+            return iequals(info.name, m_token.text);
+        });
+        if (field_it == kFields.end()) return error("Unknown field '{}'");
+        const FieldInfo& field = *field_it;
+        if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+
+        Predicate predicate{.field = field.field, .op = CompareOp::Equal, .numbers = {}, .texts = {}};
+        if (at_keyword("in")) {
+            predicate.op = CompareOp::In;
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            if (m_token.kind != Token::Kind::LBrace) return error("Expected '{' after 'in' but found '{}'");
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            while (true) {
+                if (auto appended = append_value(field, predicate); !appended) return std::unexpected(appended.error());
+                if (m_token.kind == Token::Kind::RBrace) break;
+                if (m_token.kind != Token::Kind::Comma) return error("Expected ',' or '}' but found '{}'");
+                if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            }
+            if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+            return Node{.kind = Node::Kind::Test, .predicate = std::move(predicate), .children = {}};
+        }
+
+        if (m_token.kind != Token::Kind::Op) return error("Expected an operator but found '{}'");
+        constexpr std::array kOps{
+            CompareOp::Equal, CompareOp::NotEqual, CompareOp::Contains, CompareOp::Less,
+            CompareOp::LessEqual, CompareOp::Greater, CompareOp::GreaterEqual, CompareOp::HasBits
+        };
+        const auto op_it = std::ranges::find_if(kOps, [&](const CompareOp op) { return op_text(op) == m_token.text; });
+        if (op_it == kOps.end()) return error("Unknown operator '{}'");
+        predicate.op = *op_it;
+
+        const bool string_only = predicate.op == CompareOp::Contains;
+        const bool numeric_only = predicate.op != CompareOp::Equal &&
+                                  predicate.op != CompareOp::NotEqual &&
+                                  predicate.op != CompareOp::Contains;
+        if ((string_only && field.numeric) || (numeric_only && !field.numeric)) {
+            return error(std::format("Operator '{{}}' is not valid for field '{}'", field.name));
+        }
+
+        if (auto advanced = advance(); !advanced) return std::unexpected(advanced.error());
+        if (auto appended = append_value(field, predicate); !appended) return std::unexpected(appended.error());
+        return Node{.kind = Node::Kind::Test, .predicate = std::move(predicate), .children = {}};
+    }
+
+    Lexer m_lexer;
+    Token m_token;
+};
+
+// ---------------------------------------------------------------------------
+// Normalization
+// ---------------------------------------------------------------------------
+
+[[nodiscard]] std::size_t cost_of(const Node& node) {
+    if (node.kind == Node::Kind::Test) {
+        return info_of(node.predicate.field).cost;
+    }
+
+    std::size_t total = 0;
+    for (const Node& child : node.children) {
+        total += cost_of(child);
+    }
+    return total;
+}
+
+// Pushes negation down to the tests (De Morgan), so Not only ever wraps a
+// Test. A negated test can then treat a failed lookup as "no match" without
+// that answer being inverted again by an enclosing not.
+[[nodiscard]] Node normalize(Node node, const bool negate = false) {
+    if (node.kind == Node::Kind::Test) {
+        if (!negate) {
+            return node;
+        }
+        Node negated{.kind = Node::Kind::Not, .predicate = {}, .children = {}};
+        negated.children.push_back(std::move(node));
+        return negated;
+    }
+
+    if (node.kind == Node::Kind::Not) {
+        return normalize(std::move(node.children.front()), !negate);
+    }
+
+    if (negate) {
+        node.kind = node.kind == Node::Kind::And ? Node::Kind::Or : Node::Kind::And;
+    }
+    std::vector<Node> flat;
+    for (Node& child : node.children) {
+        Node normalized = normalize(std::move(child), negate);
+        if (normalized.kind == node.kind) {
+            for (Node& grandchild : normalized.children) {
+                flat.push_back(std::move(grandchild));
+            }
+        } else {
+            flat.push_back(std::move(normalized));
+        }
+    }
+
+    // and/or are commutative here (predicates have no side effects), so cheap
+    // operands go first and expensive lookups only run when still undecided.
+    std::ranges::stable_sort(flat, {}, [](const Node& child) { return cost_of(child); });
+    node.children = std::move(flat);
+    return node;
+}
+
+// ---------------------------------------------------------------------------
+// Evaluation
+// ---------------------------------------------------------------------------
+
+// Per-handle memo so each lookup runs at most once per evaluation.
+struct LazyText {
+    bool loaded = false;
+    bool ok = false;
+    std::string lower;
+};
+
+[[nodiscard]] std::uint64_t raw_value(const nt::RawHandle& handle, const Field field) {
+    switch (field) {
+    case Field::Pid: return handle.processId;
+    case Field::Handle: return handle.handleValue;
+    case Field::Access: return handle.grantedAccess;
+    case Field::Address: return handle.objectAddress;
+    case Field::TypeIndex: return handle.objectTypeIndex;
+    default: return 0;
+    }
+}
+
+[[nodiscard]] bool test_number(const std::uint64_t value, const Predicate& predicate) {
+    const std::uint64_t operand = predicate.numbers.front();
+    switch (predicate.op) {
+    case CompareOp::Equal: return value == operand;
+    case CompareOp::NotEqual: return value != operand;
+    case CompareOp::Less: return value < operand;
+    case CompareOp::LessEqual: return value <= operand;
+    case CompareOp::Greater: return value > operand;
+    case CompareOp::GreaterEqual: return value >= operand;
+    case CompareOp::HasBits: return (value & operand) != 0;
+    case CompareOp::In: return std::ranges::find(predicate.numbers, value) != predicate.numbers.end();
+    case CompareOp::Contains: return false;
+    }
+    return false;
+}
+
+// Only meaningful when value.ok; callers decide what a failed lookup means.
+[[nodiscard]] bool test_text(const LazyText& value, const Predicate& predicate) {
+    switch (predicate.op) {
+    case CompareOp::Equal: return value.lower == predicate.texts.front();
+    case CompareOp::NotEqual: return value.lower != predicate.texts.front();
+    case CompareOp::Contains: return value.lower.find(predicate.texts.front()) != std::string::npos;
+    case CompareOp::In: return std::ranges::find(predicate.texts, value.lower) != predicate.texts.end();
+    default: return false;
+    }
+}
+
+void load(LazyText& slot, const nt::ObjectQuery& query, const nt::RawHandle& handle) {
+    slot.loaded = true;
+    if (!query) {
+        return;
+    }
+    if (auto result = query(handle); result) {
+        slot.ok = true;
+        slot.lower = std::move(*result);
+        lower_in_place(slot.lower);
+    }
+}
+
+} // namespace
+
+std::expected<Node, std::string> parse(const std::string_view text) {
+    return Parser(text).parse_all();
+}
+
+Node make_test(const Field field, const CompareOp op, const std::uint64_t number) {
+    return Node{.kind = Node::Kind::Test,
+                .predicate = Predicate{.field = field, .op = op, .numbers = {number}, .texts = {}},
+                .children = {}};
+}
+
+Node make_test(const Field field, const CompareOp op, const std::string_view text) {
+    return Node{.kind = Node::Kind::Test,
+                .predicate = Predicate{.field = field, .op = op, .numbers = {}, .texts = {lower_ascii(text)}},
+                .children = {}};
+}
+
+Node all_of(std::vector<Node> nodes) {
+    if (nodes.size() == 1) {
+        return std::move(nodes.front());
+    }
+    return Node{.kind = Node::Kind::And, .predicate = {}, .children = std::move(nodes)};
+}
+
+void FilterProgram::emit(const Node& node) {
+    switch (node.kind) {
+    case Node::Kind::Test:
+    case Node::Kind::Not: {
+        // normalize() leaves Not only directly above a Test.
+        const Predicate& predicate = node.kind == Node::Kind::Not ? node.children.front().predicate : node.predicate;
+        m_code.push_back(Instruction{
+            .code = OpCode::Test,
+            .field = predicate.field,
+            .op = predicate.op,
+            .negate = node.kind == Node::Kind::Not,
+            .operand = static_cast<std::uint32_t>(m_predicates.size())
+        });
+        m_predicates.push_back(predicate);
+        return;
+    }
+    case Node::Kind::And:
+    case Node::Kind::Or: {
+        // The accumulator already holds the answer when an operand decides it,
+        // so jumps skip straight past the remaining operands.
+        const OpCode exit = node.kind == Node::Kind::And ? OpCode::JumpIfFalse : OpCode::JumpIfTrue;
+        std::vector<std::size_t> patches;
+        for (std::size_t i = 0; i < node.children.size(); ++i) {
+            emit(node.children[i]);
+            if (i + 1 < node.children.size()) {
+                patches.push_back(m_code.size());
+                m_code.push_back(Instruction{.code = exit, .field = Field::Pid, .op = CompareOp::Equal, .negate = false,
+                                             .operand = 0});
+            }
+        }
+        for (const std::size_t patch : patches) {
+            m_code[patch].operand = static_cast<std::uint32_t>(m_code.size());
+        }
+        return;
+    }
+    }
+}
+
+FilterProgram FilterProgram::compile(Node root) {
+    FilterProgram program;
+    program.emit(normalize(std::move(root)));
+    return program;
+}
+
+bool FilterProgram::empty() const noexcept {
+    return m_code.empty();
+}
+
+bool FilterProgram::uses(const Field field) const noexcept {
+    return std::ranges::any_of(m_code, [field](const Instruction& instruction) {
+        return instruction.code == OpCode::Test && instruction.field == field;
+    });
+}
+
+bool FilterProgram::matches(const nt::RawHandle& handle, const FieldResolvers& resolvers) const {
+    LazyText process;
+    LazyText type;
+    LazyText name;
+
+    bool accumulator = true;
+    std::size_t pc = 0;
+    while (pc < m_code.size()) {
+        const Instruction& instruction = m_code[pc];
+        switch (instruction.code) {
+        case OpCode::JumpIfFalse:
+            pc = accumulator ? pc + 1 : instruction.operand;
+            continue;
+        case OpCode::JumpIfTrue:
+            pc = accumulator ? instruction.operand : pc + 1;
+            continue;
+        case OpCode::Test:
+            break;
+        }
+
+        const Predicate& predicate = m_predicates[instruction.operand];
+        switch (instruction.field) {
+        case Field::Process:
+            if (!process.loaded) {
+                process.loaded = true;
+                if (resolvers.processName && handle.processId <= UINT32_MAX) {
+                    process.ok = true;
+                    process.lower = lower_ascii(resolvers.processName(static_cast<uint32_t>(handle.processId)));
+                }
+            }
+            accumulator = process.ok && test_text(process, predicate) != instruction.negate;
+            break;
+        case Field::Type:
+            if (!type.loaded) {
+                load(type, resolvers.typeQuery, handle);
+            }
+            accumulator = type.ok && test_text(type, predicate) != instruction.negate;
+            break;
+        case Field::Name:
+            if (!name.loaded) {
+                load(name, resolvers.nameQuery, handle);
+            }
+            accumulator = name.ok && test_text(name, predicate) != instruction.negate;
+            break;
+        default:
+            accumulator = test_number(raw_value(handle, instruction.field), predicate) != instruction.negate;
+            break;
+        }
+        ++pc;
+    }
+
+    return accumulator;
+}
+
+std::string FilterProgram::disassemble() const {
+    std::string listing;
+    for (std::size_t pc = 0; pc < m_code.size(); ++pc) {
+        const Instruction& instruction = m_code[pc];
+        switch (instruction.code) {
+        case OpCode::JumpIfFalse:
+            listing += std::format("{}: jump_if_false {}\n", pc, instruction.operand);
+            break;
+        case OpCode::JumpIfTrue:
+            listing += std::format("{}: jump_if_true {}\n", pc, instruction.operand);
+            break;
+        case OpCode::Test: {
+            const Predicate& predicate = m_predicates[instruction.operand];
+            std::string values;
+            for (const std::uint64_t number : predicate.numbers) {
+                values += (values.empty() ? "" : ",") + std::to_string(number);
+            }
+            for (const std::string& text : predicate.texts) {
+                values += (values.empty() ? "" : ",") + text;
+            }
+            listing += std::format("{}: test {}{} {} {}\n", pc, instruction.negate ? "not " : "", info_of(predicate.field).name,
+                                   op_text(predicate.op), values);
+            break;
+        }
+        }
+    }
+    return listing;
+}
+
+} // namespace filter_expr
@@ -0,0 +1,695 @@
+#include "fleet_merge.hpp"
+
+#include "binary_codec.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fleet {
+
+namespace {
+
+// File layout (fixed-width values little-endian, varints LEB128):
+//   header:  "HNDLSNAP" fixed32(version) varint(sortField) string(host) fixed64(takenMs)
+//            varint(totalRawCount) varint(rowCount) varint(stringCount) varint(stringBytes)
+//   strings: fixed32 offsets[stringCount + 1] into the text, then stringBytes of text
+//   blocks:  varint(rows) varint(size) payload, until rowCount rows are stored
+// A block's rows are delta-encoded against the block's previous row only, so
+// any block decodes on its own once its offset is known.
+constexpr std::string_view kMagic = "HNDLSNAP";
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kUnmapped = std::numeric_limits<std::uint32_t>::max();
+constexpr std::string_view kExtension = ".snap";
+
+[[nodiscard]] std::string_view sort_name(const SortField sort_by) noexcept {
+    switch (sort_by) {
+    case SortField::Pid: return "pid";
+    case SortField::Type: return "type";
+    case SortField::Name: return "name";
+    }
+    return "unknown";
+}
+
+[[nodiscard]] std::uint32_t load_le32(const std::uint8_t* bytes) noexcept {
+    return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+           static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+}
+
+// Read-only view of a whole file. The descriptor is closed once the view
+// exists; the view keeps the file alive.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile&& other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] static std::expected<MappedFile, std::string> open(const std::filesystem::path& path);
+
+    [[nodiscard]] std::span<const std::uint8_t> bytes() const noexcept { return {m_data, m_size}; }
+
+private:
+    void close() noexcept;
+
+    const std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+#ifdef _WIN32
+
+std::expected<MappedFile, std::string> MappedFile::open(const std::filesystem::path& path) {
+    const HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return std::unexpected(std::format("cannot open {} (error {})", path.string(), ::GetLastError()));
+    }
+    LARGE_INTEGER size{};
+    if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        ::CloseHandle(file);
+        return std::unexpected(std::format("{} is empty", path.string()));
+    }
+    const HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    ::CloseHandle(file);
+    if (mapping == nullptr) {
+        return std::unexpected(std::format("cannot map {} (error {})", path.string(), ::GetLastError()));
+    }
+    void* const view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    ::CloseHandle(mapping);
+    if (view == nullptr) {
+        return std::unexpected(std::format("cannot map {} (error {})", path.string(), ::GetLastError()));
+    }
+    MappedFile mapped;
+    mapped.m_data = static_cast<const std::uint8_t*>(view);
+    mapped.m_size = static_cast<std::size_t>(size.QuadPart);
+    return mapped;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data != nullptr) {
+        ::UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    m_size = 0;
+}
+
+#else
+
+std::expected<MappedFile, std::string> MappedFile::open(const std::filesystem::path& path) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        return std::unexpected(std::format("cannot open {} ({})", path.string(), std::strerror(errno)));
+    }
+    struct stat status{};
+    if (::fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        ::close(descriptor);
+        return std::unexpected(std::format("{} is empty", path.string()));
+    }
+    const auto size = static_cast<std::size_t>(status.st_size);
+    void* const view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (view == MAP_FAILED) {
+        return std::unexpected(std::format("cannot map {} ({})", path.string(), std::strerror(errno)));
+    }
+    // Each file is read front to back exactly once.
+    ::madvise(view, size, MADV_SEQUENTIAL);
+    MappedFile mapped;
+    mapped.m_data = static_cast<const std::uint8_t*>(view);
+    mapped.m_size = size;
+    return mapped;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data != nullptr) {
+        ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+    m_size = 0;
+}
+
+#endif
+
+// One mapped snapshot file and the merge's read position in it.
+struct Input {
+    std::filesystem::path path;
+    MappedFile file;
+    SnapshotInfo info;
+    std::uint64_t stringCount = 0;
+    // stringCount + 1 little-endian offsets, validated by open_input().
+    const std::uint8_t* offsets = nullptr;
+    std::string_view text;
+    // Byte offset of the first block not yet handed to a decoder.
+    std::size_t nextBlock = 0;
+    std::uint64_t rowsHandedOut = 0;
+
+    [[nodiscard]] std::string_view string(const std::uint64_t id) const noexcept {
+        const std::uint32_t begin = load_le32(offsets + id * 4);
+        return text.substr(begin, load_le32(offsets + id * 4 + 4) - begin);
+    }
+};
+
+[[nodiscard]] std::expected<Input, std::string> open_input(const std::filesystem::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    const std::span<const std::uint8_t> bytes = file->bytes();
+    const auto corrupt = [&](const std::string_view what) {
+        return std::unexpected(std::format("{} is not a valid snapshot file ({})", path.string(), what));
+    };
+
+    codec::ByteReader in(bytes);
+    const std::span<const std::uint8_t> magic = in.bytes(kMagic.size());
+    if (in.failed() || !std::ranges::equal(magic, kMagic, [](const std::uint8_t byte, const char c) {
+            return byte == static_cast<std::uint8_t>(c);
+        })) {
+        return corrupt("bad magic");
+    }
+    if (const std::uint32_t version = in.fixed32(); version != kVersion) {
+        return std::unexpected(std::format("{} has snapshot format version {}; this build reads version {}",
+                                           path.string(), version, kVersion));
+    }
+
+    Input input;
+    input.path = path;
+    const std::uint64_t sort_by = in.varint();
+    if (sort_by > static_cast<std::uint64_t>(SortField::Name)) {
+        return corrupt("unknown sort key");
+    }
+    input.info.sortBy = static_cast<SortField>(sort_by);
+    input.info.host = std::string(in.string());
+    input.info.takenMs = static_cast<std::int64_t>(in.fixed64());
+    input.info.totalRawCount = in.varint();
+    input.info.rowCount = in.varint();
+    input.stringCount = in.varint();
+    const std::uint64_t string_bytes = in.varint();
+    if (in.failed() || input.stringCount >= std::numeric_limits<std::uint32_t>::max() ||
+        string_bytes > std::numeric_limits<std::uint32_t>::max()) {
+        return corrupt("truncated header");
+    }
+
+    const std::span<const std::uint8_t> offsets = in.bytes(static_cast<std::size_t>(input.stringCount + 1) * 4);
+    const std::span<const std::uint8_t> text = in.bytes(static_cast<std::size_t>(string_bytes));
+    if (in.failed()) {
+        return corrupt("truncated string table");
+    }
+    // Checked once here, so decoding can slice strings without bounds checks.
+    std::uint32_t previous = 0;
+    for (std::uint64_t id = 0; id <= input.stringCount; ++id) {
+        const std::uint32_t offset = load_le32(offsets.data() + id * 4);
+        if (offset < previous || offset > string_bytes || (id == 0 && offset != 0)) {
+            return corrupt("bad string offsets");
+        }
+        previous = offset;
+    }
+    if (previous != string_bytes) {
+        return corrupt("bad string offsets");
+    }
+
+    input.offsets = offsets.data();
+    input.text = std::string_view(reinterpret_cast<const char*>(text.data()), text.size());
+    input.nextBlock = in.offset();
+    input.file = std::move(*file);
+    return input;
+}
+
+// The next encoded block of `input`, or an empty span after the last one.
+struct EncodedBlock {
+    std::size_t rows = 0;
+    std::span<const std::uint8_t> payload;
+};
+
+[[nodiscard]] std::expected<EncodedBlock, std::string> take_block(Input& input) {
+    if (input.rowsHandedOut == input.info.rowCount) {
+        return EncodedBlock{};
+    }
+    const std::span<const std::uint8_t> bytes = input.file.bytes();
+    codec::ByteReader in(bytes.subspan(input.nextBlock));
+    const std::uint64_t rows = in.varint();
+    const std::uint64_t size = in.varint();
+    const std::span<const std::uint8_t> payload = in.bytes(static_cast<std::size_t>(size));
+    // Every row takes at least one byte per field.
+    if (in.failed() || rows == 0 || rows > input.info.rowCount - input.rowsHandedOut || size < rows) {
+        return std::unexpected(std::format("{} is truncated or corrupt after {} of {} rows", input.path.string(),
+                                           input.rowsHandedOut, input.info.rowCount));
+    }
+    input.nextBlock += in.offset();
+    input.rowsHandedOut += rows;
+    return EncodedBlock{.rows = static_cast<std::size_t>(rows), .payload = payload};
+}
+
+[[nodiscard]] bool decode_block(const Input& input, const EncodedBlock& block, std::vector<Row>& rows) {
+    rows.resize(block.rows);
+    codec::ByteReader in(block.payload);
+    std::uint32_t previous_pid = 0;
+    std::uint64_t previous_handle = 0;
+    std::uint64_t previous_address = 0;
+    const auto string = [&](const std::uint64_t id) {
+        return id < input.stringCount ? input.string(id) : std::string_view{};
+    };
+    for (Row& row : rows) {
+        row.pid = previous_pid + static_cast<std::uint32_t>(in.zigzag());
+        row.handleValue = previous_handle + static_cast<std::uint64_t>(in.zigzag());
+        row.objectAddress = previous_address + static_cast<std::uint64_t>(in.zigzag());
+        previous_pid = row.pid;
+        previous_handle = row.handleValue;
+        previous_address = row.objectAddress;
+        row.grantedAccess = static_cast<std::uint32_t>(in.varint());
+        row.handleAttributes = static_cast<std::uint32_t>(in.varint());
+        row.objectTypeIndex = static_cast<std::uint16_t>(in.varint());
+        const std::uint64_t process = in.varint();
+        const std::uint64_t type = in.varint();
+        const std::uint64_t name = in.varint();
+        if (process >= input.stringCount || type >= input.stringCount || name >= input.stringCount) {
+            return false;
+        }
+        row.processName = string(process);
+        row.handleType = string(type);
+        row.objectName = string(name);
+    }
+    return !in.failed() && in.at_end();
+}
+
+} // namespace
+
+std::expected<std::uint64_t, std::string> write_snapshot(const std::filesystem::path& path,
+                                                         const SnapshotInfo& info,
+                                                         const std::span<const HandleInfo> rows,
+                                                         const StringInterner& strings) {
+    // Dense ids for the strings the rows use; id 0 is the empty string.
+    std::vector<std::uint32_t> remap(strings.size(), kUnmapped);
+    std::vector<StringId> used{StringInterner::kEmpty};
+    remap[StringInterner::kEmpty] = 0;
+    std::size_t string_bytes = 0;
+    const auto use = [&](const StringId id) {
+        if (remap[id] == kUnmapped) {
+            remap[id] = static_cast<std::uint32_t>(used.size());
+            used.push_back(id);
+            string_bytes += strings.view(id).size();
+        }
+        return remap[id];
+    };
+    for (const HandleInfo& row : rows) {
+        (void)use(row.processName);
+        (void)use(row.handleType);
+        (void)use(row.objectName);
+    }
+    if (string_bytes > std::numeric_limits<std::uint32_t>::max()) {
+        return std::unexpected("snapshot strings exceed 4 GiB");
+    }
+
+    codec::ByteWriter out;
+    out.bytes({reinterpret_cast<const std::uint8_t*>(kMagic.data()), kMagic.size()});
+    out.fixed32(kVersion);
+    out.varint(static_cast<std::uint64_t>(info.sortBy));
+    out.string(info.host);
+    out.fixed64(static_cast<std::uint64_t>(info.takenMs));
+    out.varint(info.totalRawCount);
+    out.varint(rows.size());
+    out.varint(used.size());
+    out.varint(string_bytes);
+    std::uint32_t offset = 0;
+    out.fixed32(0);
+    for (const StringId id : used) {
+        offset += static_cast<std::uint32_t>(strings.view(id).size());
+        out.fixed32(offset);
+    }
+    for (const StringId id : used) {
+        const std::string_view text = strings.view(id);
+        out.bytes({reinterpret_cast<const std::uint8_t*>(text.data()), text.size()});
+    }
+
+    codec::ByteWriter block;
+    for (std::size_t first = 0; first < rows.size(); first += kBlockRows) {
+        const std::span<const HandleInfo> chunk = rows.subspan(first, std::min(kBlockRows, rows.size() - first));
+        block.clear();
+        std::uint32_t previous_pid = 0;
+        std::uint64_t previous_handle = 0;
+        std::uint64_t previous_address = 0;
+        for (const HandleInfo& row : chunk) {
+            // Sorted by pid or grouped by key, neighbouring rows mostly share
+            // a pid and close handle values and addresses.
+            block.zigzag(static_cast<std::int64_t>(row.pid) - static_cast<std::int64_t>(previous_pid));
+            block.zigzag(static_cast<std::int64_t>(row.handleValue - previous_handle));
+            block.zigzag(static_cast<std::int64_t>(row.objectAddress - previous_address));
+            previous_pid = row.pid;
+            previous_handle = row.handleValue;
+            previous_address = row.objectAddress;
+            block.varint(row.grantedAccess);
+            block.varint(row.handleAttributes);
+            block.varint(row.objectTypeIndex);
+            block.varint(remap[row.processName]);
+            block.varint(remap[row.handleType]);
+            block.varint(remap[row.objectName]);
+        }
+        out.varint(chunk.size());
+        out.varint(block.size());
+        out.bytes(block.data());
+    }
+
+    // Written aside and renamed, so a collector never picks up half a file.
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(out.data().data()), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            return std::unexpected(std::format("cannot write {}", temp.string()));
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return std::unexpected(std::format("cannot write {}", path.string()));
+    }
+    return out.size();
+}
+
+std::string local_host_name() {
+#ifdef _WIN32
+    char name[MAX_COMPUTERNAME_LENGTH + 1]{};
+    DWORD size = sizeof(name);
+    if (::GetComputerNameA(name, &size) && size > 0) {
+        return std::string(name, size);
+    }
+#else
+    char name[256]{};
+    if (::gethostname(name, sizeof(name) - 1) == 0 && name[0] != '\0') {
+        return name;
+    }
+#endif
+    return "unknown";
+}
+
+namespace {
+
+// Rows of one file share their key's bytes, so a repeated key needs no scan.
+[[nodiscard]] int compare_key(const std::string_view left, const std::string_view right) noexcept {
+    if (left.data() == right.data() && left.size() == right.size()) {
+        return 0;
+    }
+    return compare_ignore_case(left, right);
+}
+
+} // namespace
+
+bool row_less(const Row& left, const Row& right, const SortField sort_by) noexcept {
+    int order = 0;
+    if (sort_by == SortField::Type) {
+        order = compare_key(left.handleType, right.handleType);
+    } else if (sort_by == SortField::Name) {
+        order = compare_key(left.objectName, right.objectName);
+    }
+    if (order != 0) {
+        return order < 0;
+    }
+    return std::tie(left.pid, left.handleValue) < std::tie(right.pid, right.handleValue);
+}
+
+bool same_key(const Row& left, const Row& right, const SortField sort_by) noexcept {
+    switch (sort_by) {
+    case SortField::Pid: return left.pid == right.pid;
+    case SortField::Type: return compare_key(left.handleType, right.handleType) == 0;
+    case SortField::Name: return compare_key(left.objectName, right.objectName) == 0;
+    }
+    return false;
+}
+
+std::expected<std::vector<std::filesystem::path>, std::string> expand_inputs(const std::span<const std::string> entries) {
+    std::vector<std::filesystem::path> paths;
+    for (const std::string& entry : entries) {
+        std::error_code error;
+        if (std::filesystem::is_directory(entry, error)) {
+            std::vector<std::filesystem::path> found;
+            for (const auto& item : std::filesystem::directory_iterator(entry, error)) {
+                if (item.is_regular_file(error) && item.path().extension() == kExtension) {
+                    found.push_back(item.path());
+                }
+            }
+            if (error) {
+                return std::unexpected(std::format("cannot list {} ({})", entry, error.message()));
+            }
+            std::ranges::sort(found);
+            paths.insert(paths.end(), found.begin(), found.end());
+        } else if (std::filesystem::is_regular_file(entry, error)) {
+            paths.emplace_back(entry);
+        } else {
+            return std::unexpected(std::format("cannot read {}", entry));
+        }
+    }
+    if (paths.empty()) {
+        return std::unexpected(std::format("no {} files to merge", kExtension));
+    }
+    return paths;
+}
+
+// Inputs, their decoded blocks and the decode workers. A block is decoded
+// into its input's `pending` while the merge consumes `current`.
+struct Merger::State {
+    struct Cursor {
+        std::vector<Row> current;
+        std::size_t position = 0;
+        // The next block; `ready` once a worker has decoded it.
+        std::vector<Row> pending;
+        bool scheduled = false;
+        bool ready = false;
+        bool failed = false;
+    };
+
+    struct Job {
+        std::size_t input = 0;
+        EncodedBlock block;
+    };
+
+    std::vector<Input> inputs;
+    std::vector<Cursor> cursors;
+    std::size_t threads = 1;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    std::deque<Job> jobs;
+    bool stopping = false;
+
+    void work() {
+        std::vector<Row> rows;
+        std::unique_lock lock(mutex);
+        while (true) {
+            work_cv.wait(lock, [&] { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            const Job job = jobs.front();
+            jobs.pop_front();
+            lock.unlock();
+            const bool decoded = decode_block(inputs[job.input], job.block, rows);
+            lock.lock();
+            Cursor& cursor = cursors[job.input];
+            cursor.pending.swap(rows);
+            cursor.ready = true;
+            cursor.failed = !decoded;
+            done_cv.notify_all();
+        }
+    }
+
+    // Hands the input's next block to the workers, if it has one.
+    [[nodiscard]] std::expected<void, std::string> schedule(const std::size_t input, MergeStats& stats) {
+        auto block = take_block(inputs[input]);
+        if (!block) {
+            return std::unexpected(block.error());
+        }
+        if (block->rows == 0) {
+            return {};
+        }
+        ++stats.blocks;
+        {
+            const std::lock_guard lock(mutex);
+            cursors[input].scheduled = true;
+            cursors[input].ready = false;
+            jobs.push_back(Job{.input = input, .block = *block});
+        }
+        work_cv.notify_one();
+        return {};
+    }
+
+    // Makes the decoded next block current and schedules the one after it.
+    // Leaves `current` empty once the input is exhausted.
+    [[nodiscard]] std::expected<void, std::string> advance(const std::size_t input, MergeStats& stats) {
+        Cursor& cursor = cursors[input];
+        cursor.position = 0;
+        if (!cursor.scheduled) {
+            cursor.current.clear();
+            return {};
+        }
+        {
+            std::unique_lock lock(mutex);
+            done_cv.wait(lock, [&] { return cursor.ready; });
+            cursor.current.swap(cursor.pending);
+            cursor.scheduled = false;
+            if (cursor.failed) {
+                return std::unexpected(std::format("{} has a corrupt block", inputs[input].path.string()));
+            }
+        }
+        return schedule(input, stats);
+    }
+};
+
+Merger::Merger(std::unique_ptr<State> state) noexcept : m_state(std::move(state)) {}
+Merger::~Merger() = default;
+Merger::Merger(Merger&&) noexcept = default;
+Merger& Merger::operator=(Merger&&) noexcept = default;
+
+std::expected<Merger, std::string> Merger::open(const std::span<const std::filesystem::path> paths, const MergeOptions options) {
+    auto state = std::make_unique<State>();
+    state->inputs.reserve(paths.size());
+    for (const std::filesystem::path& path : paths) {
+        auto input = open_input(path);
+        if (!input) {
+            return std::unexpected(input.error());
+        }
+        if (!state->inputs.empty() && input->info.sortBy != state->inputs.front().info.sortBy) {
+            return std::unexpected(std::format("{} is sorted by {} but {} by {}; merged files must share a sort key",
+                                               path.string(), sort_name(input->info.sortBy),
+                                               state->inputs.front().path.string(),
+                                               sort_name(state->inputs.front().info.sortBy)));
+        }
+        state->inputs.push_back(std::move(*input));
+    }
+    if (state->inputs.empty()) {
+        return std::unexpected("no snapshot files to merge");
+    }
+    state->cursors.resize(state->inputs.size());
+    const std::size_t hardware = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    state->threads = std::clamp<std::size_t>(options.threads == 0 ? hardware : options.threads, 1, state->inputs.size());
+    return Merger(std::move(state));
+}
+
+SortField Merger::sort_by() const noexcept {
+    return m_state->inputs.front().info.sortBy;
+}
+
+std::size_t Merger::input_count() const noexcept {
+    return m_state->inputs.size();
+}
+
+const SnapshotInfo& Merger::info(const std::size_t input) const noexcept {
+    return m_state->inputs[input].info;
+}
+
+std::expected<MergeStats, std::string> Merger::run(const Consumer& consume) {
+    State& state = *m_state;
+    MergeStats stats;
+    for (const Input& input : state.inputs) {
+        stats.bytes += input.file.bytes().size();
+    }
+
+    std::vector<std::thread> workers;
+    // Stops the workers on every return path; queued blocks are dropped.
+    struct Stop {
+        State& state;
+        std::vector<std::thread>& workers;
+        ~Stop() {
+            {
+                const std::lock_guard lock(state.mutex);
+                state.stopping = true;
+                state.jobs.clear();
+            }
+            state.work_cv.notify_all();
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+    } stop{state, workers};
+    for (std::size_t i = 0; i < state.threads; ++i) {
+        workers.emplace_back([&state] { state.work(); });
+    }
+
+    // First blocks of every file decode in parallel before the merge starts.
+    const std::size_t count = state.inputs.size();
+    for (std::size_t input = 0; input < count; ++input) {
+        if (auto scheduled = state.schedule(input, stats); !scheduled) {
+            return std::unexpected(scheduled.error());
+        }
+    }
+
+    // Min-heap of inputs by their current row; input order breaks ties.
+    const SortField sort_by = this->sort_by();
+    const auto after = [&](const std::size_t left, const std::size_t right) {
+        const Row& left_row = state.cursors[left].current[state.cursors[left].position];
+        const Row& right_row = state.cursors[right].current[state.cursors[right].position];
+        if (row_less(right_row, left_row, sort_by)) {
+            return true;
+        }
+        return !row_less(left_row, right_row, sort_by) && left > right;
+    };
+    std::vector<std::size_t> heap;
+    heap.reserve(count);
+    for (std::size_t input = 0; input < count; ++input) {
+        if (auto advanced = state.advance(input, stats); !advanced) {
+            return std::unexpected(advanced.error());
+        }
+        if (!state.cursors[input].current.empty()) {
+            heap.push_back(input);
+        }
+    }
+    std::ranges::make_heap(heap, after);
+
+    while (!heap.empty()) {
+        std::ranges::pop_heap(heap, after);
+        const std::size_t input = heap.back();
+        State::Cursor& cursor = state.cursors[input];
+        // Files usually hold runs that sort before every other file's head:
+        // one comparison per row keeps the run going without heap updates.
+        bool exhausted = false;
+        do {
+            consume(cursor.current[cursor.position], input);
+            ++stats.rows;
+            if (++cursor.position == cursor.current.size()) {
+                if (auto advanced = state.advance(input, stats); !advanced) {
+                    return std::unexpected(advanced.error());
+                }
+                exhausted = cursor.current.empty();
+            }
+        } while (!exhausted && (heap.size() == 1 || !after(input, heap.front())));
+        if (exhausted) {
+            heap.pop_back();
+        } else {
+            std::ranges::push_heap(heap, after);
+        }
+    }
+    return stats;
+}
+
+} // namespace fleet
@@ -0,0 +1,164 @@
+#include "generation_cache.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+
+[[nodiscard]] std::uint32_t clamp_pid(const std::uintptr_t pid) noexcept {
+    return pid > static_cast<std::uintptr_t>(std::numeric_limits<std::uint32_t>::max())
+        ? std::numeric_limits<std::uint32_t>::max()
+        : static_cast<std::uint32_t>(pid);
+}
+
+} // namespace
+
+ProcessCache::RefreshStats ProcessCache::refresh(const std::span<const nt::ProcessIdentity> processes) {
+    const bool unchanged = m_generation != 0 && processes.size() == m_processes.size() &&
+        std::ranges::all_of(processes, [this](const nt::ProcessIdentity& process) {
+            const auto it = m_processes.find(process.pid);
+            return it != m_processes.end() && it->second.createTime == process.createTime;
+        });
+    if (unchanged) {
+        return {};
+    }
+
+    std::unordered_map<std::uint32_t, Entry> next;
+    next.reserve(processes.size());
+    std::size_t carried = 0;
+    for (const nt::ProcessIdentity& process : processes) {
+        Entry entry;
+        entry.createTime = process.createTime;
+        if (const auto it = m_processes.find(process.pid);
+            it != m_processes.end() && it->second.createTime == process.createTime && it->second.name) {
+            entry.name = std::move(it->second.name);
+            it->second.name.reset();
+            ++carried;
+        }
+        next.insert_or_assign(process.pid, std::move(entry));
+    }
+
+    const RefreshStats stats{.changed = true, .evicted = m_named - carried};
+    m_processes = std::move(next);
+    m_named = carried;
+    ++m_generation;
+    return stats;
+}
+
+std::optional<std::uint64_t> ProcessCache::create_time(const std::uint32_t pid) const {
+    const auto it = m_processes.find(pid);
+    return it == m_processes.end() ? std::nullopt : std::optional(it->second.createTime);
+}
+
+const std::string* ProcessCache::name(const std::uint32_t pid) const {
+    const auto it = m_processes.find(pid);
+    return it == m_processes.end() || !it->second.name ? nullptr : &*it->second.name;
+}
+
+void ProcessCache::store(const std::uint32_t pid, const std::string_view name) {
+    const auto it = m_processes.find(pid);
+    if (it == m_processes.end()) {
+        return;
+    }
+    if (!it->second.name) {
+        ++m_named;
+    }
+    it->second.name = std::string(name);
+}
+
+void ProcessCache::clear() {
+    m_processes.clear();
+    m_named = 0;
+    m_generation = 0;
+}
+
+std::size_t ObjectCache::refresh(const std::span<const nt::RawHandle> handles, const ProcessCache& processes) {
+    ++m_refreshes;
+    if (m_objects.empty()) {
+        return 0;
+    }
+
+    for (const nt::RawHandle& handle : handles) {
+        const auto it = m_objects.find(ObjectKey{handle.objectAddress, handle.objectTypeIndex});
+        if (it == m_objects.end()) {
+            continue;
+        }
+        for (Anchor& anchor : it->second.anchors) {
+            if (anchor.same_handle(handle) &&
+                processes.create_time(clamp_pid(handle.processId)) == anchor.processCreateTime) {
+                anchor.seenInRefresh = m_refreshes;
+            }
+        }
+    }
+
+    std::size_t evicted = 0;
+    for (auto it = m_objects.begin(); it != m_objects.end();) {
+        std::erase_if(it->second.anchors, [this](const Anchor& anchor) { return anchor.seenInRefresh != m_refreshes; });
+        if (it->second.anchors.empty() || m_refreshes - it->second.storedInRefresh > kMaxCarriedRefreshes) {
+            it = m_objects.erase(it);
+            ++evicted;
+        } else {
+            ++it;
+        }
+    }
+    return evicted;
+}
+
+const std::string* ObjectCache::type_name(const std::uint16_t typeIndex) const {
+    const auto it = m_types.find(typeIndex);
+    return it == m_types.end() ? nullptr : &it->second;
+}
+
+void ObjectCache::store_type(const std::uint16_t typeIndex, const std::string_view name) {
+    m_types.insert_or_assign(typeIndex, std::string(name));
+}
+
+const std::string* ObjectCache::object_name(const nt::RawHandle& handle,
+                                            const std::optional<std::uint64_t> processCreateTime) {
+    if (handle.objectAddress == 0) {
+        return nullptr;
+    }
+    const auto it = m_objects.find(ObjectKey{handle.objectAddress, handle.objectTypeIndex});
+    if (it == m_objects.end()) {
+        return nullptr;
+    }
+
+    std::vector<Anchor>& anchors = it->second.anchors;
+    const bool anchored = std::ranges::any_of(anchors, [&](const Anchor& anchor) { return anchor.same_handle(handle); });
+    if (processCreateTime && !anchored && anchors.size() < kMaxAnchors) {
+        anchors.push_back(Anchor{
+            .pid = handle.processId,
+            .handleValue = handle.handleValue,
+            .grantedAccess = handle.grantedAccess,
+            .handleAttributes = handle.handleAttributes,
+            .processCreateTime = *processCreateTime,
+            .seenInRefresh = m_refreshes
+        });
+    }
+    return &it->second.name;
+}
+
+void ObjectCache::store_object(const nt::RawHandle& handle, const std::uint64_t processCreateTime, const std::string_view name) {
+    if (handle.objectAddress == 0) {
+        return;
+    }
+    m_objects.insert_or_assign(ObjectKey{handle.objectAddress, handle.objectTypeIndex},
+                               ObjectEntry{
+                                   .name = std::string(name),
+                                   .anchors = {Anchor{
+                                       .pid = handle.processId,
+                                       .handleValue = handle.handleValue,
+                                       .grantedAccess = handle.grantedAccess,
+                                       .handleAttributes = handle.handleAttributes,
+                                       .processCreateTime = processCreateTime,
+                                       .seenInRefresh = m_refreshes
+                                   }},
+                                   .storedInRefresh = m_refreshes
+                               });
+}
+
+void ObjectCache::clear() {
+    m_types.clear();
+    m_objects.clear();
+}
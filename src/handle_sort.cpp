@@ -0,0 +1,103 @@
+#include "handle_sort.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+namespace sorting {
+
+bool handle_less(const HandleInfo& left,
+                 const HandleInfo& right,
+                 const SortField sort_by,
+                 const StringInterner& strings) noexcept {
+    switch (sort_by) {
+    case SortField::Type: {
+        const auto left_rank = strings.sort_rank(left.handleType);
+        const auto right_rank = strings.sort_rank(right.handleType);
+        if (left_rank != right_rank) {
+            return left_rank < right_rank;
+        }
+        break;
+    }
+    case SortField::Name: {
+        const auto left_rank = strings.sort_rank(left.objectName);
+        const auto right_rank = strings.sort_rank(right.objectName);
+        if (left_rank != right_rank) {
+            return left_rank < right_rank;
+        }
+        break;
+    }
+    case SortField::Pid:
+        break;
+    }
+
+    return std::tie(left.pid, left.handleValue) < std::tie(right.pid, right.handleValue);
+}
+
+bool handle_less_unranked(const HandleInfo& left,
+                          const HandleInfo& right,
+                          const SortField sort_by,
+                          const StringInterner& strings) noexcept {
+    int order = 0;
+    if (sort_by == SortField::Type && left.handleType != right.handleType) {
+        order = compare_ignore_case(strings.view(left.handleType), strings.view(right.handleType));
+    } else if (sort_by == SortField::Name && left.objectName != right.objectName) {
+        order = compare_ignore_case(strings.view(left.objectName), strings.view(right.objectName));
+    }
+    if (order != 0) {
+        return order < 0;
+    }
+
+    return std::tie(left.pid, left.handleValue) < std::tie(right.pid, right.handleValue);
+}
+
+void sort_handles(std::vector<HandleInfo>& handles, const SortField sort_by, StringInterner& strings) {
+    if (sort_by != SortField::Pid) {
+        strings.build_sort_ranks();
+    }
+
+    std::ranges::sort(handles, [&](const HandleInfo& left, const HandleInfo& right) {
+        return handle_less(left, right, sort_by, strings);
+    });
+}
+
+TopRows::TopRows(const std::size_t limit,
+                 const std::size_t row_count,
+                 const SortField sort_by,
+                 const StringInterner& strings)
+    : m_limit(limit), m_sort_by(sort_by), m_strings(strings) {
+    m_heap.reserve(std::min(limit, row_count));
+}
+
+bool TopRows::less(const Entry& left, const Entry& right) const noexcept {
+    return handle_less_unranked(left.row, right.row, m_sort_by, m_strings);
+}
+
+void TopRows::offer(const HandleInfo& row, const std::size_t source) {
+    if (m_limit == 0) {
+        return;
+    }
+
+    const auto heap_less = [this](const Entry& left, const Entry& right) { return less(left, right); };
+    if (m_heap.size() < m_limit) {
+        m_heap.push_back(Entry{.row = row, .source = source});
+        std::ranges::push_heap(m_heap, heap_less);
+        return;
+    }
+
+    // The root is the largest kept row; anything not smaller is discarded.
+    const Entry candidate{.row = row, .source = source};
+    if (!less(candidate, m_heap.front())) {
+        return;
+    }
+    std::ranges::pop_heap(m_heap, heap_less);
+    m_heap.back() = candidate;
+    std::ranges::push_heap(m_heap, heap_less);
+}
+
+std::vector<TopRows::Entry> TopRows::take_sorted() {
+    std::ranges::sort_heap(m_heap, [this](const Entry& left, const Entry& right) { return less(left, right); });
+    return std::exchange(m_heap, {});
+}
+
+} // namespace sorting
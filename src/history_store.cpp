@@ -0,0 +1,591 @@
+#include "history_store.hpp"
+
+#include "binary_codec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <map>
+#include <span>
+#include <system_error>
+
+namespace history {
+
+namespace {
+
+// File layout:
+//   header:  "HNDLHIST" fixed32(version)
+//   blocks:  u8 kind, then
+//     Dictionary: varint(size) payload{varint(firstId) varint(count) string...}
+//     Keyframe:   varint(ts) varint(handles) varint(opened) varint(closed) varint(size) payload{rows}
+//     Delta:      same header, payload{closed keys, opened rows}
+// A section is varint(rowCount) followed by length-prefixed columns, so a
+// reader can decode the address column alone and skip the others.
+constexpr std::string_view kMagic = "HNDLHIST";
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint8_t kDictionaryBlock = 1;
+
+enum ColumnIndex : std::size_t { Pid, Handle, Address, Access, TypeIndex, Process, Type, Name };
+constexpr std::size_t kKeyColumns = 3;
+constexpr std::size_t kRowColumns = 8;
+
+struct Section {
+    std::size_t rows = 0;
+    std::array<std::span<const std::uint8_t>, kRowColumns> columns{};
+};
+
+[[nodiscard]] bool key_less(const Record& left, const Record& right) noexcept {
+    return left.key() < right.key();
+}
+
+void encode_section(const std::span<const Record> rows, const std::size_t column_count, codec::ByteWriter& out) {
+    std::array<codec::ByteWriter, kRowColumns> columns;
+    std::uint32_t previous_pid = 0;
+    std::uint64_t previous_handle = 0;
+    std::uint64_t previous_address = 0;
+
+    for (const Record& row : rows) {
+        // Rows are sorted by key: pids never decrease and handles only
+        // increase within one pid, so both encode as small deltas.
+        columns[Pid].varint(row.pid - previous_pid);
+        columns[Handle].varint(row.pid == previous_pid ? row.handleValue - previous_handle : row.handleValue);
+        columns[Address].zigzag(static_cast<std::int64_t>(row.objectAddress - previous_address));
+        previous_pid = row.pid;
+        previous_handle = row.handleValue;
+        previous_address = row.objectAddress;
+
+        if (column_count == kRowColumns) {
+            columns[Access].varint(row.grantedAccess);
+            columns[TypeIndex].varint(row.objectTypeIndex);
+            columns[Process].varint(row.processName);
+            columns[Type].varint(row.handleType);
+            columns[Name].varint(row.objectName);
+        }
+    }
+
+    out.varint(rows.size());
+    for (std::size_t column = 0; column < column_count; ++column) {
+        out.varint(columns[column].size());
+        out.bytes(columns[column].data());
+    }
+}
+
+[[nodiscard]] bool read_section(codec::ByteReader& in, const std::size_t column_count, Section& section) {
+    section.rows = static_cast<std::size_t>(in.varint());
+    for (std::size_t column = 0; column < column_count; ++column) {
+        section.columns[column] = in.bytes(static_cast<std::size_t>(in.varint()));
+        // Every value takes at least one byte; reject counts the data cannot hold.
+        if (section.columns[column].size() < section.rows) {
+            return false;
+        }
+    }
+    return !in.failed();
+}
+
+[[nodiscard]] bool decode_addresses(const Section& section, std::vector<std::uint64_t>& addresses) {
+    addresses.resize(section.rows);
+    codec::ByteReader in(section.columns[Address]);
+    std::uint64_t previous = 0;
+    for (std::uint64_t& address : addresses) {
+        previous += static_cast<std::uint64_t>(in.zigzag());
+        address = previous;
+    }
+    return !in.failed();
+}
+
+[[nodiscard]] bool decode_records(const Section& section, const std::size_t column_count, std::vector<Record>& records) {
+    records.assign(section.rows, Record{});
+    std::array<codec::ByteReader, kRowColumns> in{
+        codec::ByteReader(section.columns[Pid]), codec::ByteReader(section.columns[Handle]),
+        codec::ByteReader(section.columns[Address]), codec::ByteReader(section.columns[Access]),
+        codec::ByteReader(section.columns[TypeIndex]), codec::ByteReader(section.columns[Process]),
+        codec::ByteReader(section.columns[Type]), codec::ByteReader(section.columns[Name])
+    };
+
+    std::uint32_t previous_pid = 0;
+    std::uint64_t previous_handle = 0;
+    std::uint64_t previous_address = 0;
+    for (Record& record : records) {
+        record.pid = previous_pid + static_cast<std::uint32_t>(in[Pid].varint());
+        const std::uint64_t handle = in[Handle].varint();
+        record.handleValue = record.pid == previous_pid ? previous_handle + handle : handle;
+        record.objectAddress = previous_address + static_cast<std::uint64_t>(in[Address].zigzag());
+        previous_pid = record.pid;
+        previous_handle = record.handleValue;
+        previous_address = record.objectAddress;
+
+        if (column_count == kRowColumns) {
+            record.grantedAccess = static_cast<std::uint32_t>(in[Access].varint());
+            record.objectTypeIndex = static_cast<std::uint16_t>(in[TypeIndex].varint());
+            record.processName = static_cast<DictionaryId>(in[Process].varint());
+            record.handleType = static_cast<DictionaryId>(in[Type].varint());
+            record.objectName = static_cast<DictionaryId>(in[Name].varint());
+        }
+    }
+
+    return std::ranges::none_of(std::span(in).first(column_count), [](const codec::ByteReader& reader) {
+        return reader.failed();
+    });
+}
+
+// Decodes only the rows of `section` whose address is `address`; the address
+// column is scanned first so frames without the object cost one column.
+[[nodiscard]] bool decode_matching(const Section& section,
+                                   const std::size_t column_count,
+                                   const std::uint64_t address,
+                                   std::vector<std::uint64_t>& scratch,
+                                   std::vector<Record>& matches) {
+    matches.clear();
+    if (!decode_addresses(section, scratch)) {
+        return false;
+    }
+    if (std::ranges::find(scratch, address) == scratch.end()) {
+        return true;
+    }
+
+    std::vector<Record> records;
+    if (!decode_records(section, column_count, records)) {
+        return false;
+    }
+    std::ranges::copy_if(records, std::back_inserter(matches), [address](const Record& record) {
+        return record.objectAddress == address;
+    });
+    return true;
+}
+
+// state - closed (by key) + opened; all three sorted by key.
+[[nodiscard]] std::vector<Record> apply_delta(const std::vector<Record>& state,
+                                              const std::vector<Record>& closed,
+                                              const std::vector<Record>& opened) {
+    std::vector<Record> kept;
+    kept.reserve(state.size());
+    auto closed_it = closed.begin();
+    for (const Record& record : state) {
+        while (closed_it != closed.end() && key_less(*closed_it, record)) {
+            ++closed_it;
+        }
+        if (closed_it == closed.end() || record.key() != closed_it->key()) {
+            kept.push_back(record);
+        }
+    }
+
+    std::vector<Record> next;
+    next.reserve(kept.size() + opened.size());
+    std::ranges::merge(kept, opened, std::back_inserter(next), key_less);
+    return next;
+}
+
+[[nodiscard]] bool read_varint(std::istream& in, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int byte = in.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+[[nodiscard]] std::string corrupt(const FrameInfo& frame) {
+    return std::format("corrupt history frame at offset {}", frame.payloadOffset);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// HistoryReader
+// ---------------------------------------------------------------------------
+
+std::expected<HistoryReader, std::string> HistoryReader::open(const std::filesystem::path& path) {
+    HistoryReader reader;
+    reader.m_file.open(path, std::ios::binary);
+    if (!reader.m_file) {
+        return std::unexpected(std::format("cannot open history file {}", path.string()));
+    }
+
+    std::error_code size_error;
+    const std::uint64_t file_size = std::filesystem::file_size(path, size_error);
+    if (size_error) {
+        return std::unexpected(std::format("cannot read history file {} ({})", path.string(), size_error.message()));
+    }
+
+    std::array<char, kMagic.size() + 4> header{};
+    if (!reader.m_file.read(header.data(), header.size()) ||
+        std::string_view(header.data(), kMagic.size()) != kMagic) {
+        return std::unexpected(std::format("{} is not a handle history file", path.string()));
+    }
+    codec::ByteReader version(std::span(reinterpret_cast<const std::uint8_t*>(header.data()) + kMagic.size(), 4));
+    if (version.fixed32() != kVersion) {
+        return std::unexpected(std::format("{} has an unsupported history version", path.string()));
+    }
+
+    reader.m_strings.emplace_back();
+    reader.m_valid_size = header.size();
+    std::size_t committed_strings = reader.m_strings.size();
+
+    // Blocks are scanned until the first incomplete one. An append is complete
+    // once its frame is; a torn append (including a dictionary block written
+    // ahead of its frame) is ignored and truncated by the next writer.
+    while (true) {
+        const int kind = reader.m_file.get();
+        if (kind == std::char_traits<char>::eof()) {
+            break;
+        }
+
+        if (kind == kDictionaryBlock) {
+            std::uint64_t size = 0;
+            if (!read_varint(reader.m_file, size) || size > file_size) {
+                break;
+            }
+            std::vector<std::uint8_t> payload(static_cast<std::size_t>(size));
+            if (!reader.m_file.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(size))) {
+                break;
+            }
+
+            codec::ByteReader in(payload);
+            const std::uint64_t first_id = in.varint();
+            const std::uint64_t count = in.varint();
+            if (first_id != reader.m_strings.size() || count > payload.size()) {
+                return std::unexpected(std::format("{}: dictionary block out of sequence", path.string()));
+            }
+            for (std::uint64_t i = 0; i < count && !in.failed(); ++i) {
+                reader.m_strings.emplace_back(in.string());
+            }
+            if (in.failed()) {
+                return std::unexpected(std::format("{}: corrupt dictionary block", path.string()));
+            }
+        } else if (kind == static_cast<int>(FrameKind::Keyframe) || kind == static_cast<int>(FrameKind::Delta)) {
+            std::uint64_t timestamp = 0;
+            std::uint64_t handles = 0;
+            std::uint64_t opened = 0;
+            std::uint64_t closed = 0;
+            std::uint64_t size = 0;
+            if (!read_varint(reader.m_file, timestamp) || !read_varint(reader.m_file, handles) ||
+                !read_varint(reader.m_file, opened) || !read_varint(reader.m_file, closed) ||
+                !read_varint(reader.m_file, size)) {
+                break;
+            }
+
+            const auto offset = static_cast<std::uint64_t>(reader.m_file.tellg());
+            if (size > file_size || offset + size > file_size) {
+                break;
+            }
+            reader.m_file.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+
+            reader.m_frames.push_back(FrameInfo{
+                .timestampMs = static_cast<std::int64_t>(timestamp),
+                .kind = static_cast<FrameKind>(kind),
+                .handleCount = static_cast<std::size_t>(handles),
+                .opened = static_cast<std::size_t>(opened),
+                .closed = static_cast<std::size_t>(closed),
+                .payloadOffset = offset,
+                .payloadSize = size
+            });
+            reader.m_valid_size = static_cast<std::uint64_t>(reader.m_file.tellg());
+            committed_strings = reader.m_strings.size();
+        } else {
+            return std::unexpected(std::format("{}: unknown block kind {}", path.string(), kind));
+        }
+    }
+
+    reader.m_strings.resize(committed_strings);
+    reader.m_file.clear();
+    return reader;
+}
+
+std::string_view HistoryReader::text(const DictionaryId id) const noexcept {
+    return id < m_strings.size() ? std::string_view(m_strings[id]) : std::string_view();
+}
+
+std::expected<std::vector<std::uint8_t>, std::string> HistoryReader::load(const FrameInfo& frame) {
+    std::vector<std::uint8_t> payload(static_cast<std::size_t>(frame.payloadSize));
+    m_file.seekg(static_cast<std::streamoff>(frame.payloadOffset));
+    if (!m_file.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()))) {
+        m_file.clear();
+        return std::unexpected(std::format("cannot read history frame at offset {}", frame.payloadOffset));
+    }
+    return payload;
+}
+
+std::size_t HistoryReader::frame_at(const std::int64_t timestampMs) const noexcept {
+    const auto after = std::ranges::upper_bound(m_frames, timestampMs, {}, &FrameInfo::timestampMs);
+    return after == m_frames.begin() ? m_frames.size() : static_cast<std::size_t>(after - m_frames.begin()) - 1;
+}
+
+std::size_t HistoryReader::keyframe_before(std::size_t frame) const noexcept {
+    while (frame > 0 && m_frames[frame].kind != FrameKind::Keyframe) {
+        --frame;
+    }
+    return frame;
+}
+
+std::expected<std::vector<Record>, std::string> HistoryReader::snapshot_at(const std::int64_t timestampMs) {
+    const std::size_t end = frame_at(timestampMs);
+    if (end == m_frames.size()) {
+        return std::vector<Record>{};
+    }
+
+    std::vector<Record> state;
+    std::vector<Record> closed;
+    std::vector<Record> opened;
+    for (std::size_t index = keyframe_before(end); index <= end; ++index) {
+        const FrameInfo& frame = m_frames[index];
+        auto payload = load(frame);
+        if (!payload) {
+            return std::unexpected(payload.error());
+        }
+
+        codec::ByteReader in(*payload);
+        Section section;
+        if (frame.kind == FrameKind::Keyframe) {
+            if (!read_section(in, kRowColumns, section) || !decode_records(section, kRowColumns, state)) {
+                return std::unexpected(corrupt(frame));
+            }
+            continue;
+        }
+
+        if (!read_section(in, kKeyColumns, section) || !decode_records(section, kKeyColumns, closed) ||
+            !read_section(in, kRowColumns, section) || !decode_records(section, kRowColumns, opened)) {
+            return std::unexpected(corrupt(frame));
+        }
+        state = apply_delta(state, closed, opened);
+    }
+    return state;
+}
+
+std::expected<std::vector<Holding>, std::string> HistoryReader::holders_of(const std::uint64_t objectAddress,
+                                                                          const std::int64_t fromMs,
+                                                                          const std::int64_t toMs) {
+    const std::size_t end = frame_at(toMs);
+    if (end == m_frames.size() || fromMs > toMs) {
+        return std::vector<Holding>{};
+    }
+
+    // The frame in effect at fromMs (or the first frame, if the range starts
+    // before the history) opens the range.
+    const std::size_t effective = frame_at(fromMs);
+    const std::size_t first_in_range = effective == m_frames.size() ? 0 : effective;
+
+    // Per record key: its open holding and the last frame that contained it.
+    // A holding is extended only through consecutive frames, so a handle value
+    // closed and reused for the same object starts a new interval.
+    struct OpenHolding {
+        std::size_t holding = 0;
+        std::size_t frame = 0;
+    };
+    std::vector<Holding> holdings;
+    std::map<std::tuple<std::uint32_t, std::uint64_t, std::uint64_t>, OpenHolding> latest;
+    std::vector<Record> state;
+    std::vector<Record> closed;
+    std::vector<Record> opened;
+    std::vector<std::uint64_t> scratch;
+
+    for (std::size_t index = keyframe_before(first_in_range); index <= end; ++index) {
+        const FrameInfo& frame = m_frames[index];
+        auto payload = load(frame);
+        if (!payload) {
+            return std::unexpected(payload.error());
+        }
+
+        codec::ByteReader in(*payload);
+        Section section;
+        if (frame.kind == FrameKind::Keyframe) {
+            if (!read_section(in, kRowColumns, section) ||
+                !decode_matching(section, kRowColumns, objectAddress, scratch, state)) {
+                return std::unexpected(corrupt(frame));
+            }
+        } else {
+            if (!read_section(in, kKeyColumns, section) ||
+                !decode_matching(section, kKeyColumns, objectAddress, scratch, closed) ||
+                !read_section(in, kRowColumns, section) ||
+                !decode_matching(section, kRowColumns, objectAddress, scratch, opened)) {
+                return std::unexpected(corrupt(frame));
+            }
+            if (!closed.empty() || !opened.empty()) {
+                state = apply_delta(state, closed, opened);
+            }
+        }
+
+        if (index < first_in_range) {
+            continue;
+        }
+        for (const Record& record : state) {
+            const auto [it, inserted] = latest.try_emplace(record.key(), OpenHolding{.holding = holdings.size(), .frame = index});
+            const bool continues = !inserted && it->second.frame + 1 == index;
+            const std::size_t previous = it->second.holding;
+            it->second.frame = index;
+            if (continues && holdings[previous].record == record) {
+                holdings[previous].lastSeenMs = frame.timestampMs;
+                continue;
+            }
+            it->second.holding = holdings.size();
+            holdings.push_back(Holding{.record = record, .firstSeenMs = frame.timestampMs, .lastSeenMs = frame.timestampMs});
+        }
+    }
+    return holdings;
+}
+
+// ---------------------------------------------------------------------------
+// HistoryWriter
+// ---------------------------------------------------------------------------
+
+std::expected<HistoryWriter, std::string> HistoryWriter::open(const std::filesystem::path& path,
+                                                              const WriterOptions options) {
+    HistoryWriter writer;
+    writer.m_options = options;
+    writer.m_options.keyframeInterval = std::max<std::size_t>(writer.m_options.keyframeInterval, 1);
+    writer.m_ids.emplace(std::string(), 0);
+
+    std::error_code ignored;
+    const bool existing = std::filesystem::exists(path, ignored) && std::filesystem::file_size(path, ignored) > 0;
+    if (existing) {
+        auto reader = HistoryReader::open(path);
+        if (!reader) {
+            return std::unexpected(reader.error());
+        }
+
+        const auto& strings = reader->dictionary();
+        for (DictionaryId id = 1; id < strings.size(); ++id) {
+            writer.m_ids.emplace(strings[id], id);
+        }
+        writer.m_first_pending = static_cast<DictionaryId>(strings.size());
+
+        const auto& frames = reader->frames();
+        if (!frames.empty()) {
+            auto previous = reader->snapshot_at(frames.back().timestampMs);
+            if (!previous) {
+                return std::unexpected(previous.error());
+            }
+            writer.m_previous = std::move(*previous);
+            writer.m_has_frames = true;
+            writer.m_last_timestamp = frames.back().timestampMs;
+            std::size_t last_keyframe = frames.size() - 1;
+            while (last_keyframe > 0 && frames[last_keyframe].kind != FrameKind::Keyframe) {
+                --last_keyframe;
+            }
+            writer.m_frames_since_keyframe = frames.size() - last_keyframe;
+        }
+
+        const std::uint64_t valid_size = reader->valid_size();
+        reader = std::unexpected(std::string());
+        std::error_code resize_error;
+        if (std::filesystem::file_size(path, ignored) != valid_size) {
+            std::filesystem::resize_file(path, valid_size, resize_error);
+            if (resize_error) {
+                return std::unexpected(std::format("cannot repair history file {} ({})", path.string(), resize_error.message()));
+            }
+        }
+    }
+
+    writer.m_file.open(path, std::ios::binary | std::ios::app);
+    if (!writer.m_file) {
+        return std::unexpected(std::format("cannot open history file {} for writing", path.string()));
+    }
+
+    if (!existing) {
+        codec::ByteWriter header;
+        header.bytes(std::span(reinterpret_cast<const std::uint8_t*>(kMagic.data()), kMagic.size()));
+        header.fixed32(kVersion);
+        writer.m_file.write(reinterpret_cast<const char*>(header.data().data()), static_cast<std::streamsize>(header.size()));
+        if (!writer.m_file.flush()) {
+            return std::unexpected(std::format("cannot write history file {}", path.string()));
+        }
+    }
+    return writer;
+}
+
+DictionaryId HistoryWriter::intern(const std::string_view text) {
+    if (const auto it = m_ids.find(text); it != m_ids.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<DictionaryId>(m_ids.size());
+    m_ids.emplace(std::string(text), id);
+    m_pending.emplace_back(text);
+    return id;
+}
+
+std::expected<AppendStats, std::string> HistoryWriter::append(const std::int64_t timestampMs, std::vector<Record> records) {
+    if (timestampMs < 0 || (m_has_frames && timestampMs <= m_last_timestamp)) {
+        return std::unexpected(std::format("history timestamps must increase (last {}, got {})", m_last_timestamp, timestampMs));
+    }
+
+    std::ranges::sort(records, key_less);
+    const auto duplicates = std::ranges::unique(records, {}, &Record::key);
+    records.erase(duplicates.begin(), duplicates.end());
+
+    codec::ByteWriter block;
+    if (!m_pending.empty()) {
+        codec::ByteWriter payload;
+        payload.varint(m_first_pending);
+        payload.varint(m_pending.size());
+        for (const std::string& text : m_pending) {
+            payload.string(text);
+        }
+        block.bytes(std::array{kDictionaryBlock});
+        block.varint(payload.size());
+        block.bytes(payload.data());
+    }
+
+    AppendStats stats;
+    codec::ByteWriter payload;
+    const bool keyframe = !m_has_frames || m_frames_since_keyframe >= m_options.keyframeInterval;
+    if (keyframe) {
+        stats.kind = FrameKind::Keyframe;
+        stats.opened = records.size();
+        encode_section(records, kRowColumns, payload);
+    } else {
+        std::vector<Record> closed;
+        std::vector<Record> opened;
+        auto previous = m_previous.begin();
+        auto current = records.begin();
+        while (previous != m_previous.end() || current != records.end()) {
+            if (current == records.end() || (previous != m_previous.end() && key_less(*previous, *current))) {
+                closed.push_back(*previous++);
+            } else if (previous == m_previous.end() || key_less(*current, *previous)) {
+                opened.push_back(*current++);
+            } else {
+                // Same handle; changed attributes are stored as close + open.
+                if (*previous != *current) {
+                    closed.push_back(*previous);
+                    opened.push_back(*current);
+                }
+                ++previous;
+                ++current;
+            }
+        }
+
+        stats.kind = FrameKind::Delta;
+        stats.opened = opened.size();
+        stats.closed = closed.size();
+        encode_section(closed, kKeyColumns, payload);
+        encode_section(opened, kRowColumns, payload);
+    }
+
+    block.bytes(std::array{static_cast<std::uint8_t>(stats.kind)});
+    block.varint(static_cast<std::uint64_t>(timestampMs));
+    block.varint(records.size());
+    block.varint(stats.opened);
+    block.varint(stats.closed);
+    block.varint(payload.size());
+    block.bytes(payload.data());
+
+    m_file.write(reinterpret_cast<const char*>(block.data().data()), static_cast<std::streamsize>(block.size()));
+    if (!m_file.flush()) {
+        return std::unexpected(std::string("cannot append to history file"));
+    }
+
+    stats.bytes = block.size();
+    m_first_pending = static_cast<DictionaryId>(m_ids.size());
+    m_pending.clear();
+    m_previous = std::move(records);
+    m_frames_since_keyframe = keyframe ? 1 : m_frames_since_keyframe + 1;
+    m_last_timestamp = timestampMs;
+    m_has_frames = true;
+    return stats;
+}
+
+} // namespace history
@@ -0,0 +1,281 @@
+#include "latency.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace latency {
+
+namespace {
+
+constexpr std::uint64_t kSubBuckets = std::uint64_t{1} << Histogram::kSubBucketBits;
+
+[[nodiscard]] std::uint64_t keyed_id(const Call call, const unsigned dimension, const std::uint32_t key) {
+    return (static_cast<std::uint64_t>(call) << 40) | (static_cast<std::uint64_t>(dimension) << 32) | key;
+}
+
+} // namespace
+
+std::string_view call_name(const Call call) noexcept {
+    switch (call) {
+    case Call::Duplicate: return "duplicate";
+    case Call::TypeQuery: return "type query";
+    case Call::NameQuery: return "name query";
+    case Call::ProcessName: return "process name";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// Histogram
+// ---------------------------------------------------------------------------
+
+std::size_t Histogram::bucket_of(std::uint64_t value) noexcept {
+    value = std::min(value, kMaxValue);
+    if (value < kSubBuckets) {
+        return static_cast<std::size_t>(value);
+    }
+    const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+    const unsigned shift = exponent - kSubBucketBits;
+    return static_cast<std::size_t>(((shift + 1) << kSubBucketBits) + ((value >> shift) - kSubBuckets));
+}
+
+std::uint64_t Histogram::bucket_upper_bound(const std::size_t bucket) noexcept {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    const unsigned shift = static_cast<unsigned>(bucket >> kSubBucketBits) - 1;
+    const std::uint64_t mantissa = kSubBuckets + (bucket & (kSubBuckets - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void Histogram::record(const std::uint64_t nanoseconds) noexcept {
+    m_counts[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t seen = m_max.load(std::memory_order_relaxed);
+    while (nanoseconds > seen && !m_max.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::reset() noexcept {
+    for (std::atomic<std::uint32_t>& count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::count() const noexcept {
+    std::uint64_t total = 0;
+    for (const std::atomic<std::uint32_t>& count : m_counts) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::uint64_t Histogram::percentile(const double percent) const noexcept {
+    const std::uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * static_cast<double>(total))));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+        seen += m_counts[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Never report more than was actually recorded.
+            return std::min(bucket_upper_bound(bucket), max());
+        }
+    }
+    return max();
+}
+
+// ---------------------------------------------------------------------------
+// Recorder
+// ---------------------------------------------------------------------------
+
+void Recorder::enable(const std::chrono::nanoseconds slow_threshold) {
+    for (Histogram& histogram : m_overall) {
+        histogram.reset();
+    }
+    {
+        const std::unique_lock lock(m_keyed_mutex);
+        m_keyed.clear();
+    }
+    {
+        const std::lock_guard lock(m_slow_mutex);
+        m_slow.clear();
+        m_slow_dropped = 0;
+    }
+    m_slow_threshold.store(static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(slow_threshold.count(), 0)),
+                           std::memory_order_relaxed);
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Recorder::record_keyed(const Call call, const Dimension dimension, const std::uint32_t key, const std::uint64_t nanoseconds) {
+    const std::uint64_t id = keyed_id(call, static_cast<unsigned>(dimension), key);
+    {
+        // Recording happens under the shared lock so enable() cannot free
+        // the histogram in between.
+        const std::shared_lock lock(m_keyed_mutex);
+        if (const auto it = m_keyed.find(id); it != m_keyed.end()) {
+            it->second->record(nanoseconds);
+            return;
+        }
+    }
+    const std::unique_lock lock(m_keyed_mutex);
+    auto it = m_keyed.find(id);
+    if (it == m_keyed.end()) {
+        if (m_keyed.size() >= kMaxKeyed) {
+            return;
+        }
+        it = m_keyed.emplace(id, std::make_unique<Histogram>()).first;
+    }
+    it->second->record(nanoseconds);
+}
+
+void Recorder::record(const Call call, const std::uint32_t pid, const std::uint32_t type_index, const std::uint32_t granted_access,
+                      const std::uintptr_t handle_value, const std::uint64_t nanoseconds) {
+    if (!enabled()) {
+        return;
+    }
+    m_overall[static_cast<std::size_t>(call)].record(nanoseconds);
+    if (type_index != kNoType) {
+        record_keyed(call, Dimension::Type, type_index, nanoseconds);
+    }
+    record_keyed(call, Dimension::Process, pid, nanoseconds);
+
+    const std::uint64_t threshold = m_slow_threshold.load(std::memory_order_relaxed);
+    if (threshold != 0 && nanoseconds >= threshold) {
+        add_slow(SlowCall{.call = call, .pid = pid, .typeIndex = type_index, .grantedAccess = granted_access,
+                          .handleValue = handle_value, .nanoseconds = nanoseconds});
+    }
+}
+
+void Recorder::record_timeout(const Call call, const std::uint32_t pid, const std::uint32_t type_index,
+                              const std::uint32_t granted_access, const std::uintptr_t handle_value,
+                              const std::chrono::nanoseconds deadline) {
+    if (!enabled() || m_slow_threshold.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    add_slow(SlowCall{.call = call, .pid = pid, .typeIndex = type_index, .grantedAccess = granted_access,
+                      .handleValue = handle_value, .nanoseconds = static_cast<std::uint64_t>(deadline.count()), .timedOut = true});
+}
+
+void Recorder::add_slow(const SlowCall& slow) {
+    const std::lock_guard lock(m_slow_mutex);
+    if (m_slow.size() >= kMaxSlowCalls) {
+        ++m_slow_dropped;
+        return;
+    }
+    m_slow.push_back(slow);
+}
+
+std::vector<CallSummary> Recorder::summarize(const std::size_t limit) const {
+    std::vector<CallSummary> summaries;
+    for (std::size_t index = 0; index < kCallCount; ++index) {
+        const Histogram& overall = m_overall[index];
+        const std::uint64_t count = overall.count();
+        if (count == 0) {
+            continue;
+        }
+        summaries.push_back(CallSummary{
+            .call = static_cast<Call>(index),
+            .count = count,
+            .p50 = overall.percentile(50),
+            .p90 = overall.percentile(90),
+            .p99 = overall.percentile(99),
+            .max = overall.max(),
+            .byType = {},
+            .byProcess = {}});
+    }
+
+    {
+        const std::shared_lock lock(m_keyed_mutex);
+        for (const auto& [id, histogram] : m_keyed) {
+            const auto call = static_cast<Call>(id >> 40);
+            const auto dimension = static_cast<Dimension>((id >> 32) & 0xFF);
+            const auto summary = std::ranges::find(summaries, call, &CallSummary::call);
+            if (summary == summaries.end()) {
+                continue;
+            }
+            const KeyedSummary keyed{
+                .key = static_cast<std::uint32_t>(id),
+                .count = histogram->count(),
+                .p50 = histogram->percentile(50),
+                .p99 = histogram->percentile(99),
+                .max = histogram->max()};
+            (dimension == Dimension::Type ? summary->byType : summary->byProcess).push_back(keyed);
+        }
+    }
+
+    const auto slowest_first = [limit](std::vector<KeyedSummary>& keyed) {
+        const std::size_t kept = std::min(limit, keyed.size());
+        std::ranges::partial_sort(keyed, keyed.begin() + static_cast<std::ptrdiff_t>(kept),
+                                  [](const KeyedSummary& left, const KeyedSummary& right) {
+            if (left.p99 != right.p99) {
+                return left.p99 > right.p99;
+            }
+            return left.key < right.key;
+        });
+        keyed.resize(kept);
+    };
+    for (CallSummary& summary : summaries) {
+        slowest_first(summary.byType);
+        slowest_first(summary.byProcess);
+    }
+    return summaries;
+}
+
+std::vector<SlowCall> Recorder::slow_calls() const {
+    std::vector<SlowCall> slow;
+    {
+        const std::lock_guard lock(m_slow_mutex);
+        slow = m_slow;
+    }
+    std::ranges::stable_sort(slow, [](const SlowCall& left, const SlowCall& right) {
+        return left.nanoseconds > right.nanoseconds;
+    });
+    return slow;
+}
+
+std::size_t Recorder::dropped_slow_calls() const {
+    const std::lock_guard lock(m_slow_mutex);
+    return m_slow_dropped;
+}
+
+Recorder& recorder() noexcept {
+    static Recorder* const instance = new Recorder();
+    return *instance;
+}
+
+// ---------------------------------------------------------------------------
+// ScopedTimer
+// ---------------------------------------------------------------------------
+
+ScopedTimer::ScopedTimer(const Call call, const std::uint32_t pid, const std::uint32_t type_index,
+                         const std::uint32_t granted_access, const std::uintptr_t handle_value) noexcept
+    : m_call(call),
+      m_pid(pid),
+      m_type_index(type_index),
+      m_granted_access(granted_access),
+      m_handle_value(handle_value),
+      m_active(recorder().enabled()) {
+    if (m_active) {
+        m_start = Clock::now();
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (!m_active) {
+        return;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+    try {
+        recorder().record(m_call, m_pid, m_type_index, m_granted_access, m_handle_value,
+                          static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(elapsed.count(), 0)));
+    } catch (...) {
+        // Instrumentation must never turn a query into a failure.
+    }
+}
+
+} // namespace latency
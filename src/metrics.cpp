@@ -0,0 +1,394 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mutex>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace metrics {
+
+namespace {
+
+[[nodiscard]] std::uint32_t narrow_pid(const std::uintptr_t pid) {
+    return static_cast<std::uint32_t>(std::min<std::uintptr_t>(pid, std::numeric_limits<std::uint32_t>::max()));
+}
+
+// Keeps the largest `top_k` entries (partial sort) and returns the sum of the rest.
+template <typename Entry, typename Key>
+std::size_t keep_top(std::vector<Entry>& entries, const std::size_t top_k, Key key) {
+    const std::size_t kept = std::min(top_k, entries.size());
+    std::ranges::partial_sort(entries, entries.begin() + static_cast<std::ptrdiff_t>(kept),
+                              [&](const Entry& left, const Entry& right) {
+        if (left.handles != right.handles) {
+            return left.handles > right.handles;
+        }
+        return key(left) < key(right);
+    });
+    std::size_t rest = 0;
+    for (std::size_t i = kept; i < entries.size(); ++i) {
+        rest += entries[i].handles;
+    }
+    entries.resize(kept);
+    return rest;
+}
+
+void append_gauge(std::string& out, const std::string_view name, const std::string_view help) {
+    std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} gauge\n", name, help, name);
+}
+
+constexpr std::size_t kMaxRequestBytes = 8 * 1024;
+constexpr int kClientTimeoutMs = 5000;
+// Pause before accepting again after a transient failure, so running out of
+// descriptors does not turn into a busy loop.
+constexpr std::chrono::milliseconds kAcceptRetryDelay{10};
+
+#ifdef _WIN32
+using Socket = SOCKET;
+constexpr std::intptr_t kNoSocket = static_cast<std::intptr_t>(INVALID_SOCKET);
+
+[[nodiscard]] std::string socket_error() {
+    return std::system_category().message(WSAGetLastError());
+}
+
+// send() never raises a signal on Windows.
+constexpr int kSendFlags = 0;
+
+// accept() failures caused by one connection or a passing shortage, not the listener.
+[[nodiscard]] bool transient_accept_error() {
+    const int error = WSAGetLastError();
+    return error == WSAEINTR || error == WSAECONNRESET || error == WSAEWOULDBLOCK || error == WSAEMFILE ||
+           error == WSAENOBUFS;
+}
+
+void close_socket(const Socket socket) {
+    ::closesocket(socket);
+}
+
+[[nodiscard]] bool start_sockets() {
+    static std::once_flag once;
+    static bool started = false;
+    std::call_once(once, [] {
+        WSADATA data{};
+        started = ::WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    });
+    return started;
+}
+
+void set_receive_timeout(const Socket socket) {
+    const DWORD timeout = kClientTimeoutMs;
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+#else
+using Socket = int;
+constexpr std::intptr_t kNoSocket = -1;
+
+[[nodiscard]] std::string socket_error() {
+    return std::strerror(errno);
+}
+
+// A scraper that disconnects mid-response must cost an EPIPE, not a SIGPIPE
+// that kills the exporter.
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// accept() failures caused by one connection or a passing shortage, not the
+// listener. Linux also passes pending network errors of the new connection
+// through accept(), which accept(2) says to treat like EAGAIN.
+[[nodiscard]] bool transient_accept_error() {
+    const int error = errno;
+    return error == EINTR || error == ECONNABORTED || error == EAGAIN || error == EWOULDBLOCK || error == EPROTO ||
+           error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM || error == EPERM ||
+           error == ENETDOWN || error == ENETUNREACH || error == EHOSTUNREACH || error == ENOPROTOOPT ||
+           error == EOPNOTSUPP;
+}
+
+void close_socket(const Socket socket) {
+    ::close(socket);
+}
+
+[[nodiscard]] bool start_sockets() {
+    return true;
+}
+
+void set_receive_timeout(const Socket socket) {
+    const timeval timeout{.tv_sec = kClientTimeoutMs / 1000, .tv_usec = 0};
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+#endif
+
+[[nodiscard]] bool send_all(const Socket socket, std::string_view data) {
+    while (!data.empty()) {
+        const int chunk = static_cast<int>(std::min<std::size_t>(data.size(), 1 << 20));
+        const auto sent = ::send(socket, data.data(), chunk, kSendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(sent));
+    }
+    return true;
+}
+
+[[nodiscard]] std::string response(const std::string_view status, const std::string_view content_type, const std::string_view body) {
+    return std::format("HTTP/1.0 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                       status, content_type, body.size(), body);
+}
+
+} // namespace
+
+Summary summarize(const std::span<const nt::RawHandle> handles, const std::size_t top_k) {
+    Summary summary;
+    summary.handles = handles.size();
+
+    // The table is grouped by process, so runs of one pid are counted locally
+    // and the map is touched once per run rather than once per handle.
+    std::unordered_map<std::uint32_t, std::size_t> by_pid;
+    std::vector<std::size_t> by_type;
+    std::vector<std::size_t> type_sample;
+    std::uint32_t run_pid = 0;
+    std::size_t run_length = 0;
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        const nt::RawHandle& handle = handles[i];
+        const std::uint32_t pid = narrow_pid(handle.processId);
+        if (pid != run_pid && run_length > 0) {
+            by_pid[run_pid] += run_length;
+            run_length = 0;
+        }
+        run_pid = pid;
+        ++run_length;
+
+        const std::size_t type = handle.objectTypeIndex;
+        if (type >= by_type.size()) {
+            by_type.resize(type + 1, 0);
+            type_sample.resize(type + 1, 0);
+        }
+        if (by_type[type]++ == 0) {
+            type_sample[type] = i;
+        }
+    }
+    if (run_length > 0) {
+        by_pid[run_pid] += run_length;
+    }
+
+    summary.topProcesses.reserve(by_pid.size());
+    for (const auto& [pid, count] : by_pid) {
+        summary.topProcesses.push_back(ProcessCount{.pid = pid, .handles = count});
+    }
+    for (std::size_t type = 0; type < by_type.size(); ++type) {
+        if (by_type[type] > 0) {
+            summary.topTypes.push_back(TypeCount{
+                .typeIndex = static_cast<std::uint16_t>(type), .handles = by_type[type], .sample = type_sample[type]});
+        }
+    }
+
+    summary.processes = summary.topProcesses.size();
+    summary.types = summary.topTypes.size();
+    summary.otherProcessHandles = keep_top(summary.topProcesses, top_k, [](const ProcessCount& entry) { return entry.pid; });
+    summary.otherTypeHandles = keep_top(summary.topTypes, top_k, [](const TypeCount& entry) { return entry.typeIndex; });
+    summary.otherProcesses = summary.processes - summary.topProcesses.size();
+    summary.otherTypes = summary.types - summary.topTypes.size();
+    return summary;
+}
+
+std::string escape_label(const std::string_view value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char ch : value) {
+        switch (ch) {
+        case '\\': escaped += "\\\\"; break;
+        case '"': escaped += "\\\""; break;
+        case '\n': escaped += "\\n"; break;
+        default: escaped += ch; break;
+        }
+    }
+    return escaped;
+}
+
+std::string render(const Summary& summary, const std::size_t system_handles, const Labels& labels) {
+    std::string out;
+    out.reserve(1024 + 96 * (summary.topProcesses.size() + summary.topTypes.size()));
+    auto it = std::back_inserter(out);
+
+    append_gauge(out, "handleenum_system_handles", "Handles in the system handle table.");
+    std::format_to(it, "handleenum_system_handles {}\n", system_handles);
+    append_gauge(out, "handleenum_handles", "Handles matching the filters.");
+    std::format_to(it, "handleenum_handles {}\n", summary.handles);
+    append_gauge(out, "handleenum_processes", "Processes holding matching handles.");
+    std::format_to(it, "handleenum_processes {}\n", summary.processes);
+
+    append_gauge(out, "handleenum_process_handles",
+                 "Matching handles per process; processes outside the top K are summed in the pid=other series.");
+    for (const ProcessCount& process : summary.topProcesses) {
+        std::format_to(it, "handleenum_process_handles{{pid=\"{}\",process=\"{}\"}} {}\n",
+                       process.pid, escape_label(labels.processName(process.pid)), process.handles);
+    }
+    if (summary.otherProcesses > 0) {
+        std::format_to(it, "handleenum_process_handles{{pid=\"other\",process=\"other\"}} {}\n", summary.otherProcessHandles);
+    }
+
+    append_gauge(out, "handleenum_type_handles",
+                 "Matching handles per object type; types outside the top K are summed in the type=other series.");
+    for (const TypeCount& type : summary.topTypes) {
+        std::format_to(it, "handleenum_type_handles{{type=\"{}\",type_index=\"{}\"}} {}\n",
+                       escape_label(labels.typeName(type)), type.typeIndex, type.handles);
+    }
+    if (summary.otherTypes > 0) {
+        std::format_to(it, "handleenum_type_handles{{type=\"other\",type_index=\"other\"}} {}\n", summary.otherTypeHandles);
+    }
+
+    out += "# EOF\n";
+    return out;
+}
+
+std::expected<void, std::string> write_textfile(const std::string& path, const std::string_view text) {
+    const std::filesystem::path target(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return std::unexpected(std::format("cannot write {}", temp.string()));
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file.flush()) {
+            return std::unexpected(std::format("cannot write {}", temp.string()));
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, target, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return std::unexpected(std::format("cannot replace {} ({})", path, error.message()));
+    }
+    return {};
+}
+
+LoopbackServer::~LoopbackServer() {
+    close();
+}
+
+LoopbackServer::LoopbackServer(LoopbackServer&& other) noexcept
+    : m_socket(std::exchange(other.m_socket, kNoSocket)), m_port(other.m_port) {}
+
+LoopbackServer& LoopbackServer::operator=(LoopbackServer&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_socket = std::exchange(other.m_socket, kNoSocket);
+        m_port = other.m_port;
+    }
+    return *this;
+}
+
+void LoopbackServer::close() noexcept {
+    if (m_socket != kNoSocket) {
+        close_socket(static_cast<Socket>(m_socket));
+        m_socket = kNoSocket;
+    }
+}
+
+std::expected<LoopbackServer, std::string> LoopbackServer::listen(const std::uint16_t port) {
+    if (!start_sockets()) {
+        return std::unexpected(std::string("cannot initialize sockets"));
+    }
+
+    const Socket socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (static_cast<std::intptr_t>(socket) == kNoSocket) {
+        return std::unexpected(std::format("cannot create socket ({})", socket_error()));
+    }
+    LoopbackServer server;
+    server.m_socket = static_cast<std::intptr_t>(socket);
+
+    const int reuse = 1;
+    ::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (::bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        return std::unexpected(std::format("cannot bind 127.0.0.1:{} ({})", port, socket_error()));
+    }
+    if (::listen(socket, 8) != 0) {
+        return std::unexpected(std::format("cannot listen on 127.0.0.1:{} ({})", port, socket_error()));
+    }
+
+    socklen_t length = sizeof(address);
+    if (::getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        return std::unexpected(std::format("cannot read the bound port ({})", socket_error()));
+    }
+    server.m_port = ntohs(address.sin_port);
+    return server;
+}
+
+std::expected<void, std::string> LoopbackServer::serve_one(const Body& body) {
+    Socket client = ::accept(static_cast<Socket>(m_socket), nullptr, nullptr);
+    while (static_cast<std::intptr_t>(client) == kNoSocket) {
+        if (!transient_accept_error()) {
+            return std::unexpected(std::format("accept failed ({})", socket_error()));
+        }
+        std::this_thread::sleep_for(kAcceptRetryDelay);
+        client = ::accept(static_cast<Socket>(m_socket), nullptr, nullptr);
+    }
+    // A client that never finishes its request must not wedge the exporter.
+    set_receive_timeout(client);
+
+    std::string request;
+    char chunk[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestBytes) {
+        const auto received = ::recv(client, chunk, static_cast<int>(sizeof(chunk)), 0);
+        if (received <= 0) {
+            break;
+        }
+        request.append(chunk, static_cast<std::size_t>(received));
+    }
+
+    // Request line: METHOD SP PATH SP VERSION; query strings are ignored.
+    const std::string_view line = std::string_view(request).substr(0, request.find("\r\n"));
+    const std::size_t method_end = line.find(' ');
+    const std::string_view method = line.substr(0, method_end);
+    std::string_view path = method_end == std::string_view::npos ? std::string_view{} : line.substr(method_end + 1);
+    path = path.substr(0, path.find(' '));
+    path = path.substr(0, path.find('?'));
+
+    std::string reply;
+    if (method != "GET") {
+        reply = response("405 Method Not Allowed", "text/plain", "only GET is supported\n");
+    } else if (path != "/metrics") {
+        reply = response("404 Not Found", "text/plain", "metrics are served at /metrics\n");
+    } else if (auto text = body(); !text) {
+        reply = response("500 Internal Server Error", "text/plain", text.error() + "\n");
+    } else {
+        reply = response("200 OK", "application/openmetrics-text; version=1.0.0; charset=utf-8", *text);
+    }
+
+    // A client that went away only loses its own response.
+    (void)send_all(client, reply);
+    close_socket(client);
+    return {};
+}
+
+} // namespace metrics
@@ -0,0 +1,75 @@
+#include "name_policy.hpp"
+
+#include <algorithm>
+
+NameSkipPolicy::NameSkipPolicy(const NameSkipOptions options) : m_options(options) {}
+
+bool NameSkipPolicy::below_threshold(const TypeStats& stats) const noexcept {
+    return stats.observed >= m_options.warmup &&
+           static_cast<double>(stats.named) < m_options.minNamedRate * static_cast<double>(stats.observed);
+}
+
+bool NameSkipPolicy::should_query(const std::uint16_t type_index) {
+    if (type_index >= m_types.size()) {
+        return true;
+    }
+    TypeStats& stats = m_types[type_index];
+    if (!below_threshold(stats)) {
+        return true;
+    }
+    if (++stats.sinceProbe >= m_options.probeInterval) {
+        stats.sinceProbe = 0;
+        return true;
+    }
+    ++stats.skipped;
+    ++m_skipped;
+    return false;
+}
+
+void NameSkipPolicy::record(const std::uint16_t type_index, const bool named, const std::chrono::nanoseconds cost) {
+    if (type_index >= m_types.size()) {
+        m_types.resize(static_cast<std::size_t>(type_index) + 1);
+    }
+    TypeStats& stats = m_types[type_index];
+    ++stats.observed;
+    stats.named += named ? 1 : 0;
+    stats.totalCost += static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(cost.count(), 0));
+}
+
+std::vector<NameSkipPolicy::TypeReport> NameSkipPolicy::skipped_types() const {
+    std::vector<TypeReport> reports;
+    for (std::size_t index = 0; index < m_types.size(); ++index) {
+        const TypeStats& stats = m_types[index];
+        if (stats.skipped == 0) {
+            continue;
+        }
+        reports.push_back(TypeReport{
+            .typeIndex = static_cast<std::uint16_t>(index),
+            .observed = stats.observed,
+            .named = stats.named,
+            .skipped = stats.skipped,
+            .averageCost = std::chrono::nanoseconds(stats.observed == 0 ? 0 : stats.totalCost / stats.observed)});
+    }
+    std::ranges::sort(reports, [](const TypeReport& left, const TypeReport& right) {
+        if (left.skipped != right.skipped) {
+            return left.skipped > right.skipped;
+        }
+        return left.typeIndex < right.typeIndex;
+    });
+    return reports;
+}
+
+std::chrono::nanoseconds NameSkipPolicy::estimated_savings() const {
+    std::chrono::nanoseconds total{0};
+    for (const TypeReport& report : skipped_types()) {
+        total += report.averageCost * static_cast<std::int64_t>(report.skipped);
+    }
+    return total;
+}
+
+void NameSkipPolicy::reset_skip_counts() noexcept {
+    for (TypeStats& stats : m_types) {
+        stats.skipped = 0;
+    }
+    m_skipped = 0;
+}
@@ -0,0 +1,156 @@
+#include "name_resolver.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <thread>
+#include <utility>
+
+struct NameResolver::Worker {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::optional<nt::RawHandle> request;
+    std::optional<std::expected<std::string, nt::Error>> result;
+    bool stopping = false;
+    bool abandoned = false;
+    std::thread thread;
+};
+
+// The thread owns a copy of the query and a reference to its own state, so an
+// abandoned worker never touches the resolver after it has been detached.
+void NameResolver::worker_loop(const std::shared_ptr<Worker>& worker, const nt::ObjectQuery& query) {
+    std::unique_lock lock(worker->mutex);
+    while (true) {
+        worker->cv.wait(lock, [&] { return worker->request.has_value() || worker->stopping; });
+        if (!worker->request) {
+            return;
+        }
+
+        const nt::RawHandle handle = *worker->request;
+        worker->request.reset();
+        lock.unlock();
+
+        std::expected<std::string, nt::Error> result =
+            std::unexpected(std::make_error_code(std::errc::io_error));
+        try {
+            result = query(handle);
+        } catch (...) {
+        }
+
+        lock.lock();
+        if (worker->abandoned) {
+            return;
+        }
+        worker->result = std::move(result);
+        worker->cv.notify_all();
+    }
+}
+
+NameResolver::NameResolver(nt::ObjectQuery query, const NameResolverOptions options)
+    : m_query(std::move(query)),
+      m_options(options) {
+    m_options.maxWorkers = std::max<std::size_t>(m_options.maxWorkers, 1);
+}
+
+NameResolver::~NameResolver() {
+    std::vector<std::shared_ptr<Worker>> workers;
+    {
+        const std::lock_guard lock(m_mutex);
+        workers.swap(m_live_workers);
+        m_idle_workers.clear();
+    }
+
+    for (const auto& worker : workers) {
+        {
+            const std::lock_guard lock(worker->mutex);
+            worker->stopping = true;
+        }
+        worker->cv.notify_all();
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+std::shared_ptr<NameResolver::Worker> NameResolver::acquire_worker() {
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        if (!m_idle_workers.empty()) {
+            auto worker = std::move(m_idle_workers.back());
+            m_idle_workers.pop_back();
+            return worker;
+        }
+
+        const bool may_spawn = m_live_workers.size() < m_options.maxWorkers &&
+                               m_abandoned.load(std::memory_order_relaxed) < m_options.maxAbandoned;
+        if (may_spawn) {
+            auto worker = std::make_shared<Worker>();
+            worker->thread = std::thread([worker, query = m_query] { worker_loop(worker, query); });
+            m_live_workers.push_back(worker);
+            return worker;
+        }
+
+        if (m_live_workers.empty()) {
+            return nullptr;
+        }
+
+        m_idle_cv.wait(lock);
+    }
+}
+
+void NameResolver::release_worker(std::shared_ptr<Worker> worker) {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_idle_workers.push_back(std::move(worker));
+    }
+    m_idle_cv.notify_one();
+}
+
+void NameResolver::abandon_worker(const std::shared_ptr<Worker>& worker) {
+    {
+        const std::lock_guard lock(m_mutex);
+        std::erase(m_live_workers, worker);
+        worker->thread.detach();
+        m_abandoned.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Wake a waiter so it can spawn the replacement (or give up if exhausted).
+    m_idle_cv.notify_all();
+}
+
+std::expected<std::string, nt::Error> NameResolver::resolve(const nt::RawHandle& handle) {
+    const auto timed_out = [this] {
+        m_timed_out.fetch_add(1, std::memory_order_relaxed);
+        return std::unexpected(std::make_error_code(std::errc::timed_out));
+    };
+
+    std::shared_ptr<Worker> worker = acquire_worker();
+    if (!worker) {
+        return timed_out();
+    }
+
+    std::unique_lock lock(worker->mutex);
+    worker->result.reset();
+    worker->request = handle;
+    worker->cv.notify_all();
+
+    if (!worker->cv.wait_for(lock, m_options.deadline, [&] { return worker->result.has_value(); })) {
+        worker->abandoned = true;
+        lock.unlock();
+        abandon_worker(worker);
+        return timed_out();
+    }
+
+    std::expected<std::string, nt::Error> result = std::move(*worker->result);
+    worker->result.reset();
+    lock.unlock();
+
+    release_worker(std::move(worker));
+    return result;
+}
+
+std::size_t NameResolver::timed_out_count() const noexcept {
+    return m_timed_out.load(std::memory_order_relaxed);
+}
+
+std::size_t NameResolver::abandoned_worker_count() const noexcept {
+    return m_abandoned.load(std::memory_order_relaxed);
+}
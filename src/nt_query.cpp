@@ -1,7 +1,9 @@
 #include "nt.hpp"
 
+#include "latency.hpp"
 #include "string_utils.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <limits>
 #include <new>
@@ -11,13 +13,7 @@
 
 namespace nt {
 
-using NtQueryObjectPtr = NTSTATUS(NTAPI*)(
-    HANDLE Handle,
-    OBJECT_INFORMATION_CLASS ObjectInformationClass,
-    PVOID ObjectInformation,
-    ULONG ObjectInformationLength,
-    PULONG ReturnLength
-);
+using detail::NtQueryObjectPtr;
 
 namespace {
 
@@ -25,6 +21,11 @@ constexpr ULONG kObjectTypeInformation = 2;
 constexpr ULONG kObjectNameInformation = 1;
 constexpr int kMaxRetries = 10;
 
+// Most type and name results fit comfortably; long paths grow the buffer once.
+constexpr std::size_t kInitialScratchSize = 1024;
+// Queries between checks whether an oversized scratch buffer can shrink.
+constexpr std::size_t kScratchWindow = 4096;
+
 struct OBJECT_TYPE_INFORMATION_HEAD {
     UNICODE_STRING TypeName;
 };
@@ -65,11 +66,6 @@ struct OBJECT_NAME_INFORMATION_HEAD {
     return cached_ptr;
 }
 
-[[nodiscard]] bool looks_like_sync_pipe_file(const RawHandle& handle) {
-    constexpr std::uint32_t pipe_mask = FILE_READ_DATA | FILE_WRITE_DATA | SYNCHRONIZE;
-    return (handle.grantedAccess & pipe_mask) == pipe_mask;
-}
-
 [[nodiscard]] std::expected<HANDLE, Error> duplicate_to_current_process(const RawHandle& handle) {
     if (handle.processId == 0 || handle.handleValue == 0) {
         return std::unexpected(std::make_error_code(std::errc::invalid_argument));
@@ -80,6 +76,8 @@ struct OBJECT_NAME_INFORMATION_HEAD {
     }
 
     const DWORD source_pid = static_cast<DWORD>(handle.processId);
+    const latency::ScopedTimer timer(latency::Call::Duplicate, source_pid, handle.objectTypeIndex, handle.grantedAccess,
+                                     handle.handleValue);
     HANDLE source_process = ::OpenProcess(PROCESS_DUP_HANDLE, FALSE, source_pid);
     if (!source_process) {
         return std::unexpected(last_error_code());
@@ -105,37 +103,68 @@ struct OBJECT_NAME_INFORMATION_HEAD {
     return duplicated;
 }
 
-[[nodiscard]] std::expected<std::string, Error> query_unicode_information(
+// Reusable per-thread buffer for NtQueryObject results. Sized from the largest
+// result seen in the current window so one long path does not pin a huge
+// buffer forever, while steady-state queries never allocate.
+struct ScratchBuffer {
+    std::vector<std::byte> bytes;
+    std::size_t windowPeak = 0;
+    std::size_t windowUses = 0;
+};
+
+thread_local ScratchBuffer t_scratch;
+thread_local detail::ObjectQueryCounters t_counters;
+
+void resize_scratch(ScratchBuffer& scratch, const std::size_t size) {
+    scratch.bytes.resize(size);
+    scratch.bytes.shrink_to_fit();
+    ++t_counters.allocations;
+}
+
+void record_scratch_use(ScratchBuffer& scratch, const std::size_t used) {
+    scratch.windowPeak = std::max(scratch.windowPeak, used);
+    if (++scratch.windowUses < kScratchWindow) {
+        return;
+    }
+
+    const std::size_t target = std::max(kInitialScratchSize, scratch.windowPeak * 2);
+    if (scratch.bytes.size() > target * 2) {
+        resize_scratch(scratch, target);
+    }
+    scratch.windowPeak = 0;
+    scratch.windowUses = 0;
+}
+
+[[nodiscard]] bool is_buffer_too_small(const NTSTATUS status) {
+    return status == STATUS_INFO_LENGTH_MISMATCH ||
+           status == STATUS_BUFFER_OVERFLOW ||
+           status == STATUS_BUFFER_TOO_SMALL;
+}
+
+} // namespace
+
+namespace detail {
+
+std::expected<std::string, Error> query_unicode_information(
     NtQueryObjectPtr nt_query_object,
     HANDLE duplicated,
     const OBJECT_INFORMATION_CLASS info_class
 ) {
-    ULONG needed_size = 0;
-    NTSTATUS status = nt_query_object(
-        duplicated,
-        info_class,
-        nullptr,
-        0,
-        &needed_size
-    );
-
-    if (status != STATUS_INFO_LENGTH_MISMATCH && status != STATUS_SUCCESS) {
-        return std::unexpected(ntstatus_error(status));
+    ScratchBuffer& scratch = t_scratch;
+    if (scratch.bytes.empty()) {
+        resize_scratch(scratch, kInitialScratchSize);
     }
 
-    std::size_t buffer_size = (needed_size == 0) ? 512u : static_cast<std::size_t>(needed_size);
-    if (buffer_size > static_cast<std::size_t>(std::numeric_limits<ULONG>::max())) {
-        return std::unexpected(std::make_error_code(std::errc::value_too_large));
-    }
-
-    std::vector<std::byte> buffer(buffer_size);
+    NTSTATUS status = STATUS_SUCCESS;
+    ULONG needed_size = 0;
     for (int attempt = 0; attempt < kMaxRetries; ++attempt) {
         needed_size = 0;
+        ++t_counters.ntCalls;
         status = nt_query_object(
             duplicated,
             info_class,
-            buffer.data(),
-            static_cast<ULONG>(buffer.size()),
+            scratch.bytes.data(),
+            static_cast<ULONG>(scratch.bytes.size()),
             &needed_size
         );
 
@@ -143,27 +172,29 @@ struct OBJECT_NAME_INFORMATION_HEAD {
             break;
         }
 
-        if (status != STATUS_INFO_LENGTH_MISMATCH) {
+        if (!is_buffer_too_small(status)) {
             return std::unexpected(ntstatus_error(status));
         }
 
-        const std::size_t next = detail::grow_buffer_size(buffer.size(), needed_size);
-        if (next <= buffer.size()) {
+        const std::size_t next = grow_buffer_size(scratch.bytes.size(), needed_size);
+        if (next <= scratch.bytes.size()) {
             return std::unexpected(std::make_error_code(std::errc::value_too_large));
         }
-        buffer.resize(next);
+        resize_scratch(scratch, next);
     }
 
     if (status != STATUS_SUCCESS) {
         return std::unexpected(ntstatus_error(status));
     }
 
+    record_scratch_use(scratch, needed_size == 0 ? scratch.bytes.size() : static_cast<std::size_t>(needed_size));
+
     const UNICODE_STRING* unicode = nullptr;
     if (info_class == static_cast<OBJECT_INFORMATION_CLASS>(kObjectTypeInformation)) {
-        const auto* info = reinterpret_cast<const OBJECT_TYPE_INFORMATION_HEAD*>(buffer.data());
+        const auto* info = reinterpret_cast<const OBJECT_TYPE_INFORMATION_HEAD*>(scratch.bytes.data());
         unicode = &info->TypeName;
     } else {
-        const auto* info = reinterpret_cast<const OBJECT_NAME_INFORMATION_HEAD*>(buffer.data());
+        const auto* info = reinterpret_cast<const OBJECT_NAME_INFORMATION_HEAD*>(scratch.bytes.data());
         unicode = &info->Name;
     }
 
@@ -174,7 +205,15 @@ struct OBJECT_NAME_INFORMATION_HEAD {
     return utils::utf16_to_utf8(std::wstring_view(unicode->Buffer, unicode->Length / sizeof(wchar_t)));
 }
 
-} // namespace
+ObjectQueryCounters& object_query_counters() noexcept {
+    return t_counters;
+}
+
+std::size_t object_query_scratch_capacity() noexcept {
+    return t_scratch.bytes.size();
+}
+
+} // namespace detail
 
 std::expected<std::string, Error> query_object_type(const RawHandle& handle) noexcept {
     try {
@@ -189,11 +228,15 @@ std::expected<std::string, Error> query_object_type(const RawHandle& handle) noe
         }
 
         const HANDLE duplicated = *duplicated_result;
-        auto type_result = query_unicode_information(
-            nt_query_object,
-            duplicated,
-            static_cast<OBJECT_INFORMATION_CLASS>(kObjectTypeInformation)
-        );
+        auto type_result = [&] {
+            const latency::ScopedTimer timer(latency::Call::TypeQuery, static_cast<std::uint32_t>(handle.processId),
+                                             handle.objectTypeIndex, handle.grantedAccess, handle.handleValue);
+            return detail::query_unicode_information(
+                nt_query_object,
+                duplicated,
+                static_cast<OBJECT_INFORMATION_CLASS>(kObjectTypeInformation)
+            );
+        }();
 
         ::CloseHandle(duplicated);
         return type_result;
@@ -210,10 +253,6 @@ std::expected<std::string, Error> query_object_name(const RawHandle& handle) noe
             return make_error(std::errc::permission_denied);
         }
 
-        if (looks_like_sync_pipe_file(handle)) {
-            return make_error(std::errc::operation_would_block);
-        }
-
         const NtQueryObjectPtr nt_query_object = load_nt_query_object();
         if (!nt_query_object) {
             return make_error(std::errc::not_supported);
@@ -225,27 +264,16 @@ std::expected<std::string, Error> query_object_name(const RawHandle& handle) noe
         }
 
         const HANDLE duplicated = *duplicated_result;
-
-        auto type_result = query_unicode_information(
-            nt_query_object,
-            duplicated,
-            static_cast<OBJECT_INFORMATION_CLASS>(kObjectTypeInformation)
-        );
-        if (!type_result) {
-            ::CloseHandle(duplicated);
-            return std::unexpected(type_result.error());
-        }
-
-        if (*type_result == "File" && looks_like_sync_pipe_file(handle)) {
-            ::CloseHandle(duplicated);
-            return make_error(std::errc::operation_would_block);
-        }
-
-        auto name_result = query_unicode_information(
-            nt_query_object,
-            duplicated,
-            static_cast<OBJECT_INFORMATION_CLASS>(kObjectNameInformation)
-        );
+        auto name_result = [&] {
+            // This is the call that hangs on synchronous pipes.
+            const latency::ScopedTimer timer(latency::Call::NameQuery, static_cast<std::uint32_t>(handle.processId),
+                                             handle.objectTypeIndex, handle.grantedAccess, handle.handleValue);
+            return detail::query_unicode_information(
+                nt_query_object,
+                duplicated,
+                static_cast<OBJECT_INFORMATION_CLASS>(kObjectNameInformation)
+            );
+        }();
 
         ::CloseHandle(duplicated);
         return name_result;
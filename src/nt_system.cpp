@@ -1,4 +1,5 @@
 #include "nt.hpp"
+#include "latency.hpp"
 #include "string_utils.hpp"
 
 #include <cstddef>
@@ -36,6 +37,23 @@ struct SYSTEM_HANDLE_INFORMATION_EX {
     SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX Handles[1];
 };
 
+// Leading fields of SYSTEM_PROCESS_INFORMATION; winternl.h hides CreateTime
+// inside Reserved1. Entries are chained by NextEntryOffset.
+struct SYSTEM_PROCESS_INFORMATION_PREFIX {
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount;
+    ULONG NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER KernelTime;
+    UNICODE_STRING ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+};
+
 constexpr std::size_t kInitialBufferSize = 1u << 20; // 1 MiB
 constexpr int kMaxRetries = 10;
 
@@ -110,7 +128,12 @@ std::expected<void, std::error_code> enable_debug_privilege() {
     return {};
 }
 
-std::expected<std::vector<RawHandle>, std::error_code> query_system_handles() {
+namespace {
+
+// Runs NtQuerySystemInformation for `info_class`, growing the buffer until the
+// snapshot fits.
+std::expected<std::vector<std::byte>, std::error_code> query_system_information(const SYSTEM_INFORMATION_CLASS info_class,
+                                                                                const std::size_t initial_size) {
     HMODULE ntdll = ::GetModuleHandleW(L"ntdll.dll");
     if (!ntdll) {
         ntdll = ::LoadLibraryW(L"ntdll.dll");
@@ -130,12 +153,12 @@ std::expected<std::vector<RawHandle>, std::error_code> query_system_handles() {
     }
 
     ULONG needed_size = 0;
-    std::vector<std::byte> buffer(kInitialBufferSize);
+    std::vector<std::byte> buffer(initial_size);
     NTSTATUS status = 0;
 
     for (int attempt = 0; attempt < kMaxRetries; ++attempt) {
         status = nt_query_info(
-            SystemExtendedHandleInformation,
+            info_class,
             buffer.data(),
             static_cast<ULONG>(buffer.size()),
             &needed_size
@@ -160,6 +183,18 @@ std::expected<std::vector<RawHandle>, std::error_code> query_system_handles() {
         return std::unexpected(ntstatus_error(status));
     }
 
+    return buffer;
+}
+
+} // namespace
+
+std::expected<std::vector<RawHandle>, std::error_code> query_system_handles() {
+    auto snapshot = query_system_information(SystemExtendedHandleInformation, kInitialBufferSize);
+    if (!snapshot) {
+        return std::unexpected(snapshot.error());
+    }
+    std::vector<std::byte>& buffer = *snapshot;
+
     auto* handle_info = reinterpret_cast<SYSTEM_HANDLE_INFORMATION_EX*>(buffer.data());
     const std::size_t handle_count = static_cast<std::size_t>(handle_info->NumberOfHandles);
 
@@ -185,6 +220,33 @@ std::expected<std::vector<RawHandle>, std::error_code> query_system_handles() {
     return result;
 }
 
+std::expected<std::vector<ProcessIdentity>, std::error_code> query_process_snapshot() {
+    // Process entries carry their threads inline; 256 KiB fits a typical desktop.
+    auto snapshot = query_system_information(SystemProcessListInformation, 256u * 1024);
+    if (!snapshot) {
+        return std::unexpected(snapshot.error());
+    }
+    const std::vector<std::byte>& buffer = *snapshot;
+
+    std::vector<ProcessIdentity> processes;
+    std::size_t offset = 0;
+    while (offset + sizeof(SYSTEM_PROCESS_INFORMATION_PREFIX) <= buffer.size()) {
+        SYSTEM_PROCESS_INFORMATION_PREFIX entry;
+        std::memcpy(&entry, buffer.data() + offset, sizeof(entry));
+        processes.push_back(ProcessIdentity{
+            .pid = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(entry.UniqueProcessId)),
+            .createTime = static_cast<std::uint64_t>(entry.CreateTime.QuadPart)
+        });
+
+        if (entry.NextEntryOffset == 0) {
+            return processes;
+        }
+        offset += entry.NextEntryOffset;
+    }
+
+    return std::unexpected(std::make_error_code(std::errc::result_out_of_range));
+}
+
 std::string get_process_name_by_pid(const uint32_t pid) noexcept {
     if (pid == 0) {
         return "Idle";
@@ -194,6 +256,7 @@ std::string get_process_name_by_pid(const uint32_t pid) noexcept {
         return "System";
     }
 
+    const latency::ScopedTimer timer(latency::Call::ProcessName, pid, latency::kNoType, 0, 0);
     HANDLE process_handle = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
     if (!process_handle) {
         return "Unknown";
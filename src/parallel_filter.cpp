@@ -0,0 +1,144 @@
+#include "parallel_filter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+namespace {
+
+[[nodiscard]] std::size_t chunk_size(const ParallelOptions& options) noexcept {
+    return std::max<std::size_t>(options.chunkSize, 1);
+}
+
+[[nodiscard]] std::size_t chunk_count(const std::size_t items, const std::size_t step) noexcept {
+    return items / step + (items % step != 0 ? 1 : 0);
+}
+
+// Runs `body(chunk_index, thread_index)` for every chunk on `threads` workers
+// (the calling thread is one of them) and rethrows the first failure.
+template <typename Body>
+void for_each_chunk(const std::size_t chunks, const std::size_t threads, Body&& body) {
+    std::atomic<std::size_t> next_chunk{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::exception_ptr> errors(threads);
+
+    const auto worker = [&](const std::size_t thread_index) {
+        try {
+            while (!failed.load(std::memory_order_relaxed)) {
+                const std::size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= chunks) {
+                    return;
+                }
+                body(chunk, thread_index);
+            }
+        } catch (...) {
+            errors[thread_index] = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    {
+        std::vector<std::jthread> helpers;
+        helpers.reserve(threads - 1);
+        for (std::size_t thread_index = 1; thread_index < threads; ++thread_index) {
+            helpers.emplace_back(worker, thread_index);
+        }
+        worker(0);
+    }
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+} // namespace
+
+std::size_t effective_threads(const std::size_t items, const ParallelOptions& options) noexcept {
+    std::size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    }
+    const std::size_t chunks = chunk_count(items, chunk_size(options));
+    return std::max<std::size_t>(std::min(threads, chunks), 1);
+}
+
+std::vector<nt::RawHandle> select(const std::span<const nt::RawHandle> handles,
+                                  const HandlePredicate& predicate,
+                                  const ParallelOptions& options) {
+    const std::size_t threads = effective_threads(handles.size(), options);
+    if (threads == 1) {
+        std::vector<nt::RawHandle> selected;
+        for (const nt::RawHandle& handle : handles) {
+            if (predicate(handle)) {
+                selected.push_back(handle);
+            }
+        }
+        return selected;
+    }
+
+    const std::size_t step = chunk_size(options);
+    const std::size_t chunks = chunk_count(handles.size(), step);
+    std::vector<std::vector<nt::RawHandle>> selections(chunks);
+
+    for_each_chunk(chunks, threads, [&](const std::size_t chunk, std::size_t) {
+        const auto part = handles.subspan(chunk * step, std::min(step, handles.size() - chunk * step));
+        std::vector<nt::RawHandle>& selection = selections[chunk];
+        for (const nt::RawHandle& handle : part) {
+            if (predicate(handle)) {
+                selection.push_back(handle);
+            }
+        }
+    });
+
+    std::size_t total = 0;
+    for (const auto& selection : selections) {
+        total += selection.size();
+    }
+
+    std::vector<nt::RawHandle> selected;
+    selected.reserve(total);
+    for (const auto& selection : selections) {
+        selected.insert(selected.end(), selection.begin(), selection.end());
+    }
+    return selected;
+}
+
+std::size_t count(const std::span<const nt::RawHandle> handles,
+                  const HandlePredicate& predicate,
+                  const ParallelOptions& options) {
+    const std::size_t threads = effective_threads(handles.size(), options);
+    if (threads == 1) {
+        return static_cast<std::size_t>(std::ranges::count_if(handles, predicate));
+    }
+
+    // One cache line per counter so workers never share a line.
+    struct alignas(64) Counter {
+        std::size_t value = 0;
+    };
+    std::vector<Counter> counters(threads);
+
+    const std::size_t step = chunk_size(options);
+    const std::size_t chunks = chunk_count(handles.size(), step);
+    for_each_chunk(chunks, threads, [&](const std::size_t chunk, const std::size_t thread_index) {
+        const auto part = handles.subspan(chunk * step, std::min(step, handles.size() - chunk * step));
+        std::size_t matched = 0;
+        for (const nt::RawHandle& handle : part) {
+            matched += predicate(handle) ? 1 : 0;
+        }
+        counters[thread_index].value += matched;
+    });
+
+    std::size_t total = 0;
+    for (const Counter& counter : counters) {
+        total += counter.value;
+    }
+    return total;
+}
+
+} // namespace parallel
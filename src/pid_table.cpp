@@ -0,0 +1,85 @@
+#include "pid_table.hpp"
+
+PidTable::~PidTable() {
+    for (std::atomic<Chunk*>& chunk : m_chunks) {
+        delete chunk.load(std::memory_order_relaxed);
+    }
+}
+
+std::optional<PidTable::Entry> PidTable::find(const std::uint32_t pid) const noexcept {
+    if (!is_dense(pid)) {
+        const std::lock_guard lock(m_sparse_mutex);
+        if (const auto it = m_sparse.find(pid); it != m_sparse.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    const std::size_t index = pid / 4;
+    const Chunk* chunk = m_chunks[index / kChunkSlots].load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        return std::nullopt;
+    }
+    const Slot& slot = (*chunk)[index % kChunkSlots];
+    const StringId published = slot.published.load(std::memory_order_acquire);
+    if (published == 0) {
+        return std::nullopt;
+    }
+    return Entry{.id = published - 1, .name = std::string_view(slot.data, slot.length)};
+}
+
+PidTable::Entry PidTable::publish(const std::uint32_t pid, const Entry entry) {
+    if (!is_dense(pid)) {
+        const std::lock_guard lock(m_sparse_mutex);
+        const auto [it, inserted] = m_sparse.emplace(pid, entry);
+        if (inserted) {
+            m_size.fetch_add(1, std::memory_order_relaxed);
+        }
+        return it->second;
+    }
+
+    const std::size_t index = pid / 4;
+    std::atomic<Chunk*>& chunk_slot = m_chunks[index / kChunkSlots];
+    Chunk* chunk = chunk_slot.load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        // Publishers are serialized, so nobody else can be installing it.
+        chunk = new Chunk();
+        chunk_slot.store(chunk, std::memory_order_release);
+    }
+
+    Slot& slot = (*chunk)[index % kChunkSlots];
+    if (const StringId published = slot.published.load(std::memory_order_relaxed); published != 0) {
+        return Entry{.id = published - 1, .name = std::string_view(slot.data, slot.length)};
+    }
+    slot.data = entry.name.data();
+    slot.length = static_cast<std::uint32_t>(entry.name.size());
+    slot.published.store(entry.id + 1, std::memory_order_release);
+    m_size.fetch_add(1, std::memory_order_relaxed);
+    return entry;
+}
+
+void PidTable::clear() noexcept {
+    if (m_size.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    for (std::atomic<Chunk*>& chunk : m_chunks) {
+        if (Chunk* slots = chunk.load(std::memory_order_relaxed)) {
+            for (Slot& slot : *slots) {
+                slot.published.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    {
+        const std::lock_guard lock(m_sparse_mutex);
+        m_sparse.clear();
+    }
+    m_size.store(0, std::memory_order_relaxed);
+}
+
+std::size_t PidTable::chunk_count() const noexcept {
+    std::size_t count = 0;
+    for (const std::atomic<Chunk*>& chunk : m_chunks) {
+        count += chunk.load(std::memory_order_relaxed) != nullptr ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,63 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace pipeline {
+
+Handles acquire(std::vector<nt::RawHandle> snapshot) {
+    for (const nt::RawHandle& handle : snapshot) {
+        co_yield handle;
+    }
+}
+
+Handles filter(Handles upstream, parallel::HandlePredicate predicate, const parallel::ParallelOptions options) {
+    if (!predicate) {
+        for (const nt::RawHandle& handle : upstream) {
+            co_yield handle;
+        }
+        co_return;
+    }
+
+    const std::size_t threads = parallel::effective_threads(std::numeric_limits<std::size_t>::max(), options);
+    if (threads <= 1) {
+        for (const nt::RawHandle& handle : upstream) {
+            if (predicate(handle)) {
+                co_yield handle;
+            }
+        }
+        co_return;
+    }
+
+    const std::size_t max_block = threads * std::max<std::size_t>(options.chunkSize, 1);
+    std::size_t block_size = threads;
+    std::vector<nt::RawHandle> block;
+    auto it = upstream.begin();
+    while (it != upstream.end()) {
+        block.clear();
+        for (; it != upstream.end() && block.size() < block_size; ++it) {
+            block.push_back(*it);
+        }
+        // Chunks sized so every thread gets a share of even the first blocks.
+        const parallel::ParallelOptions block_options{.threads = threads, .chunkSize = std::max<std::size_t>(block_size / threads, 1)};
+        for (const nt::RawHandle& handle : parallel::select(block, predicate, block_options)) {
+            co_yield handle;
+        }
+        block_size = std::min(block_size * 2, max_block);
+    }
+}
+
+Rows resolve(Handles upstream, const Resolver resolver) {
+    for (const nt::RawHandle& handle : upstream) {
+        co_yield resolver(handle);
+    }
+}
+
+Lines format(Rows upstream, const Formatter formatter) {
+    for (const HandleInfo& row : upstream) {
+        co_yield formatter(row);
+    }
+}
+
+} // namespace pipeline
@@ -1,7 +1,99 @@
 #include "printer.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
 #include <format>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace {
+
+struct ColumnLayout {
+    std::string_view header;
+    std::size_t width;
+};
+
+[[nodiscard]] ColumnLayout layout_of(const Column column) {
+    switch (column) {
+    case Column::Pid: return {"PID", 8};
+    case Column::Process: return {"Process", 15};
+    case Column::Handle: return {"Handle", 10};
+    case Column::Type: return {"Type", 24};
+    case Column::Name: return {"Name", 0};
+    case Column::Access: return {"Access", 10};
+    case Column::Address: return {"Address", 18};
+    }
+    return {"", 0};
+}
+
+// --merge: width of the leading Host column.
+constexpr std::size_t kHostWidth = 16;
+
+[[nodiscard]] std::string_view sort_label(const SortField sort_by) {
+    switch (sort_by) {
+    case SortField::Pid: return "pid";
+    case SortField::Type: return "type";
+    case SortField::Name: return "name";
+    }
+    return "";
+}
+
+void append_cell(std::string& line, const std::size_t start, const std::size_t width, const bool last) {
+    if (!last) {
+        const std::size_t written = line.size() - start;
+        if (written < width) {
+            line.append(width - written, ' ');
+        }
+        line.push_back(' ');
+    }
+}
+
+// Appends `value` in decimal, or in upper-case hex after "0x", without the
+// temporary string a format call may allocate.
+void append_number(std::string& line, const std::uint64_t value, const bool hex) {
+    char digits[24];
+    char* first = digits;
+    if (hex) {
+        *first++ = '0';
+        *first++ = 'x';
+    }
+    char* const last = std::to_chars(first, std::end(digits), value, hex ? 16 : 10).ptr;
+    std::transform(first, last, first, [](const char digit) {
+        return digit >= 'a' ? static_cast<char>(digit - 'a' + 'A') : digit;
+    });
+    line.append(digits, last);
+}
+
+// Milliseconds since the Unix epoch as "YYYY-MM-DD HH:MM:SS" (UTC).
+[[nodiscard]] std::string format_utc(const int64_t timestamp_ms) {
+    using namespace std::chrono;
+    const sys_time<milliseconds> time{milliseconds(timestamp_ms)};
+    const sys_days day = floor<days>(time);
+    const year_month_day date{day};
+    const hh_mm_ss clock{floor<seconds>(time - day)};
+    return std::format("{:04}-{:02}-{:02} {:02}:{:02}:{:02}",
+                       static_cast<int>(date.year()),
+                       static_cast<unsigned>(date.month()),
+                       static_cast<unsigned>(date.day()),
+                       clock.hours().count(),
+                       clock.minutes().count(),
+                       clock.seconds().count());
+}
+
+[[nodiscard]] std::string format_range(const CliOptions& options) {
+    return std::format("{} .. {}",
+                       options.fromMs ? format_utc(*options.fromMs) : std::string("start"),
+                       options.toMs ? format_utc(*options.toMs) : std::string("end"));
+}
+
+} // namespace
+
+HandlePrinter::HandlePrinter(std::vector<Column> columns)
+    : m_columns(std::move(columns)) {}
 
 void HandlePrinter::print_count_only(const CliOptions& options,
                                      const std::size_t total_raw_count,
@@ -19,8 +111,18 @@ void HandlePrinter::print_count_only(const CliOptions& options,
 }
 
 void HandlePrinter::print_results(const std::vector<HandleInfo>& handles,
+                                  const StringInterner& strings,
                                   const CliOptions& options,
                                   const std::size_t total_raw_count) const {
+    print_preamble(options, total_raw_count);
+    print_header();
+    for (const HandleInfo& handle : handles) {
+        print_row(handle, strings);
+    }
+    print_footer(handles.size());
+}
+
+void HandlePrinter::print_preamble(const CliOptions& options, const std::size_t total_raw_count) const {
     if (options.verbose) {
         std::cout << "Verbose mode is ON\n";
     }
@@ -30,29 +132,410 @@ void HandlePrinter::print_results(const std::vector<HandleInfo>& handles,
     }
 
     std::cout << std::format("Retrieved {} system handles.\n", total_raw_count);
+}
 
-    std::cout << std::format("{:<8} {:<15} {:<10} {:<24} {}\n", "PID", "Process", "Handle", "Type", "Name");
-    for (const HandleInfo& handle : handles) {
-        std::cout << std::format("{:<8} {:<15} 0x{:<8X} {:<24} {}\n",
-                                 handle.pid,
-                                 handle.processName,
-                                 handle.handleValue,
-                                 handle.handleType,
-                                 handle.objectName);
+void HandlePrinter::print_footer(const std::size_t matching_count, const std::optional<std::size_t> shown_count) const {
+    if (shown_count && *shown_count < matching_count) {
+        std::cout << std::format("Matching handles: {} (first {} shown)\n", matching_count, *shown_count);
+        return;
     }
+    std::cout << std::format("Matching handles: {}\n", matching_count);
+}
 
-    std::cout << std::format("Matching handles: {}\n", handles.size());
+void HandlePrinter::print_process_counts(const std::vector<ProcessHandleCount>& processes,
+                                         const StringInterner& strings,
+                                         const CliOptions& options,
+                                         const std::size_t total_raw_count,
+                                         const std::size_t matching_count) const {
+    print_count_only(options, total_raw_count, matching_count);
+    std::cout << std::format("Top {} processes by handle count:\n", processes.size());
+    std::cout << std::format("{:<8} {:<24} {:>9}\n", "PID", "Process", "Handles");
+    for (const ProcessHandleCount& process : processes) {
+        std::cout << std::format("{:<8} {:<24} {:>9}\n", process.pid, strings.view(process.processName), process.handleCount);
+    }
+}
+
+void HandlePrinter::print_sample_estimates(const CliOptions& options,
+                                           const std::size_t total_raw_count,
+                                           const std::size_t sampled_count,
+                                           const sampling::Estimate& matching,
+                                           const std::vector<EstimatedGroup>& processes,
+                                           const std::vector<EstimatedGroup>& types,
+                                           const StringInterner& strings) const {
+    print_preamble(options, total_raw_count);
+    std::cout << std::format("Sampled {} handles ({:g}%, {}).\n",
+                             sampled_count, *options.sampleFraction * 100, options.sampleByPid ? "per process" : "uniform");
+    std::cout << std::format("Estimated matching handles: {} (95% CI {} .. {}, {} in sample)\n",
+                             std::llround(matching.value), std::llround(matching.low), std::llround(matching.high),
+                             matching.observed);
+    if (options.showCountOnly) {
+        return;
+    }
+
+    std::cout << std::format("\nTop {} processes by estimated handle count:\n", processes.size());
+    std::cout << std::format("{:<8} {:<24} {:>9}  {}\n", "PID", "Process", "Estimate", "95% CI");
+    for (const EstimatedGroup& process : processes) {
+        std::cout << std::format("{:<8} {:<24} {:>9}  {} .. {}\n", process.pid, strings.view(process.label),
+                                 std::llround(process.estimate), std::llround(process.low), std::llround(process.high));
+    }
+
+    std::cout << std::format("\nTop {} types by estimated handle count:\n", types.size());
+    std::cout << std::format("{:<33} {:>9}  {}\n", "Type", "Estimate", "95% CI");
+    for (const EstimatedGroup& type : types) {
+        std::cout << std::format("{:<33} {:>9}  {} .. {}\n", strings.view(type.label),
+                                 std::llround(type.estimate), std::llround(type.low), std::llround(type.high));
+    }
+}
+
+void HandlePrinter::print_sketch_summary(const CliOptions& options,
+                                         const sketch::SketchSet& sketches,
+                                         const std::optional<std::size_t> total_raw_count,
+                                         const std::size_t added_count) const {
+    if (total_raw_count) {
+        print_preamble(options, *total_raw_count);
+        std::cout << std::format("Added {} matching handles to {}.\n", added_count, options.sketchPath.value_or(""));
+    } else {
+        std::cout << std::format("Merged {} sketch files into {}.\n", options.sketchMergePaths.size(), options.sketchPath.value_or(""));
+    }
+    std::cout << std::format("Sketch covers {} snapshots, {} handles.\n", sketches.snapshots, sketches.handles);
+    std::cout << std::format("Distinct objects: ~{} (+/-{:.1f}%)\n",
+                             std::llround(sketches.objects.estimate()), sketches.objects.relative_error() * 100);
+
+    const std::size_t rows = options.topN.value_or(sketch::kDefaultRows);
+    const auto print_distinct = [](const std::string_view heading, const std::string_view label,
+                                   const std::vector<sketch::LabeledDistinct::Count>& counts) {
+        std::cout << std::format("\nTop {} {} by distinct objects:\n", counts.size(), heading);
+        std::cout << std::format("{:<33} {:>9}\n", label, "Objects");
+        for (const sketch::LabeledDistinct::Count& count : counts) {
+            std::cout << std::format("{:<33} {:>9}\n", count.label, std::llround(count.estimate));
+        }
+    };
+    print_distinct("types", "Type", sketches.objectsByType.largest(rows));
+    print_distinct("processes", "Process", sketches.objectsByProcess.largest(rows));
+
+    const std::vector<sketch::HeavyHitters::Entry> names = sketches.names.top();
+    const std::size_t shown = std::min(rows, names.size());
+    std::cout << std::format("\nTop {} object names by handle count (upper bounds):\n", shown);
+    std::cout << std::format("{:>9}  {}\n", "Handles", "Name");
+    for (std::size_t i = 0; i < shown; ++i) {
+        std::cout << std::format("{:>9}  {}\n", names[i].count, names[i].key);
+    }
+}
+
+void HandlePrinter::print_completeness(const progressive::Completeness& completeness,
+                                       const progressive::FieldSet& needed,
+                                       const std::chrono::nanoseconds budget,
+                                       const std::chrono::nanoseconds elapsed,
+                                       const std::size_t lookups_left) const {
+    const auto seconds = [](const std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double>(duration).count();
+    };
+    if (lookups_left == 0) {
+        std::cout << std::format("Deadline: {:.2f} s, finished in {:.2f} s\n", seconds(budget), seconds(elapsed));
+    } else {
+        std::cout << std::format("Deadline: {:.2f} s, stopped after {:.2f} s with {} lookups not started\n",
+                                 seconds(budget), seconds(elapsed), lookups_left);
+    }
+    std::cout << std::format("Complete rows: {} of {} ({:.1f}% of fields resolved)\n",
+                             completeness.completeRows, completeness.rows, completeness.fraction() * 100);
+    for (std::size_t field = 0; field < progressive::kFieldCount; ++field) {
+        if (needed[field]) {
+            std::cout << std::format("  {:<14} {} of {}\n", progressive::field_name(static_cast<progressive::Field>(field)),
+                                     completeness.resolved[field], completeness.needed[field]);
+        }
+    }
+}
+
+void HandlePrinter::print_latency(const CliOptions& options,
+                                  const std::vector<latency::CallSummary>& calls,
+                                  const std::vector<latency::SlowCall>& slow_calls,
+                                  const std::size_t dropped_slow_calls,
+                                  const std::function<std::string_view(uint32_t type_index)>& type_name,
+                                  const std::function<std::string_view(uint32_t pid)>& process_name) const {
+    const auto us = [](const std::uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1000.0; };
+    const auto type_label = [&](const uint32_t type_index) {
+        if (type_index == latency::kNoType) {
+            return std::string("-");
+        }
+        const std::string_view name = type_name(type_index);
+        return name.empty() ? std::to_string(type_index) : std::format("{} {}", type_index, name);
+    };
+
+    if (options.latencyReport) {
+        std::cout << "\nNT call latency (us):\n";
+        std::cout << std::format("{:<14} {:>9} {:>10} {:>10} {:>10} {:>10}\n", "Call", "Count", "p50", "p90", "p99", "Max");
+        for (const latency::CallSummary& call : calls) {
+            std::cout << std::format("{:<14} {:>9} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n", latency::call_name(call.call),
+                                     call.count, us(call.p50), us(call.p90), us(call.p99), us(call.max));
+        }
+
+        for (const latency::CallSummary& call : calls) {
+            const auto print_keyed = [&](const std::string_view dimension, const std::vector<latency::KeyedSummary>& keyed,
+                                         const auto& label) {
+                if (keyed.empty()) {
+                    return;
+                }
+                std::cout << std::format("\nSlowest {} for {} by p99 (us):\n", dimension, latency::call_name(call.call));
+                std::cout << std::format("{:<33} {:>9} {:>10} {:>10} {:>10}\n",
+                                         dimension == "types" ? "Type" : "Process", "Count", "p50", "p99", "Max");
+                for (const latency::KeyedSummary& entry : keyed) {
+                    std::cout << std::format("{:<33} {:>9} {:>10.1f} {:>10.1f} {:>10.1f}\n", label(entry.key), entry.count,
+                                             us(entry.p50), us(entry.p99), us(entry.max));
+                }
+            };
+            print_keyed("types", call.byType, type_label);
+            print_keyed("processes", call.byProcess, [&](const uint32_t pid) { return std::format("{} {}", pid, process_name(pid)); });
+        }
+    }
+
+    if (!options.slowLogMs) {
+        return;
+    }
+    std::cout << std::format("\nSlow NT calls (>= {} ms): {}\n", *options.slowLogMs, slow_calls.size() + dropped_slow_calls);
+    if (!slow_calls.empty()) {
+        std::cout << std::format("{:<14} {:<8} {:<24} {:<24} {:<10} {:<10} {:>10}\n",
+                                 "Call", "PID", "Process", "Type", "Access", "Handle", "ms");
+    }
+    for (const latency::SlowCall& slow : slow_calls) {
+        std::cout << std::format("{:<14} {:<8} {:<24} {:<24} 0x{:08X} 0x{:<8X} {:>10.1f}{}\n",
+                                 latency::call_name(slow.call), slow.pid, process_name(slow.pid), type_label(slow.typeIndex),
+                                 slow.grantedAccess, slow.handleValue, static_cast<double>(slow.nanoseconds) / 1e6,
+                                 slow.timedOut ? "  timed out" : "");
+    }
+    if (dropped_slow_calls != 0) {
+        std::cout << std::format("({} more not kept)\n", dropped_slow_calls);
+    }
+}
+
+void HandlePrinter::print_allocations(const std::array<alloc::Counts, alloc::kStageCount>& counts,
+                                      const std::size_t snapshot_handles,
+                                      const std::size_t mapped_rows) const {
+    const auto per = [](const std::uint64_t value, const std::size_t items) {
+        return items == 0 ? 0.0 : static_cast<double>(value) / static_cast<double>(items);
+    };
+
+    std::cout << std::format("\nHeap allocations ({} handles in snapshot, {} rows mapped):\n", snapshot_handles, mapped_rows);
+    std::cout << std::format("{:<9} {:>12} {:>14} {:>12}  {:<7} {:>10} {:>10}\n",
+                             "Stage", "Allocations", "Bytes", "Frees", "Per", "Allocs", "Bytes");
+    alloc::Counts total;
+    // Pipeline order, with allocations outside any stage last.
+    for (const alloc::Stage stage : {alloc::Stage::Acquire, alloc::Stage::Filter, alloc::Stage::Map,
+                                     alloc::Stage::Sort, alloc::Stage::Print, alloc::Stage::Other}) {
+        const alloc::Counts& stage_counts = counts[static_cast<std::size_t>(stage)];
+        const bool per_row = stage == alloc::Stage::Map || stage == alloc::Stage::Sort || stage == alloc::Stage::Print;
+        const std::size_t items = per_row ? mapped_rows : snapshot_handles;
+        std::cout << std::format("{:<9} {:>12} {:>14} {:>12}  {:<7} {:>10.2f} {:>10.1f}\n",
+                                 alloc::stage_name(stage), stage_counts.allocations, stage_counts.bytes, stage_counts.frees,
+                                 per_row ? "row" : "handle", per(stage_counts.allocations, items),
+                                 per(stage_counts.bytes, items));
+        total.allocations += stage_counts.allocations;
+        total.bytes += stage_counts.bytes;
+        total.frees += stage_counts.frees;
+    }
+    std::cout << std::format("{:<9} {:>12} {:>14} {:>12}  {:<7} {:>10.2f} {:>10.1f}\n", "total", total.allocations,
+                             total.bytes, total.frees, "handle", per(total.allocations, snapshot_handles),
+                             per(total.bytes, snapshot_handles));
+}
+
+void HandlePrinter::print_shared_objects(const std::vector<SharedObjectInfo>& objects,
+                                         const StringInterner& strings,
+                                         const CliOptions& options,
+                                         const std::size_t total_raw_count) const {
+    if (options.verbose) {
+        std::cout << "Verbose mode is ON\n";
+    }
+
+    std::cout << std::format("Retrieved {} system handles.\n", total_raw_count);
+
+    // Holders always show who owns the handle; type and name belong to the object.
+    const HandlePrinter holders({Column::Pid, Column::Process, Column::Handle, Column::Access});
+    for (const SharedObjectInfo& object : objects) {
+        std::cout << std::format("\nObject 0x{:X}  {}  {}  ({} processes, {} handles)\n",
+                                 object.objectAddress,
+                                 strings.view(object.handleType),
+                                 strings.view(object.objectName),
+                                 object.processCount,
+                                 object.holders.size());
+        std::cout << "    " << holders.format_header();
+        for (const HandleInfo& holder : object.holders) {
+            std::cout << "    " << holders.format_row(holder, strings);
+        }
+    }
+
+    std::cout << std::format("\nShared objects: {}\n", objects.size());
+}
+
+void HandlePrinter::print_record_summary(const CliOptions& options,
+                                         const history::AppendStats& stats,
+                                         const std::size_t recorded_count,
+                                         const std::size_t total_raw_count) const {
+    if (options.verbose) {
+        std::cout << "Verbose mode is ON\n";
+    }
+
+    std::cout << std::format("Retrieved {} system handles.\n", total_raw_count);
+    std::cout << std::format("Recorded {} handles to {}: {} (+{} -{}, {} bytes)\n",
+                             recorded_count,
+                             options.recordPath.value_or(""),
+                             stats.kind == history::FrameKind::Keyframe ? "keyframe" : "delta",
+                             stats.opened,
+                             stats.closed,
+                             stats.bytes);
+}
+
+void HandlePrinter::print_history_frames(const std::vector<history::FrameInfo>& frames, const CliOptions& options) const {
+    std::cout << std::format("History frames ({}):\n", format_range(options));
+    std::cout << std::format("{:<20} {:<9} {:>9} {:>8} {:>8} {:>10}\n", "Time (UTC)", "Kind", "Handles", "Opened", "Closed", "Bytes");
+
+    std::size_t shown = 0;
+    for (const history::FrameInfo& frame : frames) {
+        if ((options.fromMs && frame.timestampMs < *options.fromMs) || (options.toMs && frame.timestampMs > *options.toMs)) {
+            continue;
+        }
+        std::cout << std::format("{:<20} {:<9} {:>9} {:>8} {:>8} {:>10}\n",
+                                 format_utc(frame.timestampMs),
+                                 frame.kind == history::FrameKind::Keyframe ? "keyframe" : "delta",
+                                 frame.handleCount,
+                                 frame.opened,
+                                 frame.closed,
+                                 frame.payloadSize);
+        ++shown;
+    }
+
+    std::cout << std::format("Frames: {} of {}\n", shown, frames.size());
+}
+
+void HandlePrinter::print_held_intervals(const std::vector<HeldInterval>& intervals,
+                                         const StringInterner& strings,
+                                         const CliOptions& options) const {
+    std::cout << std::format("Holders of 0x{:X} ({}):\n", options.heldAddress.value_or(0), format_range(options));
+
+    const HandlePrinter holders({Column::Pid, Column::Process, Column::Handle, Column::Access, Column::Type, Column::Name});
+    std::cout << std::format("{:<20} {:<20} ", "First seen (UTC)", "Last seen (UTC)") << holders.format_header();
+    for (const HeldInterval& interval : intervals) {
+        std::cout << std::format("{:<20} {:<20} ", format_utc(interval.firstSeenMs), format_utc(interval.lastSeenMs))
+                  << holders.format_row(interval.handle, strings);
+    }
+
+    std::cout << std::format("Holding handles: {}\n", intervals.size());
+}
+
+void HandlePrinter::print_export_summary(const CliOptions& options,
+                                         const std::string_view host,
+                                         const std::size_t exported_count,
+                                         const std::size_t total_raw_count,
+                                         const std::uint64_t bytes) const {
+    if (options.verbose) {
+        std::cout << "Verbose mode is ON\n";
+    }
+
+    std::cout << std::format("Retrieved {} system handles.\n", total_raw_count);
+    std::cout << std::format("Exported {} handles to {} (host {}, sorted by {}, {} bytes)\n", exported_count,
+                             options.exportPath.value_or(""), host, sort_label(options.sortBy), bytes);
+}
+
+void HandlePrinter::print_merge_preamble(const std::size_t file_count, const SortField sort_by) const {
+    std::cout << std::format("Merging {} snapshot files sorted by {}.\n", file_count, sort_label(sort_by));
+}
+
+void HandlePrinter::print_merge_header() const {
+    std::string line("Host");
+    append_cell(line, 0, kHostWidth, false);
+    std::cout << line << format_header();
+}
+
+std::string HandlePrinter::format_merged_row(const std::string_view host, const fleet::Row& row) const {
+    const HandleInfo numbers{
+        .pid = row.pid,
+        .grantedAccess = row.grantedAccess,
+        .objectAddress = static_cast<std::uintptr_t>(row.objectAddress),
+        .handleValue = static_cast<std::uintptr_t>(row.handleValue)};
+    return format_cells(host.empty() ? "-" : host, numbers, row.processName, row.handleType, row.objectName);
+}
+
+void HandlePrinter::print_merge_count_header(const SortField sort_by) const {
+    const std::string_view key = sort_by == SortField::Pid ? "PID" : (sort_by == SortField::Type ? "Type" : "Name");
+    std::cout << std::format("{:<12} {:<8} {}\n", "Handles", "Hosts", key);
+}
+
+std::string HandlePrinter::format_merge_count(const SortField sort_by,
+                                              const fleet::Row& key,
+                                              const std::size_t handle_count,
+                                              const std::size_t host_count) const {
+    std::string line;
+    switch (sort_by) {
+    case SortField::Pid: line = std::format("{:<12} {:<8} {}\n", handle_count, host_count, key.pid); break;
+    case SortField::Type: line = std::format("{:<12} {:<8} {}\n", handle_count, host_count, key.handleType); break;
+    case SortField::Name: line = std::format("{:<12} {:<8} {}\n", handle_count, host_count, key.objectName); break;
+    }
+    return line;
 }
 
 void HandlePrinter::print_header() const {
-    std::cout << std::format("{:<8} {:<15} {:<10} {:<24} {}\n", "PID", "Process", "Handle", "Type", "Name");
+    std::cout << format_header();
+}
+
+void HandlePrinter::print_row(const HandleInfo& handle, const StringInterner& strings) const {
+    std::cout << format_row(handle, strings);
+}
+
+std::string HandlePrinter::format_header() const {
+    std::string line;
+    for (std::size_t i = 0; i < m_columns.size(); ++i) {
+        const ColumnLayout layout = layout_of(m_columns[i]);
+        const std::size_t start = line.size();
+        line.append(layout.header);
+        append_cell(line, start, layout.width, i + 1 == m_columns.size());
+    }
+    line.push_back('\n');
+    return line;
+}
+
+std::string HandlePrinter::format_row(const HandleInfo& handle, const StringInterner& strings) const {
+    return format_cells({}, handle, strings.view(handle.processName), strings.view(handle.handleType),
+                        strings.view(handle.objectName));
 }
 
-void HandlePrinter::print_row(const HandleInfo& handle) const {
-    std::cout << std::format("{:<8} {:<15} 0x{:<8X} {:<24} {}\n",
-                             handle.pid,
-                             handle.processName,
-                             handle.handleValue,
-                             handle.handleType,
-                             handle.objectName);
+std::string HandlePrinter::format_cells(const std::string_view host,
+                                        const HandleInfo& handle,
+                                        const std::string_view process,
+                                        const std::string_view type,
+                                        const std::string_view name) const {
+    // Reserved up front so the row costs one allocation, not one per growth
+    // step; a number is at most 18 characters ("0x" and 16 hex digits).
+    std::size_t capacity = 1;
+    if (!host.empty()) {
+        capacity += std::max(host.size(), kHostWidth) + 1;
+    }
+    for (const Column column : m_columns) {
+        std::size_t text = 18;
+        switch (column) {
+        case Column::Process: text = process.size(); break;
+        case Column::Type: text = type.size(); break;
+        case Column::Name: text = name.size(); break;
+        default: break;
+        }
+        capacity += std::max(text, layout_of(column).width) + 1;
+    }
+    std::string line;
+    line.reserve(capacity);
+    if (!host.empty()) {
+        line.append(host);
+        append_cell(line, 0, kHostWidth, false);
+    }
+    for (std::size_t i = 0; i < m_columns.size(); ++i) {
+        const std::size_t start = line.size();
+        switch (m_columns[i]) {
+        case Column::Pid: append_number(line, handle.pid, false); break;
+        case Column::Process: line.append(process); break;
+        case Column::Handle: append_number(line, handle.handleValue, true); break;
+        case Column::Type: line.append(type); break;
+        case Column::Name: line.append(name); break;
+        case Column::Access: append_number(line, handle.grantedAccess, true); break;
+        case Column::Address: append_number(line, handle.objectAddress, true); break;
+        }
+        append_cell(line, start, layout_of(m_columns[i]).width, i + 1 == m_columns.size());
+    }
+    line.push_back('\n');
+    return line;
 }
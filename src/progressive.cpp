@@ -0,0 +1,106 @@
+#include "progressive.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace progressive {
+
+namespace {
+
+// Rows sharing one key (pid or type index), in order of first appearance.
+struct Group {
+    std::size_t firstRow = 0;
+    std::size_t rows = 0;
+};
+
+template <typename Key>
+void append_groups(std::vector<Lookup>& lookups, const Field field, const std::unordered_map<Key, Group>& groups) {
+    std::vector<Group> ordered;
+    ordered.reserve(groups.size());
+    for (const auto& [key, group] : groups) {
+        ordered.push_back(group);
+    }
+    // Largest first; ties by first row so the plan does not depend on hashing.
+    std::ranges::sort(ordered, [](const Group& left, const Group& right) {
+        if (left.rows != right.rows) {
+            return left.rows > right.rows;
+        }
+        return left.firstRow < right.firstRow;
+    });
+    for (const Group& group : ordered) {
+        lookups.push_back(Lookup{.field = field, .row = group.firstRow});
+    }
+}
+
+} // namespace
+
+std::string_view field_name(const Field field) noexcept {
+    switch (field) {
+    case Field::ProcessName: return "process names";
+    case Field::HandleType: return "types";
+    case Field::ObjectName: return "object names";
+    }
+    return "fields";
+}
+
+std::vector<Lookup> plan(const std::span<const HandleInfo> rows, const StringId unresolved) {
+    std::unordered_map<std::uint32_t, Group> processes;
+    std::unordered_map<std::uint16_t, Group> types;
+    std::size_t names = 0;
+    for (std::size_t index = 0; index < rows.size(); ++index) {
+        const HandleInfo& row = rows[index];
+        if (row.processName == unresolved) {
+            const auto [it, added] = processes.try_emplace(row.pid, Group{.firstRow = index, .rows = 0});
+            ++it->second.rows;
+        }
+        if (row.handleType == unresolved) {
+            const auto [it, added] = types.try_emplace(row.objectTypeIndex, Group{.firstRow = index, .rows = 0});
+            ++it->second.rows;
+        }
+        names += row.objectName == unresolved ? 1 : 0;
+    }
+
+    std::vector<Lookup> lookups;
+    lookups.reserve(processes.size() + types.size() + names);
+    append_groups(lookups, Field::ProcessName, processes);
+    append_groups(lookups, Field::HandleType, types);
+    for (std::size_t index = 0; index < rows.size(); ++index) {
+        if (rows[index].objectName == unresolved) {
+            lookups.push_back(Lookup{.field = Field::ObjectName, .row = index});
+        }
+    }
+    return lookups;
+}
+
+double Completeness::fraction() const noexcept {
+    std::size_t total_needed = 0;
+    std::size_t total_resolved = 0;
+    for (std::size_t field = 0; field < kFieldCount; ++field) {
+        total_needed += needed[field];
+        total_resolved += resolved[field];
+    }
+    return total_needed == 0 ? 1.0 : static_cast<double>(total_resolved) / static_cast<double>(total_needed);
+}
+
+Completeness measure(const std::span<const HandleInfo> rows, const FieldSet needed, const StringId unresolved) {
+    Completeness completeness{.rows = rows.size()};
+    for (const HandleInfo& row : rows) {
+        const std::array<StringId, kFieldCount> values{row.processName, row.handleType, row.objectName};
+        bool complete = true;
+        for (std::size_t field = 0; field < kFieldCount; ++field) {
+            if (!needed[field]) {
+                continue;
+            }
+            ++completeness.needed[field];
+            if (values[field] == unresolved) {
+                complete = false;
+            } else {
+                ++completeness.resolved[field];
+            }
+        }
+        completeness.completeRows += complete ? 1 : 0;
+    }
+    return completeness;
+}
+
+} // namespace progressive
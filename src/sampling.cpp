@@ -0,0 +1,141 @@
+#include "sampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace sampling {
+
+namespace {
+
+[[nodiscard]] std::uint32_t narrow_pid(const std::uintptr_t pid) {
+    return static_cast<std::uint32_t>(std::min<std::uintptr_t>(pid, std::numeric_limits<std::uint32_t>::max()));
+}
+
+[[nodiscard]] std::size_t sample_size(const std::size_t population, const double fraction) {
+    if (population == 0) {
+        return 0;
+    }
+    const auto wanted = static_cast<std::size_t>(std::llround(fraction * static_cast<double>(population)));
+    return std::clamp<std::size_t>(wanted, 1, population);
+}
+
+} // namespace
+
+std::uint32_t Sample::stratum_of(const nt::RawHandle& handle) const {
+    if (strategy == Strategy::Uniform) {
+        return 0;
+    }
+    return pidStrata.at(narrow_pid(handle.processId));
+}
+
+Sample draw(const std::span<const nt::RawHandle> handles, const double fraction, const Strategy strategy, const std::uint64_t seed) {
+    Sample sample;
+    sample.population = handles.size();
+    sample.strategy = strategy;
+
+    // Pass 1: stratum sizes. The table is grouped by process, so the last
+    // lookup is reused across a process's run of handles.
+    std::vector<std::uint32_t> stratum_of_handle;
+    if (strategy == Strategy::Uniform) {
+        sample.strata.push_back(Stratum{.population = handles.size()});
+    } else {
+        stratum_of_handle.resize(handles.size());
+        std::uint32_t last_pid = 0;
+        std::uint32_t last_stratum = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t i = 0; i < handles.size(); ++i) {
+            const std::uint32_t pid = narrow_pid(handles[i].processId);
+            if (pid != last_pid || last_stratum == std::numeric_limits<std::uint32_t>::max()) {
+                const auto [it, inserted] = sample.pidStrata.try_emplace(pid, static_cast<std::uint32_t>(sample.strata.size()));
+                if (inserted) {
+                    sample.strata.emplace_back();
+                }
+                last_pid = pid;
+                last_stratum = it->second;
+            }
+            stratum_of_handle[i] = last_stratum;
+            ++sample.strata[last_stratum].population;
+        }
+    }
+
+    // Pass 2: selection sampling (Knuth's algorithm S) within every stratum:
+    // take a handle with probability still-needed / still-remaining.
+    std::vector<std::size_t> needed(sample.strata.size());
+    std::vector<std::size_t> remaining(sample.strata.size());
+    std::size_t total_needed = 0;
+    for (std::size_t s = 0; s < sample.strata.size(); ++s) {
+        Stratum& stratum = sample.strata[s];
+        stratum.sampled = sample_size(stratum.population, fraction);
+        needed[s] = stratum.sampled;
+        remaining[s] = stratum.population;
+        total_needed += stratum.sampled;
+    }
+
+    std::mt19937_64 rng(seed);
+    sample.handles.reserve(total_needed);
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        const std::uint32_t s = stratum_of_handle.empty() ? 0 : stratum_of_handle[i];
+        if (needed[s] > 0 && std::uniform_int_distribution<std::size_t>(0, remaining[s] - 1)(rng) < needed[s]) {
+            sample.handles.push_back(handles[i]);
+            --needed[s];
+        }
+        --remaining[s];
+    }
+    return sample;
+}
+
+void Estimator::add(const nt::RawHandle& handle, const std::uint64_t group) {
+    ++m_hits[group][m_sample.stratum_of(handle)];
+}
+
+Estimate Estimator::estimate(const std::uint64_t group, const double z) const {
+    Estimate estimate;
+    double variance = 0;
+    // Unsampled handles that could still belong to the group.
+    double unseen = 0;
+    const auto add_stratum = [&](const std::size_t stratum_index, const std::size_t hits) {
+        const Stratum& stratum = m_sample.strata[stratum_index];
+        const auto population = static_cast<double>(stratum.population);
+        const auto sampled = static_cast<double>(stratum.sampled);
+        estimate.value += population / sampled * static_cast<double>(hits);
+        estimate.observed += hits;
+
+        // Agresti-Coull: pretend z^2 extra draws, half of them hits.
+        const double adjusted = (static_cast<double>(hits) + z * z / 2) / (sampled + z * z);
+        const double spread = stratum.sampled < 2 ? 0.25 : adjusted * (1 - adjusted) * sampled / (sampled - 1);
+        variance += population * population * (1 - sampled / population) * spread / sampled;
+    };
+
+    const auto group_it = m_hits.find(group);
+    for (std::size_t s = 0; s < m_sample.strata.size(); ++s) {
+        const Stratum& stratum = m_sample.strata[s];
+        if (stratum.population == 0) {
+            continue;
+        }
+        unseen += static_cast<double>(stratum.population - stratum.sampled);
+        if (group_it == m_hits.end()) {
+            // Never seen: every stratum bounds how many it could still have.
+            add_stratum(s, 0);
+        } else if (const auto hits = group_it->second.find(static_cast<std::uint32_t>(s)); hits != group_it->second.end()) {
+            add_stratum(s, hits->second);
+        }
+    }
+
+    const double margin = z * std::sqrt(variance);
+    const auto observed = static_cast<double>(estimate.observed);
+    estimate.low = std::max(estimate.value - margin, observed);
+    estimate.high = std::min(estimate.value + margin, observed + unseen);
+    return estimate;
+}
+
+std::vector<std::uint64_t> Estimator::groups() const {
+    std::vector<std::uint64_t> groups;
+    groups.reserve(m_hits.size());
+    for (const auto& entry : m_hits) {
+        groups.push_back(entry.first);
+    }
+    return groups;
+}
+
+} // namespace sampling
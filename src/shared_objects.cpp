@@ -0,0 +1,223 @@
+#include "shared_objects.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace shared_objects {
+
+namespace {
+
+constexpr std::uint32_t kNoGroup = std::numeric_limits<std::uint32_t>::max();
+
+// Open-addressing slot; kept to 16 bytes so probing stays cache friendly.
+struct Slot {
+    std::uintptr_t address = 0;
+    std::uint32_t group = 0;
+};
+
+// A handle routed to its hash partition.
+struct Routed {
+    std::uintptr_t address = 0;
+    std::uint32_t index = 0;
+};
+
+// Per-address state within one partition.
+struct GroupState {
+    std::uint32_t handleCount = 0;
+    // Times the owning pid changed along the group: an upper bound on the
+    // number of distinct processes, exact when a process's handles are adjacent.
+    std::uint32_t pidRuns = 0;
+    std::uintptr_t lastPid = 0;
+    // Write cursor into Report::handles while placing, kNoGroup if not a candidate.
+    std::size_t cursor = kNoGroup;
+};
+
+// Handles per partition we aim for; keeps a partition's slots (and states)
+// within L2 so the build phase does not miss on every probe.
+constexpr std::size_t kPartitionTarget = 8 * 1024;
+constexpr int kMaxPartitionBits = 12;
+
+// Kernel object addresses are aligned, so mix the high bits down (Fibonacci hashing).
+[[nodiscard]] std::uint64_t hash_of(const std::uintptr_t address) noexcept {
+    return static_cast<std::uint64_t>(address) * 0x9E3779B97F4A7C15ULL;
+}
+
+// Small chains (the common case) are counted without sorting.
+[[nodiscard]] std::size_t count_distinct_pids(const std::span<const nt::RawHandle> holders,
+                                              std::vector<std::uintptr_t>& scratch) {
+    constexpr std::size_t kQuadraticLimit = 16;
+    if (holders.size() <= kQuadraticLimit) {
+        std::size_t distinct = 0;
+        for (std::size_t i = 0; i < holders.size(); ++i) {
+            bool seen = false;
+            for (std::size_t j = 0; j < i && !seen; ++j) {
+                seen = holders[j].processId == holders[i].processId;
+            }
+            distinct += seen ? 0 : 1;
+        }
+        return distinct;
+    }
+
+    scratch.clear();
+    for (const nt::RawHandle& holder : holders) {
+        scratch.push_back(holder.processId);
+    }
+    std::ranges::sort(scratch);
+    return static_cast<std::size_t>(std::ranges::distance(scratch.begin(), std::ranges::unique(scratch).begin()));
+}
+
+} // namespace
+
+std::span<const nt::RawHandle> Report::holders(const Group& group) const noexcept {
+    return std::span<const nt::RawHandle>(handles).subspan(group.firstHandle, group.handleCount);
+}
+
+Report find(const std::span<const nt::RawHandle> handles, const std::size_t min_processes, const std::size_t max_groups) {
+    Report report;
+    if (handles.empty()) {
+        return report;
+    }
+
+    // Pass 1: route handles into hash partitions (top hash bits) so every
+    // address lands in exactly one partition, in input order.
+    const int partition_bits = std::min(
+        kMaxPartitionBits, static_cast<int>(std::bit_width(handles.size() / kPartitionTarget)));
+    const std::size_t partitions = std::size_t{1} << partition_bits;
+    const auto partition_of = [partition_bits](const std::uintptr_t address) -> std::size_t {
+        return partition_bits == 0 ? 0 : static_cast<std::size_t>(hash_of(address) >> (64 - partition_bits));
+    };
+
+    std::vector<std::size_t> offsets(partitions + 1, 0);
+    for (const nt::RawHandle& handle : handles) {
+        if (handle.objectAddress != 0) {
+            ++offsets[partition_of(handle.objectAddress) + 1];
+        }
+    }
+    for (std::size_t partition = 0; partition < partitions; ++partition) {
+        offsets[partition + 1] += offsets[partition];
+    }
+
+    std::vector<Routed> routed(offsets.back());
+    {
+        std::vector<std::size_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (std::uint32_t index = 0; index < handles.size(); ++index) {
+            const std::uintptr_t address = handles[index].objectAddress;
+            if (address != 0) {
+                routed[cursors[partition_of(address)]++] = Routed{.address = address, .index = index};
+            }
+        }
+    }
+
+    // Pass 2, per partition: group by address in a cache-sized table, place
+    // candidate groups contiguously and count their processes exactly.
+    // Upper bound on the output, so placement never reallocates.
+    report.handles.reserve(routed.size());
+    std::vector<Slot> slots;
+    std::vector<GroupState> states;
+    std::vector<std::uint32_t> group_of;
+    std::vector<std::uintptr_t> scratch;
+
+    for (std::size_t partition = 0; partition < partitions; ++partition) {
+        const auto part = std::span<const Routed>(routed).subspan(offsets[partition], offsets[partition + 1] - offsets[partition]);
+        if (part.empty()) {
+            continue;
+        }
+
+        const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(part.size() * 2, 16));
+        const int shift = 64 - std::countr_zero(capacity);
+        const std::size_t mask = capacity - 1;
+        slots.assign(capacity, Slot{});
+        states.clear();
+        group_of.resize(part.size());
+
+        for (std::size_t i = 0; i < part.size(); ++i) {
+            const std::uintptr_t address = part[i].address;
+            std::size_t position = static_cast<std::size_t>(hash_of(address) << partition_bits >> shift);
+            while (slots[position].address != 0 && slots[position].address != address) {
+                position = (position + 1) & mask;
+            }
+            if (slots[position].address == 0) {
+                slots[position] = Slot{.address = address, .group = static_cast<std::uint32_t>(states.size())};
+                states.emplace_back();
+            }
+
+            const std::uint32_t group = slots[position].group;
+            GroupState& state = states[group];
+            const std::uintptr_t pid = handles[part[i].index].processId;
+            if (state.handleCount == 0 || state.lastPid != pid) {
+                ++state.pidRuns;
+                state.lastPid = pid;
+            }
+            ++state.handleCount;
+            group_of[i] = group;
+        }
+
+        // Counting-sort placement of candidate groups; routing kept input
+        // order, so each group's handles stay in input order.
+        const std::size_t base = report.handles.size();
+        std::size_t candidate_handles = 0;
+        for (GroupState& state : states) {
+            if (state.pidRuns >= min_processes) {
+                state.cursor = base + candidate_handles;
+                candidate_handles += state.handleCount;
+            }
+        }
+        if (candidate_handles == 0) {
+            continue;
+        }
+
+        report.handles.resize(base + candidate_handles);
+        for (std::size_t i = 0; i < part.size(); ++i) {
+            GroupState& state = states[group_of[i]];
+            if (state.cursor != kNoGroup) {
+                report.handles[state.cursor++] = handles[part[i].index];
+            }
+        }
+
+        // Groups that fall short on exact counting are compacted away.
+        std::size_t read = base;
+        std::size_t write = base;
+        for (const GroupState& state : states) {
+            if (state.cursor == kNoGroup) {
+                continue;
+            }
+
+            const auto holders = std::span<const nt::RawHandle>(report.handles).subspan(read, state.handleCount);
+            read += state.handleCount;
+            const std::size_t process_count = count_distinct_pids(holders, scratch);
+            if (process_count < min_processes) {
+                continue;
+            }
+
+            report.groups.push_back(Group{
+                .objectAddress = holders.front().objectAddress,
+                .objectTypeIndex = holders.front().objectTypeIndex,
+                .processCount = process_count,
+                .firstHandle = write,
+                .handleCount = holders.size()
+            });
+            std::ranges::copy(holders, report.handles.begin() + static_cast<std::ptrdiff_t>(write));
+            write += holders.size();
+        }
+        report.handles.resize(write);
+    }
+
+    const auto widest_first = [](const Group& left, const Group& right) {
+        if (left.processCount != right.processCount) {
+            return left.processCount > right.processCount;
+        }
+        if (left.handleCount != right.handleCount) {
+            return left.handleCount > right.handleCount;
+        }
+        return left.objectAddress < right.objectAddress;
+    };
+    // Dropped groups keep their handles in Report::handles; holders() only
+    // ever reads the kept groups' ranges.
+    const std::size_t kept = std::min(max_groups, report.groups.size());
+    std::ranges::partial_sort(report.groups, report.groups.begin() + static_cast<std::ptrdiff_t>(kept), widest_first);
+    report.groups.resize(kept);
+    return report;
+}
+
+} // namespace shared_objects
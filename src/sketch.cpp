@@ -0,0 +1,537 @@
+#include "sketch.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+// Sketch file layout:
+//   header:  "HNDLSKCH" fixed32(version)
+//   body:    varint(snapshots) varint(handles) hll(objects)
+//            labeled(objectsByType) labeled(objectsByProcess) heavy(names)
+//   hll:     u8(precision) varint(encoding) then either the raw registers or
+//            varint(count) and count x (varint(index delta) u8(rank))
+//   labeled: varint(max labels) u8(precision) varint(count) count x (string(label) hll)
+//   cms:     varint(width) varint(depth) varint(total) width*depth x varint(counter)
+//   heavy:   varint(capacity) cms varint(count) count x string(key)
+// Candidate counts are not stored; they are re-estimated from the sketch.
+
+namespace sketch {
+
+namespace {
+
+constexpr std::string_view kMagic = "HNDLSKCH";
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint8_t kMinPrecision = 4;
+constexpr std::uint8_t kMaxPrecision = 18;
+// Upper bound on counters accepted from a file (128 MiB of uint64).
+constexpr std::size_t kMaxCells = std::size_t{1} << 24;
+
+enum class RegisterEncoding : std::uint64_t { Dense = 0, Sparse = 1 };
+
+// MurmurHash3's 64-bit finalizer: full avalanche, so the top bits HyperLogLog
+// indexes by are as good as the low ones.
+[[nodiscard]] constexpr std::uint64_t fmix64(std::uint64_t value) noexcept {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+} // namespace
+
+std::uint64_t hash_bytes(const std::string_view bytes) noexcept {
+    // FNV-1a, then the finalizer to spread FNV's weak high bits.
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (const char ch : bytes) {
+        hash ^= static_cast<std::uint8_t>(ch);
+        hash *= 0x100000001B3ull;
+    }
+    return fmix64(hash ^ bytes.size());
+}
+
+std::uint64_t hash_u64(const std::uint64_t value) noexcept {
+    return fmix64(value + 0x9E3779B97F4A7C15ull);
+}
+
+// ---------------------------------------------------------------------------
+// HyperLogLog
+// ---------------------------------------------------------------------------
+
+HyperLogLog::HyperLogLog(const std::uint8_t precision)
+    : m_precision(std::clamp(precision, kMinPrecision, kMaxPrecision)),
+      m_registers(std::size_t{1} << m_precision, 0) {}
+
+void HyperLogLog::add_hash(const std::uint64_t hash) noexcept {
+    const std::size_t index = hash >> (64 - m_precision);
+    // Rank of the first set bit after the index bits; the guard bit caps it.
+    const std::uint64_t rest = (hash << m_precision) | (std::uint64_t{1} << (m_precision - 1));
+    const auto rank = static_cast<std::uint8_t>(std::countl_zero(rest) + 1);
+    m_registers[index] = std::max(m_registers[index], rank);
+}
+
+double HyperLogLog::estimate() const noexcept {
+    const auto registers = static_cast<double>(m_registers.size());
+    double sum = 0;
+    std::size_t zeros = 0;
+    for (const std::uint8_t rank : m_registers) {
+        sum += std::ldexp(1.0, -rank);
+        zeros += rank == 0;
+    }
+
+    const double alpha = m_registers.size() >= 128 ? 0.7213 / (1 + 1.079 / registers)
+                         : m_registers.size() == 64 ? 0.709
+                         : m_registers.size() == 32 ? 0.697
+                                                    : 0.673;
+    const double raw = alpha * registers * registers / sum;
+    // Linear counting is far more accurate while many registers are empty.
+    if (raw <= 2.5 * registers && zeros > 0) {
+        return registers * std::log(registers / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+double HyperLogLog::relative_error() const noexcept {
+    return 1.04 / std::sqrt(static_cast<double>(m_registers.size()));
+}
+
+std::expected<void, std::string> HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.m_precision != m_precision) {
+        return std::unexpected(std::format("cannot merge HyperLogLog sketches of precision {} and {}", m_precision, other.m_precision));
+    }
+    for (std::size_t i = 0; i < m_registers.size(); ++i) {
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+    }
+    return {};
+}
+
+void HyperLogLog::serialize(codec::ByteWriter& out) const {
+    const auto used = static_cast<std::size_t>(std::ranges::count_if(m_registers, [](const std::uint8_t rank) { return rank != 0; }));
+    out.bytes(std::span(&m_precision, 1));
+    // A sparse pair costs about two bytes against one per dense register.
+    if (used * 3 < m_registers.size()) {
+        out.varint(static_cast<std::uint64_t>(RegisterEncoding::Sparse));
+        out.varint(used);
+        std::size_t previous = 0;
+        for (std::size_t i = 0; i < m_registers.size(); ++i) {
+            if (m_registers[i] != 0) {
+                out.varint(i - previous);
+                out.bytes(std::span(&m_registers[i], 1));
+                previous = i;
+            }
+        }
+        return;
+    }
+    out.varint(static_cast<std::uint64_t>(RegisterEncoding::Dense));
+    out.bytes(m_registers);
+}
+
+std::expected<HyperLogLog, std::string> HyperLogLog::deserialize(codec::ByteReader& in) {
+    const std::span<const std::uint8_t> precision = in.bytes(1);
+    if (in.failed() || precision[0] < kMinPrecision || precision[0] > kMaxPrecision) {
+        return std::unexpected(std::string("invalid HyperLogLog precision"));
+    }
+    HyperLogLog sketch(precision[0]);
+    const auto max_rank = static_cast<std::uint8_t>(64 - sketch.m_precision + 1);
+    const std::uint64_t encoding = in.varint();
+    if (encoding == static_cast<std::uint64_t>(RegisterEncoding::Dense)) {
+        const std::span<const std::uint8_t> registers = in.bytes(sketch.m_registers.size());
+        if (in.failed() || std::ranges::any_of(registers, [&](const std::uint8_t rank) { return rank > max_rank; })) {
+            return std::unexpected(std::string("truncated or invalid HyperLogLog registers"));
+        }
+        std::ranges::copy(registers, sketch.m_registers.begin());
+        return sketch;
+    }
+    if (encoding != static_cast<std::uint64_t>(RegisterEncoding::Sparse)) {
+        return std::unexpected(std::string("unknown HyperLogLog encoding"));
+    }
+
+    const std::uint64_t used = in.varint();
+    std::uint64_t index = 0;
+    for (std::uint64_t i = 0; i < used && !in.failed(); ++i) {
+        index += in.varint();
+        const std::span<const std::uint8_t> rank = in.bytes(1);
+        if (in.failed() || index >= sketch.m_registers.size() || rank[0] == 0 || rank[0] > max_rank) {
+            return std::unexpected(std::string("invalid sparse HyperLogLog register"));
+        }
+        sketch.m_registers[index] = rank[0];
+    }
+    if (in.failed()) {
+        return std::unexpected(std::string("truncated HyperLogLog registers"));
+    }
+    return sketch;
+}
+
+// ---------------------------------------------------------------------------
+// CountMin
+// ---------------------------------------------------------------------------
+
+CountMin::CountMin(const std::size_t width, const std::size_t depth)
+    : m_width(std::max<std::size_t>(width, 1)), m_depth(std::max<std::size_t>(depth, 1)), m_counters(m_width * m_depth, 0) {}
+
+std::size_t CountMin::cell(const std::size_t row, const std::uint64_t hash) const noexcept {
+    // Kirsch-Mitzenmacher: row hashes from two halves of one 64-bit hash.
+    const std::uint64_t low = hash & 0xFFFFFFFFu;
+    const std::uint64_t high = (hash >> 32) | 1;
+    return row * m_width + static_cast<std::size_t>((low + row * high) % m_width);
+}
+
+void CountMin::add(const std::uint64_t hash, const std::uint64_t count) noexcept {
+    for (std::size_t row = 0; row < m_depth; ++row) {
+        m_counters[cell(row, hash)] += count;
+    }
+    m_total += count;
+}
+
+std::uint64_t CountMin::estimate(const std::uint64_t hash) const noexcept {
+    std::uint64_t smallest = m_counters[cell(0, hash)];
+    for (std::size_t row = 1; row < m_depth; ++row) {
+        smallest = std::min(smallest, m_counters[cell(row, hash)]);
+    }
+    return smallest;
+}
+
+std::expected<void, std::string> CountMin::merge(const CountMin& other) {
+    if (other.m_width != m_width || other.m_depth != m_depth) {
+        return std::unexpected(std::format("cannot merge count-min sketches of {}x{} and {}x{}",
+                                           m_width, m_depth, other.m_width, other.m_depth));
+    }
+    for (std::size_t i = 0; i < m_counters.size(); ++i) {
+        m_counters[i] += other.m_counters[i];
+    }
+    m_total += other.m_total;
+    return {};
+}
+
+void CountMin::serialize(codec::ByteWriter& out) const {
+    out.varint(m_width);
+    out.varint(m_depth);
+    out.varint(m_total);
+    for (const std::uint64_t counter : m_counters) {
+        out.varint(counter);
+    }
+}
+
+std::expected<CountMin, std::string> CountMin::deserialize(codec::ByteReader& in) {
+    const std::uint64_t width = in.varint();
+    const std::uint64_t depth = in.varint();
+    if (in.failed() || width == 0 || depth == 0 || width > kMaxCells || depth > kMaxCells / width) {
+        return std::unexpected(std::string("invalid count-min dimensions"));
+    }
+    CountMin sketch(static_cast<std::size_t>(width), static_cast<std::size_t>(depth));
+    sketch.m_total = in.varint();
+    for (std::uint64_t& counter : sketch.m_counters) {
+        counter = in.varint();
+    }
+    if (in.failed()) {
+        return std::unexpected(std::string("truncated count-min counters"));
+    }
+    return sketch;
+}
+
+// ---------------------------------------------------------------------------
+// HeavyHitters
+// ---------------------------------------------------------------------------
+
+HeavyHitters::HeavyHitters(const std::size_t capacity, const std::size_t width, const std::size_t depth)
+    : m_capacity(std::max<std::size_t>(capacity, 1)), m_counts(width, depth) {}
+
+void HeavyHitters::add(const std::string_view key, const std::uint64_t count) {
+    const std::string_view kept = key.substr(0, kMaxKeyBytes);
+    const std::uint64_t hash = hash_bytes(kept);
+    m_counts.add(hash, count);
+    offer(hash, kept, m_counts.estimate(hash));
+}
+
+void HeavyHitters::offer(const std::uint64_t hash, const std::string_view key, const std::uint64_t estimate) {
+    if (const auto it = m_candidates.find(hash); it != m_candidates.end()) {
+        it->second.estimate = estimate;
+        return;
+    }
+    if (m_candidates.size() < m_capacity) {
+        m_candidates.emplace(hash, Candidate{.key = std::string(key), .estimate = estimate});
+        return;
+    }
+    // Candidates are few (tens), so a scan for the smallest is cheap.
+    auto smallest = m_candidates.begin();
+    for (auto it = m_candidates.begin(); it != m_candidates.end(); ++it) {
+        const Candidate& candidate = it->second;
+        if (candidate.estimate < smallest->second.estimate ||
+            (candidate.estimate == smallest->second.estimate && candidate.key > smallest->second.key)) {
+            smallest = it;
+        }
+    }
+    if (estimate > smallest->second.estimate) {
+        m_candidates.erase(smallest);
+        m_candidates.emplace(hash, Candidate{.key = std::string(key), .estimate = estimate});
+    }
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::top() const {
+    std::vector<Entry> entries;
+    entries.reserve(m_candidates.size());
+    for (const auto& [hash, candidate] : m_candidates) {
+        entries.push_back(Entry{.key = candidate.key, .count = m_counts.estimate(hash)});
+    }
+    std::ranges::sort(entries, [](const Entry& left, const Entry& right) {
+        return left.count != right.count ? left.count > right.count : left.key < right.key;
+    });
+    return entries;
+}
+
+std::expected<void, std::string> HeavyHitters::merge(const HeavyHitters& other) {
+    if (auto merged = m_counts.merge(other.m_counts); !merged) {
+        return merged;
+    }
+    // Re-rank the union of both candidate sets against the merged counts.
+    std::unordered_map<std::uint64_t, Candidate> candidates = std::move(m_candidates);
+    for (const auto& [hash, candidate] : other.m_candidates) {
+        candidates.try_emplace(hash, candidate);
+    }
+    m_candidates.clear();
+    for (const auto& [hash, candidate] : candidates) {
+        offer(hash, candidate.key, m_counts.estimate(hash));
+    }
+    return {};
+}
+
+void HeavyHitters::serialize(codec::ByteWriter& out) const {
+    out.varint(m_capacity);
+    m_counts.serialize(out);
+    // Sorted so equal sketches serialize to equal bytes.
+    std::vector<std::string_view> keys;
+    keys.reserve(m_candidates.size());
+    for (const auto& entry : m_candidates) {
+        keys.push_back(entry.second.key);
+    }
+    std::ranges::sort(keys);
+    out.varint(keys.size());
+    for (const std::string_view key : keys) {
+        out.string(key);
+    }
+}
+
+std::expected<HeavyHitters, std::string> HeavyHitters::deserialize(codec::ByteReader& in) {
+    const std::uint64_t capacity = in.varint();
+    if (in.failed() || capacity == 0 || capacity > kMaxCells) {
+        return std::unexpected(std::string("invalid heavy-hitter capacity"));
+    }
+    auto counts = CountMin::deserialize(in);
+    if (!counts) {
+        return std::unexpected(counts.error());
+    }
+    HeavyHitters sketch(static_cast<std::size_t>(capacity));
+    sketch.m_counts = std::move(*counts);
+
+    const std::uint64_t count = in.varint();
+    if (in.failed() || count > capacity) {
+        return std::unexpected(std::string("invalid heavy-hitter candidate count"));
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        const std::string_view key = in.string();
+        if (in.failed() || key.size() > kMaxKeyBytes) {
+            return std::unexpected(std::string("truncated heavy-hitter candidates"));
+        }
+        const std::uint64_t hash = hash_bytes(key);
+        sketch.m_candidates.emplace(hash, Candidate{.key = std::string(key), .estimate = sketch.m_counts.estimate(hash)});
+    }
+    return sketch;
+}
+
+// ---------------------------------------------------------------------------
+// LabeledDistinct
+// ---------------------------------------------------------------------------
+
+LabeledDistinct::LabeledDistinct(const std::size_t max_labels, const std::uint8_t precision)
+    : m_max_labels(std::max<std::size_t>(max_labels, 1)), m_precision(precision) {}
+
+HyperLogLog& LabeledDistinct::counter(const std::string_view label) {
+    std::string key(label);
+    if (const auto it = m_counters.find(key); it != m_counters.end()) {
+        return it->second;
+    }
+    if (m_counters.size() >= m_max_labels) {
+        key = kOtherLabel;
+    }
+    return m_counters.try_emplace(std::move(key), m_precision).first->second;
+}
+
+void LabeledDistinct::add_hash(const std::string_view label, const std::uint64_t hash) {
+    counter(label).add_hash(hash);
+}
+
+std::vector<LabeledDistinct::Count> LabeledDistinct::largest(const std::size_t limit) const {
+    std::vector<Count> counts;
+    counts.reserve(m_counters.size());
+    for (const auto& [label, distinct] : m_counters) {
+        counts.push_back(Count{.label = label, .estimate = distinct.estimate()});
+    }
+    const std::size_t kept = std::min(limit, counts.size());
+    std::ranges::partial_sort(counts, counts.begin() + static_cast<std::ptrdiff_t>(kept), [](const Count& left, const Count& right) {
+        return left.estimate != right.estimate ? left.estimate > right.estimate : left.label < right.label;
+    });
+    counts.resize(kept);
+    return counts;
+}
+
+std::expected<void, std::string> LabeledDistinct::merge(const LabeledDistinct& other) {
+    for (const auto& [label, distinct] : other.m_counters) {
+        if (auto merged = counter(label).merge(distinct); !merged) {
+            return merged;
+        }
+    }
+    return {};
+}
+
+void LabeledDistinct::serialize(codec::ByteWriter& out) const {
+    out.varint(m_max_labels);
+    out.bytes(std::span(&m_precision, 1));
+    std::vector<const std::pair<const std::string, HyperLogLog>*> entries;
+    entries.reserve(m_counters.size());
+    for (const auto& entry : m_counters) {
+        entries.push_back(&entry);
+    }
+    std::ranges::sort(entries, {}, [](const auto* entry) -> const std::string& { return entry->first; });
+    out.varint(entries.size());
+    for (const auto* entry : entries) {
+        out.string(entry->first);
+        entry->second.serialize(out);
+    }
+}
+
+std::expected<LabeledDistinct, std::string> LabeledDistinct::deserialize(codec::ByteReader& in) {
+    const std::uint64_t max_labels = in.varint();
+    const std::span<const std::uint8_t> precision = in.bytes(1);
+    const std::uint64_t count = in.varint();
+    // The overflow label may come on top of max_labels.
+    if (in.failed() || max_labels == 0 || max_labels > kMaxCells || count > max_labels + 1) {
+        return std::unexpected(std::string("invalid labeled sketch header"));
+    }
+    LabeledDistinct sketch(static_cast<std::size_t>(max_labels), precision[0]);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::string label(in.string());
+        auto distinct = HyperLogLog::deserialize(in);
+        if (!distinct) {
+            return std::unexpected(distinct.error());
+        }
+        if (distinct->precision() != sketch.m_precision) {
+            return std::unexpected(std::string("labeled sketch precision mismatch"));
+        }
+        sketch.m_counters.insert_or_assign(std::move(label), std::move(*distinct));
+    }
+    return sketch;
+}
+
+// ---------------------------------------------------------------------------
+// SketchSet
+// ---------------------------------------------------------------------------
+
+std::expected<void, std::string> SketchSet::merge(const SketchSet& other) {
+    if (auto merged = objects.merge(other.objects); !merged) {
+        return merged;
+    }
+    if (auto merged = objectsByType.merge(other.objectsByType); !merged) {
+        return merged;
+    }
+    if (auto merged = objectsByProcess.merge(other.objectsByProcess); !merged) {
+        return merged;
+    }
+    if (auto merged = names.merge(other.names); !merged) {
+        return merged;
+    }
+    snapshots += other.snapshots;
+    handles += other.handles;
+    return {};
+}
+
+codec::Bytes serialize(const SketchSet& sketches) {
+    codec::ByteWriter out;
+    out.bytes(std::span(reinterpret_cast<const std::uint8_t*>(kMagic.data()), kMagic.size()));
+    out.fixed32(kVersion);
+    out.varint(sketches.snapshots);
+    out.varint(sketches.handles);
+    sketches.objects.serialize(out);
+    sketches.objectsByType.serialize(out);
+    sketches.objectsByProcess.serialize(out);
+    sketches.names.serialize(out);
+    return out.take();
+}
+
+std::expected<SketchSet, std::string> deserialize(const std::span<const std::uint8_t> bytes) {
+    codec::ByteReader in(bytes);
+    const std::span<const std::uint8_t> magic = in.bytes(kMagic.size());
+    if (in.failed() || !std::ranges::equal(magic, kMagic, {}, {}, [](const char ch) { return static_cast<std::uint8_t>(ch); })) {
+        return std::unexpected(std::string("not a sketch file"));
+    }
+    if (in.fixed32() != kVersion) {
+        return std::unexpected(std::string("unsupported sketch version"));
+    }
+
+    SketchSet sketches;
+    sketches.snapshots = in.varint();
+    sketches.handles = in.varint();
+    auto objects = HyperLogLog::deserialize(in);
+    if (!objects) {
+        return std::unexpected(objects.error());
+    }
+    auto by_type = LabeledDistinct::deserialize(in);
+    if (!by_type) {
+        return std::unexpected(by_type.error());
+    }
+    auto by_process = LabeledDistinct::deserialize(in);
+    if (!by_process) {
+        return std::unexpected(by_process.error());
+    }
+    auto names = HeavyHitters::deserialize(in);
+    if (!names) {
+        return std::unexpected(names.error());
+    }
+    if (in.failed() || !in.at_end()) {
+        return std::unexpected(std::string("trailing or truncated sketch data"));
+    }
+    sketches.objects = std::move(*objects);
+    sketches.objectsByType = std::move(*by_type);
+    sketches.objectsByProcess = std::move(*by_process);
+    sketches.names = std::move(*names);
+    return sketches;
+}
+
+std::expected<SketchSet, std::string> load(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::unexpected(std::format("cannot open {}", path.string()));
+    }
+    const codec::Bytes bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    auto sketches = deserialize(bytes);
+    if (!sketches) {
+        return std::unexpected(std::format("{}: {}", path.string(), sketches.error()));
+    }
+    return sketches;
+}
+
+std::expected<void, std::string> save(const std::filesystem::path& path, const SketchSet& sketches) {
+    const codec::Bytes bytes = serialize(sketches);
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file.flush()) {
+            return std::unexpected(std::format("cannot write {}", temp.string()));
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return std::unexpected(std::format("cannot replace {} ({})", path.string(), error.message()));
+    }
+    return {};
+}
+
+} // namespace sketch
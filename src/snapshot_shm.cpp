@@ -0,0 +1,457 @@
+#include "snapshot_shm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace shm {
+
+namespace {
+
+static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free && std::atomic_ref<std::uint32_t>::is_always_lock_free,
+              "lock-free atomics are address-free, so they work across processes");
+
+constexpr std::size_t kHeaderBytes = sizeof(RegionHeader);
+constexpr std::size_t kMaxNameLength = 64;
+constexpr std::uint32_t kUnmapped = std::numeric_limits<std::uint32_t>::max();
+
+// Readers may map the region read-only; an aligned 64-bit atomic load never writes.
+[[nodiscard]] std::uint64_t load_acquire(const std::uint64_t& value) noexcept {
+    return std::atomic_ref(const_cast<std::uint64_t&>(value)).load(std::memory_order_acquire);
+}
+
+[[nodiscard]] std::uint64_t load_relaxed(const std::uint64_t& value) noexcept {
+    return std::atomic_ref(const_cast<std::uint64_t&>(value)).load(std::memory_order_relaxed);
+}
+
+[[nodiscard]] std::expected<void, std::string> check_name(const std::string_view name) {
+    const bool valid = !name.empty() && name.size() <= kMaxNameLength && std::ranges::all_of(name, [](const char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-';
+    });
+    if (!valid) {
+        return std::unexpected(std::format("invalid shared memory name '{}' (1 to {} of A-Z a-z 0-9 . _ -)", name, kMaxNameLength));
+    }
+    return {};
+}
+
+// Dense string table for the ids the rows use, in first-use order.
+struct StringTable {
+    std::vector<std::uint32_t> remap;
+    std::vector<StringId> used;
+    std::size_t bytes = 0;
+};
+
+[[nodiscard]] StringTable build_table(const std::span<const HandleInfo> rows, const StringInterner& strings) {
+    StringTable table;
+    table.remap.assign(strings.size(), kUnmapped);
+    const auto use = [&](const StringId id) {
+        if (table.remap[id] == kUnmapped) {
+            table.remap[id] = static_cast<std::uint32_t>(table.used.size());
+            table.used.push_back(id);
+            table.bytes += strings.view(id).size();
+        }
+    };
+    for (const HandleInfo& row : rows) {
+        use(row.processName);
+        use(row.handleType);
+        use(row.objectName);
+    }
+    return table;
+}
+
+[[nodiscard]] std::size_t table_payload(const std::size_t rows, const StringTable& table) noexcept {
+    return rows * sizeof(Row) + (table.used.size() + 1) * sizeof(std::uint32_t) + table.bytes;
+}
+
+#ifdef _WIN32
+constexpr std::intptr_t kNoHandle = 0;
+
+[[nodiscard]] std::wstring region_path(const std::string_view name) {
+    // check_name() allows ASCII only, so widening is a plain copy.
+    std::wstring path = L"Local\\HandleEnum-";
+    path.append(name.begin(), name.end());
+    return path;
+}
+#else
+constexpr std::intptr_t kNoHandle = -1;
+
+[[nodiscard]] std::string region_path(const std::string_view name) {
+    return std::format("/HandleEnum-{}", name);
+}
+#endif
+
+} // namespace
+
+std::size_t payload_bytes(const std::span<const HandleInfo> rows, const StringInterner& strings) {
+    return table_payload(rows.size(), build_table(rows, strings));
+}
+
+std::string_view SnapshotView::string(const std::uint32_t index) const noexcept {
+    if (index + std::size_t{1} >= stringOffsets.size()) {
+        return {};
+    }
+    const std::uint32_t begin = stringOffsets[index];
+    const std::uint32_t end = stringOffsets[index + 1];
+    if (begin > end || end > stringData.size()) {
+        return {};
+    }
+    return stringData.substr(begin, end - begin);
+}
+
+Mapping::~Mapping() {
+    close();
+}
+
+Mapping::Mapping(Mapping&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_handle(std::exchange(other.m_handle, kNoHandle)),
+      m_owned_name(std::move(other.m_owned_name)) {
+    other.m_owned_name.clear();
+}
+
+Mapping& Mapping::operator=(Mapping&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_handle = std::exchange(other.m_handle, kNoHandle);
+        m_owned_name = std::move(other.m_owned_name);
+        other.m_owned_name.clear();
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+void Mapping::close() noexcept {
+    if (m_data != nullptr) {
+        ::UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_handle != kNoHandle) {
+        ::CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+        m_handle = kNoHandle;
+    }
+    // The kernel drops a named mapping with its last handle.
+    m_owned_name.clear();
+    m_size = 0;
+}
+
+std::expected<Mapping, std::string> Mapping::create(const std::string_view name, const std::size_t bytes) {
+    if (auto checked = check_name(name); !checked) {
+        return std::unexpected(checked.error());
+    }
+    const std::wstring path = region_path(name);
+    const std::uint64_t size = bytes;
+    const HANDLE handle = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                               static_cast<DWORD>(size & 0xFFFFFFFFu), path.c_str());
+    if (handle == nullptr) {
+        return std::unexpected(std::format("cannot create shared memory '{}' (error {})", name, ::GetLastError()));
+    }
+    Mapping mapping;
+    mapping.m_handle = reinterpret_cast<std::intptr_t>(handle);
+    if (::GetLastError() == ERROR_ALREADY_EXISTS) {
+        return std::unexpected(std::format("shared memory '{}' already exists (is another publisher running?)", name));
+    }
+    void* const view = ::MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (view == nullptr) {
+        return std::unexpected(std::format("cannot map shared memory '{}' (error {})", name, ::GetLastError()));
+    }
+    mapping.m_data = static_cast<std::byte*>(view);
+    mapping.m_size = bytes;
+    mapping.m_owned_name = std::string(name);
+    return mapping;
+}
+
+std::expected<Mapping, std::string> Mapping::open(const std::string_view name) {
+    if (auto checked = check_name(name); !checked) {
+        return std::unexpected(checked.error());
+    }
+    const std::wstring path = region_path(name);
+    const HANDLE handle = ::OpenFileMappingW(FILE_MAP_READ, FALSE, path.c_str());
+    if (handle == nullptr) {
+        return std::unexpected(std::format("cannot open shared memory '{}' (error {})", name, ::GetLastError()));
+    }
+    Mapping mapping;
+    mapping.m_handle = reinterpret_cast<std::intptr_t>(handle);
+    void* const view = ::MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        return std::unexpected(std::format("cannot map shared memory '{}' (error {})", name, ::GetLastError()));
+    }
+    mapping.m_data = static_cast<std::byte*>(view);
+    MEMORY_BASIC_INFORMATION info{};
+    mapping.m_size = ::VirtualQuery(view, &info, sizeof(info)) != 0 ? info.RegionSize : 0;
+    return mapping;
+}
+
+#else
+
+void Mapping::close() noexcept {
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+    if (m_handle != kNoHandle) {
+        ::close(static_cast<int>(m_handle));
+        m_handle = kNoHandle;
+    }
+    // Readers that still map the region keep it; new ones can no longer open it.
+    if (!m_owned_name.empty()) {
+        ::shm_unlink(region_path(m_owned_name).c_str());
+        m_owned_name.clear();
+    }
+    m_size = 0;
+}
+
+std::expected<Mapping, std::string> Mapping::create(const std::string_view name, const std::size_t bytes) {
+    if (auto checked = check_name(name); !checked) {
+        return std::unexpected(checked.error());
+    }
+    const std::string path = region_path(name);
+    const int descriptor = ::shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (descriptor < 0) {
+        if (errno == EEXIST) {
+            return std::unexpected(std::format("shared memory '{}' already exists (is another publisher running?)", name));
+        }
+        return std::unexpected(std::format("cannot create shared memory '{}' ({})", name, std::strerror(errno)));
+    }
+    Mapping mapping;
+    mapping.m_handle = descriptor;
+    mapping.m_owned_name = std::string(name);
+    if (::ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+        return std::unexpected(std::format("cannot size shared memory '{}' ({})", name, std::strerror(errno)));
+    }
+    void* const view = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (view == MAP_FAILED) {
+        return std::unexpected(std::format("cannot map shared memory '{}' ({})", name, std::strerror(errno)));
+    }
+    mapping.m_data = static_cast<std::byte*>(view);
+    mapping.m_size = bytes;
+    return mapping;
+}
+
+std::expected<Mapping, std::string> Mapping::open(const std::string_view name) {
+    if (auto checked = check_name(name); !checked) {
+        return std::unexpected(checked.error());
+    }
+    const int descriptor = ::shm_open(region_path(name).c_str(), O_RDONLY, 0);
+    if (descriptor < 0) {
+        return std::unexpected(std::format("cannot open shared memory '{}' ({})", name, std::strerror(errno)));
+    }
+    Mapping mapping;
+    mapping.m_handle = descriptor;
+    struct stat status{};
+    if (::fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        return std::unexpected(std::format("shared memory '{}' is empty", name));
+    }
+    const std::size_t bytes = static_cast<std::size_t>(status.st_size);
+    void* const view = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, descriptor, 0);
+    if (view == MAP_FAILED) {
+        return std::unexpected(std::format("cannot map shared memory '{}' ({})", name, std::strerror(errno)));
+    }
+    mapping.m_data = static_cast<std::byte*>(view);
+    mapping.m_size = bytes;
+    return mapping;
+}
+
+#endif
+
+std::expected<Publisher, std::string> Publisher::create(const std::string_view name,
+                                                        const std::size_t slot_bytes,
+                                                        const std::uint64_t last_generation) {
+    // Whole cache lines per slot keep every slot header 64-byte aligned.
+    const std::size_t slot = (sizeof(SlotHeader) + slot_bytes + 63) / 64 * 64;
+    auto mapping = Mapping::create(name, kHeaderBytes + kSlotCount * slot);
+    if (!mapping) {
+        return std::unexpected(mapping.error());
+    }
+
+    auto* const header = reinterpret_cast<RegionHeader*>(mapping->data());
+    header->layoutVersion = kLayoutVersion;
+    header->slotCount = kSlotCount;
+    header->headerBytes = static_cast<std::uint32_t>(kHeaderBytes);
+    header->rowBytes = static_cast<std::uint32_t>(sizeof(Row));
+    header->slotBytes = slot;
+    header->latest = 0;
+    header->retired = 0;
+#ifdef _WIN32
+    header->publisherPid = ::GetCurrentProcessId();
+#else
+    header->publisherPid = static_cast<std::uint64_t>(::getpid());
+#endif
+    std::atomic_ref(header->magic).store(kMagic, std::memory_order_release);
+
+    Publisher publisher;
+    publisher.m_mapping = std::move(*mapping);
+    publisher.m_generation = last_generation;
+    return publisher;
+}
+
+void Publisher::retire() noexcept {
+    auto* const header = reinterpret_cast<RegionHeader*>(m_mapping.data());
+    std::atomic_ref(header->retired).store(1, std::memory_order_release);
+}
+
+std::size_t Publisher::slot_capacity() const noexcept {
+    return reinterpret_cast<const RegionHeader*>(m_mapping.data())->slotBytes - sizeof(SlotHeader);
+}
+
+std::expected<std::uint64_t, std::string> Publisher::publish(const std::span<const HandleInfo> rows,
+                                                             const StringInterner& strings,
+                                                             const std::uint64_t total_raw_count,
+                                                             const std::int64_t published_ms) {
+    const StringTable table = build_table(rows, strings);
+    const std::size_t needed = table_payload(rows.size(), table);
+    if (needed > slot_capacity() || rows.size() > std::numeric_limits<std::uint32_t>::max() ||
+        table.bytes > std::numeric_limits<std::uint32_t>::max()) {
+        return std::unexpected(std::format("snapshot needs {} bytes but a shared memory slot holds {}", needed, slot_capacity()));
+    }
+
+    auto* const region = reinterpret_cast<RegionHeader*>(m_mapping.data());
+    const std::uint64_t generation = m_generation + 1;
+    std::byte* const slot = m_mapping.data() + kHeaderBytes + (generation % kSlotCount) * region->slotBytes;
+    auto* const header = reinterpret_cast<SlotHeader*>(slot);
+
+    // The slot holds generation - 2, which is no longer the newest; readers
+    // still on it see the odd sequence or a changed one and retry.
+    std::atomic_ref sequence(header->sequence);
+    const std::uint64_t before = sequence.load(std::memory_order_relaxed);
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header->generation = generation;
+    header->publishedMs = published_ms;
+    header->totalRawCount = total_raw_count;
+    header->rowCount = static_cast<std::uint32_t>(rows.size());
+    header->stringCount = static_cast<std::uint32_t>(table.used.size());
+    header->stringBytes = table.bytes;
+
+    auto* const out_rows = reinterpret_cast<Row*>(slot + sizeof(SlotHeader));
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const HandleInfo& row = rows[i];
+        out_rows[i] = Row{
+            .objectAddress = row.objectAddress,
+            .handleValue = row.handleValue,
+            .pid = row.pid,
+            .grantedAccess = row.grantedAccess,
+            .handleAttributes = row.handleAttributes,
+            .processName = table.remap[row.processName],
+            .handleType = table.remap[row.handleType],
+            .objectName = table.remap[row.objectName],
+            .objectTypeIndex = row.objectTypeIndex,
+            .reserved = {}};
+    }
+    auto* const offsets = reinterpret_cast<std::uint32_t*>(out_rows + rows.size());
+    char* const data = reinterpret_cast<char*>(offsets + table.used.size() + 1);
+    std::uint32_t offset = 0;
+    for (std::size_t i = 0; i < table.used.size(); ++i) {
+        const std::string_view text = strings.view(table.used[i]);
+        offsets[i] = offset;
+        std::memcpy(data + offset, text.data(), text.size());
+        offset += static_cast<std::uint32_t>(text.size());
+    }
+    offsets[table.used.size()] = offset;
+
+    sequence.store(before + 2, std::memory_order_release);
+    std::atomic_ref(region->latest).store(generation, std::memory_order_release);
+    m_generation = generation;
+    return generation;
+}
+
+std::expected<Reader, std::string> Reader::open(const std::string_view name) {
+    auto mapping = Mapping::open(name);
+    if (!mapping) {
+        return std::unexpected(mapping.error());
+    }
+    if (mapping->size() < kHeaderBytes) {
+        return std::unexpected(std::format("shared memory '{}' is too small for a snapshot header", name));
+    }
+    const auto* const header = reinterpret_cast<const RegionHeader*>(mapping->data());
+    if (std::atomic_ref(const_cast<std::uint32_t&>(header->magic)).load(std::memory_order_acquire) != kMagic) {
+        return std::unexpected(std::format("shared memory '{}' holds no published snapshot region", name));
+    }
+    if (header->layoutVersion != kLayoutVersion) {
+        return std::unexpected(std::format("shared memory '{}' has layout version {}; this reader knows {}", name,
+                                           header->layoutVersion, kLayoutVersion));
+    }
+    if (header->headerBytes != kHeaderBytes || header->rowBytes != sizeof(Row) || header->slotCount != kSlotCount ||
+        header->slotBytes < sizeof(SlotHeader) || header->slotBytes % 64 != 0 ||
+        header->slotBytes > (mapping->size() - kHeaderBytes) / kSlotCount) {
+        return std::unexpected(std::format("shared memory '{}' has an inconsistent header", name));
+    }
+
+    Reader reader;
+    reader.m_slot_bytes = header->slotBytes;
+    reader.m_mapping = std::move(*mapping);
+    return reader;
+}
+
+std::optional<SnapshotView> Reader::latest() const {
+    const auto* const region = reinterpret_cast<const RegionHeader*>(m_mapping.data());
+    while (true) {
+        const std::uint64_t generation = load_acquire(region->latest);
+        if (generation == 0) {
+            return std::nullopt;
+        }
+        const auto slot = static_cast<std::uint32_t>(generation % kSlotCount);
+        const std::byte* const base = m_mapping.data() + kHeaderBytes + slot * m_slot_bytes;
+        const auto* const header = reinterpret_cast<const SlotHeader*>(base);
+        const std::uint64_t sequence = load_acquire(header->sequence);
+        if (sequence % 2 == 1) {
+            // Rewritten for a newer generation, which `latest` now names.
+            continue;
+        }
+
+        SnapshotView view;
+        view.generation = header->generation;
+        view.publishedMs = header->publishedMs;
+        view.totalRawCount = header->totalRawCount;
+        view.slot = slot;
+        view.sequence = sequence;
+        const std::uint64_t rows = header->rowCount;
+        const std::uint64_t strings = header->stringCount;
+        const std::uint64_t string_bytes = header->stringBytes;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (load_relaxed(header->sequence) != sequence || view.generation != generation) {
+            continue;
+        }
+        // A stable header whose counts overflow the slot is not a layout this reader can use.
+        if (rows * sizeof(Row) + (strings + 1) * sizeof(std::uint32_t) + string_bytes > m_slot_bytes - sizeof(SlotHeader)) {
+            return std::nullopt;
+        }
+        const auto* const row_data = reinterpret_cast<const Row*>(base + sizeof(SlotHeader));
+        const auto* const offsets = reinterpret_cast<const std::uint32_t*>(row_data + rows);
+        view.rows = std::span<const Row>(row_data, static_cast<std::size_t>(rows));
+        view.stringOffsets = std::span<const std::uint32_t>(offsets, static_cast<std::size_t>(strings + 1));
+        view.stringData = std::string_view(reinterpret_cast<const char*>(offsets + strings + 1), static_cast<std::size_t>(string_bytes));
+        return view;
+    }
+}
+
+bool Reader::valid(const SnapshotView& view) const noexcept {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto* const header =
+        reinterpret_cast<const SlotHeader*>(m_mapping.data() + kHeaderBytes + view.slot * m_slot_bytes);
+    return load_relaxed(header->sequence) == view.sequence;
+}
+
+bool Reader::retired() const noexcept {
+    return load_acquire(reinterpret_cast<const RegionHeader*>(m_mapping.data())->retired) != 0;
+}
+
+} // namespace shm
@@ -0,0 +1,163 @@
+#include "string_interner.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <numeric>
+
+namespace {
+
+[[nodiscard]] unsigned char fold_ascii(const char ch) noexcept {
+    const auto byte = static_cast<unsigned char>(ch);
+    return (byte >= 'A' && byte <= 'Z') ? static_cast<unsigned char>(byte - 'A' + 'a') : byte;
+}
+
+} // namespace
+
+// Allocation-free equivalent of comparing utils::to_lower_ascii() copies.
+int compare_ignore_case(const std::string_view left, const std::string_view right) noexcept {
+    const std::size_t common = std::min(left.size(), right.size());
+    for (std::size_t i = 0; i < common; ++i) {
+        const unsigned char l = fold_ascii(left[i]);
+        const unsigned char r = fold_ascii(right[i]);
+        if (l != r) {
+            return l < r ? -1 : 1;
+        }
+    }
+
+    if (left.size() == right.size()) {
+        return 0;
+    }
+    return left.size() < right.size() ? -1 : 1;
+}
+
+StringInterner::StringInterner() {
+    clear();
+}
+
+std::string_view StringInterner::store(const std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+
+    if (text.size() > kChunkSize) {
+        // Oversized strings get a dedicated chunk, inserted before the chunk
+        // currently being filled so that one stays at the back.
+        auto chunk = std::make_unique<char[]>(text.size());
+        std::memcpy(chunk.get(), text.data(), text.size());
+        m_arena_bytes += text.size();
+        const std::string_view stored{chunk.get(), text.size()};
+        m_chunks.insert(m_chunks.empty() ? m_chunks.end() : std::prev(m_chunks.end()), std::move(chunk));
+        return stored;
+    }
+
+    if (kChunkSize - m_chunk_used < text.size()) {
+        m_chunks.push_back(std::make_unique<char[]>(kChunkSize));
+        m_arena_bytes += kChunkSize;
+        m_chunk_used = 0;
+    }
+
+    char* destination = m_chunks.back().get() + m_chunk_used;
+    std::memcpy(destination, text.data(), text.size());
+    m_chunk_used += text.size();
+    return {destination, text.size()};
+}
+
+void StringInterner::grow_index() {
+    m_slots.assign(std::max<std::size_t>(m_slots.size() * 2, 1024), 0);
+    const std::size_t mask = m_slots.size() - 1;
+    for (StringId id = 0; id < m_views.size(); ++id) {
+        std::size_t slot = m_hashes[id] & mask;
+        while (m_slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = id + 1;
+    }
+}
+
+StringId StringInterner::intern(const std::string_view text) {
+    if (m_slots.empty()) {
+        grow_index();
+    }
+
+    const std::size_t hash = std::hash<std::string_view>{}(text);
+    const std::size_t mask = m_slots.size() - 1;
+    std::size_t slot = hash & mask;
+    while (m_slots[slot] != 0) {
+        const StringId candidate = m_slots[slot] - 1;
+        if (m_hashes[candidate] == hash && m_views[candidate] == text) {
+            return candidate;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    const auto id = static_cast<StringId>(m_views.size());
+    m_views.push_back(store(text));
+    m_hashes.push_back(hash);
+    m_slots[slot] = id + 1;
+
+    // Keep the load factor under one half so probe chains stay short.
+    if (m_views.size() * 2 > m_slots.size()) {
+        grow_index();
+    }
+    return id;
+}
+
+std::string_view StringInterner::view(const StringId id) const noexcept {
+    return id < m_views.size() ? m_views[id] : std::string_view{};
+}
+
+void StringInterner::build_sort_ranks() {
+    if (has_sort_ranks()) {
+        return;
+    }
+
+    std::vector<StringId> order(m_views.size());
+    std::iota(order.begin(), order.end(), StringId{0});
+    std::ranges::sort(order, [this](const StringId left, const StringId right) {
+        return compare_ignore_case(m_views[left], m_views[right]) < 0;
+    });
+
+    m_ranks.assign(m_views.size(), 0);
+    std::uint32_t rank = 0;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && compare_ignore_case(m_views[order[i - 1]], m_views[order[i]]) != 0) {
+            ++rank;
+        }
+        m_ranks[order[i]] = rank;
+    }
+}
+
+bool StringInterner::has_sort_ranks() const noexcept {
+    return m_ranks.size() == m_views.size();
+}
+
+std::uint32_t StringInterner::sort_rank(const StringId id) const noexcept {
+    return id < m_ranks.size() ? m_ranks[id] : 0;
+}
+
+void StringInterner::clear() {
+    m_chunks.clear();
+    m_chunk_used = kChunkSize;
+    m_arena_bytes = 0;
+    m_views.clear();
+    m_hashes.clear();
+    m_slots.assign(1024, 0);
+    m_ranks.clear();
+
+    const StringId empty = intern({});
+    (void)empty;
+}
+
+std::size_t StringInterner::size() const noexcept {
+    return m_views.size();
+}
+
+std::size_t StringInterner::bytes_reserved() const noexcept {
+    return m_arena_bytes +
+           m_views.capacity() * sizeof(std::string_view) +
+           m_hashes.capacity() * sizeof(std::size_t) +
+           m_slots.capacity() * sizeof(StringId) +
+           m_ranks.capacity() * sizeof(std::uint32_t);
+}
@@ -1,11 +1,108 @@
 #include "string_utils.hpp"
 
-#include <windows.h>
-
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HANDLE_ENUM_HAS_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HANDLE_ENUM_HAS_NEON 1
+#endif
 
 namespace utils {
 
+namespace {
+
+constexpr char32_t kReplacement = 0xFFFD;
+
+[[nodiscard]] constexpr bool is_high_surrogate(const char32_t unit) noexcept { return unit >= 0xD800 && unit <= 0xDBFF; }
+[[nodiscard]] constexpr bool is_low_surrogate(const char32_t unit) noexcept { return unit >= 0xDC00 && unit <= 0xDFFF; }
+
+[[nodiscard]] constexpr std::size_t encoded_size(const char32_t code_point) noexcept {
+    return code_point < 0x80 ? 1 : code_point < 0x800 ? 2 : code_point < 0x10000 ? 3 : 4;
+}
+
+// Writes one code point and returns the byte after it.
+char* encode(const char32_t code_point, char* out) noexcept {
+    if (code_point < 0x80) {
+        *out++ = static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+        *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+        *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    return out;
+}
+
+// Decodes the code point at `index` and advances past it; a surrogate
+// without its partner decodes to U+FFFD.
+[[nodiscard]] char32_t decode(const std::u16string_view utf16, std::size_t& index) noexcept {
+    const char32_t unit = utf16[index++];
+    if (!is_high_surrogate(unit) && !is_low_surrogate(unit)) {
+        return unit;
+    }
+    if (is_high_surrogate(unit) && index < utf16.size() && is_low_surrogate(utf16[index])) {
+        return 0x10000 + ((unit - 0xD800) << 10) + (utf16[index++] - 0xDC00);
+    }
+    return kReplacement;
+}
+
+/**
+ * Length of the ASCII run at the start of `in`. With kNarrow the run is also
+ * written to `out` as bytes. Blocks of 16 units are tested and packed with
+ * vector instructions; the first block holding a non-ASCII unit, and the
+ * tail, finish one unit at a time.
+ */
+template <bool kNarrow>
+[[nodiscard]] std::size_t ascii_run(const char16_t* in, const std::size_t size, [[maybe_unused]] char* out) noexcept {
+    std::size_t index = 0;
+#if defined(HANDLE_ENUM_HAS_SSE2)
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; index + 16 <= size; index += 16) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + index));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + index + 8));
+        const __m128i masked = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(masked, zero)) != 0xFFFF) {
+            break;
+        }
+        if constexpr (kNarrow) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + index), _mm_packus_epi16(low, high));
+        }
+    }
+#elif defined(HANDLE_ENUM_HAS_NEON)
+    for (; index + 16 <= size; index += 16) {
+        const uint16x8_t low = vld1q_u16(reinterpret_cast<const std::uint16_t*>(in + index));
+        const uint16x8_t high = vld1q_u16(reinterpret_cast<const std::uint16_t*>(in + index + 8));
+        if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+            break;
+        }
+        if constexpr (kNarrow) {
+            vst1q_u8(reinterpret_cast<std::uint8_t*>(out + index), vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+        }
+    }
+#endif
+    for (; index < size && in[index] < 0x80; ++index) {
+        if constexpr (kNarrow) {
+            out[index] = static_cast<char>(in[index]);
+        }
+    }
+    return index;
+}
+
+} // namespace
+
 std::string to_lower_ascii(const std::string_view text) {
     std::string lower;
     lower.reserve(text.size());
@@ -25,42 +122,63 @@ bool contains_ignore_case(const std::string_view text, const std::string_view ne
     return lower_text.find(lower_needle) != std::string::npos;
 }
 
+std::string utf16_to_utf8(const std::u16string_view utf16) {
+    // Names are almost always ASCII: then the prefix is everything and the
+    // buffer is exact. Otherwise size for the worst case, three bytes per
+    // remaining unit (a surrogate pair is four bytes for two units), and
+    // shrink in place.
+    const std::size_t ascii = ascii_run<false>(utf16.data(), utf16.size(), nullptr);
+    std::string utf8;
+    utf8.resize_and_overwrite(ascii + (utf16.size() - ascii) * 3, [&](char* const begin, std::size_t) {
+        std::size_t index = ascii_run<true>(utf16.data(), ascii, begin);
+        char* out = begin + index;
+        while (index < utf16.size()) {
+            if (utf16[index] < 0x80) {
+                const std::size_t run = ascii_run<true>(utf16.data() + index, utf16.size() - index, out);
+                index += run;
+                out += run;
+                continue;
+            }
+            out = encode(decode(utf16, index), out);
+        }
+        return static_cast<std::size_t>(out - begin);
+    });
+    return utf8;
+}
+
 std::string utf16_to_utf8(const std::wstring_view wide) {
-    if (wide.empty()) {
-        return {};
+    if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+        return utf16_to_utf8(std::u16string_view(reinterpret_cast<const char16_t*>(wide.data()), wide.size()));
+    } else {
+        const auto valid = [](const char32_t code_point) {
+            return code_point <= 0x10FFFF && !is_high_surrogate(code_point) && !is_low_surrogate(code_point);
+        };
+        std::size_t size = 0;
+        for (const wchar_t unit : wide) {
+            size += encoded_size(valid(static_cast<char32_t>(unit)) ? static_cast<char32_t>(unit) : kReplacement);
+        }
+        std::string utf8;
+        utf8.resize_and_overwrite(size, [&](char* const begin, std::size_t) {
+            char* out = begin;
+            for (const wchar_t unit : wide) {
+                out = encode(valid(static_cast<char32_t>(unit)) ? static_cast<char32_t>(unit) : kReplacement, out);
+            }
+            return static_cast<std::size_t>(out - begin);
+        });
+        return utf8;
     }
+}
 
-    const int size = ::WideCharToMultiByte(
-        CP_UTF8,
-        0,
-        wide.data(),
-        static_cast<int>(wide.size()),
-        nullptr,
-        0,
-        nullptr,
-        nullptr
-    );
-
-    if (size <= 0) {
-        return {};
+std::string utf16_to_utf8_scalar(const std::u16string_view utf16) {
+    std::size_t size = 0;
+    for (std::size_t index = 0; index < utf16.size();) {
+        size += encoded_size(decode(utf16, index));
     }
-
-    std::string utf8(static_cast<std::size_t>(size), '\0');
-    const int written = ::WideCharToMultiByte(
-        CP_UTF8,
-        0,
-        wide.data(),
-        static_cast<int>(wide.size()),
-        utf8.data(),
-        size,
-        nullptr,
-        nullptr
-    );
-
-    if (written <= 0) {
-        return {};
+    std::string utf8(size, '\0');
+    char* out = utf8.data();
+    for (std::size_t index = 0; index < utf16.size();) {
+        out = encode(decode(utf16, index), out);
     }
-
     return utf8;
 }
 
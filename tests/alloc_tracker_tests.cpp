@@ -0,0 +1,206 @@
+#include "alloc_tracker.hpp"
+#include "filter_expr.hpp"
+#include "handle_sort.hpp"
+#include "parallel_filter.hpp"
+#include "printer.hpp"
+#include "string_interner.hpp"
+
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+using alloc::Stage;
+
+// Kept in a global so the compiler cannot drop the allocation.
+std::unique_ptr<char[]> g_kept;
+
+void allocate(const std::size_t bytes) {
+    g_kept = std::make_unique<char[]>(bytes);
+    g_kept.reset();
+}
+
+constexpr std::size_t kRows = 10'000;
+
+[[nodiscard]] std::vector<nt::RawHandle> make_handles() {
+    std::vector<nt::RawHandle> handles(kRows);
+    for (std::size_t i = 0; i < kRows; ++i) {
+        handles[i].processId = 4 + (i % 61) * 4;
+        handles[i].handleValue = 4 + i * 4;
+        handles[i].grantedAccess = i % 5 == 0 ? 0x1F0FFF : 0x100001;
+        handles[i].objectAddress = 0xFFFF'8000'0000'0000ull + i * 0x40;
+        handles[i].objectTypeIndex = static_cast<std::uint16_t>(i % 40);
+    }
+    return handles;
+}
+
+[[nodiscard]] std::vector<HandleInfo> make_rows(StringInterner& strings) {
+    std::vector<HandleInfo> rows;
+    rows.reserve(kRows);
+    for (std::size_t i = 0; i < kRows; ++i) {
+        rows.push_back(HandleInfo{
+            .pid = static_cast<std::uint32_t>(4 + (i % 61) * 4),
+            .processName = strings.intern(std::format("process{}.exe", i % 61)),
+            .handleType = strings.intern(i % 2 == 0 ? "File" : "Event"),
+            .objectName = strings.intern(std::format("\\Device\\HarddiskVolume3\\Windows\\System32\\file{}.dll", i % 500)),
+            .grantedAccess = 0x100001,
+            .objectAddress = 0xFFFF'8000'0000'0000ull + i * 0x40,
+            .handleValue = 4 + i * 4,
+            .objectTypeIndex = static_cast<std::uint16_t>(i % 40)});
+    }
+    return rows;
+}
+
+[[nodiscard]] double per_row(const Stage stage) {
+    return static_cast<double>(alloc::counts(stage).allocations) / static_cast<double>(kRows);
+}
+
+void test_counts_by_stage() {
+    alloc::enable();
+    {
+        const alloc::StageScope scope(Stage::Map);
+        allocate(100);
+    }
+    const alloc::Counts map = alloc::counts(Stage::Map);
+    expect_true(map.allocations == 1 && map.bytes == 100 && map.frees == 1,
+                "an allocation and its free should be counted in the scope's stage");
+    expect_true(alloc::counts(Stage::Sort).allocations == 0, "other stages should be untouched");
+
+    alloc::enable();
+    expect_true(alloc::counts(Stage::Map).allocations == 0, "enable() should clear the counters");
+    alloc::disable();
+}
+
+void test_disabled_counts_nothing() {
+    alloc::enable();
+    alloc::disable();
+    {
+        const alloc::StageScope scope(Stage::Map);
+        allocate(100);
+    }
+    expect_true(alloc::counts(Stage::Map).allocations == 0, "nothing should be counted while disabled");
+}
+
+void test_scopes_nest() {
+    alloc::enable();
+    {
+        const alloc::StageScope sort(Stage::Sort);
+        {
+            const alloc::StageScope map(Stage::Map);
+            allocate(8);
+        }
+        allocate(8);
+    }
+    expect_true(alloc::counts(Stage::Map).allocations == 1 && alloc::counts(Stage::Sort).allocations == 1,
+                "the outer stage should be restored when an inner scope ends");
+    alloc::disable();
+}
+
+void test_stage_is_per_thread() {
+    alloc::enable();
+    {
+        const alloc::StageScope sort(Stage::Sort);
+        std::thread worker([] {
+            const alloc::StageScope filter(Stage::Filter);
+            allocate(8);
+        });
+        worker.join();
+    }
+    expect_true(alloc::counts(Stage::Filter).allocations == 1, "a worker's allocation should count in its own stage");
+    alloc::disable();
+}
+
+void test_filter_budget() {
+    const std::vector<nt::RawHandle> handles = make_handles();
+    using filter_expr::CompareOp;
+    using filter_expr::Field;
+    const filter_expr::FilterProgram program = filter_expr::FilterProgram::compile(filter_expr::all_of({
+        filter_expr::make_test(Field::Pid, CompareOp::NotEqual, 8),
+        filter_expr::make_test(Field::Access, CompareOp::HasBits, 0x1F0000)}));
+    const filter_expr::FieldResolvers resolvers;
+
+    alloc::enable();
+    std::size_t matched = 0;
+    for (const nt::RawHandle& handle : handles) {
+        const alloc::StageScope scope(Stage::Filter);
+        matched += program.matches(handle, resolvers) ? 1 : 0;
+    }
+    expect_true(matched > 0 && alloc::counts(Stage::Filter).allocations == 0,
+                "raw-field filter tests should not allocate");
+
+    // The parallel selection allocates per chunk, never per handle.
+    alloc::enable();
+    const std::vector<nt::RawHandle> selected = [&] {
+        const alloc::StageScope scope(Stage::Filter);
+        return parallel::select(handles, [&](const nt::RawHandle& handle) { return program.matches(handle, resolvers); },
+                                parallel::ParallelOptions{.threads = 1});
+    }();
+    expect_true(selected.size() == matched && per_row(Stage::Filter) <= 0.01,
+                std::format("parallel selection should allocate per chunk (got {} per handle)", per_row(Stage::Filter)));
+    alloc::disable();
+}
+
+void test_sort_budget() {
+    StringInterner strings;
+    std::vector<HandleInfo> rows = make_rows(strings);
+
+    alloc::enable();
+    {
+        const alloc::StageScope scope(Stage::Sort);
+        sorting::sort_handles(rows, SortField::Name, strings);
+    }
+    expect_true(per_row(Stage::Sort) <= 0.01,
+                std::format("sorting by name should not allocate per row (got {} per row)", per_row(Stage::Sort)));
+    alloc::disable();
+}
+
+void test_print_budget() {
+    StringInterner strings;
+    const std::vector<HandleInfo> rows = make_rows(strings);
+    const HandlePrinter printer({Column::Pid, Column::Process, Column::Handle, Column::Type, Column::Name,
+                                 Column::Access, Column::Address});
+
+    alloc::enable();
+    std::size_t bytes = 0;
+    for (const HandleInfo& row : rows) {
+        const alloc::StageScope scope(Stage::Print);
+        bytes += printer.format_row(row, strings).size();
+    }
+    expect_true(bytes > 0 && per_row(Stage::Print) <= 1.0,
+                std::format("a formatted row should cost one allocation (got {} per row)", per_row(Stage::Print)));
+    alloc::disable();
+}
+
+} // namespace
+
+int main() {
+    test_counts_by_stage();
+    test_disabled_counts_nothing();
+    test_scopes_nest();
+    test_stage_is_per_thread();
+    test_filter_budget();
+    test_sort_budget();
+    test_print_budget();
+
+    if (failures == 0) {
+        std::cout << "All alloc tracker tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " alloc tracker test(s) failed.\n";
+    return EXIT_FAILURE;
+}
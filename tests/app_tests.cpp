@@ -1,15 +1,36 @@
+#include "alloc_tracker.hpp"
 #include "app.hpp"
+#include "latency.hpp"
 #include "nt.hpp"
+#include "snapshot_shm.hpp"
 
+#include <chrono>
 #include <cstdlib>
 #include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
 namespace {
 
 int failures = 0;
@@ -25,11 +46,30 @@ struct NtStubConfig {
     bool privilege_ok = true;
     bool query_ok = true;
     std::size_t handle_count = 3;
+    // When non-empty, returned instead of handle_count zeroed handles.
+    std::vector<nt::RawHandle> handles;
+    // When non-empty, returned from the second handle query on (a growing table).
+    std::vector<nt::RawHandle> grown_handles;
+    std::size_t handle_queries = 0;
     std::error_code privilege_error = std::make_error_code(std::errc::operation_not_permitted);
     std::error_code query_error = std::make_error_code(std::errc::io_error);
+    // Process snapshot; empty leaves every pid without a known instance.
+    std::vector<nt::ProcessIdentity> processes;
+    // Names by pid (default "<pid>.exe") and by object address (default: query fails).
+    std::unordered_map<uint32_t, std::string> process_names;
+    std::unordered_map<std::uintptr_t, std::string> object_names;
+    // When set, every type query succeeds with this name.
+    std::optional<std::string> type_name;
+    // Name queries for this object address take `slow_name_delay`.
+    std::uintptr_t slow_name_address = 0;
+    std::chrono::milliseconds slow_name_delay{0};
 };
 
 NtStubConfig g_nt_stub_config{};
+std::size_t g_type_queries = 0;
+std::size_t g_name_queries = 0;
+std::size_t g_process_queries = 0;
+std::size_t g_handle_queries = 0;
 
 struct RunResult {
     int exit_code = EXIT_FAILURE;
@@ -37,7 +77,7 @@ struct RunResult {
     std::string err;
 };
 
-RunResult run_app(std::initializer_list<const char*> args) {
+RunResult run_app(HandleEnumApp& app, std::initializer_list<const char*> args) {
     std::vector<std::string> owned;
     owned.reserve(args.size() + 1);
     owned.emplace_back("HandleEnum.exe");
@@ -57,7 +97,7 @@ RunResult run_app(std::initializer_list<const char*> args) {
     auto* old_out = std::cout.rdbuf(out_capture.rdbuf());
     auto* old_err = std::cerr.rdbuf(err_capture.rdbuf());
 
-    const int code = HandleEnumApp{}.run(static_cast<int>(argv.size()), argv.data());
+    const int code = app.run(static_cast<int>(argv.size()), argv.data());
 
     std::cout.rdbuf(old_out);
     std::cerr.rdbuf(old_err);
@@ -65,6 +105,11 @@ RunResult run_app(std::initializer_list<const char*> args) {
     return RunResult{code, out_capture.str(), err_capture.str()};
 }
 
+RunResult run_app(std::initializer_list<const char*> args) {
+    HandleEnumApp app;
+    return run_app(app, args);
+}
+
 void test_help_returns_success() {
     g_nt_stub_config = {};
     const auto result = run_app({"--help"});
@@ -126,6 +171,732 @@ void test_privilege_failure_only_warns() {
                 "query success path should still print summary");
 }
 
+void test_columns_skip_unneeded_queries() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handle_count = 4;
+    g_type_queries = 0;
+    g_name_queries = 0;
+
+    const auto result = run_app({"--columns", "pid,handle,type"});
+
+    expect_true(result.exit_code == EXIT_SUCCESS, "--columns run should succeed");
+    expect_true(result.out.find("PID      Handle     Type\n") != std::string::npos,
+                "header should contain only the requested columns");
+    expect_true(result.out.find("Name") == std::string::npos, "unrequested Name column should not be printed");
+    expect_true(g_type_queries == 4, "type should be resolved once per printed row");
+    expect_true(g_name_queries == 0, "name should not be resolved when not printed, sorted or filtered");
+}
+
+void test_name_sort_resolves_hidden_name() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handle_count = 3;
+    g_type_queries = 0;
+    g_name_queries = 0;
+
+    const auto result = run_app({"--columns", "pid", "--sort", "name"});
+
+    expect_true(result.exit_code == EXIT_SUCCESS, "--columns with --sort name should succeed");
+    expect_true(g_name_queries == 3, "sorting on name should resolve names even when not printed");
+    expect_true(g_type_queries == 0, "type should not be resolved when neither printed nor sorted on");
+}
+
+void test_where_skips_lookups_decided_by_pid() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handle_count = 3;
+    g_type_queries = 0;
+    g_name_queries = 0;
+
+    const auto result = run_app({"--where", "name~pipe and type=File and pid=4", "--count"});
+
+    expect_true(result.exit_code == EXIT_SUCCESS, "valid --where should succeed");
+    expect_true(result.out.find("Matching handles: 0") != std::string::npos, "no stub handle belongs to pid 4");
+    expect_true(g_type_queries == 0 && g_name_queries == 0,
+                "pid test should be evaluated first and skip type/name lookups");
+}
+
+void test_invalid_where_returns_failure() {
+    g_nt_stub_config = {};
+    const auto result = run_app({"--where", "pid=4 and"});
+
+    expect_true(result.exit_code == EXIT_FAILURE, "malformed --where should return failure");
+    expect_true(result.err.find("invalid --where expression") != std::string::npos,
+                "malformed --where should explain the error");
+}
+
+void test_shared_objects_resolves_only_reported_groups() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handles = {
+        nt::RawHandle{.objectAddress = 0xA000, .processId = 10, .handleValue = 0x10},
+        nt::RawHandle{.objectAddress = 0xB000, .processId = 10, .handleValue = 0x14},
+        nt::RawHandle{.objectAddress = 0xA000, .processId = 20, .handleValue = 0x20},
+        nt::RawHandle{.objectAddress = 0xC000, .processId = 30, .handleValue = 0x30},
+    };
+    g_type_queries = 0;
+    g_name_queries = 0;
+
+    const auto result = run_app({"--shared-objects", "2"});
+
+    expect_true(result.exit_code == EXIT_SUCCESS, "--shared-objects run should succeed");
+    expect_true(result.out.find("Object 0xA000") != std::string::npos, "shared object should be reported");
+    expect_true(result.out.find("0xB000") == std::string::npos, "object held by one process should not be reported");
+    expect_true(result.out.find("Shared objects: 1") != std::string::npos, "summary should count reported objects");
+    expect_true(result.out.find("20.exe") != std::string::npos, "holders should list their process names");
+    expect_true(g_type_queries == 1, "type should be resolved once for the single reported object");
+    expect_true(g_name_queries <= 2, "names should only be queried through the reported object's holders");
+}
+
+void test_record_then_query_history() {
+    const std::string path = (std::filesystem::temp_directory_path() / "handle_enum_app_history.bin").string();
+    std::filesystem::remove(path);
+
+    g_nt_stub_config = {};
+    g_nt_stub_config.handles = {
+        nt::RawHandle{.objectAddress = 0xA000, .processId = 10, .handleValue = 0x10},
+        nt::RawHandle{.objectAddress = 0xB000, .processId = 20, .handleValue = 0x20},
+    };
+    g_name_queries = 0;
+
+    const auto first = run_app({"--record", path.c_str(), "--columns", "pid,process,handle"});
+    expect_true(first.exit_code == EXIT_SUCCESS, "--record should succeed");
+    expect_true(first.out.find("Recorded 2 handles") != std::string::npos, "--record should report the frame");
+    expect_true(first.out.find("keyframe") != std::string::npos, "the first frame should be a keyframe");
+    expect_true(g_name_queries == 0, "--record should only resolve the requested columns");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    g_nt_stub_config.handles.push_back(nt::RawHandle{.objectAddress = 0xA000, .processId = 30, .handleValue = 0x30});
+    const auto second = run_app({"--record", path.c_str(), "--columns", "pid,process,handle"});
+    expect_true(second.exit_code == EXIT_SUCCESS && second.out.find("delta (+1 -0") != std::string::npos,
+                "the second frame should store only the new handle");
+
+    const auto frames = run_app({"--history", path.c_str()});
+    expect_true(frames.exit_code == EXIT_SUCCESS && frames.out.find("Frames: 2 of 2") != std::string::npos,
+                "--history should list both frames");
+
+    const auto held = run_app({"--history", path.c_str(), "--held", "0xA000"});
+    expect_true(held.exit_code == EXIT_SUCCESS, "--held query should succeed");
+    expect_true(held.out.find("Holding handles: 2") != std::string::npos, "two handles held 0xA000");
+    expect_true(held.out.find("30.exe") != std::string::npos, "holders should keep recorded process names");
+
+    const auto missing = run_app({"--history", (path + ".missing").c_str()});
+    expect_true(missing.exit_code == EXIT_FAILURE, "a missing history file should fail");
+
+    std::filesystem::remove(path);
+}
+
+void test_caches_survive_runs_and_pid_reuse() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handles = {
+        nt::RawHandle{.objectAddress = 0xA000, .processId = 10, .handleValue = 0x10, .objectTypeIndex = 37},
+        nt::RawHandle{.objectAddress = 0xA000, .processId = 20, .handleValue = 0x20, .objectTypeIndex = 37},
+    };
+    g_nt_stub_config.processes = {{.pid = 10, .createTime = 1000}, {.pid = 20, .createTime = 1000}};
+    g_nt_stub_config.process_names = {{10, "first.exe"}, {20, "other.exe"}};
+    g_nt_stub_config.object_names = {{0xA000, "\\Device\\Shared"}};
+    g_nt_stub_config.type_name = "File";
+    g_type_queries = 0;
+    g_name_queries = 0;
+    g_process_queries = 0;
+
+    HandleEnumApp app;
+    const auto first = run_app(app, {});
+    expect_true(first.exit_code == EXIT_SUCCESS && first.out.find("first.exe") != std::string::npos, "first run should succeed");
+    expect_true(g_process_queries == 2 && g_type_queries == 1 && g_name_queries == 1,
+                "the first run should resolve each process once and share the object's type and name");
+
+    const auto second = run_app(app, {"-v"});
+    expect_true(second.out.find("first.exe") != std::string::npos && second.out.find("\\Device\\Shared") != std::string::npos,
+                "cached names should still be printed");
+    expect_true(g_process_queries == 2 && g_type_queries == 1 && g_name_queries == 1,
+                "an unchanged snapshot should be served entirely from cache");
+    expect_true(second.out.find("process list unchanged") != std::string::npos, "verbose mode should report cache reuse");
+
+    // Pid 10 exits and its pid is reused by a new process that holds a
+    // different object at the same handle value.
+    g_nt_stub_config.processes = {{.pid = 10, .createTime = 2000}, {.pid = 20, .createTime = 1000}};
+    g_nt_stub_config.process_names[10] = "second.exe";
+    g_nt_stub_config.handles[0].objectAddress = 0xB000;
+    g_nt_stub_config.object_names[0xB000] = "\\Device\\Other";
+    const auto reused = run_app(app, {});
+    expect_true(reused.out.find("second.exe") != std::string::npos && reused.out.find("first.exe") == std::string::npos,
+                "a reused pid must not be served the previous process's name");
+    expect_true(reused.out.find("\\Device\\Other") != std::string::npos, "the new object's name should be queried");
+    expect_true(g_process_queries == 3, "only the reused pid should be queried again");
+    expect_true(g_name_queries == 2, "the surviving holder's object should stay cached");
+
+    // The surviving anchor keeps 0xA000 cached; once pid 20 restarts, its
+    // entry must go as well.
+    g_nt_stub_config.processes[1].createTime = 3000;
+    (void)run_app(app, {});
+    expect_true(g_process_queries == 4 && g_name_queries == 3,
+                "restarting the anchor process should evict its process and object names");
+}
+
+void test_max_memory_sort_matches_in_memory_sort() {
+    g_nt_stub_config = {};
+    for (std::uintptr_t i = 0; i < 200; ++i) {
+        const std::uintptr_t address = 0x10000 + i * 0x40;
+        g_nt_stub_config.handles.push_back(nt::RawHandle{
+            .objectAddress = address, .processId = 8 + i % 5 * 4, .handleValue = 4 + i * 4, .objectTypeIndex = 37});
+        if (i % 7 != 0) {
+            g_nt_stub_config.object_names[address] =
+                (i % 2 == 0 ? "\\BaseNamedObjects\\Event" : "\\basenamedobjects\\event") + std::to_string(i * 31 % 50);
+        }
+    }
+    g_nt_stub_config.type_name = "Event";
+
+    for (const char* field : {"name", "type"}) {
+        const auto in_memory = run_app({"--sort", field});
+        const auto spilled = run_app({"--sort", field, "--max-memory", "1K"});
+        expect_true(in_memory.exit_code == EXIT_SUCCESS && spilled.exit_code == EXIT_SUCCESS, "both sorts should succeed");
+        expect_true(spilled.out == in_memory.out, "spilling to disk should not change the output");
+    }
+
+    const auto verbose = run_app({"--sort", "name", "--max-memory", "1K", "-v"});
+    expect_true(verbose.out.find("Sort spilled") != std::string::npos, "verbose mode should report spilled runs");
+}
+
+void test_batch_shares_one_snapshot() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handles = {
+        nt::RawHandle{.objectAddress = 0xA000, .processId = 10, .handleValue = 0x10, .objectTypeIndex = 37},
+        nt::RawHandle{.objectAddress = 0xB000, .processId = 10, .handleValue = 0x14, .objectTypeIndex = 37},
+        nt::RawHandle{.objectAddress = 0xC000, .processId = 20, .handleValue = 0x20, .objectTypeIndex = 37},
+        nt::RawHandle{.objectAddress = 0xD000, .processId = 20, .handleValue = 0x24, .objectTypeIndex = 16},
+    };
+    // No process snapshot: names cannot go into the long-lived cache, so only
+    // the per-snapshot memo can avoid repeated queries. 0xD000 has no name.
+    g_nt_stub_config.object_names = {{0xA000, "\\Device\\NamedPipe\\one"}, {0xB000, "\\Device\\Disk"},
+                                     {0xC000, "\\Device\\NamedPipe\\two"}};
+    g_nt_stub_config.type_name = "File";
+
+    const auto directory = std::filesystem::temp_directory_path() / "handle_app_batch";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const std::string queries = (directory / "queries.txt").string();
+    {
+        std::ofstream file(queries);
+        file << "# health checks\n"
+             << "--sort name --columns pid,name\n"
+             << "\n"
+             << "--where 'name~pipe and pid=20' --count\n"
+             << "-t File -o Disk --columns pid,type\n";
+    }
+
+    g_type_queries = 0;
+    g_name_queries = 0;
+    g_handle_queries = 0;
+    const auto result = run_app({"--batch", queries.c_str()});
+    expect_true(result.exit_code == EXIT_SUCCESS, "a valid batch should succeed");
+    expect_true(g_handle_queries == 1, "all queries should share one acquisition");
+    expect_true(g_name_queries == 4 && g_type_queries == 2,
+                "each name (failures included) and each type index should be queried once");
+    expect_true(result.out.find("=== Query 2 (line 4): --where 'name~pipe and pid=20' --count ===") != std::string::npos,
+                "stdout sections should name each query and its line");
+    expect_true(result.out.find("Matching handles: 1") != std::string::npos, "the count query should see the snapshot");
+
+    const std::string out_dir = (directory / "out").string();
+    const auto split = run_app({"--batch", queries.c_str(), "--batch-output", out_dir.c_str()});
+    expect_true(split.exit_code == EXIT_SUCCESS && split.out.empty(), "--batch-output should keep stdout empty");
+    std::ifstream third(directory / "out" / "query-003.txt");
+    const std::string third_text((std::istreambuf_iterator<char>(third)), std::istreambuf_iterator<char>());
+    expect_true(third_text.find("PID      Type") != std::string::npos && third_text.find("Matching handles: 1") != std::string::npos,
+                "each query should get its own output file");
+
+    {
+        std::ofstream file(queries);
+        file << "--count\n--where 'pid ='\n--sort name\n";
+    }
+    g_handle_queries = 0;
+    const auto partial = run_app({"--batch", queries.c_str()});
+    expect_true(partial.exit_code == EXIT_FAILURE && partial.err.find("query 2 (line 2)") != std::string::npos,
+                "an invalid query should be reported with its line");
+    expect_true(partial.out.find("=== Query 3") != std::string::npos && g_handle_queries == 1,
+                "the remaining queries should still run");
+
+    std::filesystem::remove_all(directory);
+}
+
+void test_top_resolves_only_winners() {
+    g_nt_stub_config = {};
+    for (std::uintptr_t i = 0; i < 50; ++i) {
+        const std::uintptr_t address = 0x20000 + i * 0x40;
+        g_nt_stub_config.handles.push_back(nt::RawHandle{
+            .objectAddress = address, .processId = 4 + i % 5 * 4, .handleValue = 4 + i * 4, .objectTypeIndex = 37});
+        g_nt_stub_config.object_names[address] = "\\Name" + std::to_string(99 - i);
+    }
+    g_nt_stub_config.type_name = "File";
+
+    g_name_queries = 0;
+    g_process_queries = 0;
+    const auto by_pid = run_app({"--top", "3"});
+    expect_true(by_pid.exit_code == EXIT_SUCCESS, "--top should succeed");
+    expect_true(g_name_queries == 3 && g_process_queries == 1, "only the kept rows should be resolved");
+    expect_true(by_pid.out.find("Matching handles: 50 (first 3 shown)") != std::string::npos, "the footer should say rows were cut");
+
+    g_nt_stub_config.handles.resize(50);
+    const auto full = run_app({"--sort", "name"});
+    const auto top = run_app({"--sort", "name", "--top", "4"});
+    const auto rows_of = [](const std::string& text, const std::size_t count) {
+        std::size_t begin = text.find("PID");
+        std::size_t end = begin;
+        for (std::size_t i = 0; i <= count; ++i) {
+            end = text.find('\n', end) + 1;
+        }
+        return text.substr(begin, end - begin);
+    };
+    expect_true(rows_of(top.out, 4) == rows_of(full.out, 4), "top rows should match the head of the full sort");
+
+    const auto processes = run_app({"--count", "--top", "2", "--where", "handle > 8"});
+    expect_true(processes.out.find("Matching handles: 48") != std::string::npos, "--count --top should keep the total");
+    expect_true(processes.out.find("Top 2 processes by handle count:") != std::string::npos &&
+                processes.out.find("12       12.exe") != std::string::npos && processes.out.find("4.exe") == std::string::npos,
+                "--count --top should list the processes with the most handles");
+
+    const std::string huge = std::to_string(std::numeric_limits<std::size_t>::max());
+    for (const std::string& count : {std::string("51"), std::string("4000000000000000000"), huge}) {
+        const auto all = run_app({"--top", count.c_str()});
+        expect_true(all.exit_code == EXIT_SUCCESS && all.out.find("Matching handles: 50\n") != std::string::npos,
+                    "--top above the row count should list every row");
+        const auto all_processes = run_app({"--count", "--top", count.c_str()});
+        expect_true(all_processes.exit_code == EXIT_SUCCESS, "--count --top above the process count should succeed");
+    }
+}
+
+void test_limit_and_exists_stop_early() {
+    g_nt_stub_config = {};
+    for (std::uintptr_t i = 0; i < 1000; ++i) {
+        const std::uintptr_t address = 0x20000 + i * 0x40;
+        g_nt_stub_config.handles.push_back(nt::RawHandle{
+            .objectAddress = address, .processId = 4 + i % 5 * 4, .handleValue = 4 + i * 4, .objectTypeIndex = 37});
+        g_nt_stub_config.object_names[address] = (i == 10 || i == 500 ? "\\Target" : "\\Name") + std::to_string(i);
+    }
+    g_nt_stub_config.type_name = "File";
+
+    g_name_queries = 0;
+    const auto exists = run_app({"--exists", "-o", "Target", "--threads", "1"});
+    expect_true(exists.exit_code == EXIT_SUCCESS && exists.out.empty(), "--exists should succeed silently on a match");
+    expect_true(g_name_queries == 11, "--exists should stop filtering at the first match");
+
+    const auto missing = run_app({"--exists", "-o", "Nowhere", "--threads", "1"});
+    expect_true(missing.exit_code == EXIT_FAILURE && missing.out.empty() && missing.err.empty(),
+                "--exists should exit 1 without output when nothing matches");
+
+    g_name_queries = 0;
+    g_process_queries = 0;
+    const auto first = run_app({"--limit", "1", "-o", "Target", "--threads", "1"});
+    expect_true(first.exit_code == EXIT_SUCCESS && first.out.find("\\Target10") != std::string::npos &&
+                    first.out.find("\\Target500") == std::string::npos,
+                "--limit 1 should print only the first match");
+    expect_true(first.out.find("Matching handles: 1 (--limit reached)") != std::string::npos, "the footer should say the limit was reached");
+    // Eleven names tested by the filter, then the match's name for its row.
+    expect_true(g_name_queries == 12 && g_process_queries == 1, "nothing after the first match should be queried");
+
+    g_name_queries = 0;
+    const auto head = run_app({"--limit", "5"});
+    expect_true(g_name_queries == 5 && head.out.find("\\Name4") != std::string::npos && head.out.find("\\Name5") == std::string::npos,
+                "without a filter only the printed rows should be resolved");
+
+    // Blocks filtered in parallel overshoot a little but print the same rows.
+    g_name_queries = 0;
+    const auto parallel_first = run_app({"--limit", "1", "-o", "Target", "--threads", "4"});
+    expect_true(parallel_first.out == first.out, "parallel filtering should not change the rows printed");
+    // Blocks double, so at most twice the handles up to the match are tested.
+    expect_true(g_name_queries <= 2 * 11 + 1, "parallel filtering should stop within a block of the first match");
+
+    const auto all = run_app({"--limit", "10", "-o", "Target"});
+    expect_true(all.out.find("Matching handles: 2\n") != std::string::npos, "a limit above the matches should list them all");
+    const auto exact = run_app({"--limit", "2", "-o", "Target"});
+    expect_true(exact.out.find("Matching handles: 2 (--limit reached)\n") != std::string::npos,
+                "a limit equal to the matches should only say the limit was reached");
+}
+
+void test_unnamed_types_are_skipped() {
+    g_nt_stub_config = {};
+    // Type 12 never has a name; type 37 always does.
+    for (std::uintptr_t i = 0; i < 500; ++i) {
+        const std::uintptr_t address = 0x20000 + i * 0x40;
+        const bool named = i % 5 == 0;
+        g_nt_stub_config.handles.push_back(nt::RawHandle{
+            .objectAddress = address, .processId = 4, .handleValue = 4 + i * 4, .objectTypeIndex = static_cast<uint16_t>(named ? 37 : 12)});
+        g_nt_stub_config.object_names[address] = named ? "\\Named" + std::to_string(i) : "";
+    }
+
+    HandleEnumApp app;
+    g_name_queries = 0;
+    const auto adaptive = run_app(app, {"-v"});
+    // 100 named handles, 64 warm-up queries of type 12 and one probe among the other 336.
+    expect_true(adaptive.exit_code == EXIT_SUCCESS && g_name_queries == 100 + 64 + 1, "an unnamed type should stop being queried");
+    expect_true(adaptive.out.find("Name queries skipped: 335") != std::string::npos &&
+                    adaptive.out.find("type 12") != std::string::npos && adaptive.out.find("0 of 65 queried named") != std::string::npos,
+                "verbose output should report the skipped type");
+    expect_true(adaptive.out.find("\\Named495") != std::string::npos, "named types should still be printed");
+
+    g_name_queries = 0;
+    (void)run_app(app, {});
+    expect_true(g_name_queries == 100 + 1, "what was learned should carry over to the next run");
+
+    g_name_queries = 0;
+    const auto everything = run_app(app, {"--all-names", "-v"});
+    expect_true(g_name_queries == 500 && everything.out.find("Name queries skipped") == std::string::npos,
+                "--all-names should query every handle");
+
+    g_name_queries = 0;
+    (void)run_app(app, {"-o", "Named"});
+    expect_true(g_name_queries >= 500, "a name filter should see every name");
+}
+
+void test_deadline_returns_partial_rows_in_time() {
+    g_nt_stub_config = {};
+    // Every name query takes 30 ms: 40 handles would need 1.2 s.
+    for (std::uintptr_t i = 0; i < 40; ++i) {
+        g_nt_stub_config.handles.push_back(
+            nt::RawHandle{.objectAddress = 0, .processId = 100 + (i % 2) * 4, .handleValue = 4 + i * 4, .objectTypeIndex = 37});
+    }
+    g_nt_stub_config.object_names[0] = "\\Device\\NamedPipe\\slow";
+    g_nt_stub_config.slow_name_delay = std::chrono::milliseconds(30);
+    g_nt_stub_config.type_name = "File";
+
+    g_name_queries = 0;
+    g_type_queries = 0;
+    g_process_queries = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto partial = run_app({"--deadline", "0.2", "--name-timeout", "60", "-v"});
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    // The budget plus one name timeout, with slack for a loaded test host.
+    expect_true(partial.exit_code == EXIT_SUCCESS && elapsed < std::chrono::milliseconds(200 + 60 + 150),
+                "--deadline should end the run within one query timeout of the budget");
+    expect_true(g_process_queries == 2 && g_type_queries == 1 && g_name_queries > 0 && g_name_queries < 40,
+                "process names and types should be resolved before per-row names");
+    expect_true(partial.out.find("Matching handles: 40") != std::string::npos &&
+                    partial.out.find("<unresolved>") != std::string::npos &&
+                    partial.out.find("\\Device\\NamedPipe\\slow") != std::string::npos,
+                "every row should be printed, unresolved names marked");
+    expect_true(partial.out.find("stopped after") != std::string::npos &&
+                    partial.out.find(std::format("Complete rows: {} of 40", g_name_queries)) != std::string::npos &&
+                    partial.out.find("  process names  40 of 40") != std::string::npos &&
+                    partial.out.find("Phase one: 40 rows") != std::string::npos,
+                "the summary should report how complete the rows are");
+
+    g_nt_stub_config.slow_name_delay = std::chrono::milliseconds(0);
+    const auto complete = run_app({"--deadline", "5", "--columns", "pid,name", "-s", "name"});
+    expect_true(complete.exit_code == EXIT_SUCCESS && complete.out.find("finished in") != std::string::npos &&
+                    complete.out.find("Complete rows: 40 of 40 (100.0% of fields resolved)") != std::string::npos &&
+                    complete.out.find("<unresolved>") == std::string::npos && complete.out.find("  types") == std::string::npos,
+                "a run within budget should be complete and report only the fields it needs");
+
+    const auto limited = run_app({"--deadline", "5", "--limit", "3"});
+    expect_true(limited.out.find("Matching handles: 40 (first 3 shown)") != std::string::npos &&
+                    limited.out.find("Complete rows: 3 of 3") != std::string::npos,
+                "--limit should cut the rows before phase two");
+
+    g_name_queries = 0;
+    const auto filtered = run_app({"--deadline", "1", "-o", "slow"});
+    expect_true(filtered.exit_code == EXIT_FAILURE && filtered.err.find("name filter") != std::string::npos && g_name_queries == 0,
+                "a name filter should be rejected before any query");
+}
+
+void test_output_file_matches_stdout() {
+    g_nt_stub_config = {};
+    g_nt_stub_config.handle_count = 500;
+    g_nt_stub_config.type_name = "File";
+
+    const auto path = (std::filesystem::temp_directory_path() / "handle_app_output.txt").string();
+    const auto console = run_app({"--columns", "pid,handle,type"});
+    const auto redirected = run_app({"--columns", "pid,handle,type", "--output", path.c_str()});
+    expect_true(redirected.exit_code == EXIT_SUCCESS && redirected.out.empty(), "--output should leave stdout empty");
+
+    std::ifstream file(path, std::ios::binary);
+    const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    expect_true(written == console.out, "--output should write exactly what stdout would show");
+
+    const auto verbose = run_app({"--count", "-v", "--output", path.c_str()});
+    expect_true(verbose.out.find("Output: ") != std::string::npos, "verbose mode should report writer statistics");
+
+    const auto missing = run_app({"--output", (path + ".missing/out.txt").c_str()});
+    expect_true(missing.exit_code == EXIT_FAILURE && missing.err.find("Error:") != std::string::npos,
+                "an unwritable output path should fail before acquisition");
+    std::filesystem::remove(path);
+}
+
+void test_openmetrics_resolves_only_kept_series() {
+    g_nt_stub_config = {};
+    for (std::uintptr_t i = 0; i < 60; ++i) {
+        // pid 4 holds 30 handles, pid 8 holds 20, pids 12..20 the rest.
+        const std::uintptr_t pid = i < 30 ? 4 : i < 50 ? 8 : 12 + (i - 50) % 3 * 4;
+        g_nt_stub_config.handles.push_back(nt::RawHandle{
+            .objectAddress = 0x1000 + i, .processId = pid, .handleValue = 4 + i * 4,
+            .objectTypeIndex = static_cast<std::uint16_t>(i % 2 == 0 ? 37 : 12)});
+    }
+    g_nt_stub_config.type_name = "File";
+
+    const auto path = (std::filesystem::temp_directory_path() / "handle_app_metrics.prom").string();
+    g_type_queries = 0;
+    g_name_queries = 0;
+    g_process_queries = 0;
+    g_handle_queries = 0;
+    const auto result = run_app({"--openmetrics", path.c_str(), "--top", "2"});
+    expect_true(result.exit_code == EXIT_SUCCESS, "--openmetrics should succeed");
+    expect_true(g_handle_queries == 1 && g_name_queries == 0, "one table query and no name queries per export");
+    expect_true(g_process_queries == 2, "process names should be resolved for the kept series only");
+
+    std::ifstream file(path);
+    const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    expect_true(text.find("handleenum_process_handles{pid=\"4\",process=\"4.exe\"} 30\n") != std::string::npos &&
+                    text.find("handleenum_process_handles{pid=\"other\",process=\"other\"} 10\n") != std::string::npos,
+                "the largest processes and an other bucket should be exported");
+    expect_true(text.find("handleenum_type_handles{type=\"File\",type_index=\"37\"} 30\n") != std::string::npos,
+                "type series should carry the resolved type name");
+    expect_true(text.ends_with("# EOF\n"), "the textfile should be a complete exposition");
+    file.close();
+    std::filesystem::remove(path);
+
+    const auto filtered = run_app({"--openmetrics", "-", "--where", "pid=8"});
+    expect_true(filtered.out.find("handleenum_handles 20\n") != std::string::npos &&
+                    filtered.out.find("handleenum_system_handles 60\n") != std::string::npos,
+                "filters should apply before counting, and - should print to stdout");
+}
+
+// Replaces the stub table with `count` File handles. The first `pid4_count`
+// belong to pid 4, the rest to pid 8. Every `handles_per_object` consecutive
+// handles share an object, at `first_address` + 0x10 per object, named by
+// `object_name(i)` for the handle index i.
+void stub_file_handles(const std::uintptr_t count,
+                       const std::uintptr_t pid4_count,
+                       const std::uintptr_t first_address,
+                       const std::function<std::string(std::uintptr_t)>& object_name,
+                       const std::uint32_t granted_access = 0,
+                       const std::uintptr_t handles_per_object = 1) {
+    g_nt_stub_config = {};
+    for (std::uintptr_t i = 0; i < count; ++i) {
+        const std::uintptr_t address = first_address + i / handles_per_object * 0x10;
+        const std::uintptr_t pid = i < pid4_count ? 4 : 8;
+        g_nt_stub_config.handles.push_back(nt::RawHandle{
+            .objectAddress = address, .processId = pid, .handleValue = 4 + i * 4, .grantedAccess = granted_access,
+            .objectTypeIndex = 37, .handleAttributes = 0});
+        g_nt_stub_config.object_names[address] = object_name(i);
+    }
+    g_nt_stub_config.type_name = "File";
+}
+
+void test_sample_filters_only_sampled_handles() {
+    stub_file_handles(1000, 600, 0x40000, [](const std::uintptr_t i) {
+        return std::string(i % 2 == 0 ? "\\Device\\Pipe" : "\\Device\\File");
+    });
+
+    g_name_queries = 0;
+    const auto result = run_app({"--sample", "0.1", "--sample-seed", "42", "-o", "Pipe"});
+    expect_true(result.exit_code == EXIT_SUCCESS, "--sample should succeed");
+    expect_true(g_name_queries == 100, "a name filter should only query the sampled handles");
+    expect_true(result.out.find("Sampled 100 handles (10%, uniform).") != std::string::npos,
+                "the sample size should be reported");
+    expect_true(result.out.find("Estimated matching handles: ") != std::string::npos &&
+                    result.out.find("Top 2 processes by estimated handle count:") != std::string::npos &&
+                    result.out.find("4.exe") != std::string::npos,
+                "estimates per process should be printed");
+
+    const auto again = run_app({"--sample", "0.1", "--sample-seed", "42", "-o", "Pipe"});
+    expect_true(again.out == result.out, "the same seed should give the same report");
+
+    const auto by_pid = run_app({"--count", "--sample", "0.01", "--sample-by", "pid", "--sample-seed", "1"});
+    expect_true(by_pid.out.find("Estimated matching handles: 1000 (95% CI ") != std::string::npos &&
+                    by_pid.out.find(" .. 1000, 10 in sample)") != std::string::npos,
+                "without filters a per-process sample estimates the table exactly");
+    expect_true(by_pid.out.find("Top ") == std::string::npos, "--count should print only the total");
+}
+
+// The integer after the first `prefix` in `text`, or -1.
+long long number_after(const std::string& text, const std::string_view prefix) {
+    const std::size_t at = text.find(prefix);
+    if (at == std::string::npos) {
+        return -1;
+    }
+    std::istringstream rest(text.substr(at + prefix.size()));
+    long long value = -1;
+    rest >> value;
+    return value;
+}
+
+// Sketch estimates are approximate: allow a few percent.
+bool near(const long long value, const long long expected) {
+    return value >= expected * 97 / 100 && value <= expected * 103 / 100;
+}
+
+void test_sketch_accumulates_and_merges() {
+    const auto configure = [](const std::uintptr_t first_address) {
+        // Two handles per object; pid 4 holds the first 100 objects.
+        stub_file_handles(300, 200, first_address, [](const std::uintptr_t i) {
+            return i < 30 ? std::string("\\Device\\Afd") : std::format("\\Sessions\\x{}", i / 2);
+        }, 0, 2);
+    };
+
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto host_a = (directory / "handle_app_a.sketch").string();
+    const auto host_b = (directory / "handle_app_b.sketch").string();
+    const auto merged = (directory / "handle_app_merged.sketch").string();
+    for (const auto& path : {host_a, host_b, merged}) {
+        std::filesystem::remove(path);
+    }
+
+    configure(0x10000);
+    g_type_queries = 0;
+    const auto first = run_app({"--sketch", host_a.c_str()});
+    expect_true(first.exit_code == EXIT_SUCCESS, "--sketch should create the file");
+    expect_true(g_type_queries == 1, "the type should be resolved once per type index");
+    const auto second = run_app({"--sketch", host_a.c_str()});
+    expect_true(second.out.find("Sketch covers 2 snapshots, 600 handles.") != std::string::npos &&
+                    near(number_after(second.out, "Distinct objects: ~"), 150),
+                "a second snapshot of the same objects should add handles but not objects");
+    expect_true(near(number_after(second.out, "\n4.exe"), 100), "distinct objects per process name should be printed");
+    expect_true(second.out.find("       60  \\Device\\Afd\n") != std::string::npos,
+                "the most frequent name should lead with its handle count");
+
+    configure(0x90000);
+    expect_true(run_app({"--sketch", host_b.c_str(), "--where", "pid=8"}).exit_code == EXIT_SUCCESS,
+                "a filtered snapshot should update the sketch");
+
+    const std::string inputs = host_a + "," + host_b;
+    const auto combined = run_app({"--sketch", merged.c_str(), "--sketch-merge", inputs.c_str()});
+    expect_true(combined.exit_code == EXIT_SUCCESS, "--sketch-merge should succeed");
+    expect_true(combined.out.find("Merged 2 sketch files into") != std::string::npos &&
+                    combined.out.find("Sketch covers 3 snapshots, 700 handles.") != std::string::npos &&
+                    near(number_after(combined.out, "Distinct objects: ~"), 200),
+                "merging hosts should add counts and union the objects");
+    expect_true(near(number_after(combined.out, "\n8.exe"), 100), "the same process name on two hosts should share one counter");
+
+    const std::string missing = host_a + ",missing.sketch";
+    expect_true(run_app({"--sketch", merged.c_str(), "--sketch-merge", missing.c_str()}).exit_code == EXIT_FAILURE,
+                "a missing input should fail");
+    for (const auto& path : {host_a, host_b, merged}) {
+        std::filesystem::remove(path);
+    }
+}
+
+void test_latency_report_and_slow_log() {
+    stub_file_handles(20, 10, 0x5000, [](std::uintptr_t) { return std::string("\\Device\\NamedPipe\\x"); }, 0x0012019F);
+    g_nt_stub_config.slow_name_address = 0x5000 + 13 * 0x10;
+    g_nt_stub_config.slow_name_delay = std::chrono::milliseconds(60);
+
+    const auto result = run_app({"--latency", "--slow-log", "50", "--name-timeout", "5000", "-s", "name"});
+    expect_true(result.exit_code == EXIT_SUCCESS, "--latency should succeed");
+    expect_true(number_after(result.out, "\nname query") == 20, "every name query should be timed");
+    expect_true(result.out.find("Slowest types for name query by p99 (us):\n") != std::string::npos &&
+                    result.out.find("\n37 File ") != std::string::npos,
+                "per-type percentiles should name the type");
+    const std::size_t processes = result.out.find("Slowest processes for name query by p99 (us):\n");
+    expect_true(processes != std::string::npos &&
+                    result.out.find("\n8 8.exe ", processes) < result.out.find("\n4 4.exe ", processes),
+                "the process holding the slow handle should rank first");
+    expect_true(result.out.find("Slow NT calls (>= 50 ms): 1\n") != std::string::npos &&
+                    result.out.find("0x0012019F 0x38") != std::string::npos,
+                "the slow call should be logged with its access mask and handle");
+    expect_true(!latency::recorder().enabled(), "recording should stop after the report");
+
+    const auto timed_out = run_app({"--slow-log", "10", "--name-timeout", "20", "-s", "name"});
+    expect_true(timed_out.out.find("timed out") != std::string::npos, "abandoned name queries should be logged");
+    expect_true(timed_out.out.find("NT call latency") == std::string::npos, "--slow-log alone should not print percentiles");
+
+    const auto plain = run_app({"-s", "name"});
+    expect_true(plain.out.find("Slow NT calls") == std::string::npos, "nothing should be reported by default");
+    // Let the abandoned query finish before the stub config changes.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+void test_stats_reports_allocations_per_stage() {
+    stub_file_handles(40, 20, 0x6000, [](const std::uintptr_t i) { return std::format("\\Device\\NamedPipe\\pipe{}", i); },
+                      0x0012019F);
+
+    const auto result = run_app({"--stats", "-p", "8", "-s", "name"});
+    expect_true(result.exit_code == EXIT_SUCCESS, "--stats should succeed");
+    expect_true(result.out.find("Heap allocations (40 handles in snapshot, 20 rows mapped):\n") != std::string::npos,
+                "the report should name both denominators");
+    for (const std::string_view stage : {"\nacquire ", "\nfilter ", "\nmap ", "\nsort ", "\nprint ", "\nother ", "\ntotal "}) {
+        expect_true(result.out.find(stage) != std::string::npos, std::format("the report should have a{} row", stage));
+    }
+    expect_true(number_after(result.out, "\nmap ") > 0, "resolving names should allocate in the map stage");
+    expect_true(!alloc::enabled(), "counting should stop after the report");
+
+    const auto plain = run_app({"-s", "name"});
+    expect_true(plain.out.find("Heap allocations") == std::string::npos, "nothing should be reported by default");
+}
+
+void test_publish_writes_shared_memory() {
+    stub_file_handles(10, 4, 0x7000, [](const std::uintptr_t i) { return std::format("\\Device\\NamedPipe\\pipe{}", i); },
+                      0x0012019F);
+
+    const std::string name = std::format("app-tests-{}", getpid());
+    const auto result = run_app({"--publish", name.c_str(), "--publish-count", "2", "--publish-interval", "0.01", "-p", "8", "-v"});
+    expect_true(result.exit_code == EXIT_SUCCESS, "--publish should succeed");
+    expect_true(result.out.find(std::format("Publishing to shared memory '{}'", name)) != std::string::npos,
+                "the region should be announced");
+    expect_true(result.out.find("Published generation 1: 6 of 10 handles\n") != std::string::npos &&
+                    result.out.find("Published generation 2: 6 of 10 handles\n") != std::string::npos,
+                "each filtered snapshot should be reported");
+    expect_true(!shm::Reader::open(name).has_value(), "the region should be removed when the publisher exits");
+
+    // The table outgrows the first region (1 MiB slots) after one snapshot.
+    g_nt_stub_config.handles.resize(4);
+    g_nt_stub_config.handle_queries = 0;
+    for (std::uintptr_t i = 0; i < 30000; ++i) {
+        g_nt_stub_config.grown_handles.push_back(nt::RawHandle{
+            .objectAddress = 0x7000, .processId = 8, .handleValue = 4 + i * 4, .grantedAccess = 0x0012019F,
+            .objectTypeIndex = 37, .handleAttributes = 0});
+    }
+    const auto grown = run_app({"--publish", name.c_str(), "--publish-count", "3", "--publish-interval", "0.01", "-v"});
+    expect_true(grown.exit_code == EXIT_SUCCESS, "a snapshot that outgrows the region should not stop the publisher");
+    expect_true(grown.out.find("Published generation 1: 4 of 4 handles\n") != std::string::npos &&
+                    grown.out.find(std::format("Grew shared memory '{}'", name)) != std::string::npos &&
+                    grown.out.find("Published generation 2: 30000 of 30000 handles\n") != std::string::npos &&
+                    grown.out.find("Published generation 3: 30000 of 30000 handles\n") != std::string::npos,
+                "the publisher should move to a larger region and keep counting generations");
+}
+
+void test_export_then_merge_hosts() {
+    const auto directory = std::filesystem::temp_directory_path() / "handle_app_fleet";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // Two hosts, each holding the shared section and one pipe of its own.
+    for (const std::string_view host : {"alpha", "beta"}) {
+        g_nt_stub_config = {};
+        g_nt_stub_config.handles = {
+            nt::RawHandle{.objectAddress = 0x8000, .processId = 4, .handleValue = 0x10, .objectTypeIndex = 37},
+            nt::RawHandle{.objectAddress = 0x8010, .processId = 8, .handleValue = 0x20, .objectTypeIndex = 37}};
+        g_nt_stub_config.object_names[0x8000] = "\\BaseNamedObjects\\shared";
+        g_nt_stub_config.object_names[0x8010] = std::format("\\Device\\NamedPipe\\{}", host);
+        g_nt_stub_config.type_name = "File";
+        const std::string path = (directory / std::format("{}.snap", host)).string();
+        const auto exported = run_app({"--export", path.c_str(), "--host", std::string(host).c_str(), "-s", "name"});
+        expect_true(exported.exit_code == EXIT_SUCCESS &&
+                        exported.out.find(std::format("Exported 2 handles to {} (host {}, sorted by name,", path, host)) !=
+                            std::string::npos,
+                    "--export should write every matching handle");
+    }
+
+    const std::string fleet = directory.string();
+    const auto merged = run_app({"--merge", fleet.c_str(), "--columns", "pid,name"});
+    expect_true(merged.exit_code == EXIT_SUCCESS, "--merge should succeed");
+    const std::size_t alpha_shared = merged.out.find("alpha            4        \\BaseNamedObjects\\shared\n");
+    const std::size_t beta_shared = merged.out.find("beta             4        \\BaseNamedObjects\\shared\n");
+    const std::size_t alpha_pipe = merged.out.find("alpha            8        \\Device\\NamedPipe\\alpha\n");
+    const std::size_t beta_pipe = merged.out.find("beta             8        \\Device\\NamedPipe\\beta\n");
+    expect_true(alpha_shared != std::string::npos && beta_shared != std::string::npos &&
+                    alpha_pipe != std::string::npos && beta_pipe != std::string::npos,
+                "every row should be tagged with its host");
+    expect_true(alpha_shared < beta_shared && beta_shared < alpha_pipe && alpha_pipe < beta_pipe,
+                "rows should be merged in name order across hosts");
+    expect_true(merged.out.find("Merged handles: 4\n") != std::string::npos, "the footer should count every row");
+
+    const auto counted = run_app({"--merge", fleet.c_str(), "--count"});
+    expect_true(counted.out.find("2            2        \\BaseNamedObjects\\shared\n") != std::string::npos &&
+                    counted.out.find("1            1        \\Device\\NamedPipe\\beta\n") != std::string::npos,
+                "--count should give handles and hosts per name");
+    expect_true(counted.out.find("Merged handles: 4 in 3 groups\n") != std::string::npos, "the footer should count groups");
+
+    const auto resorted = run_app({"--merge", fleet.c_str(), "-s", "type"});
+    expect_true(resorted.exit_code == EXIT_FAILURE, "--sort should not contradict the files' order");
+    std::filesystem::remove_all(directory);
+}
+
 } // namespace
 
 namespace nt {
@@ -138,24 +909,54 @@ std::expected<void, std::error_code> enable_debug_privilege() {
 }
 
 std::expected<std::vector<RawHandle>, std::error_code> query_system_handles() {
+    ++g_handle_queries;
     if (!g_nt_stub_config.query_ok) {
         return std::unexpected(g_nt_stub_config.query_error);
     }
 
+    if (++g_nt_stub_config.handle_queries > 1 && !g_nt_stub_config.grown_handles.empty()) {
+        return g_nt_stub_config.grown_handles;
+    }
+    if (!g_nt_stub_config.handles.empty()) {
+        return g_nt_stub_config.handles;
+    }
+
     std::vector<RawHandle> handles;
     handles.resize(g_nt_stub_config.handle_count);
     return handles;
 }
 
+std::expected<std::vector<ProcessIdentity>, std::error_code> query_process_snapshot() {
+    return g_nt_stub_config.processes;
+}
+
 std::expected<std::string, Error> query_object_type(const RawHandle&) noexcept {
+    ++g_type_queries;
+    if (g_nt_stub_config.type_name) {
+        return *g_nt_stub_config.type_name;
+    }
     return std::unexpected(std::make_error_code(std::errc::not_supported));
 }
 
-std::expected<std::string, Error> query_object_name(const RawHandle&) noexcept {
+std::expected<std::string, Error> query_object_name(const RawHandle& handle) noexcept {
+    ++g_name_queries;
+    // Timed like the real query.
+    const latency::ScopedTimer timer(latency::Call::NameQuery, static_cast<uint32_t>(handle.processId),
+                                     handle.objectTypeIndex, handle.grantedAccess, handle.handleValue);
+    if (handle.objectAddress == g_nt_stub_config.slow_name_address) {
+        std::this_thread::sleep_for(g_nt_stub_config.slow_name_delay);
+    }
+    if (const auto it = g_nt_stub_config.object_names.find(handle.objectAddress); it != g_nt_stub_config.object_names.end()) {
+        return it->second;
+    }
     return std::unexpected(std::make_error_code(std::errc::not_supported));
 }
 
 std::string get_process_name_by_pid(const uint32_t pid) noexcept {
+    ++g_process_queries;
+    if (const auto it = g_nt_stub_config.process_names.find(pid); it != g_nt_stub_config.process_names.end()) {
+        return it->second;
+    }
     return std::to_string(pid) + ".exe";
 }
 
@@ -167,6 +968,27 @@ int main() {
     test_successful_flow_prints_summary();
     test_query_failure_returns_failure();
     test_privilege_failure_only_warns();
+    test_columns_skip_unneeded_queries();
+    test_name_sort_resolves_hidden_name();
+    test_where_skips_lookups_decided_by_pid();
+    test_invalid_where_returns_failure();
+    test_shared_objects_resolves_only_reported_groups();
+    test_record_then_query_history();
+    test_caches_survive_runs_and_pid_reuse();
+    test_max_memory_sort_matches_in_memory_sort();
+    test_batch_shares_one_snapshot();
+    test_top_resolves_only_winners();
+    test_output_file_matches_stdout();
+    test_openmetrics_resolves_only_kept_series();
+    test_sample_filters_only_sampled_handles();
+    test_sketch_accumulates_and_merges();
+    test_latency_report_and_slow_log();
+    test_limit_and_exists_stop_early();
+    test_unnamed_types_are_skipped();
+    test_deadline_returns_partial_rows_in_time();
+    test_stats_reports_allocations_per_stage();
+    test_publish_writes_shared_memory();
+    test_export_then_merge_hosts();
 
     if (failures == 0) {
         std::cout << "All app tests passed.\n";
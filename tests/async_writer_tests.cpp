@@ -0,0 +1,178 @@
+#include "async_writer.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// Records every byte; optionally blocks its first batch until released.
+class MemoryBackend final : public output::WriteBackend {
+public:
+    explicit MemoryBackend(std::shared_future<void> gate = {}) : m_gate(std::move(gate)) {}
+
+    std::expected<void, std::string> write_batch(const std::span<const std::span<const char>> buffers) override {
+        if (m_gate.valid()) {
+            m_gate.wait();
+        }
+        const std::lock_guard lock(m_mutex);
+        for (const std::span<const char> buffer : buffers) {
+            m_bytes.append(buffer.data(), buffer.size());
+        }
+        return {};
+    }
+
+    std::string_view name() const noexcept override { return "memory"; }
+
+    [[nodiscard]] std::string bytes() const {
+        const std::lock_guard lock(m_mutex);
+        return m_bytes;
+    }
+
+private:
+    std::shared_future<void> m_gate;
+    mutable std::mutex m_mutex;
+    std::string m_bytes;
+};
+
+class FailingBackend final : public output::WriteBackend {
+public:
+    std::expected<void, std::string> write_batch(std::span<const std::span<const char>>) override {
+        return std::unexpected("disk full");
+    }
+    std::string_view name() const noexcept override { return "failing"; }
+};
+
+[[nodiscard]] std::string pattern(const std::size_t size) {
+    std::string text;
+    text.reserve(size);
+    for (std::size_t i = 0; text.size() < size; ++i) {
+        text += std::to_string(i) + (i % 17 == 0 ? "\n" : " ");
+    }
+    text.resize(size);
+    return text;
+}
+
+void test_spsc_ring_preserves_order_across_threads() {
+    output::SpscRing<int> ring(3);
+    expect_true(ring.capacity() == 4, "capacity should round up to a power of two");
+
+    constexpr int kCount = 200'000;
+    std::thread producer([&] {
+        for (int i = 0; i < kCount; ++i) {
+            int value = i;
+            while (!ring.try_push(value)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool ordered = true;
+    for (int expected = 0; expected < kCount; ++expected) {
+        ring.wait_nonempty();
+        const std::optional<int> value = ring.try_pop();
+        ordered = ordered && value && *value == expected;
+    }
+    producer.join();
+    expect_true(ordered, "values should arrive once each and in order");
+    expect_true(!ring.try_pop().has_value(), "the ring should be empty afterwards");
+}
+
+void test_file_output_matches_for_each_backend() {
+    const auto path = std::filesystem::temp_directory_path() / "handle_async_writer.txt";
+    const std::string text = pattern(3 * 1024 * 1024 + 123);
+
+    for (const bool io_uring : {true, false}) {
+        {
+            auto writer = output::AsyncWriter::open(path, {.bufferBytes = 64 * 1024, .bufferCount = 2, .allowIoUring = io_uring});
+            expect_true(writer.has_value(), "opening the output file should succeed");
+            if (!writer) {
+                continue;
+            }
+            std::ostream stream(writer->get());
+            // Mixed small and large writes, with flushes in between.
+            stream << text.substr(0, 10) << std::flush;
+            stream.put(text[10]);
+            stream.write(text.data() + 11, static_cast<std::streamsize>(text.size() - 11));
+            expect_true(writer.value()->close().has_value(), "closing should report success");
+            expect_true(writer.value()->stats().bytes == text.size(), "stats should count every byte");
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        expect_true(written == text, io_uring ? "the default backend should write the exact bytes"
+                                              : "the write(2) fallback should write the exact bytes");
+    }
+
+    std::filesystem::remove(path);
+    expect_true(!output::AsyncWriter::open(path / "missing" / "out.txt").has_value(), "an unwritable path should fail");
+}
+
+void test_producer_does_not_wait_on_a_stalled_disk() {
+    std::promise<void> release;
+    auto backend = std::make_unique<MemoryBackend>(release.get_future().share());
+    MemoryBackend& memory = *backend;
+    output::AsyncWriter writer(std::move(backend), {.bufferBytes = 1024, .bufferCount = 4});
+    std::ostream stream(&writer);
+
+    // The disk is stuck on the first buffer; every other buffer can still be filled.
+    const std::string text = pattern(4 * 1024);
+    stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+    expect_true(writer.stats().producerWaits == 0, "filling every buffer should not wait on the disk");
+
+    release.set_value();
+    stream << "tail";
+    expect_true(writer.close().has_value(), "close should succeed");
+    expect_true(memory.bytes() == text + "tail", "bytes should arrive in order");
+
+    const output::WriterStats stats = writer.stats();
+    expect_true(stats.buffers == 5 && stats.batches < stats.buffers,
+                "buffers queued behind a slow write should be coalesced into one batch");
+}
+
+void test_write_errors_surface_on_close() {
+    output::AsyncWriter writer(std::make_unique<FailingBackend>(), {.bufferBytes = 256, .bufferCount = 2});
+    std::ostream stream(&writer);
+    const std::string text = pattern(100 * 256);
+    stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+    expect_true(stream.good(), "the producer should keep running after a write error");
+
+    const auto closed = writer.close();
+    expect_true(!closed && closed.error() == "disk full", "close should report the first write error");
+    expect_true(!writer.close().has_value(), "closing again should repeat the result");
+    expect_true(writer.stats().bytes == 0, "failed writes should not be counted");
+}
+
+} // namespace
+
+int main() {
+    test_spsc_ring_preserves_order_across_threads();
+    test_file_output_matches_for_each_backend();
+    test_producer_does_not_wait_on_a_stalled_disk();
+    test_write_errors_surface_on_close();
+
+    if (failures == 0) {
+        std::cout << "All async_writer tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " async_writer test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -1,5 +1,7 @@
 #include "cli_parser.hpp"
 
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -80,6 +82,275 @@ void test_unknown_argument() {
     expect_true(!result.has_value(), "unknown argument should fail");
 }
 
+void test_name_timeout() {
+    auto result = parse_args({"--name-timeout", "75"});
+    expect_true(result.has_value() && result->nameTimeoutMs == 75u, "name timeout should be parsed from --name-timeout");
+
+    auto zero = parse_args({"--name-timeout", "0"});
+    expect_true(!zero.has_value(), "zero name timeout should fail");
+}
+
+void test_threads() {
+    auto result = parse_args({"--threads", "6"});
+    expect_true(result.has_value() && result->threads == 6u, "thread count should be parsed from --threads");
+    expect_true(!parse_args({"--threads", "many"}).has_value(), "non-numeric thread count should fail");
+    expect_true(!parse_args({"--threads", "-1"}).has_value(), "a negative thread count should not wrap around");
+    expect_true(!parse_args({"--threads", "0"}).has_value(), "zero threads should fail");
+    expect_true(!parse_args({"--threads", "4x"}).has_value(), "trailing characters should fail");
+    expect_true(parse_args({"--threads", "1024"}).has_value() && !parse_args({"--threads", "1025"}).has_value(),
+                "thread counts above 1024 should fail");
+}
+
+void test_shared_objects() {
+    auto result = parse_args({"--shared-objects", "3"});
+    expect_true(result.has_value() && result->sharedObjectsMin == 3u, "--shared-objects should store the minimum");
+    expect_true(!parse_args({"--shared-objects", "1"}).has_value(), "a minimum below two should fail");
+    expect_true(!parse_args({"--shared-objects"}).has_value(), "missing minimum should fail");
+    expect_true(!parse_args({"--shared-objects", "2", "-c"}).has_value(), "--shared-objects with --count should fail");
+}
+
+void test_columns() {
+    auto result = parse_args({"--columns", "pid,type,address"});
+    expect_true(result.has_value(), "--columns should parse a valid list");
+    if (result) {
+        const std::vector<Column> expected{Column::Pid, Column::Type, Column::Address};
+        expect_true(result->columns == expected, "--columns should keep the requested order");
+    }
+
+    expect_true(!parse_args({"--columns", "pid,bogus"}).has_value(), "unknown column should fail");
+    expect_true(!parse_args({"--columns", "pid,pid"}).has_value(), "duplicate column should fail");
+    expect_true(!parse_args({"--columns", ""}).has_value(), "empty column list should fail");
+}
+
+void test_max_memory() {
+    auto result = parse_args({"--max-memory", "512M", "-s", "name"});
+    expect_true(result.has_value() && result->maxMemoryBytes == std::size_t{512} << 20, "--max-memory should accept M");
+    expect_true(parse_args({"--max-memory", "64k"}).value_or(CliOptions{}).maxMemoryBytes == std::size_t{64} << 10,
+                "--max-memory should accept lowercase suffixes");
+    expect_true(parse_args({"--max-memory", "4096"}).value_or(CliOptions{}).maxMemoryBytes == 4096u,
+                "--max-memory should accept plain bytes");
+    expect_true(!parse_args({"--max-memory", "0"}).has_value(), "a zero budget should fail");
+    expect_true(!parse_args({"--max-memory", "12X"}).has_value(), "an unknown suffix should fail");
+    expect_true(!parse_args({"--max-memory", "G"}).has_value(), "a suffix without digits should fail");
+    expect_true(!parse_args({"--max-memory"}).has_value(), "missing budget should fail");
+}
+
+void test_history_options() {
+    auto result = parse_args({"--history", "h.bin", "--held", "0xFFFF8001", "--from", "2024-03-01T10:02", "--to", "1709287500"});
+    expect_true(result.has_value(), "--history query options should parse");
+    if (result) {
+        expect_true(result->historyPath == "h.bin", "--history should store the path");
+        expect_true(result->heldAddress == 0xFFFF8001ull, "--held should accept hex addresses");
+        expect_true(result->fromMs == 1709287320000ll, "--from should parse a UTC date and time");
+        expect_true(result->toMs == 1709287500000ll, "--to should parse epoch seconds");
+    }
+
+    auto seconds = parse_args({"--history", "h.bin", "--from", "2024-03-01 10:02:30"});
+    expect_true(seconds.has_value() && seconds->fromMs == 1709287350000ll, "seconds and a space separator should be accepted");
+
+    auto record = parse_args({"--record", "h.bin", "-t", "File"});
+    expect_true(record.has_value() && record->recordPath == "h.bin", "--record should store the path");
+
+    expect_true(!parse_args({"--held", "0x10"}).has_value(), "--held without --history should fail");
+    expect_true(!parse_args({"--history", "h.bin", "--held", "0x10zz"}).has_value(), "invalid address should fail");
+    expect_true(!parse_args({"--history", "h.bin", "--from", "2024-02-30T10:00"}).has_value(), "invalid date should fail");
+    expect_true(!parse_args({"--history", "h.bin", "--from", "10:00"}).has_value(), "malformed time should fail");
+    expect_true(!parse_args({"--history", "h.bin", "--from", "200", "--to", "100"}).has_value(), "reversed range should fail");
+    expect_true(!parse_args({"--history", "a.bin", "--record", "b.bin"}).has_value(), "record and history are exclusive");
+    expect_true(!parse_args({"--record", "h.bin", "-c"}).has_value(), "record cannot be combined with --count");
+}
+
+void test_batch_options() {
+    auto batch = parse_args({"--batch", "q.txt", "--batch-output", "out", "-v", "--threads", "2"});
+    expect_true(batch.has_value() && batch->batchPath == "q.txt" && batch->batchOutputDir == "out",
+                "--batch should accept snapshot-wide options");
+    expect_true(!parse_args({"--batch", "q.txt", "-t", "File"}).has_value(), "per-query options belong in the query file");
+    expect_true(!parse_args({"--batch-output", "out"}).has_value(), "--batch-output without --batch should fail");
+
+    auto split = cli::split_arguments("  --where 'name = \"A B\"'  -o \\Device\\Pipe \"\"");
+    expect_true(split.has_value() && split->size() == 5, "quoted text should stay one argument");
+    if (split && split->size() == 5) {
+        expect_true((*split)[1] == "name = \"A B\"", "single quotes should keep inner double quotes");
+        expect_true((*split)[3] == "\\Device\\Pipe", "backslashes should be kept literally");
+        expect_true((*split)[4].empty(), "an empty quoted argument should be kept");
+    }
+    expect_true(!cli::split_arguments("--where 'pid=4").has_value(), "an unterminated quote should fail");
+
+    const auto path = (std::filesystem::temp_directory_path() / "handle_cli_batch.txt").string();
+    {
+        std::ofstream file(path);
+        file << "# comment\n\n-s name --columns pid,name\r\n  --where \"pid in {4, 8}\" -c  \n";
+    }
+    auto queries = cli::load_batch(path);
+    expect_true(queries.has_value() && queries->size() == 2, "comments and blank lines should be skipped");
+    if (queries && queries->size() == 2) {
+        expect_true((*queries)[0].line == 3 && (*queries)[0].options.sortBy == SortField::Name, "line numbers should be 1-based");
+        expect_true((*queries)[1].text == "--where \"pid in {4, 8}\" -c" && (*queries)[1].options.showCountOnly,
+                    "query text should be trimmed");
+    }
+
+    {
+        std::ofstream file(path);
+        file << "-c\n--record h.bin\n";
+    }
+    auto nested = cli::load_batch(path);
+    expect_true(!nested.has_value() && nested.error().find(":2:") != std::string::npos,
+                "snapshot-wide options in a query should fail with the line number");
+
+    {
+        std::ofstream file(path);
+        file << "--limit 5 -o Pipe\n--exists -o Pipe\n";
+    }
+    auto exit_code_query = cli::load_batch(path);
+    expect_true(!exit_code_query.has_value() && exit_code_query.error().find(":2:") != std::string::npos,
+                "--limit should be allowed in a query but --exists should not");
+
+    {
+        std::ofstream file(path);
+        file << "# nothing\n";
+    }
+    expect_true(!cli::load_batch(path).has_value(), "a query file without queries should fail");
+    expect_true(!cli::load_batch(path + ".missing").has_value(), "a missing query file should fail");
+    std::filesystem::remove(path);
+}
+
+void test_top() {
+    auto result = parse_args({"--top", "20", "-s", "name"});
+    expect_true(result.has_value() && result->topN == 20u, "--top should store the row count");
+    expect_true(!parse_args({"--top", "0"}).has_value(), "--top 0 should fail");
+    expect_true(!parse_args({"--top", "5x"}).has_value(), "a malformed count should fail");
+    expect_true(!parse_args({"--top", "5", "--max-memory", "1M"}).has_value(), "--top already bounds memory");
+    expect_true(!parse_args({"--top", "5", "--record", "h.bin"}).has_value(), "--top cannot cut a recorded snapshot");
+}
+
+void test_output() {
+    auto result = parse_args({"--output", "out.txt", "-s", "name"});
+    expect_true(result.has_value() && result->outputPath == "out.txt", "--output should store the path");
+    expect_true(!parse_args({"--output"}).has_value(), "missing output path should fail");
+}
+
+void test_openmetrics() {
+    auto result = parse_args({"--openmetrics", "handles.prom", "--top", "10", "--where", "type=File"});
+    expect_true(result.has_value() && result->openMetricsPath == "handles.prom" && result->topN == 10u,
+                "--openmetrics should store the path and keep --top");
+    result = parse_args({"--openmetrics-port", "9464"});
+    expect_true(result.has_value() && result->openMetricsPort == 9464, "--openmetrics-port should store the port");
+    expect_true(!parse_args({"--openmetrics-port", "0"}).has_value(), "port 0 should fail");
+    expect_true(!parse_args({"--openmetrics-port", "70000"}).has_value(), "out-of-range port should fail");
+    expect_true(!parse_args({"--openmetrics", "a.prom", "--openmetrics-port", "9464"}).has_value(),
+                "file and port should not combine");
+    expect_true(!parse_args({"--openmetrics", "a.prom", "--count"}).has_value(), "--openmetrics with --count should fail");
+}
+
+void test_sample() {
+    auto result = parse_args({"--sample", "0.05", "--sample-by", "pid", "--sample-seed", "7", "-o", "pipe"});
+    expect_true(result.has_value() && result->sampleFraction == 0.05 && result->sampleByPid && result->sampleSeed == 7u,
+                "--sample options should be stored");
+    expect_true(parse_args({"--sample", "1"}).has_value(), "a fraction of 1 should be accepted");
+    expect_true(!parse_args({"--sample", "0"}).has_value(), "a zero fraction should fail");
+    expect_true(!parse_args({"--sample", "1.5"}).has_value(), "a fraction above 1 should fail");
+    expect_true(!parse_args({"--sample", "abc"}).has_value(), "a non-numeric fraction should fail");
+    expect_true(!parse_args({"--sample", "0.1", "--sample-by", "type"}).has_value(), "unknown sampling mode should fail");
+    expect_true(!parse_args({"--sample-seed", "3"}).has_value(), "--sample-seed without --sample should fail");
+    expect_true(!parse_args({"--sample", "0.1", "--shared-objects", "2"}).has_value(),
+                "--sample with --shared-objects should fail");
+}
+
+void test_sketch() {
+    auto result = parse_args({"--sketch", "host.sketch", "--top", "5", "-t", "File"});
+    expect_true(result.has_value() && result->sketchPath == "host.sketch" && result->topN == 5u, "--sketch should store the path");
+    result = parse_args({"--sketch", "all.sketch", "--sketch-merge", "a.sketch,b.sketch"});
+    expect_true(result.has_value() && result->sketchMergePaths == std::vector<std::string>{"a.sketch", "b.sketch"},
+                "--sketch-merge should split the file list");
+    expect_true(!parse_args({"--sketch-merge", "a.sketch"}).has_value(), "--sketch-merge without --sketch should fail");
+    expect_true(!parse_args({"--sketch", "s", "--sketch-merge", "a,,b"}).has_value(), "an empty list item should fail");
+    expect_true(!parse_args({"--sketch", "s", "--count"}).has_value(), "--sketch with --count should fail");
+    expect_true(!parse_args({"--sketch", "s", "--sample", "0.1"}).has_value(), "--sketch with --sample should fail");
+}
+
+void test_latency() {
+    auto result = parse_args({"--latency", "--slow-log", "100", "-t", "File"});
+    expect_true(result.has_value() && result->latencyReport && result->slowLogMs == 100u,
+                "--latency and --slow-log should be stored");
+    expect_true(!parse_args({"--slow-log", "0"}).has_value(), "a zero threshold should fail");
+    expect_true(!parse_args({"--slow-log", "fast"}).has_value(), "a malformed threshold should fail");
+    expect_true(!parse_args({"--latency", "--history", "h.bin"}).has_value(), "--latency with --history should fail");
+    expect_true(!parse_args({"--slow-log", "5", "--openmetrics", "-"}).has_value(), "--slow-log with --openmetrics should fail");
+}
+
+void test_stats() {
+    auto result = parse_args({"--stats", "-s", "name"});
+    expect_true(result.has_value() && result->stats, "--stats should be stored");
+    expect_true(!parse_args({}).value().stats, "--stats should be off by default");
+    expect_true(!parse_args({"--stats", "--history", "h.bin"}).has_value(), "--stats with --history should fail");
+    expect_true(!parse_args({"--stats", "--openmetrics-port", "9400"}).has_value(), "--stats with --openmetrics-port should fail");
+}
+
+void test_publish() {
+    auto result = parse_args({"--publish", "edr", "--publish-interval", "0.5", "--publish-count", "3", "-p", "4"});
+    expect_true(result.has_value() && result->publishName == "edr" && result->publishIntervalMs == 500u &&
+                    result->publishCount == 3u,
+                "--publish and its interval and count should be stored");
+    expect_true(parse_args({"--publish", "edr"}).value().publishIntervalMs == std::nullopt,
+                "the interval should default in the app");
+    expect_true(!parse_args({"--publish-interval", "1"}).has_value(), "--publish-interval without --publish should fail");
+    expect_true(!parse_args({"--publish-count", "1"}).has_value(), "--publish-count without --publish should fail");
+    expect_true(!parse_args({"--publish", "edr", "--publish-interval", "0"}).has_value(), "a zero interval should fail");
+    expect_true(!parse_args({"--publish", "edr", "--publish-count", "0"}).has_value(), "a zero count should fail");
+    expect_true(!parse_args({"--publish", "edr", "--count"}).has_value(), "--publish with --count should fail");
+    expect_true(!parse_args({"--batch", "q.txt", "--publish", "edr"}).has_value(), "--publish with --batch should fail");
+}
+
+void test_export_and_merge() {
+    auto exported = parse_args({"--export", "host.snap", "--host", "web-01", "-s", "name", "-t", "File"});
+    expect_true(exported.has_value() && exported->exportPath == "host.snap" && exported->exportHost == "web-01",
+                "--export and --host should be stored");
+    expect_true(!parse_args({"--host", "web-01"}).has_value(), "--host without --export should fail");
+    expect_true(!parse_args({"--export", "h.snap", "--count"}).has_value(), "--export with --count should fail");
+
+    auto merged = parse_args({"--merge", "a.snap,fleet", "--count"});
+    expect_true(merged.has_value() && merged->mergePaths == std::vector<std::string>{"a.snap", "fleet"} &&
+                    merged->showCountOnly,
+                "--merge should store its list and allow --count");
+    expect_true(!parse_args({"--merge", "a.snap,,b.snap"}).has_value(), "an empty list entry should fail");
+    expect_true(!parse_args({"--merge", "a.snap", "-t", "File"}).has_value(), "--merge with a filter should fail");
+    expect_true(!parse_args({"--merge", "a.snap", "--export", "b.snap"}).has_value(), "--merge with --export should fail");
+}
+
+void test_all_names() {
+    auto result = parse_args({"--all-names", "-s", "name"});
+    expect_true(result.has_value() && result->allNames, "--all-names should be stored");
+    expect_true(parse_args({}).has_value() && !parse_args({})->allNames, "names should be skipped adaptively by default");
+    expect_true(!parse_args({"--batch", "q.txt", "--all-names"}).has_value(), "--all-names belongs in the query file");
+}
+
+void test_limit_and_exists() {
+    auto limit = parse_args({"--limit", "10", "-o", "Pipe"});
+    expect_true(limit.has_value() && limit->limit == 10u && !limit->exists, "--limit should store the row count");
+    auto exists = parse_args({"--exists", "--where", "name~config.sys", "-s", "name"});
+    expect_true(exists.has_value() && exists->exists, "--exists should be stored and ignore the sort order");
+    expect_true(!parse_args({"--limit", "0"}).has_value(), "--limit 0 should fail");
+    expect_true(!parse_args({"--limit", "3", "-s", "type"}).has_value(), "--limit with a sort order should point to --top");
+    expect_true(!parse_args({"--limit", "3", "--exists"}).has_value(), "--limit and --exists should not combine");
+    expect_true(!parse_args({"--exists", "--count"}).has_value(), "--exists with --count should fail");
+    expect_true(!parse_args({"--limit", "3", "--top", "3"}).has_value(), "--limit with --top should fail");
+    expect_true(!parse_args({"--batch", "q.txt", "--limit", "3"}).has_value(), "--limit belongs in the query file");
+}
+
+void test_deadline() {
+    auto seconds = parse_args({"--deadline", "5"});
+    expect_true(seconds.has_value() && seconds->deadlineMs == 5000u, "--deadline should store milliseconds");
+    auto sorted = parse_args({"--deadline", "0.25", "-s", "name", "-t", "File"});
+    expect_true(sorted.has_value() && sorted->deadlineMs == 250u, "--deadline should accept fractions of a second");
+    expect_true(!parse_args({"--deadline", "0"}).has_value(), "--deadline 0 should fail");
+    expect_true(!parse_args({"--deadline", "-1"}).has_value(), "a negative deadline should fail");
+    expect_true(!parse_args({"--deadline", "5s"}).has_value(), "a deadline with a unit should fail");
+    expect_true(!parse_args({"--deadline", "5", "--count"}).has_value(), "--deadline with --count should fail");
+    expect_true(!parse_args({"--deadline", "5", "--top", "3"}).has_value(), "--deadline with --top should fail");
+    expect_true(!parse_args({"--deadline", "5", "--exists"}).has_value(), "--deadline with --exists should fail");
+    expect_true(!parse_args({"--batch", "q.txt", "--deadline", "5"}).has_value(), "--deadline should not accompany --batch");
+}
+
 } // namespace
 
 int main() {
@@ -88,6 +359,25 @@ int main() {
     test_help_flow();
     test_invalid_pid();
     test_unknown_argument();
+    test_name_timeout();
+    test_threads();
+    test_shared_objects();
+    test_columns();
+    test_max_memory();
+    test_history_options();
+    test_batch_options();
+    test_top();
+    test_output();
+    test_openmetrics();
+    test_sample();
+    test_sketch();
+    test_latency();
+    test_stats();
+    test_limit_and_exists();
+    test_publish();
+    test_export_and_merge();
+    test_all_names();
+    test_deadline();
 
     if (failures == 0) {
         std::cout << "All cli_parser tests passed.\n";
@@ -0,0 +1,152 @@
+#include "external_sort.hpp"
+#include "handle_sort.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// Interns names while rows are produced, so strings that sort between
+// already spilled ones keep arriving after earlier runs were written.
+[[nodiscard]] std::vector<HandleInfo> make_rows(StringInterner& strings, const std::size_t count) {
+    std::vector<HandleInfo> rows;
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (std::size_t i = 0; i < count; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const std::size_t name = state % 97;
+        const std::string text = (name % 3 == 0 ? "\\Device\\PIPE_" : "\\device\\pipe_") + std::to_string(name);
+        rows.push_back(HandleInfo{
+            .pid = static_cast<uint32_t>(4 + (state >> 20) % 16 * 4),
+            .processName = strings.intern("proc" + std::to_string((state >> 20) % 16) + ".exe"),
+            .handleType = strings.intern(name % 2 == 0 ? "File" : "Event"),
+            .objectName = strings.intern(name % 11 == 0 ? std::string() : text),
+            .grantedAccess = static_cast<uint32_t>(state & 0x1F01FF),
+            .objectAddress = static_cast<std::uintptr_t>(0xFFFF800000000000ull + (state >> 8) % 4096 * 0x40),
+            .handleValue = static_cast<std::uintptr_t>(4 + i * 4),
+            .objectTypeIndex = static_cast<uint16_t>(name % 2 == 0 ? 37 : 16),
+            .handleAttributes = static_cast<uint32_t>(i % 3)
+        });
+    }
+    return rows;
+}
+
+[[nodiscard]] bool same_rows(const std::vector<HandleInfo>& left, const std::vector<HandleInfo>& right) {
+    if (left.size() != right.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < left.size(); ++i) {
+        const HandleInfo& l = left[i];
+        const HandleInfo& r = right[i];
+        if (l.pid != r.pid || l.processName != r.processName || l.handleType != r.handleType ||
+            l.objectName != r.objectName || l.grantedAccess != r.grantedAccess || l.objectAddress != r.objectAddress ||
+            l.handleValue != r.handleValue || l.objectTypeIndex != r.objectTypeIndex ||
+            l.handleAttributes != r.handleAttributes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] std::size_t run_files(const std::filesystem::path& directory) {
+    std::size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        count += entry.path().extension() == ".run" ? 1 : 0;
+    }
+    return count;
+}
+
+void test_spilled_merge_matches_in_memory_sort() {
+    const auto directory = std::filesystem::temp_directory_path() / "handle_external_sort_tests";
+    std::filesystem::create_directories(directory);
+
+    for (const SortField field : {SortField::Name, SortField::Type, SortField::Pid}) {
+        StringInterner strings;
+        const std::vector<HandleInfo> rows = make_rows(strings, 5000);
+
+        std::vector<HandleInfo> merged;
+        {
+            // Room for about 100 rows: roughly 50 runs.
+            sorting::ExternalSorter sorter(field, strings, 100 * sizeof(HandleInfo), directory);
+            bool pushed = true;
+            for (const HandleInfo& row : rows) {
+                pushed = pushed && sorter.push(row).has_value();
+            }
+            expect_true(pushed, "push should succeed");
+            expect_true(sorter.run_count() >= 40 && run_files(directory) == sorter.run_count(),
+                        "a tiny budget should spill many runs");
+
+            const auto finished = sorter.finish([&](const HandleInfo& row) { merged.push_back(row); });
+            expect_true(finished.has_value(), "merge should succeed");
+            expect_true(sorter.spilled_rows() + 100 >= rows.size(), "all but the tail should have been spilled");
+            expect_true(run_files(directory) == 0, "runs should be removed after the merge");
+        }
+
+        std::vector<HandleInfo> expected = rows;
+        sorting::sort_handles(expected, field, strings);
+        expect_true(same_rows(merged, expected), "spilled merge should equal the in-memory sort");
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+void test_within_budget_does_not_spill() {
+    StringInterner strings;
+    const std::vector<HandleInfo> rows = make_rows(strings, 200);
+
+    sorting::ExternalSorter sorter(SortField::Name, strings, std::size_t{1} << 20);
+    for (const HandleInfo& row : rows) {
+        (void)sorter.push(row);
+    }
+    std::vector<HandleInfo> merged;
+    expect_true(sorter.finish([&](const HandleInfo& row) { merged.push_back(row); }).has_value(), "finish should succeed");
+    expect_true(sorter.run_count() == 0, "rows within the budget should never touch disk");
+
+    std::vector<HandleInfo> expected = rows;
+    sorting::sort_handles(expected, SortField::Name, strings);
+    expect_true(same_rows(merged, expected), "in-memory finish should sort like sort_handles");
+}
+
+void test_unused_runs_are_removed() {
+    const auto directory = std::filesystem::temp_directory_path() / "handle_external_sort_abandoned";
+    std::filesystem::create_directories(directory);
+    {
+        StringInterner strings;
+        sorting::ExternalSorter sorter(SortField::Name, strings, 1, directory);
+        for (const HandleInfo& row : make_rows(strings, 10)) {
+            (void)sorter.push(row);
+        }
+        expect_true(run_files(directory) == 9, "a one-row budget spills every row but the last");
+    }
+    expect_true(run_files(directory) == 0, "an abandoned sorter should remove its runs");
+    std::filesystem::remove_all(directory);
+}
+
+} // namespace
+
+int main() {
+    test_spilled_merge_matches_in_memory_sort();
+    test_within_budget_does_not_spill();
+    test_unused_runs_are_removed();
+
+    if (failures == 0) {
+        std::cout << "All external_sort tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " external_sort test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,207 @@
+#include "filter_expr.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+std::unordered_map<std::uintptr_t, std::string> g_types;
+std::unordered_map<std::uintptr_t, std::string> g_names;
+std::size_t g_type_queries = 0;
+std::size_t g_name_queries = 0;
+
+[[nodiscard]] filter_expr::FieldResolvers make_resolvers() {
+    g_type_queries = 0;
+    g_name_queries = 0;
+    return filter_expr::FieldResolvers{
+        .typeQuery = [](const nt::RawHandle& handle) -> std::expected<std::string, nt::Error> {
+            ++g_type_queries;
+            if (const auto it = g_types.find(handle.handleValue); it != g_types.end()) return it->second;
+            return std::unexpected(std::make_error_code(std::errc::permission_denied));
+        },
+        .nameQuery = [](const nt::RawHandle& handle) -> std::expected<std::string, nt::Error> {
+            ++g_name_queries;
+            if (const auto it = g_names.find(handle.handleValue); it != g_names.end()) return it->second;
+            return std::unexpected(std::make_error_code(std::errc::permission_denied));
+        },
+        .processName = [](const uint32_t pid) -> std::string_view {
+            return pid == 4 ? "System" : "notepad.exe";
+        }
+    };
+}
+
+[[nodiscard]] nt::RawHandle make_handle(const std::uintptr_t pid, const std::uintptr_t value) {
+    return nt::RawHandle{.processId = pid, .handleValue = value, .grantedAccess = 0x120089};
+}
+
+[[nodiscard]] filter_expr::FilterProgram compile_or_fail(const std::string& text) {
+    auto parsed = filter_expr::parse(text);
+    expect_true(parsed.has_value(), "expression should parse: " + text);
+    return parsed ? filter_expr::FilterProgram::compile(std::move(*parsed)) : filter_expr::FilterProgram{};
+}
+
+void test_example_expression() {
+    g_types = {{0x10, "File"}, {0x14, "File"}, {0x18, "Event"}};
+    g_names = {{0x10, "\\Device\\NamedPipe\\wkssvc"}, {0x14, "\\Device\\HarddiskVolume3\\x.log"}};
+    const auto resolvers = make_resolvers();
+    const auto program = compile_or_fail("(type=File and name~PIPE) or pid in {4,8}");
+
+    expect_true(program.matches(make_handle(100, 0x10), resolvers), "File named pipe should match");
+    expect_true(!program.matches(make_handle(100, 0x14), resolvers), "File without pipe in name should not match");
+    expect_true(!program.matches(make_handle(100, 0x18), resolvers), "Event should not match");
+    expect_true(program.matches(make_handle(8, 0x18), resolvers), "pid 8 should match through the or branch");
+}
+
+void test_cheap_operands_short_circuit_lookups() {
+    g_types = {{0x10, "File"}};
+    g_names = {{0x10, "\\Device\\NamedPipe\\x"}};
+    const auto resolvers = make_resolvers();
+    const auto program = compile_or_fail("name~pipe and type=file and pid=4");
+
+    expect_true(!program.matches(make_handle(100, 0x10), resolvers), "pid mismatch should reject the handle");
+    expect_true(g_type_queries == 0 && g_name_queries == 0,
+                "pid test should run first and skip type/name lookups when it decides");
+
+    expect_true(program.matches(make_handle(4, 0x10), resolvers), "all operands true should match");
+    expect_true(g_type_queries == 1 && g_name_queries == 1, "each lookup should run once per handle");
+}
+
+void test_lookup_runs_once_per_handle() {
+    g_types = {{0x10, "Mutant"}};
+    const auto resolvers = make_resolvers();
+    const auto program = compile_or_fail("type=File or type=Event or type in {Mutant, Section}");
+
+    expect_true(program.matches(make_handle(1, 0x10), resolvers), "in-list should match Mutant");
+    expect_true(g_type_queries == 1, "repeated type tests should share one lookup");
+}
+
+void test_not_and_numeric_operators() {
+    const auto resolvers = make_resolvers();
+    const auto program = compile_or_fail("not not (access & 0x80 and handle >= 0x10) and not process = SYSTEM");
+
+    expect_true(program.matches(make_handle(100, 0x10), resolvers), "numeric operators and not should combine");
+    expect_true(!program.matches(make_handle(4, 0x10), resolvers), "process names compare case-insensitively");
+    expect_true(!program.matches(make_handle(100, 0x0C), resolvers), "handle >= 0x10 should reject 0xC");
+}
+
+void test_string_tests_ignore_case() {
+    g_types = {{0x10, "Event"}, {0x14, "File"}};
+    g_names = {{0x10, "\\Device\\HarddiskVolume3\\Windows\\Temp\\sample.log"}};
+    const auto resolvers = make_resolvers();
+
+    expect_true(compile_or_fail("type=event").matches(make_handle(1, 0x10), resolvers), "type should match case-insensitively");
+    expect_true(!compile_or_fail("type=Process").matches(make_handle(1, 0x14), resolvers), "a different type should not match");
+    expect_true(compile_or_fail(R"(name~"windows\temp")").matches(make_handle(1, 0x10), resolvers),
+                "name~ should match a case-insensitive substring");
+}
+
+void test_pid_compares_the_full_value() {
+    const auto resolvers = make_resolvers();
+    const auto program = compile_or_fail("pid=1234");
+
+    expect_true(program.matches(make_handle(1234, 1), resolvers), "an equal pid should match");
+    if constexpr (sizeof(std::uintptr_t) > sizeof(std::uint32_t)) {
+        const std::uintptr_t wide = (std::uintptr_t{1} << 32) | 1234;
+        expect_true(!program.matches(make_handle(wide, 1), resolvers), "a pid above 32 bits should not match its truncated value");
+    }
+}
+
+void test_failed_lookup_is_false() {
+    g_types.clear();
+    const auto resolvers = make_resolvers();
+    const auto program = compile_or_fail("type != File");
+
+    expect_true(!program.matches(make_handle(1, 0x99), resolvers), "failed lookups should make string tests false");
+    expect_true(!compile_or_fail("type=Event or name~Temp").matches(make_handle(1, 0x99), resolvers),
+                "failed type and name lookups should not match");
+}
+
+void test_failed_lookup_never_matches_when_negated() {
+    g_types = {{0x10, "File"}};
+    g_names = {{0x10, "\\Device\\NamedPipe\\x"}};
+    const auto resolvers = make_resolvers();
+    const nt::RawHandle readable = make_handle(100, 0x10);
+    const nt::RawHandle unreadable = make_handle(100, 0x99);
+
+    for (const std::string text : {"not name~pipe", "name!=\\device\\namedpipe\\y", "not (name~pipe or type=File)",
+                                   "not not not name=x", "not (name=x and pid=100)"}) {
+        const auto program = compile_or_fail(text);
+        expect_true(!program.matches(unreadable, resolvers), "an unreadable name should never match: " + text);
+    }
+    expect_true(!compile_or_fail("not name~pipe").matches(readable, resolvers), "a readable name should still be tested");
+    expect_true(compile_or_fail("not name~mailslot").matches(readable, resolvers), "not should invert a readable name");
+    expect_true(compile_or_fail("not (name=x and pid=4)").matches(unreadable, resolvers),
+                "a known false operand should decide a negated and without the lookup");
+    expect_true(compile_or_fail("not name~pipe or pid=100").matches(unreadable, resolvers),
+                "an unknown operand should not stop another from matching");
+}
+
+void test_parse_errors() {
+    expect_true(!filter_expr::parse("").has_value(), "empty expression should fail");
+    expect_true(!filter_expr::parse("colour=red").has_value(), "unknown field should fail");
+    expect_true(!filter_expr::parse("pid~4").has_value(), "contains on numeric field should fail");
+    expect_true(!filter_expr::parse("type<File").has_value(), "ordering on string field should fail");
+    expect_true(!filter_expr::parse("(pid=4").has_value(), "missing ')' should fail");
+    expect_true(!filter_expr::parse("pid in {4,").has_value(), "unterminated in-list should fail");
+    expect_true(!filter_expr::parse("pid=abc").has_value(), "non-numeric pid should fail");
+
+    const auto error = filter_expr::parse("pid=4 and bogus=1");
+    expect_true(!error && error.error().find("position 10") != std::string::npos,
+                "parse errors should report the offending position");
+}
+
+void test_compile_orders_by_cost() {
+    const auto program = compile_or_fail("name~x and (type=File or pid=4) and access=1");
+    const std::string listing = program.disassemble();
+
+    const auto access_at = listing.find("test access");
+    const auto pid_at = listing.find("test pid");
+    const auto type_at = listing.find("test type");
+    const auto name_at = listing.find("test name");
+    expect_true(access_at < pid_at && pid_at < type_at && type_at < name_at,
+                "operands should be ordered raw fields, then type, then name");
+    expect_true(program.uses(filter_expr::Field::Name) && !program.uses(filter_expr::Field::Process),
+                "uses() should report referenced fields");
+}
+
+void test_empty_program_matches_everything() {
+    const auto resolvers = make_resolvers();
+    const filter_expr::FilterProgram program;
+    expect_true(program.empty() && program.matches(make_handle(1, 1), resolvers), "empty program should match");
+}
+
+} // namespace
+
+int main() {
+    test_example_expression();
+    test_cheap_operands_short_circuit_lookups();
+    test_lookup_runs_once_per_handle();
+    test_not_and_numeric_operators();
+    test_string_tests_ignore_case();
+    test_pid_compares_the_full_value();
+    test_failed_lookup_is_false();
+    test_failed_lookup_never_matches_when_negated();
+    test_parse_errors();
+    test_compile_orders_by_cost();
+    test_empty_program_matches_everything();
+
+    if (failures == 0) {
+        std::cout << "All filter_expr tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " filter_expr test(s) failed.\n";
+    return EXIT_FAILURE;
+}
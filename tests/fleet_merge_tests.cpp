@@ -0,0 +1,222 @@
+#include "fleet_merge.hpp"
+#include "handle_sort.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+const std::filesystem::path kDirectory = std::filesystem::temp_directory_path() / "handle_fleet_merge_tests";
+
+// A host's snapshot: `count` handles in `processes` processes, with object
+// names shared between hosts so equal keys meet in the merge.
+std::vector<HandleInfo> make_rows(StringInterner& strings, const std::size_t host, const std::size_t count,
+                                  const std::size_t processes = 7) {
+    std::vector<HandleInfo> rows;
+    rows.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto pid = static_cast<std::uint32_t>(4 + (i % processes) * 4);
+        rows.push_back(HandleInfo{
+            .pid = pid,
+            .processName = strings.intern(std::format("proc{}.exe", pid)),
+            .handleType = strings.intern(i % 3 == 0 ? "File" : (i % 3 == 1 ? "event" : "Key")),
+            .objectName = strings.intern(std::format("\\BaseNamedObjects\\Obj{}", (i * 7 + host) % 97)),
+            .grantedAccess = static_cast<std::uint32_t>(0x1F0000 + i),
+            .objectAddress = 0xFFFF'8000'0000'0000ull + host * 0x100000 + i * 0x40,
+            .handleValue = 4 + i * 4,
+            .objectTypeIndex = static_cast<std::uint16_t>(i % 3 + 30),
+            .handleAttributes = static_cast<std::uint32_t>(i % 2)});
+    }
+    return rows;
+}
+
+std::filesystem::path write_host(const std::size_t host, const std::size_t count, const SortField sort_by) {
+    StringInterner strings;
+    std::vector<HandleInfo> rows = make_rows(strings, host, count);
+    sorting::sort_handles(rows, sort_by, strings);
+    const auto path = kDirectory / std::format("host{:03}.snap", host);
+    const auto written = fleet::write_snapshot(
+        path,
+        fleet::SnapshotInfo{.host = std::format("host{:03}", host), .sortBy = sort_by, .takenMs = 1'700'000'000'000,
+                            .totalRawCount = count * 2},
+        rows, strings);
+    expect_true(written.has_value() && *written == std::filesystem::file_size(path), "the snapshot file should be written");
+    return path;
+}
+
+// Everything the merge emits for one row, with the host it came from.
+using Merged = std::tuple<std::string, std::uint32_t, std::uint64_t, std::string, std::string, std::string,
+                          std::uint64_t, std::uint32_t, std::uint32_t, std::uint16_t>;
+
+std::vector<Merged> merge_all(fleet::Merger& merger) {
+    std::vector<Merged> merged;
+    const auto stats = merger.run([&](const fleet::Row& row, const std::size_t input) {
+        merged.emplace_back(merger.info(input).host, row.pid, row.handleValue, std::string(row.processName),
+                            std::string(row.handleType), std::string(row.objectName), row.objectAddress,
+                            row.grantedAccess, row.handleAttributes, row.objectTypeIndex);
+    });
+    expect_true(stats.has_value() && stats->rows == merged.size(), "the merge should succeed and count its rows");
+    return merged;
+}
+
+void test_round_trip() {
+    const std::filesystem::path path = write_host(1, 1000, SortField::Name);
+    auto merger = fleet::Merger::open(std::vector{path});
+    expect_true(merger.has_value(), "a written snapshot should open");
+    if (!merger) {
+        return;
+    }
+    expect_true(merger->sort_by() == SortField::Name && merger->info(0).host == "host001" &&
+                    merger->info(0).rowCount == 1000 && merger->info(0).totalRawCount == 2000 &&
+                    merger->info(0).takenMs == 1'700'000'000'000,
+                "the header should round-trip");
+
+    StringInterner strings;
+    std::vector<HandleInfo> expected = make_rows(strings, 1, 1000);
+    sorting::sort_handles(expected, SortField::Name, strings);
+    const std::vector<Merged> merged = merge_all(*merger);
+    bool same = merged.size() == expected.size();
+    for (std::size_t i = 0; same && i < expected.size(); ++i) {
+        const HandleInfo& row = expected[i];
+        same = merged[i] == Merged{"host001", row.pid, row.handleValue, std::string(strings.view(row.processName)),
+                                   std::string(strings.view(row.handleType)), std::string(strings.view(row.objectName)),
+                                   row.objectAddress, row.grantedAccess, row.handleAttributes, row.objectTypeIndex};
+    }
+    expect_true(same, "every field of every row should round-trip in file order");
+}
+
+void test_merge_orders_across_hosts() {
+    for (const SortField sort_by : {SortField::Pid, SortField::Type, SortField::Name}) {
+        std::vector<std::filesystem::path> paths;
+        std::size_t total = 0;
+        for (std::size_t host = 0; host < 40; ++host) {
+            // Sizes straddle the block size, and one host has no rows.
+            const std::size_t count = host == 5 ? 0 : 100 + host * 37;
+            paths.push_back(write_host(host, count, sort_by));
+            total += count;
+        }
+        auto merger = fleet::Merger::open(paths, fleet::MergeOptions{.threads = 4});
+        expect_true(merger.has_value(), "every snapshot should open");
+        if (!merger) {
+            return;
+        }
+
+        std::vector<fleet::Row> rows;
+        std::vector<std::string> texts;
+        std::vector<std::size_t> inputs;
+        std::vector<std::size_t> per_input(merger->input_count());
+        bool ordered = true;
+        std::optional<std::tuple<std::string, std::uint32_t, std::uint64_t, std::string, std::size_t>> previous;
+        const auto stats = merger->run([&](const fleet::Row& row, const std::size_t input) {
+            ++per_input[input];
+            if (previous) {
+                fleet::Row before;
+                before.pid = std::get<1>(*previous);
+                before.handleValue = std::get<2>(*previous);
+                before.handleType = std::get<0>(*previous);
+                before.objectName = std::get<3>(*previous);
+                const bool tie = !fleet::row_less(before, row, sort_by) && !fleet::row_less(row, before, sort_by);
+                if (fleet::row_less(row, before, sort_by) || (tie && input < std::get<4>(*previous))) {
+                    ordered = false;
+                }
+            }
+            previous.emplace(std::string(row.handleType), row.pid, row.handleValue, std::string(row.objectName), input);
+        });
+        expect_true(stats && stats->rows == total && stats->blocks > merger->input_count(),
+                    "every row of every block should be merged");
+        expect_true(ordered, std::format("rows should come out in sort order ({})", static_cast<int>(sort_by)));
+        bool complete = true;
+        for (std::size_t host = 0; host < paths.size(); ++host) {
+            complete = complete && per_input[host] == (host == 5 ? 0 : 100 + host * 37);
+        }
+        expect_true(complete, "each row should be tagged with the file it came from");
+    }
+}
+
+void test_same_key_groups_case_insensitively() {
+    fleet::Row left;
+    fleet::Row right;
+    left.handleType = "Event";
+    right.handleType = "event";
+    left.pid = 4;
+    right.pid = 8;
+    expect_true(fleet::same_key(left, right, SortField::Type), "type keys should compare ignoring case");
+    expect_true(!fleet::same_key(left, right, SortField::Pid), "different pids are different keys");
+}
+
+void test_rejects_bad_inputs() {
+    const std::filesystem::path by_name = write_host(900, 10, SortField::Name);
+    const std::filesystem::path by_pid = write_host(901, 10, SortField::Pid);
+    auto mixed = fleet::Merger::open(std::vector{by_name, by_pid});
+    expect_true(!mixed && mixed.error().find("sort key") != std::string::npos, "files sorted by different keys should fail");
+
+    const auto garbage = kDirectory / "garbage.snap";
+    std::ofstream(garbage, std::ios::binary) << "not a snapshot at all";
+    auto bad = fleet::Merger::open(std::vector{garbage});
+    expect_true(!bad && bad.error().find("not a valid snapshot") != std::string::npos, "a foreign file should be rejected");
+
+    // Cut inside the row blocks: the header and strings still parse.
+    const std::filesystem::path large = write_host(902, 1000, SortField::Pid);
+    const auto truncated = kDirectory / "truncated.snap";
+    std::filesystem::copy_file(large, truncated, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(truncated, std::filesystem::file_size(large) - 100);
+    auto cut = fleet::Merger::open(std::vector{truncated});
+    expect_true(cut.has_value(), "a file cut inside its blocks should still open");
+    if (cut) {
+        const auto run = cut->run([](const fleet::Row&, std::size_t) {});
+        expect_true(!run && run.error().find("truncated") != std::string::npos, "the merge should report the truncation");
+    }
+
+    expect_true(!fleet::Merger::open(std::vector{kDirectory / "missing.snap"}).has_value(), "a missing file should fail");
+}
+
+void test_expand_inputs() {
+    const auto listed = fleet::expand_inputs(std::vector<std::string>{kDirectory.string()});
+    expect_true(listed && !listed->empty() && std::ranges::is_sorted(*listed) &&
+                    std::ranges::all_of(*listed, [](const auto& path) { return path.extension() == ".snap"; }),
+                "a directory should expand to its .snap files in name order");
+    expect_true(!fleet::expand_inputs(std::vector<std::string>{(kDirectory / "missing.snap").string()}).has_value(),
+                "a missing entry should fail");
+    const auto empty = kDirectory / "empty";
+    std::filesystem::create_directories(empty);
+    expect_true(!fleet::expand_inputs(std::vector<std::string>{empty.string()}).has_value(),
+                "a directory without snapshots should fail");
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory);
+
+    test_round_trip();
+    test_merge_orders_across_hosts();
+    test_same_key_groups_case_insensitively();
+    test_rejects_bad_inputs();
+    test_expand_inputs();
+
+    std::filesystem::remove_all(kDirectory);
+    if (failures == 0) {
+        std::cout << "All fleet merge tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " fleet merge test(s) failed.\n";
+    return EXIT_FAILURE;
+}
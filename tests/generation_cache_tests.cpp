@@ -0,0 +1,149 @@
+#include "generation_cache.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+[[nodiscard]] nt::RawHandle make_handle(const std::uintptr_t pid, const std::uintptr_t value, const std::uintptr_t address) {
+    return nt::RawHandle{.objectAddress = address, .processId = pid, .handleValue = value, .objectTypeIndex = 37};
+}
+
+void test_process_names_follow_process_instances() {
+    ProcessCache cache;
+    const std::vector<nt::ProcessIdentity> first{{.pid = 4, .createTime = 1}, {.pid = 100, .createTime = 500}};
+    auto stats = cache.refresh(first);
+    expect_true(stats.changed && cache.generation() == 1, "the first refresh installs a generation");
+
+    cache.store(100, "first.exe");
+    cache.store(200, "ghost.exe");
+    expect_true(cache.name(100) && *cache.name(100) == "first.exe", "a stored name should be served");
+    expect_true(cache.name(200) == nullptr && cache.named_count() == 1, "pids outside the snapshot are not cached");
+
+    stats = cache.refresh(first);
+    expect_true(!stats.changed && cache.generation() == 1, "an identical snapshot should not bump the generation");
+    expect_true(cache.name(100) != nullptr, "names survive an unchanged snapshot");
+
+    // Pid 100 exits and the pid is reused by a newer process.
+    const std::vector<nt::ProcessIdentity> reused{{.pid = 4, .createTime = 1}, {.pid = 100, .createTime = 900}};
+    stats = cache.refresh(reused);
+    expect_true(stats.changed && stats.evicted == 1 && cache.generation() == 2, "pid reuse should evict the old name");
+    expect_true(cache.name(100) == nullptr, "the new process must not inherit the old name");
+    expect_true(cache.create_time(100) == 900u, "the new instance's creation time should be tracked");
+
+    cache.store(4, "System");
+    const std::vector<nt::ProcessIdentity> grown{{.pid = 4, .createTime = 1}, {.pid = 100, .createTime = 900}, {.pid = 300, .createTime = 950}};
+    stats = cache.refresh(grown);
+    expect_true(stats.changed && stats.evicted == 0 && cache.name(4) != nullptr, "new processes leave existing names intact");
+    expect_true(!cache.create_time(200).has_value(), "unknown pids have no creation time");
+}
+
+void test_object_names_follow_anchor_handles() {
+    ProcessCache processes;
+    processes.refresh(std::vector<nt::ProcessIdentity>{{.pid = 10, .createTime = 1}, {.pid = 20, .createTime = 1}});
+
+    ObjectCache cache;
+    const nt::RawHandle holder10 = make_handle(10, 0x40, 0xA000);
+    const nt::RawHandle holder20 = make_handle(20, 0x80, 0xA000);
+    cache.store_object(holder10, 1, "\\Device\\Shared");
+    cache.store_object(make_handle(10, 0x44, 0), 1, "\\Unelevated");
+    expect_true(cache.object_count() == 1, "handles without an object address are never cached");
+
+    const std::string* shared = cache.object_name(holder20, 1);
+    expect_true(shared && *shared == "\\Device\\Shared", "every holder of the object shares the entry");
+
+    // holder10 closes its handle; holder20 (recorded as an anchor above) keeps it valid.
+    std::vector<nt::RawHandle> table{holder20};
+    expect_true(cache.refresh(table, processes) == 0 && cache.object_name(holder20, 1) != nullptr,
+                "an entry survives while one of its anchors is present");
+
+    // Same address, different type: a different object.
+    nt::RawHandle other_type = holder20;
+    other_type.objectTypeIndex = 12;
+    expect_true(cache.object_name(other_type, 1) == nullptr, "the type index is part of the key");
+
+    // The last holder closes; the address may now be reused by another object.
+    expect_true(cache.refresh(std::vector<nt::RawHandle>{make_handle(30, 0x10, 0xA000)}, processes) == 1,
+                "an entry with no surviving anchor should be evicted");
+    expect_true(cache.object_name(make_handle(30, 0x10, 0xA000), 1) == nullptr, "a reused address must not be served");
+}
+
+void test_object_names_evicted_on_pid_reuse() {
+    ProcessCache processes;
+    processes.refresh(std::vector<nt::ProcessIdentity>{{.pid = 10, .createTime = 1}});
+
+    ObjectCache cache;
+    const nt::RawHandle handle = make_handle(10, 0x40, 0xA000);
+    cache.store_object(handle, 1, "\\Device\\Old");
+    cache.store_type(37, "File");
+
+    // Same pid, handle value and address, but a different process instance.
+    processes.refresh(std::vector<nt::ProcessIdentity>{{.pid = 10, .createTime = 2}});
+    expect_true(cache.refresh(std::vector<nt::RawHandle>{handle}, processes) == 1,
+                "an anchor from a previous process instance should not keep the entry alive");
+    expect_true(cache.object_name(handle, 2) == nullptr, "the reused pid's handle must be queried again");
+    expect_true(cache.type_name(37) && *cache.type_name(37) == "File", "type names are boot-stable and survive");
+}
+
+void test_object_names_do_not_survive_reopen_at_same_address() {
+    ProcessCache processes;
+    processes.refresh(std::vector<nt::ProcessIdentity>{{.pid = 10, .createTime = 1}});
+
+    ObjectCache cache;
+    nt::RawHandle file = make_handle(10, 0x40, 0xA000);
+    file.grantedAccess = 0x120089;
+    cache.store_object(file, 1, "\\Device\\HarddiskVolume3\\first.log");
+
+    // Between snapshots the process closes the handle and opens another object
+    // that gets the same handle value and, from the lookaside list, the same
+    // pool address, but with a different access mask.
+    nt::RawHandle reopened = file;
+    reopened.grantedAccess = 0x12019F;
+    expect_true(cache.refresh(std::vector<nt::RawHandle>{reopened}, processes) == 1,
+                "a handle with a different access mask should not vouch for the entry");
+    expect_true(cache.object_name(reopened, 1) == nullptr, "the reopened object's name must be queried again");
+
+    // Closed in one snapshot and back at the same address in the next: the
+    // gap alone drops the entry, even though every field matches again.
+    cache.store_object(file, 1, "\\Device\\HarddiskVolume3\\first.log");
+    expect_true(cache.refresh(std::vector<nt::RawHandle>{}, processes) == 1, "a missing anchor should evict at once");
+    expect_true(cache.refresh(std::vector<nt::RawHandle>{file}, processes) == 0 && cache.object_name(file, 1) == nullptr,
+                "a handle that reappears after a gap must be queried again");
+
+    // Identical in every snapshot: still re-queried after a bounded number of refreshes.
+    cache.store_object(file, 1, "\\Device\\HarddiskVolume3\\first.log");
+    std::size_t carried = 0;
+    while (cache.refresh(std::vector<nt::RawHandle>{file}, processes) == 0 && carried <= ObjectCache::kMaxCarriedRefreshes) {
+        ++carried;
+    }
+    expect_true(carried == ObjectCache::kMaxCarriedRefreshes && cache.object_name(file, 1) == nullptr,
+                "a name should be carried a bounded number of refreshes");
+}
+
+} // namespace
+
+int main() {
+    test_process_names_follow_process_instances();
+    test_object_names_follow_anchor_handles();
+    test_object_names_evicted_on_pid_reuse();
+    test_object_names_do_not_survive_reopen_at_same_address();
+
+    if (failures == 0) {
+        std::cout << "All generation_cache tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " generation_cache test(s) failed.\n";
+    return EXIT_FAILURE;
+}
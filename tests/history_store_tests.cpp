@@ -0,0 +1,362 @@
+#include "binary_codec.hpp"
+#include "history_store.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// Removes the file on construction and destruction so runs are independent.
+class TempFile {
+public:
+    explicit TempFile(const std::string& name)
+        : m_path(std::filesystem::temp_directory_path() / ("handle_history_" + name + ".bin")) {
+        std::filesystem::remove(m_path);
+    }
+    ~TempFile() {
+        std::error_code ignored;
+        std::filesystem::remove(m_path, ignored);
+    }
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& path() const noexcept { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+};
+
+[[nodiscard]] history::Record make_record(history::HistoryWriter& writer,
+                                          const std::uint32_t pid,
+                                          const std::uint64_t handle,
+                                          const std::uint64_t address,
+                                          const std::string& name = "\\Device\\Afd") {
+    return history::Record{
+        .pid = pid,
+        .handleValue = handle,
+        .objectAddress = address,
+        .grantedAccess = 0x1F0003,
+        .objectTypeIndex = 37,
+        .processName = writer.intern("proc" + std::to_string(pid) + ".exe"),
+        .handleType = writer.intern("File"),
+        .objectName = writer.intern(name)
+    };
+}
+
+void test_codec_roundtrip() {
+    codec::ByteWriter writer;
+    writer.varint(0);
+    writer.varint(127);
+    writer.varint(128);
+    writer.varint(std::numeric_limits<std::uint64_t>::max());
+    writer.zigzag(-1);
+    writer.zigzag(std::numeric_limits<std::int64_t>::min());
+    writer.fixed32(0xDEADBEEF);
+    writer.fixed64(0x0123456789ABCDEF);
+    writer.string("handle");
+
+    expect_true(writer.size() == 1 + 1 + 2 + 10 + 1 + 10 + 4 + 8 + 7, "varints should use LEB128 lengths");
+
+    codec::ByteReader reader(writer.data());
+    expect_true(reader.varint() == 0, "varint 0");
+    expect_true(reader.varint() == 127, "varint 127");
+    expect_true(reader.varint() == 128, "varint 128");
+    expect_true(reader.varint() == std::numeric_limits<std::uint64_t>::max(), "varint max");
+    expect_true(reader.zigzag() == -1, "zigzag -1");
+    expect_true(reader.zigzag() == std::numeric_limits<std::int64_t>::min(), "zigzag min");
+    expect_true(reader.fixed32() == 0xDEADBEEF, "fixed32");
+    expect_true(reader.fixed64() == 0x0123456789ABCDEF, "fixed64");
+    expect_true(reader.string() == "handle", "string");
+    expect_true(reader.at_end() && !reader.failed(), "reader should end cleanly");
+
+    expect_true(reader.varint() == 0 && reader.failed(), "reading past the end should fail");
+    expect_true(reader.fixed32() == 0 && reader.failed(), "failure should be sticky");
+
+    const std::vector<std::uint8_t> truncated{0x80, 0x80};
+    codec::ByteReader partial(truncated);
+    expect_true(partial.varint() == 0 && partial.failed(), "a truncated varint should fail");
+}
+
+void test_snapshots_roundtrip_through_deltas() {
+    const TempFile file("roundtrip");
+    std::vector<std::vector<history::Record>> snapshots;
+    {
+        auto writer = history::HistoryWriter::open(file.path(), history::WriterOptions{.keyframeInterval = 3});
+        expect_true(writer.has_value(), "writer should open a new file");
+        if (!writer) {
+            return;
+        }
+
+        std::vector<history::Record> state{
+            make_record(*writer, 4, 0x10, 0xA000),
+            make_record(*writer, 4, 0x14, 0xB000),
+            make_record(*writer, 8, 0x20, 0xA000),
+        };
+        for (int frame = 0; frame < 5; ++frame) {
+            if (frame == 1) {
+                state.push_back(make_record(*writer, 12, 0x30, 0xC000, "\\BaseNamedObjects\\Mutex"));
+            } else if (frame == 2) {
+                state.erase(state.begin());
+            } else if (frame == 3) {
+                state[0].grantedAccess = 0x1;
+            }
+            snapshots.push_back(state);
+            const auto stats = writer->append(1000 * (frame + 1), state);
+            expect_true(stats.has_value(), "append should succeed");
+            if (stats) {
+                const bool keyframe = frame == 0 || frame == 3;
+                expect_true((stats->kind == history::FrameKind::Keyframe) == keyframe,
+                            "keyframes should follow the interval");
+            }
+        }
+
+        expect_true(!writer->append(5000, state).has_value(), "non-increasing timestamps should be rejected");
+    }
+
+    auto reader = history::HistoryReader::open(file.path());
+    expect_true(reader.has_value(), "reader should open the file");
+    if (!reader) {
+        return;
+    }
+    expect_true(reader->frames().size() == 5, "five frames should be recorded");
+    expect_true(reader->frames()[1].opened == 1 && reader->frames()[1].closed == 0, "frame 2 opens one handle");
+    expect_true(reader->frames()[2].closed == 1 && reader->frames()[2].handleCount == 3, "frame 3 closes one handle");
+
+    for (std::size_t frame = 0; frame < snapshots.size(); ++frame) {
+        auto expected = snapshots[frame];
+        std::ranges::sort(expected, {}, &history::Record::key);
+        const auto actual = reader->snapshot_at(static_cast<std::int64_t>(1000 * (frame + 1) + 500));
+        expect_true(actual.has_value() && *actual == expected,
+                    "snapshot " + std::to_string(frame) + " should round-trip");
+    }
+    expect_true(reader->snapshot_at(999).value_or(std::vector<history::Record>{{}}).empty(),
+                "nothing was held before the first frame");
+
+    const auto mutex = reader->snapshot_at(2000);
+    expect_true(mutex.has_value() && mutex->size() == 4 && reader->text(mutex->back().objectName) == "\\BaseNamedObjects\\Mutex",
+                "dictionary ids should resolve to strings");
+}
+
+void test_holders_of_reports_intervals() {
+    const TempFile file("holders");
+    {
+        auto writer = history::HistoryWriter::open(file.path(), history::WriterOptions{.keyframeInterval = 4});
+        if (!writer) {
+            expect_true(false, "writer should open");
+            return;
+        }
+        const auto a4 = make_record(*writer, 4, 0x10, 0xA000);
+        const auto a8 = make_record(*writer, 8, 0x20, 0xA000);
+        const auto b4 = make_record(*writer, 4, 0x14, 0xB000);
+
+        // t=1..8 seconds: pid 4 holds A throughout, pid 8 holds A during 3..5.
+        for (int second = 1; second <= 8; ++second) {
+            std::vector<history::Record> state{a4, b4};
+            if (second >= 3 && second <= 5) {
+                state.push_back(a8);
+            }
+            expect_true(writer->append(second * 1000, state).has_value(), "append should succeed");
+        }
+    }
+
+    auto reader = history::HistoryReader::open(file.path());
+    if (!reader) {
+        expect_true(false, "reader should open");
+        return;
+    }
+
+    const auto all = reader->holders_of(0xA000, 0, 10000);
+    expect_true(all.has_value() && all->size() == 2, "two handles held 0xA000");
+    if (all && all->size() == 2) {
+        const auto& pid4 = (*all)[0].record.pid == 4 ? (*all)[0] : (*all)[1];
+        const auto& pid8 = (*all)[0].record.pid == 8 ? (*all)[0] : (*all)[1];
+        expect_true(pid4.firstSeenMs == 1000 && pid4.lastSeenMs == 8000, "pid 4 held the object throughout");
+        expect_true(pid8.firstSeenMs == 3000 && pid8.lastSeenMs == 5000, "pid 8 held it from 3 to 5 seconds");
+    }
+
+    // 6.5..7.5s: only pid 4 (the frame at 6s is in effect at the range start).
+    const auto late = reader->holders_of(0xA000, 6500, 7500);
+    expect_true(late.has_value() && late->size() == 1 && late->front().record.pid == 4 &&
+                    late->front().firstSeenMs == 6000 && late->front().lastSeenMs == 7000,
+                "a late range should replay from the keyframe but report only frames in effect");
+
+    const auto middle = reader->holders_of(0xA000, 4200, 4300);
+    expect_true(middle.has_value() && middle->size() == 2, "the frame at 4s should be in effect at 4.2s");
+
+    const auto missing = reader->holders_of(0xDEAD, 0, 10000);
+    expect_true(missing.has_value() && missing->empty(), "an unknown object has no holders");
+    const auto before = reader->holders_of(0xA000, 0, 500);
+    expect_true(before.has_value() && before->empty(), "nothing is held before the first frame");
+}
+
+void test_reused_handle_starts_a_new_interval() {
+    const TempFile file("reused");
+    {
+        auto writer = history::HistoryWriter::open(file.path(), history::WriterOptions{.keyframeInterval = 4});
+        if (!writer) {
+            expect_true(false, "writer should open");
+            return;
+        }
+        const auto a4 = make_record(*writer, 4, 0x10, 0xA000);
+        const auto b4 = make_record(*writer, 4, 0x14, 0xB000);
+
+        // The same pid/handle/address/access holds A at 1..2s, is closed at 3s
+        // and comes back at 4..5s; frame 5 is a keyframe.
+        for (int second = 1; second <= 5; ++second) {
+            std::vector<history::Record> state{b4};
+            if (second != 3) {
+                state.push_back(a4);
+            }
+            expect_true(writer->append(second * 1000, state).has_value(), "append should succeed");
+        }
+    }
+
+    auto reader = history::HistoryReader::open(file.path());
+    if (!reader) {
+        expect_true(false, "reader should open");
+        return;
+    }
+
+    const auto held = reader->holders_of(0xA000, 0, 10000);
+    expect_true(held.has_value() && held->size() == 2, "held, absent, held again should be two intervals");
+    if (held && held->size() == 2) {
+        expect_true((*held)[0].firstSeenMs == 1000 && (*held)[0].lastSeenMs == 2000 && (*held)[1].firstSeenMs == 4000 &&
+                        (*held)[1].lastSeenMs == 5000,
+                    "neither interval should cover the frame where nothing held the object");
+    }
+}
+
+void test_reopen_continues_dictionary_and_chain() {
+    const TempFile file("reopen");
+    {
+        auto writer = history::HistoryWriter::open(file.path(), history::WriterOptions{.keyframeInterval = 10});
+        if (!writer) {
+            expect_true(false, "writer should open");
+            return;
+        }
+        expect_true(writer->append(1000, {make_record(*writer, 4, 0x10, 0xA000)}).has_value(), "first append");
+    }
+    {
+        auto writer = history::HistoryWriter::open(file.path(), history::WriterOptions{.keyframeInterval = 10});
+        if (!writer) {
+            expect_true(false, "writer should reopen");
+            return;
+        }
+        expect_true(!writer->append(1000, {}).has_value(), "reopened writer should keep the last timestamp");
+        const auto reused = writer->intern("proc4.exe");
+        expect_true(reused == 1, "reopened writer should reuse existing dictionary ids");
+
+        const auto stats = writer->append(2000, {make_record(*writer, 4, 0x10, 0xA000), make_record(*writer, 8, 0x20, 0xB000, "\\New")});
+        expect_true(stats.has_value() && stats->kind == history::FrameKind::Delta && stats->opened == 1 && stats->closed == 0,
+                    "reopened writer should continue the delta chain");
+    }
+
+    auto reader = history::HistoryReader::open(file.path());
+    const auto snapshot = reader ? reader->snapshot_at(2000) : std::expected<std::vector<history::Record>, std::string>{};
+    expect_true(snapshot.has_value() && snapshot->size() == 2 && reader->text(snapshot->back().objectName) == "\\New",
+                "new strings appended after reopening should resolve");
+}
+
+void test_torn_append_is_ignored_and_repaired() {
+    const TempFile file("torn");
+    std::uint64_t complete_size = 0;
+    {
+        auto writer = history::HistoryWriter::open(file.path());
+        if (!writer) {
+            expect_true(false, "writer should open");
+            return;
+        }
+        expect_true(writer->append(1000, {make_record(*writer, 4, 0x10, 0xA000)}).has_value(), "first append");
+        complete_size = std::filesystem::file_size(file.path());
+        expect_true(writer->append(2000, {make_record(*writer, 8, 0x20, 0xB000, "\\Torn")}).has_value(), "second append");
+    }
+    std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) - 3);
+
+    {
+        auto reader = history::HistoryReader::open(file.path());
+        expect_true(reader.has_value() && reader->frames().size() == 1 && reader->valid_size() == complete_size,
+                    "a torn frame should be ignored");
+    }
+    {
+        auto writer = history::HistoryWriter::open(file.path());
+        expect_true(writer.has_value() && std::filesystem::file_size(file.path()) == complete_size,
+                    "reopening should truncate the torn frame");
+        if (writer) {
+            expect_true(writer->append(2000, {make_record(*writer, 8, 0x20, 0xB000, "\\Again")}).has_value(),
+                        "appending after repair should succeed");
+        }
+    }
+
+    auto reader = history::HistoryReader::open(file.path());
+    const auto snapshot = reader ? reader->snapshot_at(2000) : std::expected<std::vector<history::Record>, std::string>{};
+    expect_true(snapshot.has_value() && snapshot->size() == 1 && reader->text(snapshot->front().objectName) == "\\Again",
+                "the repaired file should replay the new frame");
+
+    const TempFile garbage("garbage");
+    {
+        std::ofstream out(garbage.path(), std::ios::binary);
+        out << "not a history file";
+    }
+    expect_true(!history::HistoryReader::open(garbage.path()).has_value(), "a foreign file should be rejected");
+    expect_true(!history::HistoryWriter::open(garbage.path()).has_value(), "the writer should not append to a foreign file");
+}
+
+void test_deltas_are_smaller_than_keyframes() {
+    const TempFile file("sizes");
+    auto writer = history::HistoryWriter::open(file.path(), history::WriterOptions{.keyframeInterval = 100});
+    if (!writer) {
+        expect_true(false, "writer should open");
+        return;
+    }
+
+    std::vector<history::Record> state;
+    for (std::uint32_t i = 0; i < 2000; ++i) {
+        state.push_back(make_record(*writer, 4 + (i / 100) * 4, 0x4 + (i % 100) * 4, 0xFFFF800000000000ull + i * 0x40));
+    }
+    const auto keyframe = writer->append(1000, state);
+    state[10].objectAddress += 0x10000;
+    state.erase(state.begin() + 500);
+    const auto delta = writer->append(2000, state);
+
+    expect_true(keyframe.has_value() && delta.has_value(), "appends should succeed");
+    if (keyframe && delta) {
+        expect_true(delta->closed == 2 && delta->opened == 1, "the delta should carry only the changes");
+        expect_true(delta->bytes * 50 < keyframe->bytes, "a small delta should be far smaller than a keyframe");
+        expect_true(keyframe->bytes < state.size() * 12, "keyframe columns should compress well below raw size");
+    }
+}
+
+} // namespace
+
+int main() {
+    test_codec_roundtrip();
+    test_snapshots_roundtrip_through_deltas();
+    test_holders_of_reports_intervals();
+    test_reused_handle_starts_a_new_interval();
+    test_reopen_continues_dictionary_and_chain();
+    test_torn_append_is_ignored_and_repaired();
+    test_deltas_are_smaller_than_keyframes();
+
+    if (failures == 0) {
+        std::cout << "All history_store tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " history_store test(s) failed.\n";
+    return EXIT_FAILURE;
+}
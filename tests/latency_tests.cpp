@@ -0,0 +1,147 @@
+#include "latency.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+using latency::Call;
+using latency::Histogram;
+
+void test_bucket_bounds() {
+    bool bounded = true;
+    bool monotonic = true;
+    std::size_t previous = 0;
+    for (std::uint64_t value = 0; value < 200'000; value += value < 1000 ? 1 : 37) {
+        const std::size_t bucket = Histogram::bucket_of(value);
+        const std::uint64_t upper = Histogram::bucket_upper_bound(bucket);
+        // Within 1/16 of the value above it.
+        bounded = bounded && upper >= value && upper - value <= value / 16;
+        monotonic = monotonic && bucket >= previous;
+        previous = bucket;
+    }
+    expect_true(bounded, "a bucket's upper bound should be within 6.25% of every value in it");
+    expect_true(monotonic, "larger values should never map to smaller buckets");
+    expect_true(Histogram::bucket_of(Histogram::kMaxValue) == Histogram::kBucketCount - 1 &&
+                    Histogram::bucket_of(~std::uint64_t{0}) == Histogram::kBucketCount - 1,
+                "values beyond the range should clamp into the last bucket");
+}
+
+void test_percentiles() {
+    Histogram histogram;
+    for (std::uint64_t us = 1; us <= 1000; ++us) {
+        histogram.record(us * 1000);
+    }
+    const auto near = [](const std::uint64_t value, const std::uint64_t expected) {
+        return value >= expected && value <= expected + expected / 16;
+    };
+    expect_true(histogram.count() == 1000, "every value should be counted");
+    expect_true(near(histogram.percentile(50), 500'000), "p50 should be about 500 us");
+    expect_true(near(histogram.percentile(99), 990'000), "p99 should be about 990 us");
+    expect_true(histogram.percentile(100) == 1'000'000 && histogram.max() == 1'000'000, "the maximum should be exact");
+
+    histogram.reset();
+    expect_true(histogram.count() == 0 && histogram.percentile(50) == 0, "reset should clear the histogram");
+}
+
+void test_recorder_keys_and_slow_calls() {
+    latency::Recorder recorder;
+    recorder.record(Call::NameQuery, 4, 37, 0x1F, 0x10, 5'000);
+    expect_true(recorder.summarize(5).empty(), "a disabled recorder should ignore calls");
+
+    recorder.enable(std::chrono::milliseconds(1));
+    for (std::uint32_t i = 0; i < 100; ++i) {
+        recorder.record(Call::NameQuery, i % 2 == 0 ? 4 : 8, i % 4 == 0 ? 37 : 12, 0x1F, 0x10 + i, 10'000);
+    }
+    recorder.record(Call::NameQuery, 8, 12, 0x0012019F, 0x44, 3'000'000);
+    recorder.record(Call::ProcessName, 8, latency::kNoType, 0, 0, 2'000'000);
+    recorder.record_timeout(Call::NameQuery, 4, 37, 0x1F, 0x48, std::chrono::milliseconds(250));
+
+    const auto calls = recorder.summarize(1);
+    expect_true(calls.size() == 2 && calls[0].call == Call::NameQuery && calls[0].count == 101,
+                "timeouts should not enter the histograms");
+    expect_true(calls[0].byType.size() == 1 && calls[0].byType[0].key == 12 && calls[0].byType[0].max == 3'000'000,
+                "keyed lists should be cut to the slowest p99");
+    expect_true(calls[1].call == Call::ProcessName && calls[1].byType.empty() && calls[1].byProcess.size() == 1,
+                "process name lookups should be keyed by pid only");
+
+    const auto slow = recorder.slow_calls();
+    expect_true(slow.size() == 3 && slow[0].timedOut && slow[0].nanoseconds == 250'000'000 &&
+                    slow[1].nanoseconds == 3'000'000 && slow[1].grantedAccess == 0x0012019F && slow[1].handleValue == 0x44 &&
+                    !slow[1].timedOut && slow[2].call == Call::ProcessName,
+                "slow calls should be kept slowest first with their handle details");
+
+    // One pid per call: more keys than kMaxKeyed and more slow calls than kMaxSlowCalls.
+    const std::size_t calls_made = latency::Recorder::kMaxKeyed + 10;
+    recorder.enable(std::chrono::nanoseconds(1));
+    for (std::size_t i = 0; i < calls_made; ++i) {
+        recorder.record(Call::Duplicate, static_cast<std::uint32_t>(i), 1, 0, 0, 100);
+    }
+    expect_true(recorder.slow_calls().size() == latency::Recorder::kMaxSlowCalls &&
+                    recorder.dropped_slow_calls() == calls_made - latency::Recorder::kMaxSlowCalls,
+                "the slow log should be bounded and count what it dropped");
+    const auto bounded = recorder.summarize(calls_made);
+    expect_true(bounded.size() == 1 && bounded[0].byProcess.size() + bounded[0].byType.size() == latency::Recorder::kMaxKeyed &&
+                    bounded[0].count == calls_made,
+                "keyed histograms should be bounded while overall counts stay exact");
+}
+
+void test_concurrent_recording_and_timer() {
+    latency::Recorder& recorder = latency::recorder();
+    recorder.enable(std::chrono::nanoseconds(0));
+    std::vector<std::thread> threads;
+    for (std::uint32_t t = 0; t < 8; ++t) {
+        threads.emplace_back([&recorder, t] {
+            for (std::uint32_t i = 0; i < 20'000; ++i) {
+                recorder.record(Call::Duplicate, t, i % 3, 0, i, 1'000 + i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    {
+        const latency::ScopedTimer timer(Call::NameQuery, 4, 37, 0x1F, 0x10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    recorder.disable();
+    {
+        const latency::ScopedTimer ignored(Call::NameQuery, 4, 37, 0x1F, 0x10);
+    }
+
+    const auto calls = recorder.summarize(8);
+    expect_true(calls.size() == 2 && calls[0].count == 160'000, "concurrent records should all be counted");
+    expect_true(calls[1].count == 1 && calls[1].max >= 5'000'000, "the timer should record the elapsed time once");
+    expect_true(recorder.slow_calls().empty(), "a zero threshold should keep no slow calls");
+}
+
+} // namespace
+
+int main() {
+    test_bucket_bounds();
+    test_percentiles();
+    test_recorder_keys_and_slow_calls();
+    test_concurrent_recording_and_timer();
+
+    if (failures == 0) {
+        std::cout << "All latency tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " latency test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,262 @@
+#include "metrics.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <csignal>
+#endif
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+[[nodiscard]] nt::RawHandle make_handle(const std::uintptr_t pid, const std::uint16_t type) {
+    return nt::RawHandle{.objectAddress = 0xA000, .processId = pid, .handleValue = 4, .objectTypeIndex = type};
+}
+
+[[nodiscard]] bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+void test_top_k_with_other_bucket() {
+    // pid p holds p handles (pids 1..10); pid 3 shows up again later.
+    std::vector<nt::RawHandle> handles;
+    for (std::uintptr_t pid = 1; pid <= 10; ++pid) {
+        for (std::uintptr_t i = 0; i < pid; ++i) {
+            handles.push_back(make_handle(pid, static_cast<std::uint16_t>(i % 4 == 0 ? 37 : 12 + i % 3)));
+        }
+    }
+    handles.push_back(make_handle(3, 37));
+
+    const metrics::Summary summary = metrics::summarize(handles, 3);
+    expect_true(summary.handles == handles.size() && summary.processes == 10 && summary.types == 4,
+                "totals should cover every handle, process and type");
+    expect_true(summary.topProcesses.size() == 3 && summary.topProcesses[0].pid == 10 && summary.topProcesses[2].pid == 8,
+                "the largest processes should be kept, largest first");
+    expect_true(summary.otherProcesses == 7, "the remaining processes should be folded into other");
+
+    std::size_t process_sum = summary.otherProcessHandles;
+    for (const metrics::ProcessCount& process : summary.topProcesses) {
+        process_sum += process.handles;
+    }
+    std::size_t type_sum = summary.otherTypeHandles;
+    for (const metrics::TypeCount& type : summary.topTypes) {
+        type_sum += type.handles;
+        expect_true(handles[type.sample].objectTypeIndex == type.typeIndex, "each type should point at one of its handles");
+    }
+    expect_true(process_sum == handles.size() && type_sum == handles.size(), "top K plus other should add up to the total");
+    expect_true(summary.topTypes.size() == 3 && summary.topTypes[0].typeIndex == 37 && summary.otherTypes == 1,
+                "types should be bounded the same way");
+}
+
+void test_render_exposition() {
+    const std::vector<nt::RawHandle> handles{make_handle(4, 37), make_handle(4, 37), make_handle(8, 12), make_handle(12, 5)};
+    const metrics::Summary summary = metrics::summarize(handles, 2);
+    const std::string text = metrics::render(summary, 100, metrics::Labels{
+        .processName = [](const std::uint32_t pid) { return pid == 4 ? std::string_view("Sys\"tem\\") : std::string_view("app.exe"); },
+        .typeName = [](const metrics::TypeCount& type) { return type.typeIndex == 37 ? std::string_view("File") : std::string_view("Event"); }
+    });
+
+    expect_true(contains(text, "# TYPE handleenum_process_handles gauge\n"), "families should declare their type");
+    expect_true(contains(text, "handleenum_system_handles 100\n") && contains(text, "handleenum_handles 4\n"),
+                "table and matching totals should be exported");
+    expect_true(contains(text, "handleenum_process_handles{pid=\"4\",process=\"Sys\\\"tem\\\\\"} 2\n"),
+                "label values should be escaped");
+    expect_true(contains(text, "handleenum_process_handles{pid=\"other\",process=\"other\"} 1\n"),
+                "processes beyond K should be summed under other");
+    expect_true(contains(text, "handleenum_type_handles{type=\"File\",type_index=\"37\"} 2\n"), "types should carry name and index");
+    expect_true(text.ends_with("# EOF\n"), "the exposition should end with # EOF");
+    expect_true(metrics::escape_label("a\nb") == "a\\nb", "newlines should be escaped");
+}
+
+void test_textfile_is_replaced_atomically() {
+    const auto path = std::filesystem::temp_directory_path() / "handle_metrics.prom";
+    expect_true(metrics::write_textfile(path.string(), "first\n").has_value(), "writing the textfile should succeed");
+    expect_true(metrics::write_textfile(path.string(), "second\n").has_value(), "replacing the textfile should succeed");
+
+    std::ifstream file(path);
+    const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    expect_true(text == "second\n", "the textfile should hold the latest exposition");
+    auto temp = path;
+    temp += ".tmp";
+    expect_true(!std::filesystem::exists(temp), "no temporary file should be left behind");
+    file.close();
+    std::filesystem::remove(path);
+
+    expect_true(!metrics::write_textfile((path / "missing" / "x.prom").string(), "x").has_value(),
+                "an unwritable directory should fail");
+}
+
+#ifndef _WIN32
+[[nodiscard]] std::string http_get(const std::uint16_t port, const std::string& path) {
+    const int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    // A server that stopped serving must fail the test, not hang it.
+    const timeval timeout{.tv_sec = 5, .tv_usec = 0};
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string reply;
+    if (::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+        const std::string request = "GET " + path + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+        (void)::send(socket, request.data(), request.size(), 0);
+        char chunk[512];
+        for (ssize_t received; (received = ::recv(socket, chunk, sizeof(chunk), 0)) > 0;) {
+            reply.append(chunk, static_cast<std::size_t>(received));
+        }
+    }
+    ::close(socket);
+    return reply;
+}
+
+void test_loopback_server_serves_metrics() {
+    auto server = metrics::LoopbackServer::listen(0);
+    expect_true(server.has_value() && server->port() != 0, "binding an ephemeral loopback port should succeed");
+    if (!server) {
+        return;
+    }
+
+    int scrapes = 0;
+    const metrics::LoopbackServer::Body body = [&]() -> std::expected<std::string, std::string> {
+        ++scrapes;
+        return "handleenum_handles 7\n# EOF\n";
+    };
+
+    std::string ok;
+    std::thread client([&] { ok = http_get(server->port(), "/metrics?x=1"); });
+    expect_true(server->serve_one(body).has_value(), "serving a scrape should succeed");
+    client.join();
+    expect_true(ok.starts_with("HTTP/1.0 200 OK\r\n") && contains(ok, "application/openmetrics-text") &&
+                    ok.ends_with("\r\n\r\nhandleenum_handles 7\n# EOF\n"),
+                "GET /metrics should return the exposition");
+
+    std::string missing;
+    client = std::thread([&] { missing = http_get(server->port(), "/"); });
+    expect_true(server->serve_one(body).has_value(), "serving a bad path should succeed");
+    client.join();
+    expect_true(missing.starts_with("HTTP/1.0 404"), "other paths should get 404");
+    expect_true(scrapes == 1, "only /metrics should take a snapshot");
+}
+
+void test_client_disconnect_does_not_kill_server() {
+    auto server = metrics::LoopbackServer::listen(0);
+    expect_true(server.has_value(), "binding an ephemeral loopback port should succeed");
+    if (!server) {
+        return;
+    }
+
+    // The default action, even if the test runner ignores SIGPIPE.
+    const auto previous = std::signal(SIGPIPE, SIG_DFL);
+
+    // The scraper sends its request and disconnects while the snapshot is
+    // taken. The first write of the response draws a reset, the next one
+    // fails with EPIPE.
+    std::atomic<bool> closed{false};
+    const metrics::LoopbackServer::Body slow = [&]() -> std::expected<std::string, std::string> {
+        while (!closed.load()) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::string(8 << 20, 'x');
+    };
+    std::thread client([&] {
+        const int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(server->port());
+        if (::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+            const std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+            (void)::send(socket, request.data(), request.size(), 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        ::close(socket);
+        closed.store(true);
+    });
+    expect_true(server->serve_one(slow).has_value(), "a client that disconnects should only lose its response");
+    client.join();
+
+    std::string ok;
+    client = std::thread([&] { ok = http_get(server->port(), "/metrics"); });
+    const metrics::LoopbackServer::Body body = []() -> std::expected<std::string, std::string> { return "# EOF\n"; };
+    expect_true(server->serve_one(body).has_value(), "the server should keep serving after a disconnect");
+    client.join();
+    expect_true(ok.starts_with("HTTP/1.0 200 OK\r\n"), "the next scrape should succeed");
+    std::signal(SIGPIPE, previous);
+}
+
+void test_interrupted_accept_is_retried() {
+    auto server = metrics::LoopbackServer::listen(0);
+    expect_true(server.has_value(), "binding an ephemeral loopback port should succeed");
+    if (!server) {
+        return;
+    }
+
+    // Without SA_RESTART a signal makes the blocked accept() fail with EINTR.
+    struct sigaction interrupt {};
+    struct sigaction previous {};
+    interrupt.sa_handler = [](int) {};
+    sigemptyset(&interrupt.sa_mask);
+    interrupt.sa_flags = 0;
+    ::sigaction(SIGUSR1, &interrupt, &previous);
+
+    const metrics::LoopbackServer::Body body = []() -> std::expected<std::string, std::string> { return "# EOF\n"; };
+    std::expected<void, std::string> served;
+    std::thread serving([&] { served = server->serve_one(body); });
+    for (int i = 0; i < 5; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ::pthread_kill(serving.native_handle(), SIGUSR1);
+    }
+    const std::string reply = http_get(server->port(), "/metrics");
+    serving.join();
+    ::sigaction(SIGUSR1, &previous, nullptr);
+
+    expect_true(served.has_value(), "an interrupted accept() should be retried, not reported");
+    expect_true(reply.starts_with("HTTP/1.0 200 OK\r\n"), "the scrape after the interruptions should be served");
+}
+#endif
+
+} // namespace
+
+int main() {
+    test_top_k_with_other_bucket();
+    test_render_exposition();
+    test_textfile_is_replaced_atomically();
+#ifndef _WIN32
+    test_loopback_server_serves_metrics();
+    test_client_disconnect_does_not_kill_server();
+    test_interrupted_accept_is_retried();
+#endif
+
+    if (failures == 0) {
+        std::cout << "All metrics tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " metrics test(s) failed.\n";
+    return EXIT_FAILURE;
+}
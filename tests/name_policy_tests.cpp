@@ -0,0 +1,105 @@
+#include "name_policy.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+using namespace std::chrono_literals;
+
+// Queries `count` handles of one type through the policy; `named` decides
+// each outcome. Returns how many were actually queried.
+template <typename Named>
+std::size_t run(NameSkipPolicy& policy, const std::uint16_t type_index, const std::size_t count, Named named) {
+    std::size_t queried = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (policy.should_query(type_index)) {
+            policy.record(type_index, named(i), 2us);
+            ++queried;
+        }
+    }
+    return queried;
+}
+
+void test_warmup_then_skip() {
+    NameSkipPolicy policy(NameSkipOptions{.warmup = 64, .minNamedRate = 0.01, .probeInterval = 256});
+    const std::size_t queried = run(policy, 12, 1'000, [](std::size_t) { return false; });
+    // 64 warm-up queries, then one probe per 256 handles of the remaining 936.
+    expect_true(queried == 64 + 3, "an unnamed type should only be probed after warm-up");
+    expect_true(policy.skipped_count() == 1'000 - queried, "every skip should be counted");
+
+    const std::size_t named = run(policy, 37, 1'000, [](std::size_t) { return true; });
+    expect_true(named == 1'000, "a named type should always be queried");
+
+    // 2 named out of 100 is above 1%: never skipped.
+    const std::size_t sometimes = run(policy, 20, 1'000, [](std::size_t i) { return i % 50 == 0; });
+    expect_true(sometimes == 1'000, "a type with a few names above the threshold should stay queried");
+}
+
+void test_probes_bring_a_type_back() {
+    NameSkipPolicy policy(NameSkipOptions{.warmup = 10, .minNamedRate = 0.5, .probeInterval = 4});
+    (void)run(policy, 3, 10, [](std::size_t) { return false; });
+    expect_true(!policy.should_query(3), "the type should be skipped after warm-up");
+
+    // From now on every probe finds a name; the rate climbs back over 50%.
+    std::size_t queried = 0;
+    for (int i = 0; i < 200 && queried < 11; ++i) {
+        if (policy.should_query(3)) {
+            policy.record(3, true, 1us);
+            ++queried;
+        }
+    }
+    expect_true(queried == 11, "probes should keep the rate current");
+    bool back = true;
+    for (int i = 0; i < 20; ++i) {
+        back = back && policy.should_query(3);
+        policy.record(3, true, 1us);
+    }
+    expect_true(back, "a type whose names reappear should be queried again");
+}
+
+void test_reports_and_reset() {
+    NameSkipPolicy policy;
+    (void)run(policy, 5, 100, [](std::size_t) { return false; });
+    (void)run(policy, 9, 400, [](std::size_t) { return false; });
+    const auto types = policy.skipped_types();
+    expect_true(types.size() == 2 && types[0].typeIndex == 9 && types[0].skipped == 400 - 64 - 1 &&
+                    types[1].typeIndex == 5 && types[1].skipped == 100 - 64,
+                "reports should list skipped types, most skipped first");
+    expect_true(types[0].named == 0 && types[0].observed == 65 && types[0].averageCost == 2us, "reports should carry the learned rate and cost");
+    expect_true(policy.estimated_savings() == 2us * static_cast<std::int64_t>(policy.skipped_count()),
+                "savings should be skipped queries times their type's average cost");
+
+    policy.reset_skip_counts();
+    expect_true(policy.skipped_count() == 0 && policy.skipped_types().empty(), "reset should clear skip counts");
+    expect_true(!policy.should_query(9), "reset should keep what was learned");
+    expect_true(policy.should_query(400), "an unseen type should be queried");
+}
+
+} // namespace
+
+int main() {
+    test_warmup_then_skip();
+    test_probes_bring_a_type_back();
+    test_reports_and_reset();
+
+    if (failures == 0) {
+        std::cout << "All name policy tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " name policy test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+#include "name_resolver.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// Fake backend gate: handles listed as "blocking" wait here until released,
+// mimicking NtQueryObject stuck on a synchronous pipe.
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+
+    void wait() {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [this] { return open; });
+    }
+
+    void release() {
+        {
+            const std::lock_guard lock(mutex);
+            open = true;
+        }
+        cv.notify_all();
+    }
+};
+
+constexpr std::uintptr_t kBlockingHandle = 0xB10C;
+constexpr std::uintptr_t kFailingHandle = 0xBAD;
+
+[[nodiscard]] nt::ObjectQuery make_fake_backend(const std::shared_ptr<Gate>& gate) {
+    return [gate](const nt::RawHandle& handle) -> std::expected<std::string, nt::Error> {
+        if (handle.handleValue == kBlockingHandle) {
+            gate->wait();
+            return std::string{"\\Device\\NamedPipe\\late"};
+        }
+        if (handle.handleValue == kFailingHandle) {
+            return std::unexpected(std::make_error_code(std::errc::permission_denied));
+        }
+        return "\\Device\\Object\\" + std::to_string(handle.handleValue);
+    };
+}
+
+[[nodiscard]] nt::RawHandle make_handle(const std::uintptr_t value) {
+    return nt::RawHandle{.processId = 1234, .handleValue = value, .grantedAccess = 0x1};
+}
+
+NameResolverOptions fast_options() {
+    return NameResolverOptions{
+        .maxWorkers = 2,
+        .deadline = std::chrono::milliseconds(50),
+        .maxAbandoned = 2
+    };
+}
+
+void test_resolves_non_blocking_names() {
+    const auto gate = std::make_shared<Gate>();
+    NameResolver resolver(make_fake_backend(gate), fast_options());
+
+    const auto result = resolver.resolve(make_handle(0x40));
+    expect_true(result.has_value() && *result == "\\Device\\Object\\64",
+                "resolver should return the backend name for fast queries");
+    expect_true(resolver.timed_out_count() == 0, "fast queries should not time out");
+    gate->release();
+}
+
+void test_backend_errors_propagate() {
+    const auto gate = std::make_shared<Gate>();
+    NameResolver resolver(make_fake_backend(gate), fast_options());
+
+    const auto result = resolver.resolve(make_handle(kFailingHandle));
+    expect_true(!result && result.error() == std::errc::permission_denied,
+                "resolver should forward backend errors unchanged");
+    gate->release();
+}
+
+void test_blocking_query_times_out_and_worker_is_replaced() {
+    const auto gate = std::make_shared<Gate>();
+    NameResolver resolver(make_fake_backend(gate), fast_options());
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto blocked = resolver.resolve(make_handle(kBlockingHandle));
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+
+    expect_true(!blocked && blocked.error() == std::errc::timed_out,
+                "blocking query should be reported as timed out");
+    expect_true(elapsed < std::chrono::seconds(2), "blocking query should return near its deadline");
+    expect_true(resolver.abandoned_worker_count() == 1, "stuck worker should be abandoned");
+
+    const auto after = resolver.resolve(make_handle(0x44));
+    expect_true(after.has_value() && *after == "\\Device\\Object\\68",
+                "a replacement worker should serve queries after a timeout");
+    gate->release();
+}
+
+void test_exhausted_abandon_budget_fails_fast() {
+    const auto gate = std::make_shared<Gate>();
+    NameResolver resolver(make_fake_backend(gate), fast_options());
+
+    (void)resolver.resolve(make_handle(kBlockingHandle));
+    (void)resolver.resolve(make_handle(kBlockingHandle));
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto result = resolver.resolve(make_handle(0x48));
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+
+    expect_true(!result && result.error() == std::errc::timed_out,
+                "resolver should refuse work once every allowed worker is stuck");
+    expect_true(elapsed < std::chrono::milliseconds(50),
+                "refusal after exhausting the abandon budget should not wait for a deadline");
+    expect_true(resolver.timed_out_count() == 3, "every refused or stuck query should count as timed out");
+    gate->release();
+}
+
+} // namespace
+
+int main() {
+    test_resolves_non_blocking_names();
+    test_backend_errors_propagate();
+    test_blocking_query_times_out_and_worker_is_replaced();
+    test_exhausted_abandon_budget_fails_fast();
+
+    if (failures == 0) {
+        std::cout << "All name_resolver tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " name_resolver test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -2,9 +2,11 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <thread>
 
 namespace {
 
@@ -110,6 +112,114 @@ void test_query_after_privilege_attempt() {
                 "query after privilege attempt returned implausibly many handles");
 }
 
+// Stubbed NtQueryObject: answers with g_stub_name laid out like
+// OBJECT_NAME_INFORMATION (UNICODE_STRING header followed by the characters).
+std::wstring g_stub_name;
+nt::NTSTATUS g_stub_too_small_status = nt::STATUS_INFO_LENGTH_MISMATCH;
+nt::NTSTATUS g_stub_forced_status = nt::STATUS_SUCCESS;
+
+nt::NTSTATUS NTAPI stub_nt_query_object(HANDLE, OBJECT_INFORMATION_CLASS, PVOID buffer, ULONG length, PULONG return_length) {
+    if (g_stub_forced_status != nt::STATUS_SUCCESS) {
+        return g_stub_forced_status;
+    }
+
+    const std::size_t chars_bytes = (g_stub_name.size() + 1) * sizeof(wchar_t);
+    const std::size_t required = sizeof(UNICODE_STRING) + chars_bytes;
+    if (return_length) {
+        *return_length = static_cast<ULONG>(required);
+    }
+    if (length < required) {
+        return g_stub_too_small_status;
+    }
+
+    auto* unicode = static_cast<UNICODE_STRING*>(buffer);
+    auto* chars = reinterpret_cast<wchar_t*>(static_cast<std::byte*>(buffer) + sizeof(UNICODE_STRING));
+    std::memcpy(chars, g_stub_name.c_str(), chars_bytes);
+    unicode->Length = static_cast<USHORT>(g_stub_name.size() * sizeof(wchar_t));
+    unicode->MaximumLength = static_cast<USHORT>(chars_bytes);
+    unicode->Buffer = chars;
+    return nt::STATUS_SUCCESS;
+}
+
+[[nodiscard]] std::expected<std::string, nt::Error> query_stub_name() {
+    return nt::detail::query_unicode_information(
+        stub_nt_query_object, nullptr, static_cast<OBJECT_INFORMATION_CLASS>(1));
+}
+
+// Scratch buffers are per thread, so each scenario runs on a fresh one.
+template <typename Fn>
+void run_on_fresh_thread(Fn&& fn) {
+    std::thread worker(std::forward<Fn>(fn));
+    worker.join();
+}
+
+void test_short_names_take_one_call_and_no_allocations() {
+    g_stub_name = L"\\BaseNamedObjects\\Sample";
+    g_stub_too_small_status = nt::STATUS_INFO_LENGTH_MISMATCH;
+    g_stub_forced_status = nt::STATUS_SUCCESS;
+
+    run_on_fresh_thread([] {
+        bool all_ok = true;
+        for (int i = 0; i < 100; ++i) {
+            const auto result = query_stub_name();
+            all_ok = all_ok && result && *result == "\\BaseNamedObjects\\Sample";
+        }
+
+        const auto& counters = nt::detail::object_query_counters();
+        expect_true(all_ok, "stubbed query should decode the object name");
+        expect_true(counters.ntCalls == 100, "short names should need exactly one NtQueryObject call each");
+        expect_true(counters.allocations == 1, "only the initial scratch buffer should be allocated");
+    });
+}
+
+void test_long_name_grows_scratch_once() {
+    g_stub_name = std::wstring(2'000, L'a');
+    g_stub_too_small_status = nt::STATUS_INFO_LENGTH_MISMATCH;
+    g_stub_forced_status = nt::STATUS_SUCCESS;
+
+    run_on_fresh_thread([] {
+        const auto first = query_stub_name();
+        const auto& counters = nt::detail::object_query_counters();
+        expect_true(first && first->size() == 2'000, "long name should decode after growing the scratch buffer");
+        expect_true(counters.ntCalls == 2, "length mismatch should cost exactly one extra call");
+        expect_true(counters.allocations == 2, "length mismatch should cost exactly one extra allocation");
+
+        const auto second = query_stub_name();
+        expect_true(second.has_value(), "repeated long name should decode");
+        expect_true(counters.ntCalls == 3, "grown scratch buffer should serve the next long name in one call");
+        expect_true(counters.allocations == 2, "grown scratch buffer should be reused");
+        expect_true(nt::detail::object_query_scratch_capacity() >= 4'000,
+                    "scratch capacity should track the largest recent result");
+    });
+}
+
+void test_buffer_overflow_status_triggers_resize() {
+    g_stub_name = std::wstring(1'500, L'b');
+    g_stub_too_small_status = nt::STATUS_BUFFER_OVERFLOW;
+    g_stub_forced_status = nt::STATUS_SUCCESS;
+
+    run_on_fresh_thread([] {
+        const auto result = query_stub_name();
+        expect_true(result && result->size() == 1'500, "STATUS_BUFFER_OVERFLOW should be treated as too-small");
+        expect_true(nt::detail::object_query_counters().ntCalls == 2,
+                    "STATUS_BUFFER_OVERFLOW should cost exactly one retry");
+    });
+}
+
+void test_hard_failure_returns_after_one_call() {
+    g_stub_name = L"unused";
+    g_stub_forced_status = static_cast<nt::NTSTATUS>(0xC0000022u);
+
+    run_on_fresh_thread([] {
+        const auto result = query_stub_name();
+        expect_true(!result, "non-size NTSTATUS failures should be reported as errors");
+        expect_true(nt::detail::object_query_counters().ntCalls == 1,
+                    "hard failures should not trigger a size probe");
+    });
+
+    g_stub_forced_status = nt::STATUS_SUCCESS;
+}
+
 } // namespace
 
 int main() {
@@ -118,6 +228,10 @@ int main() {
     test_grow_buffer_size_doubles_when_needed_is_small();
     test_buffer_has_complete_payload_rejects_too_small_buffer();
     test_buffer_has_complete_payload_accepts_zero_handles_for_header_only_buffer();
+    test_short_names_take_one_call_and_no_allocations();
+    test_long_name_grows_scratch_once();
+    test_buffer_overflow_status_triggers_resize();
+    test_hard_failure_returns_after_one_call();
     test_enable_debug_privilege_smoke();
     test_query_system_handles_smoke();
     test_query_after_privilege_attempt();
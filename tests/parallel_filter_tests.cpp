@@ -0,0 +1,133 @@
+#include "parallel_filter.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+[[nodiscard]] std::vector<nt::RawHandle> make_handles(const std::size_t count) {
+    std::vector<nt::RawHandle> handles(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        handles[i].processId = i % 97;
+        handles[i].handleValue = i;
+    }
+    return handles;
+}
+
+[[nodiscard]] bool keep(const nt::RawHandle& handle) {
+    return handle.processId % 3 == 0 || handle.handleValue % 7 == 0;
+}
+
+void test_select_preserves_order() {
+    const auto handles = make_handles(10'000);
+
+    std::vector<nt::RawHandle> expected;
+    for (const nt::RawHandle& handle : handles) {
+        if (keep(handle)) {
+            expected.push_back(handle);
+        }
+    }
+
+    const auto selected = parallel::select(handles, keep, {.threads = 4, .chunkSize = 64});
+    bool same = selected.size() == expected.size();
+    for (std::size_t i = 0; same && i < selected.size(); ++i) {
+        same = selected[i].handleValue == expected[i].handleValue;
+    }
+    expect_true(same, "parallel select should return the serial result in input order");
+}
+
+void test_count_matches_serial() {
+    const auto handles = make_handles(10'001);
+
+    std::size_t expected = 0;
+    for (const nt::RawHandle& handle : handles) {
+        expected += keep(handle) ? 1 : 0;
+    }
+
+    expect_true(parallel::count(handles, keep, {.threads = 3, .chunkSize = 100}) == expected,
+                "parallel count should equal the serial count");
+    expect_true(parallel::count(handles, keep, {.threads = 1}) == expected,
+                "single-threaded count should equal the serial count");
+}
+
+void test_work_is_spread_across_threads() {
+    const auto handles = make_handles(4'096);
+    std::mutex mutex;
+    std::set<std::thread::id> seen;
+
+    const auto slow_keep = [&](const nt::RawHandle& handle) {
+        {
+            const std::lock_guard lock(mutex);
+            seen.insert(std::this_thread::get_id());
+        }
+        // Stand-in for a syscall so helpers get a chance to claim chunks.
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        return keep(handle);
+    };
+
+    (void)parallel::count(handles, slow_keep, {.threads = 4, .chunkSize = 16});
+    expect_true(seen.size() > 1, "more than one thread should evaluate the predicate");
+}
+
+void test_thread_count_is_bounded_by_chunks() {
+    expect_true(parallel::effective_threads(10, {.threads = 8, .chunkSize = 4}) == 3,
+                "threads should not exceed the number of chunks");
+    expect_true(parallel::effective_threads(0, {.threads = 8}) == 1, "empty input should use one thread");
+    expect_true(parallel::effective_threads(5'000, {.threads = 0}) >= 1, "0 threads should mean hardware threads");
+}
+
+void test_predicate_exception_propagates() {
+    const auto handles = make_handles(5'000);
+    bool threw = false;
+    try {
+        (void)parallel::select(handles, [](const nt::RawHandle& handle) -> bool {
+            if (handle.handleValue == 4'321) {
+                throw std::runtime_error("boom");
+            }
+            return true;
+        }, {.threads = 4, .chunkSize = 128});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    expect_true(threw, "predicate exceptions should be rethrown to the caller");
+}
+
+void test_empty_input() {
+    const std::vector<nt::RawHandle> handles;
+    expect_true(parallel::select(handles, keep, {.threads = 4}).empty(), "empty input should select nothing");
+    expect_true(parallel::count(handles, keep, {.threads = 4}) == 0, "empty input should count zero");
+}
+
+} // namespace
+
+int main() {
+    test_select_preserves_order();
+    test_count_matches_serial();
+    test_work_is_spread_across_threads();
+    test_thread_count_is_bounded_by_chunks();
+    test_predicate_exception_propagates();
+    test_empty_input();
+
+    if (failures == 0) {
+        std::cout << "All parallel_filter tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " parallel_filter test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,138 @@
+#include "pid_table.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+void test_publish_and_find() {
+    StringInterner strings;
+    PidTable table;
+    expect_true(!table.find(4).has_value() && table.chunk_count() == 0, "an empty table should allocate nothing");
+
+    const StringId explorer = strings.intern("explorer.exe");
+    const PidTable::Entry stored = table.publish(1234 * 4, PidTable::Entry{.id = explorer, .name = strings.view(explorer)});
+    const auto found = table.find(1234 * 4);
+    expect_true(stored.id == explorer && found && found->id == explorer && found->name == "explorer.exe",
+                "a published pid should be found with its id and name");
+    expect_true(!table.find(1233 * 4).has_value() && !table.find(1235 * 4).has_value(), "neighbouring pids should stay empty");
+
+    const StringId other = strings.intern("other.exe");
+    const PidTable::Entry kept = table.publish(1234 * 4, PidTable::Entry{.id = other, .name = strings.view(other)});
+    expect_true(kept.id == explorer && table.find(1234 * 4)->id == explorer, "the first publish of a pid should win");
+
+    const PidTable::Entry empty = table.publish(0, PidTable::Entry{});
+    expect_true(empty.id == StringInterner::kEmpty && table.find(0).has_value(), "the empty string id should be storable");
+    expect_true(table.size() == 2 && table.chunk_count() == 2, "only the chunks holding published pids should be allocated");
+}
+
+void test_sparse_pids() {
+    StringInterner strings;
+    PidTable table;
+    const StringId odd = strings.intern("odd");
+    const StringId huge = strings.intern("huge");
+    (void)table.publish(1001, PidTable::Entry{.id = odd, .name = strings.view(odd)});
+    (void)table.publish(PidTable::kMaxDensePid + 4, PidTable::Entry{.id = huge, .name = strings.view(huge)});
+    (void)table.publish(0xFFFF'FFFFu, PidTable::Entry{.id = huge, .name = strings.view(huge)});
+
+    expect_true(table.find(1001) && table.find(1001)->name == "odd", "pids that are not multiples of four should still be stored");
+    expect_true(table.find(PidTable::kMaxDensePid + 4) && table.find(0xFFFF'FFFFu)->name == "huge",
+                "pids beyond the dense range should still be stored");
+    expect_true(!table.find(1000).has_value() && table.chunk_count() == 0, "sparse pids should not allocate chunks");
+    expect_true(table.size() == 3, "sparse pids should be counted");
+}
+
+void test_clear_keeps_chunks() {
+    StringInterner strings;
+    PidTable table;
+    const StringId name = strings.intern("svchost.exe");
+    for (std::uint32_t pid = 4; pid <= 40'000; pid += 4) {
+        (void)table.publish(pid, PidTable::Entry{.id = name, .name = strings.view(name)});
+    }
+    (void)table.publish(7, PidTable::Entry{.id = name, .name = strings.view(name)});
+    const std::size_t chunks = table.chunk_count();
+    expect_true(table.size() == 10'001 && chunks == 10, "10'000 pids should fill ten chunks");
+
+    table.clear();
+    expect_true(table.size() == 0 && !table.find(4).has_value() && !table.find(40'000).has_value() && !table.find(7).has_value(),
+                "clear should forget every pid");
+    expect_true(table.chunk_count() == chunks, "clear should keep chunks for the next snapshot");
+
+    const StringId next = strings.intern("next.exe");
+    expect_true(table.publish(4, PidTable::Entry{.id = next, .name = strings.view(next)}).id == next,
+                "a cleared pid should accept a new name");
+}
+
+void test_concurrent_readers() {
+    StringInterner strings;
+    PidTable table;
+    constexpr std::uint32_t kPids = 20'000;
+    std::vector<StringId> ids;
+    for (std::uint32_t i = 0; i < kPids; ++i) {
+        ids.push_back(strings.intern("process-" + std::to_string(i)));
+    }
+
+    // One publisher, several readers checking every entry they see is whole.
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> torn{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                for (std::uint32_t i = 0; i < kPids; i += 7) {
+                    if (const auto entry = table.find((i + 1) * 4)) {
+                        if (entry->id != ids[i] || entry->name != "process-" + std::to_string(i)) {
+                            torn.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
+            }
+        });
+    }
+    for (std::uint32_t i = 0; i < kPids; ++i) {
+        (void)table.publish((i + 1) * 4, PidTable::Entry{.id = ids[i], .name = strings.view(ids[i])});
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    bool all_found = true;
+    for (std::uint32_t i = 0; i < kPids; ++i) {
+        const auto entry = table.find((i + 1) * 4);
+        all_found = all_found && entry && entry->id == ids[i];
+    }
+    expect_true(torn.load() == 0, "readers should never see a half-published entry");
+    expect_true(all_found && table.size() == kPids, "every published pid should be found afterwards");
+}
+
+} // namespace
+
+int main() {
+    test_publish_and_find();
+    test_sparse_pids();
+    test_clear_keeps_chunks();
+    test_concurrent_readers();
+
+    if (failures == 0) {
+        std::cout << "All pid table tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " pid table test(s) failed.\n";
+    return EXIT_FAILURE;
+}
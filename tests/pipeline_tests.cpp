@@ -0,0 +1,142 @@
+#include "pipeline.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+[[nodiscard]] std::vector<nt::RawHandle> make_handles(const std::size_t count) {
+    std::vector<nt::RawHandle> handles(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        handles[i].processId = 4 + (i % 97) * 4;
+        handles[i].handleValue = i;
+    }
+    return handles;
+}
+
+[[nodiscard]] bool keep(const nt::RawHandle& handle) {
+    return handle.handleValue % 7 == 3;
+}
+
+void test_stages_preserve_order() {
+    std::vector<std::size_t> values;
+    for (const nt::RawHandle& handle : pipeline::filter(pipeline::acquire(make_handles(100)), {})) {
+        values.push_back(handle.handleValue);
+    }
+    bool ordered = values.size() == 100;
+    for (std::size_t i = 0; ordered && i < values.size(); ++i) {
+        ordered = values[i] == i;
+    }
+    expect_true(ordered, "an empty predicate should pass every handle through in order");
+
+    const auto handles = make_handles(10'000);
+    std::vector<std::size_t> serial;
+    for (const nt::RawHandle& handle : pipeline::filter(pipeline::acquire(handles), keep, {.threads = 1})) {
+        serial.push_back(handle.handleValue);
+    }
+    std::vector<std::size_t> parallel;
+    for (const nt::RawHandle& handle : pipeline::filter(pipeline::acquire(handles), keep, {.threads = 4, .chunkSize = 64})) {
+        parallel.push_back(handle.handleValue);
+    }
+    expect_true(serial.size() == 1'429 && serial == parallel, "parallel blocks should select the same handles in order");
+}
+
+void test_early_stop_stops_upstream() {
+    std::atomic<std::size_t> tested{0};
+    std::size_t resolved = 0;
+    std::size_t formatted = 0;
+    const parallel::HandlePredicate counting = [&tested](const nt::RawHandle& handle) {
+        tested.fetch_add(1, std::memory_order_relaxed);
+        return keep(handle);
+    };
+
+    std::vector<std::string> lines;
+    for (const std::string& line : pipeline::format(
+             pipeline::resolve(pipeline::filter(pipeline::acquire(make_handles(10'000)), counting, {.threads = 1}),
+                               [&resolved](const nt::RawHandle& handle) {
+                                   ++resolved;
+                                   return HandleInfo{.pid = static_cast<uint32_t>(handle.processId), .handleValue = handle.handleValue};
+                               }),
+             [&formatted](const HandleInfo& row) {
+                 ++formatted;
+                 return std::format("{} {}", row.pid, row.handleValue);
+             })) {
+        lines.push_back(line);
+        if (lines.size() == 3) {
+            break;
+        }
+    }
+    expect_true(lines.size() == 3 && lines[0] == "16 3" && lines[2] == "72 17", "lines should come from the first matches");
+    expect_true(tested.load() == 18 && resolved == 3 && formatted == 3, "nothing after the third match should be touched");
+
+    tested = 0;
+    {
+        pipeline::Handles first = pipeline::filter(pipeline::acquire(make_handles(100'000)), counting, {.threads = 4, .chunkSize = 1024});
+        expect_true(first.begin() != first.end(), "a match should be found");
+    }
+    // The first block of four handles holds the match at index 3.
+    expect_true(tested.load() == 4, "a parallel filter should stop after the block holding the first match");
+
+    tested = 0;
+    std::size_t pulled = 0;
+    for ([[maybe_unused]] const nt::RawHandle& handle :
+         pipeline::filter(pipeline::acquire(make_handles(100'000)), counting, {.threads = 4, .chunkSize = 1024})) {
+        if (++pulled == 2'000) {
+            break;
+        }
+    }
+    // 2'000 matches need about 14'000 handles; doubling blocks at most double that.
+    expect_true(tested.load() < 2 * 14'000 && tested.load() >= 13'997, "blocks should grow without running far ahead");
+}
+
+void test_predicate_exception_propagates() {
+    const parallel::HandlePredicate throwing = [](const nt::RawHandle& handle) -> bool {
+        if (handle.handleValue == 50) {
+            throw std::runtime_error("boom");
+        }
+        return true;
+    };
+    for (const std::size_t threads : {1u, 4u}) {
+        std::size_t seen = 0;
+        bool thrown = false;
+        try {
+            for ([[maybe_unused]] const nt::RawHandle& handle :
+                 pipeline::filter(pipeline::acquire(make_handles(100)), throwing, {.threads = threads})) {
+                ++seen;
+            }
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        expect_true(thrown && seen <= 50, "a predicate exception should reach the consumer");
+    }
+}
+
+} // namespace
+
+int main() {
+    test_stages_preserve_order();
+    test_early_stop_stops_upstream();
+    test_predicate_exception_propagates();
+
+    if (failures == 0) {
+        std::cout << "All pipeline tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " pipeline test(s) failed.\n";
+    return EXIT_FAILURE;
+}
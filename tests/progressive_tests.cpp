@@ -0,0 +1,126 @@
+#include "progressive.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+using progressive::Field;
+using progressive::Lookup;
+
+constexpr StringId kUnresolved = 7;
+constexpr StringId kKnown = 3;
+
+HandleInfo row(const std::uint32_t pid, const std::uint16_t type_index, const bool process, const bool type, const bool name) {
+    return HandleInfo{
+        .pid = pid,
+        .processName = process ? kKnown : kUnresolved,
+        .handleType = type ? kKnown : kUnresolved,
+        .objectName = name ? kKnown : kUnresolved,
+        .objectTypeIndex = type_index};
+}
+
+void test_budget() {
+    using Clock = progressive::Budget::Clock;
+    const Clock::time_point start = Clock::now();
+    const progressive::Budget budget(start, std::chrono::milliseconds(500));
+    expect_true(!budget.expired(start) && !budget.expired(start + std::chrono::milliseconds(499)),
+                "the budget should not expire early");
+    expect_true(budget.expired(start + std::chrono::milliseconds(500)), "the budget should expire at its end");
+    expect_true(budget.budget() == std::chrono::milliseconds(500) &&
+                    budget.elapsed(start + std::chrono::milliseconds(120)) == std::chrono::milliseconds(120),
+                "elapsed time should count from the start");
+}
+
+void test_plan_orders_by_rows_completed() {
+    const std::vector<HandleInfo> rows{
+        row(8, 12, false, true, false),
+        row(4, 12, false, false, true),
+        row(4, 37, true, false, false),
+        row(4, 37, false, false, true),
+        row(12, 37, true, true, true),
+    };
+    const std::vector<Lookup> lookups = progressive::plan(rows, kUnresolved);
+    const std::vector<Lookup> expected{
+        // Pid 4 misses its process name on two rows, pid 8 on one.
+        {Field::ProcessName, 1},
+        {Field::ProcessName, 0},
+        // Type 37 misses on two rows, type 12 on one.
+        {Field::HandleType, 2},
+        {Field::HandleType, 1},
+        // Names in row order.
+        {Field::ObjectName, 0},
+        {Field::ObjectName, 2},
+    };
+    bool same = lookups.size() == expected.size();
+    for (std::size_t i = 0; same && i < expected.size(); ++i) {
+        same = lookups[i].field == expected[i].field && lookups[i].row == expected[i].row;
+    }
+    expect_true(same, "group lookups should come first, largest first, then names in row order");
+    expect_true(progressive::plan(std::vector<HandleInfo>{row(4, 1, true, true, true)}, kUnresolved).empty(),
+                "complete rows should need no lookups");
+}
+
+void test_plan_ties_follow_row_order() {
+    std::vector<HandleInfo> rows;
+    for (std::uint32_t pid = 400; pid > 0; pid -= 4) {
+        rows.push_back(row(pid, 1, false, true, true));
+    }
+    const std::vector<Lookup> lookups = progressive::plan(rows, kUnresolved);
+    bool ordered = lookups.size() == rows.size();
+    for (std::size_t i = 0; ordered && i < lookups.size(); ++i) {
+        ordered = lookups[i].row == i;
+    }
+    expect_true(ordered, "equally large groups should keep the order of their first rows");
+}
+
+void test_measure() {
+    const std::vector<HandleInfo> rows{
+        row(4, 1, true, true, true),
+        row(4, 1, true, false, false),
+        row(8, 2, false, true, true),
+        row(8, 2, true, true, false),
+    };
+    const progressive::Completeness all = progressive::measure(rows, {true, true, true}, kUnresolved);
+    expect_true(all.rows == 4 && all.completeRows == 1, "a row is complete only with every needed field");
+    expect_true(all.needed[0] == 4 && all.resolved[0] == 3 && all.resolved[1] == 3 && all.resolved[2] == 2,
+                "resolved fields should be counted per field");
+    expect_true(all.fraction() == 8.0 / 12.0, "the fraction should cover every needed field");
+
+    // Types and names not shown: their markers do not count.
+    const progressive::Completeness processes = progressive::measure(rows, {true, false, false}, kUnresolved);
+    expect_true(processes.completeRows == 3 && processes.needed[1] == 0 && processes.fraction() == 0.75,
+                "fields that are not needed should be ignored");
+    expect_true(progressive::measure({}, {true, true, true}, kUnresolved).fraction() == 1.0,
+                "no rows should count as complete");
+}
+
+} // namespace
+
+int main() {
+    test_budget();
+    test_plan_orders_by_rows_completed();
+    test_plan_ties_follow_row_order();
+    test_measure();
+
+    if (failures == 0) {
+        std::cout << "All progressive tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " progressive test(s) failed.\n";
+    return EXIT_FAILURE;
+}
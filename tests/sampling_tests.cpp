@@ -0,0 +1,148 @@
+#include "sampling.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// 60 processes with skewed sizes (pid 4 * k holds 40 + 25 * k handles) and
+// 12 types, one of them rare.
+[[nodiscard]] std::vector<nt::RawHandle> make_table() {
+    std::vector<nt::RawHandle> handles;
+    std::uint64_t state = 12345;
+    for (std::uintptr_t k = 1; k <= 60; ++k) {
+        for (std::uintptr_t i = 0; i < 40 + 25 * k; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            const auto draw = static_cast<std::uint16_t>((state >> 33) % 100);
+            const std::uint16_t type = draw < 2 ? 99 : static_cast<std::uint16_t>(draw % 11);
+            handles.push_back(nt::RawHandle{
+                .objectAddress = 0x1000 + handles.size(), .processId = 4 * k, .handleValue = 4 * (i + 1), .objectTypeIndex = type});
+        }
+    }
+    return handles;
+}
+
+// Stand-in for an expensive filter: handles of types 0..4.
+[[nodiscard]] bool matches(const nt::RawHandle& handle) {
+    return handle.objectTypeIndex < 5;
+}
+
+void test_draw_sizes_and_determinism() {
+    const std::vector<nt::RawHandle> table = make_table();
+    const sampling::Sample uniform = sampling::draw(table, 0.05, sampling::Strategy::Uniform, 7);
+    expect_true(uniform.population == table.size() && uniform.strata.size() == 1, "uniform sampling uses one stratum");
+    expect_true(uniform.handles.size() == uniform.strata[0].sampled &&
+                    uniform.handles.size() == static_cast<std::size_t>(std::llround(0.05 * static_cast<double>(table.size()))),
+                "the sample should hold exactly the requested fraction");
+
+    const sampling::Sample again = sampling::draw(table, 0.05, sampling::Strategy::Uniform, 7);
+    bool same = again.handles.size() == uniform.handles.size();
+    for (std::size_t i = 0; same && i < again.handles.size(); ++i) {
+        same = again.handles[i].objectAddress == uniform.handles[i].objectAddress;
+    }
+    expect_true(same, "the same seed should draw the same sample");
+
+    bool ordered = true;
+    for (std::size_t i = 1; i < uniform.handles.size(); ++i) {
+        ordered = ordered && uniform.handles[i - 1].objectAddress < uniform.handles[i].objectAddress;
+    }
+    expect_true(ordered, "sampled handles should keep table order without duplicates");
+
+    const sampling::Sample tiny = sampling::draw(table, 0.001, sampling::Strategy::ByPid, 7);
+    expect_true(tiny.strata.size() == 60 && tiny.handles.size() >= 60, "every process should be represented");
+
+    // Without a filter, a per-process estimate from a by-pid sample is exact.
+    sampling::Estimator per_pid(tiny);
+    for (const nt::RawHandle& handle : tiny.handles) {
+        per_pid.add(handle, handle.processId);
+    }
+    const sampling::Estimate pid_8 = per_pid.estimate(8);
+    expect_true(std::llround(pid_8.value) == 90 && pid_8.low <= 90 && pid_8.high >= 90,
+                "a by-pid sample should estimate process sizes exactly");
+
+    const sampling::Estimate unseen = per_pid.estimate(4000);
+    expect_true(unseen.value == 0 && unseen.low == 0 && unseen.high > 0,
+                "a group missing from the sample should still get a non-empty upper bound");
+}
+
+void test_error_stays_within_reported_bounds() {
+    const std::vector<nt::RawHandle> table = make_table();
+    std::size_t true_total = 0;
+    std::unordered_map<std::uint64_t, std::size_t> true_by_pid;
+    std::unordered_map<std::uint64_t, std::size_t> true_by_type;
+    for (const nt::RawHandle& handle : table) {
+        if (matches(handle)) {
+            ++true_total;
+            ++true_by_pid[handle.processId];
+            ++true_by_type[handle.objectTypeIndex];
+        }
+    }
+
+    for (const sampling::Strategy strategy : {sampling::Strategy::Uniform, sampling::Strategy::ByPid}) {
+        std::size_t intervals = 0;
+        std::size_t covered = 0;
+        std::size_t totals_covered = 0;
+        constexpr std::uint64_t kRuns = 40;
+        for (std::uint64_t seed = 1; seed <= kRuns; ++seed) {
+            const sampling::Sample sample = sampling::draw(table, 0.05, strategy, seed);
+            sampling::Estimator total(sample);
+            sampling::Estimator by_pid(sample);
+            sampling::Estimator by_type(sample);
+            for (const nt::RawHandle& handle : sample.handles) {
+                if (matches(handle)) {
+                    total.add(handle, 0);
+                    by_pid.add(handle, handle.processId);
+                    by_type.add(handle, handle.objectTypeIndex);
+                }
+            }
+
+            const sampling::Estimate estimate = total.estimate(0);
+            const auto truth = static_cast<double>(true_total);
+            totals_covered += estimate.low <= truth && truth <= estimate.high;
+            expect_true(estimate.low <= estimate.value && estimate.value <= estimate.high, "the estimate should lie inside its interval");
+
+            for (const auto& [estimator, truths] : {std::pair{&by_pid, &true_by_pid}, std::pair{&by_type, &true_by_type}}) {
+                for (const std::uint64_t group : estimator->groups()) {
+                    const sampling::Estimate group_estimate = estimator->estimate(group);
+                    const auto group_truth = static_cast<double>(truths->at(group));
+                    ++intervals;
+                    covered += group_estimate.low <= group_truth && group_truth <= group_estimate.high;
+                }
+            }
+        }
+
+        const std::string name = strategy == sampling::Strategy::Uniform ? "uniform" : "by-pid";
+        // 95% intervals: allow some slack for the finite number of runs.
+        expect_true(totals_covered >= kRuns * 85 / 100, name + ": the total should fall inside its interval in most runs");
+        expect_true(static_cast<double>(covered) >= 0.9 * static_cast<double>(intervals),
+                    name + ": group counts should fall inside their intervals at the nominal rate");
+    }
+}
+
+} // namespace
+
+int main() {
+    test_draw_sizes_and_determinism();
+    test_error_stays_within_reported_bounds();
+
+    if (failures == 0) {
+        std::cout << "All sampling tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " sampling test(s) failed.\n";
+    return EXIT_FAILURE;
+}
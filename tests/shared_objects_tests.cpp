@@ -0,0 +1,147 @@
+#include "shared_objects.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+[[nodiscard]] nt::RawHandle make_handle(const std::uintptr_t address, const std::uintptr_t pid, const std::uintptr_t value) {
+    return nt::RawHandle{.objectAddress = address, .processId = pid, .handleValue = value, .objectTypeIndex = 37};
+}
+
+void test_groups_by_address_with_threshold() {
+    const std::vector<nt::RawHandle> handles{
+        make_handle(0xA000, 4, 0x10),
+        make_handle(0xB000, 4, 0x14),
+        make_handle(0xA000, 8, 0x20),
+        make_handle(0xC000, 8, 0x24),
+        make_handle(0xA000, 12, 0x30),
+        make_handle(0xB000, 12, 0x34),
+    };
+
+    const auto report = shared_objects::find(handles, 2);
+    const auto& groups = report.groups;
+    expect_true(groups.size() == 2, "two objects are held by at least two processes");
+    if (groups.size() == 2) {
+        expect_true(groups[0].objectAddress == 0xA000 && groups[0].processCount == 3,
+                    "the object with most holders should come first");
+        expect_true(groups[1].objectAddress == 0xB000 && groups[1].processCount == 2, "second group should be 0xB000");
+        expect_true(groups[0].objectTypeIndex == 37, "group should carry the object type index");
+        const auto holders = report.holders(groups[0]);
+        expect_true(holders.size() == 3 && holders[0].handleValue == 0x10 && holders[1].handleValue == 0x20 &&
+                        holders[2].handleValue == 0x30,
+                    "holders should be listed in input order");
+        expect_true(report.holders(groups[1]).size() == 2 && report.holders(groups[1])[0].objectAddress == 0xB000,
+                    "each group should own its own handle range");
+    }
+
+    expect_true(shared_objects::find(handles, 3).groups.size() == 1, "only 0xA000 has three holders");
+    expect_true(shared_objects::find(handles, 4).groups.empty(), "no object has four holders");
+}
+
+void test_counts_distinct_processes_exactly() {
+    // pid runs alternate (4, 8, 4, 8) so the run counter overestimates; the
+    // exact count must still be two.
+    const std::vector<nt::RawHandle> handles{
+        make_handle(0xA000, 4, 0x10),
+        make_handle(0xA000, 8, 0x20),
+        make_handle(0xA000, 4, 0x14),
+        make_handle(0xA000, 8, 0x24),
+    };
+
+    const auto report = shared_objects::find(handles, 2);
+    expect_true(report.groups.size() == 1 && report.groups[0].processCount == 2 && report.groups[0].handleCount == 4,
+                "interleaved handles should count two distinct processes and keep all four handles");
+    expect_true(shared_objects::find(handles, 3).groups.empty(), "two processes should not satisfy a minimum of three");
+}
+
+void test_many_handles_in_one_process_are_not_shared() {
+    std::vector<nt::RawHandle> handles;
+    for (std::uintptr_t i = 0; i < 10; ++i) {
+        handles.push_back(make_handle(0xA000, 4, 0x10 + i * 4));
+    }
+    expect_true(shared_objects::find(handles, 2).groups.empty(), "one process with many handles is not shared");
+}
+
+void test_zero_address_is_ignored() {
+    const std::vector<nt::RawHandle> handles{
+        make_handle(0, 4, 0x10),
+        make_handle(0, 8, 0x14),
+    };
+    expect_true(shared_objects::find(handles, 2).groups.empty(), "hidden (zero) addresses should not form a group");
+}
+
+void test_many_objects_span_partitions() {
+    std::vector<nt::RawHandle> handles;
+    constexpr std::uintptr_t kObjects = 50'000;
+    for (std::uintptr_t pid = 4; pid <= 8; pid += 4) {
+        for (std::uintptr_t object = 0; object < kObjects; ++object) {
+            handles.push_back(make_handle(0xFFFF800000000000ull + object * 0x40, pid, object * 4));
+        }
+    }
+    handles.push_back(make_handle(0xFFFF900000000000ull, 12, 0x4));
+
+    const auto report = shared_objects::find(handles, 2);
+    const auto& groups = report.groups;
+    expect_true(groups.size() == kObjects, "every object shared by pids 4 and 8 should be reported");
+    expect_true(!groups.empty() && groups.front().objectAddress < groups.back().objectAddress,
+                "equal groups should be ordered by address");
+
+    bool holders_match = true;
+    for (const auto& group : groups) {
+        for (const nt::RawHandle& holder : report.holders(group)) {
+            holders_match = holders_match && holder.objectAddress == group.objectAddress;
+        }
+    }
+    expect_true(holders_match, "every holder should belong to its group's object across partitions");
+}
+
+void test_max_groups_keeps_widest_objects() {
+    std::vector<nt::RawHandle> handles;
+    // Object k is held by k + 2 processes.
+    for (std::uintptr_t object = 0; object < 20; ++object) {
+        for (std::uintptr_t pid = 0; pid < object + 2; ++pid) {
+            handles.push_back(make_handle(0xA000 + object * 0x40, 4 + pid * 4, 0x10 + object * 4));
+        }
+    }
+
+    const auto full = shared_objects::find(handles, 2);
+    const auto top = shared_objects::find(handles, 2, 3);
+    expect_true(full.groups.size() == 20 && top.groups.size() == 3, "max_groups should cap the reported groups");
+    bool same = top.groups.size() == 3;
+    for (std::size_t i = 0; same && i < top.groups.size(); ++i) {
+        same = top.groups[i].objectAddress == full.groups[i].objectAddress &&
+               top.holders(top.groups[i]).size() == full.holders(full.groups[i]).size();
+    }
+    expect_true(same, "the kept groups should be the widest ones, in order, with their holders");
+}
+
+} // namespace
+
+int main() {
+    test_groups_by_address_with_threshold();
+    test_counts_distinct_processes_exactly();
+    test_many_handles_in_one_process_are_not_shared();
+    test_zero_address_is_ignored();
+    test_many_objects_span_partitions();
+    test_max_groups_keeps_widest_objects();
+
+    if (failures == 0) {
+        std::cout << "All shared_objects tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " shared_objects test(s) failed.\n";
+    return EXIT_FAILURE;
+}
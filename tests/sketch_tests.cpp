@@ -0,0 +1,167 @@
+#include "sketch.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+[[nodiscard]] bool within(const double estimate, const double truth, const double relative) {
+    return std::abs(estimate - truth) <= relative * truth;
+}
+
+void test_hyperloglog_accuracy_and_merge() {
+    sketch::HyperLogLog small(12);
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        small.add_hash(sketch::hash_u64(i));
+        small.add_hash(sketch::hash_u64(i));
+    }
+    expect_true(within(small.estimate(), 100, 0.02), "small cardinalities should be nearly exact");
+
+    sketch::HyperLogLog first(12);
+    sketch::HyperLogLog second(12);
+    sketch::HyperLogLog both(12);
+    for (std::uint64_t i = 0; i < 150'000; ++i) {
+        const std::uint64_t hash = sketch::hash_u64(i);
+        (i < 100'000 ? first : second).add_hash(hash);
+        if (i >= 50'000 && i < 100'000) {
+            second.add_hash(hash);
+        }
+        both.add_hash(hash);
+    }
+    // Three standard errors.
+    expect_true(within(first.estimate(), 100'000, 3 * first.relative_error()), "100k distinct values should be within 3 sigma");
+
+    expect_true(first.merge(second).has_value(), "same-precision sketches should merge");
+    expect_true(first.estimate() == both.estimate(), "a merge should equal one sketch that saw the union");
+    const double merged = first.estimate();
+    expect_true(first.merge(second).has_value() && first.estimate() == merged, "merging again should change nothing");
+    expect_true(!first.merge(sketch::HyperLogLog(10)).has_value(), "different precisions should not merge");
+}
+
+void test_hyperloglog_serialization() {
+    for (const std::uint64_t count : {50u, 200'000u}) {
+        sketch::HyperLogLog original(12);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            original.add_hash(sketch::hash_u64(i));
+        }
+        codec::ByteWriter out;
+        original.serialize(out);
+        if (count == 50) {
+            expect_true(out.size() < 200, "a nearly empty sketch should serialize sparsely");
+        }
+        codec::ByteReader in(out.data());
+        const auto copy = sketch::HyperLogLog::deserialize(in);
+        expect_true(copy && copy->estimate() == original.estimate() && in.at_end(), "registers should round-trip exactly");
+
+        codec::ByteReader truncated(std::span(out.data()).first(out.size() - 1));
+        expect_true(!sketch::HyperLogLog::deserialize(truncated).has_value(), "truncated registers should be rejected");
+    }
+}
+
+void test_count_min_and_heavy_hitters() {
+    sketch::CountMin counts(256, 4);
+    for (std::uint64_t key = 0; key < 5000; ++key) {
+        counts.add(sketch::hash_u64(key), key % 7 + 1);
+    }
+    bool never_under = true;
+    for (std::uint64_t key = 0; key < 5000; ++key) {
+        never_under = never_under && counts.estimate(sketch::hash_u64(key)) >= key % 7 + 1;
+    }
+    expect_true(never_under, "count-min should never undercount");
+
+    // Two hosts: names "hot-0".."hot-4" are frequent overall, but each host
+    // sees only some of them often, and both see a long tail.
+    sketch::HeavyHitters host_a(8, 512, 4);
+    sketch::HeavyHitters host_b(8, 512, 4);
+    for (int i = 0; i < 20'000; ++i) {
+        host_a.add("tail-a-" + std::to_string(i));
+        host_b.add("tail-b-" + std::to_string(i));
+        if (i % 10 == 0) {
+            host_a.add("hot-" + std::to_string(i / 10 % 3));
+            host_b.add("hot-" + std::to_string(2 + i / 10 % 3));
+        }
+    }
+    expect_true(host_a.merge(host_b).has_value(), "heavy hitters should merge");
+    const auto top = host_a.top();
+    expect_true(top.size() >= 5 && top[0].key == "hot-2" && top[0].count >= 1334,
+                "the key frequent on both hosts should rank first without undercounting");
+    bool all_hot = true;
+    for (std::size_t i = 0; i < 5 && i < top.size(); ++i) {
+        all_hot = all_hot && top[i].key.starts_with("hot-");
+    }
+    expect_true(all_hot, "the merged top five should be the hot names");
+
+    sketch::HeavyHitters long_keys(4);
+    long_keys.add(std::string(1000, 'x'));
+    expect_true(long_keys.top().front().key.size() == sketch::HeavyHitters::kMaxKeyBytes, "keys should be truncated");
+}
+
+void test_sketch_set_fixed_memory_and_file_round_trip() {
+    sketch::SketchSet sketches;
+    sketch::LabeledDistinct labels(16, 8);
+    for (std::uint64_t i = 0; i < 100'000; ++i) {
+        labels.add_hash("process-" + std::to_string(i % 1000), sketch::hash_u64(i));
+    }
+    expect_true(labels.counters().size() == 17 && labels.counters().contains(std::string(sketch::LabeledDistinct::kOtherLabel)),
+                "labels beyond the limit should share the other counter");
+
+    for (std::uint64_t i = 0; i < 30'000; ++i) {
+        sketches.objects.add_hash(sketch::hash_u64(i));
+        sketches.objectsByType.add_hash(i % 3 == 0 ? "File" : "Event", sketch::hash_u64(i));
+        sketches.objectsByProcess.add_hash("svchost.exe", sketch::hash_u64(i));
+        sketches.names.add(i % 2 == 0 ? "\\Device\\Afd" : "\\BaseNamedObjects\\x" + std::to_string(i));
+    }
+    const auto types = sketches.objectsByType.largest(1);
+    expect_true(types.size() == 1 && types[0].label == "Event" && within(types[0].estimate, 20'000, 0.1),
+                "largest should rank labels by distinct count");
+    sketches.snapshots = 1;
+    sketches.handles = 30'000;
+
+    const auto path = std::filesystem::temp_directory_path() / "handle_sketch_test.sketch";
+    expect_true(sketch::save(path, sketches).has_value(), "saving should succeed");
+    auto loaded = sketch::load(path);
+    expect_true(loaded.has_value(), "loading should succeed");
+    if (loaded) {
+        expect_true(sketch::serialize(*loaded) == sketch::serialize(sketches), "a loaded sketch should serialize identically");
+        expect_true(loaded->merge(sketches).has_value() && loaded->snapshots == 2 && loaded->handles == 60'000,
+                    "merging iterations should add snapshot and handle counts");
+        expect_true(loaded->objects.estimate() == sketches.objects.estimate(), "re-merging the same objects should not inflate counts");
+        expect_true(loaded->names.top().front().key == "\\Device\\Afd", "the heaviest name should survive a round trip");
+    }
+
+    codec::Bytes corrupt = sketch::serialize(sketches);
+    corrupt[0] = 'X';
+    expect_true(!sketch::deserialize(corrupt).has_value(), "a bad magic should be rejected");
+    std::filesystem::remove(path);
+    expect_true(!sketch::load(path).has_value(), "a missing file should fail");
+}
+
+} // namespace
+
+int main() {
+    test_hyperloglog_accuracy_and_merge();
+    test_hyperloglog_serialization();
+    test_count_min_and_heavy_hitters();
+    test_sketch_set_fixed_memory_and_file_round_trip();
+
+    if (failures == 0) {
+        std::cout << "All sketch tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " sketch test(s) failed.\n";
+    return EXIT_FAILURE;
+}
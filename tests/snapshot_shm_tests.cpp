@@ -0,0 +1,260 @@
+#include "snapshot_shm.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// Unique per test process so parallel test runs do not collide.
+std::string region_name(const std::string_view test) {
+    return std::format("test-{}-{}", test, getpid());
+}
+
+// Generation `generation` of a snapshot every row of which can be checked on
+// its own: pid, handle and names all derive from the generation and row.
+std::vector<HandleInfo> make_rows(StringInterner& strings, const std::uint64_t generation, const std::size_t count) {
+    std::vector<HandleInfo> rows;
+    rows.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        rows.push_back(HandleInfo{
+            .pid = static_cast<std::uint32_t>(generation),
+            .processName = strings.intern(std::format("gen{}.exe", generation)),
+            .handleType = strings.intern(i % 2 == 0 ? "File" : "Event"),
+            .objectName = strings.intern(std::format("\\BaseNamedObjects\\gen{}-row{}", generation, i)),
+            .grantedAccess = 0x1F0003,
+            .objectAddress = 0xFFFF'8000'0000'0000ull + i * 0x40,
+            .handleValue = 4 + i * 4,
+            .objectTypeIndex = static_cast<std::uint16_t>(i % 2 == 0 ? 37 : 16),
+            .handleAttributes = 0});
+    }
+    return rows;
+}
+
+// True if every row of `view` is the one make_rows() produced for its generation.
+bool consistent(const shm::SnapshotView& view, const std::size_t count) {
+    if (view.rows.size() != count || view.totalRawCount != count * 2) {
+        return false;
+    }
+    const std::string process = std::format("gen{}.exe", view.generation);
+    for (std::size_t i = 0; i < view.rows.size(); ++i) {
+        const shm::Row& row = view.rows[i];
+        if (row.pid != view.generation || row.handleValue != 4 + i * 4 || view.string(row.processName) != process ||
+            view.string(row.handleType) != (i % 2 == 0 ? "File" : "Event") ||
+            view.string(row.objectName) != std::format("\\BaseNamedObjects\\gen{}-row{}", view.generation, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_publish_and_read() {
+    const std::string name = region_name("basic");
+    auto publisher = shm::Publisher::create(name, 1 << 20);
+    expect_true(publisher.has_value(), "the publisher should create the region");
+    if (!publisher) {
+        return;
+    }
+    auto reader = shm::Reader::open(name);
+    expect_true(reader.has_value(), "a reader should open the region");
+    if (!reader) {
+        return;
+    }
+    expect_true(!reader->latest().has_value(), "nothing should be readable before the first publication");
+
+    StringInterner strings;
+    const std::vector<HandleInfo> rows = make_rows(strings, 1, 100);
+    const auto generation = publisher->publish(rows, strings, 200, 1'700'000'000'000);
+    expect_true(generation == 1u, "the first publication should be generation 1");
+
+    const std::optional<shm::SnapshotView> view = reader->latest();
+    expect_true(view && view->generation == 1 && view->publishedMs == 1'700'000'000'000 && consistent(*view, 100),
+                "the reader should see every row and string");
+    expect_true(view && view->stringOffsets.size() == 100 + 3 + 1, "only the strings the rows use should be copied");
+    expect_true(view && view->string(9999).empty(), "an out-of-range string index should read as empty");
+    expect_true(view && reader->valid(*view), "an untouched view should stay valid");
+    expect_true(shm::payload_bytes(rows, strings) <= publisher->slot_capacity(), "payload_bytes should size the slot");
+
+    // Two newer generations reuse the view's slot, which invalidates it.
+    for (std::uint64_t next = 2; next <= 3; ++next) {
+        StringInterner next_strings;
+        const std::vector<HandleInfo> next_rows = make_rows(next_strings, next, 100);
+        expect_true(publisher->publish(next_rows, next_strings, 200, 0).has_value(), "later publications should succeed");
+    }
+    expect_true(view && !reader->valid(*view), "a view whose slot was rewritten should be invalid");
+    const auto consumed = reader->read([](const shm::SnapshotView& latest) { return latest.rows.size(); });
+    expect_true(consumed == 3u, "read() should consume the newest generation");
+}
+
+void test_region_errors() {
+    const std::string name = region_name("errors");
+    expect_true(!shm::Reader::open(name).has_value(), "opening a missing region should fail");
+    expect_true(!shm::Publisher::create("bad/name", 4096).has_value(), "a name with a slash should be rejected");
+    expect_true(!shm::Publisher::create("", 4096).has_value(), "an empty name should be rejected");
+
+    auto publisher = shm::Publisher::create(name, 4096);
+    expect_true(publisher.has_value(), "the publisher should create the region");
+    expect_true(!shm::Publisher::create(name, 4096).has_value(), "a second publisher on the same name should fail");
+    if (!publisher) {
+        return;
+    }
+
+    StringInterner strings;
+    const std::vector<HandleInfo> small = make_rows(strings, 1, 10);
+    expect_true(publisher->publish(small, strings, 20, 0).has_value(), "a snapshot that fits should be published");
+    const std::vector<HandleInfo> large = make_rows(strings, 2, 1000);
+    const auto rejected = publisher->publish(large, strings, 2000, 0);
+    expect_true(!rejected && rejected.error().find("needs") != std::string::npos, "a snapshot that does not fit should fail");
+
+    auto reader = shm::Reader::open(name);
+    const std::optional<shm::SnapshotView> view = reader ? reader->latest() : std::nullopt;
+    expect_true(view && view->generation == 1 && consistent(*view, 10), "the previous snapshot should stay readable");
+
+    publisher = std::unexpected(std::string("closed")); // Destroys the publisher.
+    expect_true(!shm::Reader::open(name).has_value(), "the name should be gone once the publisher closes");
+    expect_true(view && consistent(*view, 10), "an open reader should keep its mapping after the publisher closes");
+}
+
+void test_replacement_region_continues_generations() {
+    const std::string name = region_name("replace");
+    auto small = shm::Publisher::create(name, 4096);
+    expect_true(small.has_value(), "the publisher should create the region");
+    if (!small) {
+        return;
+    }
+    StringInterner strings;
+    const std::vector<HandleInfo> few = make_rows(strings, 1, 10);
+    expect_true(small->publish(few, strings, 20, 0).has_value() && small->publish(few, strings, 20, 0).has_value(),
+                "snapshots that fit should be published");
+    auto reader = shm::Reader::open(name);
+    expect_true(reader && !reader->retired(), "a live region should not be retired");
+
+    // The table outgrew the slots: retire the region and replace it.
+    const std::uint64_t last = small->generation();
+    small->retire();
+    expect_true(reader && reader->retired(), "readers should see the region retired");
+    const std::optional<shm::SnapshotView> old_view = reader ? reader->latest() : std::nullopt;
+    expect_true(old_view && old_view->generation == 2 && reader->valid(*old_view),
+                "the last snapshot of a retired region should stay readable");
+    small = std::unexpected(std::string("replaced")); // Destroys the old publisher, freeing the name.
+
+    StringInterner more_strings;
+    const std::vector<HandleInfo> many = make_rows(more_strings, 3, 1000);
+    auto large = shm::Publisher::create(name, shm::payload_bytes(many, more_strings), last);
+    expect_true(large.has_value(), "a larger region should take over the name");
+    if (!large) {
+        return;
+    }
+    expect_true(large->publish(many, more_strings, 2000, 0) == 3u, "generations should continue across the replacement");
+    auto reopened = shm::Reader::open(name);
+    const std::optional<shm::SnapshotView> view = reopened ? reopened->latest() : std::nullopt;
+    expect_true(view && view->generation == 3 && consistent(*view, 1000) && !reopened->retired(),
+                "a reopened reader should follow the replacement");
+}
+
+void test_concurrent_readers_never_see_torn_snapshots() {
+    const std::string name = region_name("concurrent");
+    constexpr std::size_t kRows = 500;
+    constexpr std::uint64_t kGenerations = 200;
+    auto publisher = shm::Publisher::create(name, 1 << 20);
+    expect_true(publisher.has_value(), "the publisher should create the region");
+    if (!publisher) {
+        return;
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> torn{0};
+    std::atomic<std::size_t> retried{0};
+    std::atomic<std::size_t> consumed{0};
+    std::atomic<std::uint64_t> last_seen{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&] {
+            auto reader = shm::Reader::open(name);
+            if (!reader) {
+                torn.fetch_add(1);
+                return;
+            }
+            std::uint64_t previous = 0;
+            while (!done.load()) {
+                bool ok = true;
+                std::size_t passes = 0;
+                const auto generation = reader->read([&](const shm::SnapshotView& view) {
+                    ++passes;
+                    ok = consistent(view, kRows);
+                });
+                if (!generation) {
+                    continue;
+                }
+                retried.fetch_add(passes - 1);
+                consumed.fetch_add(1);
+                // A validated pass must have read an intact snapshot, and
+                // generations never go backwards.
+                if (!ok || *generation < previous) {
+                    torn.fetch_add(1);
+                }
+                previous = *generation;
+                last_seen.store(*generation);
+            }
+        });
+    }
+
+    for (std::uint64_t generation = 1; generation <= kGenerations; ++generation) {
+        StringInterner strings;
+        const std::vector<HandleInfo> rows = make_rows(strings, generation, kRows);
+        if (!publisher->publish(rows, strings, kRows * 2, 0)) {
+            torn.fetch_add(1);
+        }
+    }
+    // Let the readers catch up with the last generation.
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (last_seen.load() != kGenerations && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::yield();
+    }
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    expect_true(torn.load() == 0, "no validated read should see a torn or stale snapshot");
+    expect_true(consumed.load() > 0, "the readers should have consumed snapshots");
+    std::cout << std::format("  {} snapshots read concurrently, {} passes retried\n", consumed.load(), retried.load());
+}
+
+} // namespace
+
+int main() {
+    test_publish_and_read();
+    test_region_errors();
+    test_replacement_region_continues_generations();
+    test_concurrent_readers_never_see_torn_snapshots();
+
+    if (failures == 0) {
+        std::cout << "All snapshot shm tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " snapshot shm test(s) failed.\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+#include "handle_sort.hpp"
+#include "string_interner.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+void test_intern_deduplicates() {
+    StringInterner strings;
+    const StringId first = strings.intern("File");
+    const StringId second = strings.intern(std::string("File"));
+    const StringId other = strings.intern("Event");
+
+    expect_true(first == second, "equal strings should share one id");
+    expect_true(first != other, "different strings should get different ids");
+    expect_true(strings.view(first) == "File", "view should return the interned text");
+    expect_true(strings.intern("") == StringInterner::kEmpty, "empty string should map to kEmpty");
+    expect_true(strings.size() == 3, "interner should hold empty, File and Event");
+}
+
+void test_views_survive_growth() {
+    StringInterner strings;
+    const StringId first = strings.intern("svchost.exe");
+    const std::string_view first_view = strings.view(first);
+
+    for (int i = 0; i < 20'000; ++i) {
+        (void)strings.intern("\\Device\\HarddiskVolume3\\Windows\\file" + std::to_string(i));
+    }
+    (void)strings.intern(std::string(100'000, 'x'));
+    const StringId after_large = strings.intern("after-large");
+
+    expect_true(first_view.data() == strings.view(first).data(), "views should stay stable as the arena grows");
+    expect_true(strings.view(after_large) == "after-large", "small strings after an oversized one should stay intact");
+}
+
+void test_sort_ranks_are_case_insensitive() {
+    StringInterner strings;
+    const StringId upper = strings.intern("MUTANT");
+    const StringId lower = strings.intern("mutant");
+    const StringId event = strings.intern("Event");
+    const StringId file = strings.intern("file");
+    strings.build_sort_ranks();
+
+    expect_true(strings.sort_rank(upper) == strings.sort_rank(lower), "case variants should share a rank");
+    expect_true(strings.sort_rank(event) < strings.sort_rank(file), "Event should sort before file");
+    expect_true(strings.sort_rank(file) < strings.sort_rank(upper), "file should sort before MUTANT");
+}
+
+void test_sort_handles_by_type_then_pid() {
+    StringInterner strings;
+    std::vector<HandleInfo> handles{
+        HandleInfo{.pid = 8, .handleType = strings.intern("file"), .handleValue = 0x10},
+        HandleInfo{.pid = 4, .handleType = strings.intern("Mutant"), .handleValue = 0x20},
+        HandleInfo{.pid = 4, .handleType = strings.intern("File"), .handleValue = 0x30},
+        HandleInfo{.pid = 4, .handleType = strings.intern("Event"), .handleValue = 0x40},
+    };
+
+    sorting::sort_handles(handles, SortField::Type, strings);
+
+    expect_true(handles[0].handleValue == 0x40, "Event should sort first");
+    expect_true(handles[1].handleValue == 0x30 && handles[2].handleValue == 0x10,
+                "File variants should tie on type and fall back to pid order");
+    expect_true(handles[3].handleValue == 0x20, "Mutant should sort last");
+}
+
+void test_sort_ranks_rebuild_after_new_strings() {
+    StringInterner strings;
+    std::vector<HandleInfo> handles{
+        HandleInfo{.pid = 1, .objectName = strings.intern("b"), .handleValue = 1},
+        HandleInfo{.pid = 1, .objectName = strings.intern("c"), .handleValue = 2},
+    };
+    sorting::sort_handles(handles, SortField::Name, strings);
+
+    handles.push_back(HandleInfo{.pid = 1, .objectName = strings.intern("a"), .handleValue = 3});
+    sorting::sort_handles(handles, SortField::Name, strings);
+
+    expect_true(handles[0].handleValue == 3, "ranks should be rebuilt after interning new strings");
+}
+
+void test_top_rows_match_full_sort_prefix() {
+    for (const SortField field : {SortField::Pid, SortField::Type, SortField::Name}) {
+        StringInterner strings;
+        sorting::TopRows top(25, 2000, field, strings);
+        std::vector<HandleInfo> all;
+        std::uint64_t state = 0x2545F4914F6CDD1Dull;
+        for (std::size_t i = 0; i < 2000; ++i) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            // Strings keep arriving while rows are offered: no ranks exist yet.
+            const std::string text = (state % 3 == 0 ? "Name" : "name") + std::to_string(state % 300);
+            const HandleInfo row{
+                .pid = static_cast<uint32_t>(state % 40),
+                .handleType = strings.intern(text.substr(0, 5)),
+                .objectName = strings.intern(text),
+                .handleValue = static_cast<std::uintptr_t>(i * 4)
+            };
+            top.offer(row, i);
+            all.push_back(row);
+        }
+        expect_true(top.size() == 25, "the heap should stay bounded by its limit");
+
+        const std::vector<sorting::TopRows::Entry> kept = top.take_sorted();
+        sorting::sort_handles(all, field, strings);
+        bool same = kept.size() == 25;
+        for (std::size_t i = 0; same && i < kept.size(); ++i) {
+            same = kept[i].row.handleValue == all[i].handleValue && kept[i].source * 4 == kept[i].row.handleValue;
+        }
+        expect_true(same, "top rows should equal the first rows of a full sort, with their source index");
+        expect_true(top.size() == 0, "take_sorted should empty the heap");
+    }
+
+    StringInterner strings;
+    sorting::TopRows few(10, 2, SortField::Pid, strings);
+    few.offer(HandleInfo{.pid = 9}, 0);
+    few.offer(HandleInfo{.pid = 3}, 1);
+    const auto two = few.take_sorted();
+    expect_true(two.size() == 2 && two[0].row.pid == 3, "fewer rows than the limit should all be kept in order");
+}
+
+} // namespace
+
+int main() {
+    test_intern_deduplicates();
+    test_views_survive_growth();
+    test_sort_ranks_are_case_insensitive();
+    test_sort_handles_by_type_then_pid();
+    test_sort_ranks_rebuild_after_new_strings();
+    test_top_rows_match_full_sort_prefix();
+
+    if (failures == 0) {
+        std::cout << "All string_interner tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " string_interner test(s) failed.\n";
+    return EXIT_FAILURE;
+}
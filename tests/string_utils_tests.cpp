@@ -0,0 +1,140 @@
+#include "string_utils.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(const bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << "\n";
+        ++failures;
+    }
+}
+
+// UTF-8 bytes written as escapes so the expectations do not depend on the
+// source encoding.
+const std::string kEAcute = "\xC3\xA9";             // U+00E9
+const std::string kEuro = "\xE2\x82\xAC";           // U+20AC
+const std::string kGrinning = "\xF0\x9F\x98\x80";   // U+1F600
+const std::string kReplacement = "\xEF\xBF\xBD";    // U+FFFD
+
+void test_case_helpers() {
+    expect_true(utils::to_lower_ascii("Event\\BaseNamedObjects") == "event\\basenamedobjects", "to_lower_ascii should fold ASCII");
+    expect_true(utils::equals_ignore_case("ALPC Port", "alpc port"), "equals_ignore_case should ignore case");
+    expect_true(utils::contains_ignore_case("\\Device\\HarddiskVolume3", "HARDDISK"), "contains_ignore_case should ignore case");
+    expect_true(!utils::contains_ignore_case("Key", "file"), "contains_ignore_case should reject a missing needle");
+}
+
+void test_known_encodings() {
+    expect_true(utils::utf16_to_utf8(std::u16string_view{}).empty(), "an empty string should stay empty");
+    expect_true(utils::utf16_to_utf8(u"\\Sessions\\1\\BaseNamedObjects") == "\\Sessions\\1\\BaseNamedObjects",
+                "ASCII should be copied unchanged");
+    expect_true(utils::utf16_to_utf8(u"caf\u00E9") == "caf" + kEAcute, "two-byte sequences should be encoded");
+    expect_true(utils::utf16_to_utf8(u"\u20AC") == kEuro, "three-byte sequences should be encoded");
+    expect_true(utils::utf16_to_utf8(u"\U0001F600") == kGrinning, "surrogate pairs should become one four-byte sequence");
+
+    const char16_t lone_high[] = {u'a', 0xD83D, u'b'};
+    const char16_t lone_low[] = {0xDE00, u'a'};
+    const char16_t reversed[] = {0xDE00, 0xD83D};
+    const char16_t trailing_high[] = {u'a', 0xD83D};
+    expect_true(utils::utf16_to_utf8(std::u16string_view(lone_high, 3)) == "a" + kReplacement + "b",
+                "a high surrogate without a low one should become U+FFFD");
+    expect_true(utils::utf16_to_utf8(std::u16string_view(lone_low, 2)) == kReplacement + "a",
+                "a low surrogate on its own should become U+FFFD");
+    expect_true(utils::utf16_to_utf8(std::u16string_view(reversed, 2)) == kReplacement + kReplacement,
+                "a reversed pair should become two U+FFFD");
+    expect_true(utils::utf16_to_utf8(std::u16string_view(trailing_high, 2)) == "a" + kReplacement,
+                "a high surrogate at the end should become U+FFFD");
+}
+
+void test_wide_overload() {
+    expect_true(utils::utf16_to_utf8(std::wstring_view(L"File")) == "File", "wide ASCII should be copied unchanged");
+    expect_true(utils::utf16_to_utf8(std::wstring_view(L"caf\u00E9 \u20AC")) == "caf" + kEAcute + " " + kEuro,
+                "wide strings should be encoded like UTF-16");
+    expect_true(utils::utf16_to_utf8(std::wstring_view(L"\U0001F600")) == kGrinning,
+                "wide supplementary characters should encode to four bytes");
+}
+
+// Every length around the 16-unit blocks, with a non-ASCII unit or a
+// surrogate pair placed at every position, including across a block edge.
+void test_block_boundaries() {
+    const std::u16string inserts[] = {u"\u00E9", u"\u20AC", u"\U0001F600", std::u16string(1, static_cast<char16_t>(0xD800))};
+    bool matched = true;
+    for (std::size_t length = 0; length <= 50; ++length) {
+        std::u16string ascii;
+        for (std::size_t i = 0; i < length; ++i) {
+            ascii.push_back(static_cast<char16_t>(u'a' + i % 26));
+        }
+        matched = matched && utils::utf16_to_utf8(ascii) == utils::utf16_to_utf8_scalar(ascii) &&
+                  utils::utf16_to_utf8(ascii).size() == length;
+        for (std::size_t position = 0; position <= length; ++position) {
+            for (const std::u16string& insert : inserts) {
+                std::u16string mixed = ascii;
+                mixed.insert(position, insert);
+                matched = matched && utils::utf16_to_utf8(mixed) == utils::utf16_to_utf8_scalar(mixed);
+            }
+        }
+    }
+    expect_true(matched, "every length and position should match the scalar reference");
+    expect_true(utils::utf16_to_utf8_scalar(u"x\U0001F600y") == "x" + kGrinning + "y", "the scalar reference should encode pairs");
+}
+
+void test_random_against_scalar() {
+    std::uint64_t state = 0x2545F4914F6CDD1Dull;
+    const auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    bool matched = true;
+    bool sized = true;
+    for (int round = 0; round < 5000; ++round) {
+        std::u16string text;
+        const std::size_t length = next() % 80;
+        // Mostly ASCII like real names, with every class of unit mixed in.
+        for (std::size_t i = 0; i < length; ++i) {
+            const std::uint64_t roll = next();
+            switch (roll % 16) {
+            case 0: text.push_back(static_cast<char16_t>(0x80 + (roll >> 8) % 0x780)); break;
+            case 1: text.push_back(static_cast<char16_t>(0x800 + (roll >> 8) % 0xD000)); break;
+            case 2: text.push_back(static_cast<char16_t>(0xD800 + (roll >> 8) % 0x800)); break;
+            case 3: text.push_back(static_cast<char16_t>(0xE000 + (roll >> 8) % 0x2000)); break;
+            case 4:
+                text.push_back(static_cast<char16_t>(0xD800 + (roll >> 8) % 0x400));
+                text.push_back(static_cast<char16_t>(0xDC00 + (roll >> 24) % 0x400));
+                break;
+            default: text.push_back(static_cast<char16_t>(0x20 + (roll >> 8) % 0x5F)); break;
+            }
+        }
+        const std::string fast = utils::utf16_to_utf8(text);
+        matched = matched && fast == utils::utf16_to_utf8_scalar(text);
+        sized = sized && fast.size() <= text.size() * 3;
+    }
+    expect_true(matched, "random mixes of units should match the scalar reference");
+    expect_true(sized, "output should never exceed three bytes per unit");
+}
+
+} // namespace
+
+int main() {
+    test_case_helpers();
+    test_known_encodings();
+    test_wide_overload();
+    test_block_boundaries();
+    test_random_against_scalar();
+
+    if (failures == 0) {
+        std::cout << "All string_utils tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::cerr << failures << " string_utils test(s) failed.\n";
+    return EXIT_FAILURE;
+}